@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+#include "boardfeatures.h"
+#include "sim.h"
+#include "book.h"
+#include "ai.h"
+
+void AI_defaultWeights (AI_Weights *weights)
+{
+    int k;
+
+    for (k = 0; k < AI_NB_WEIGHTS; k++)
+        weights->w[k] = 0.0;
+
+    weights->w[AI_W_AGGREGATE_HEIGHT] = -0.51;
+    weights->w[AI_W_HOLES] = -0.36;
+    weights->w[AI_W_BUMPINESS] = -0.18;
+    weights->w[AI_W_LINES] = 0.76;
+}
+
+double AI_evaluate (const AI_Weights *weights, const BoardFeatures *ftr, int nbLines, double landingHeight)
+{
+    return weights->w[AI_W_AGGREGATE_HEIGHT]*ftr->aggregateHeight
+         + weights->w[AI_W_MAX_HEIGHT]*ftr->maxHeight
+         + weights->w[AI_W_HOLES]*ftr->holes
+         + weights->w[AI_W_BUMPINESS]*ftr->bumpiness
+         + weights->w[AI_W_WELL_SUMS]*ftr->wellSums
+         + weights->w[AI_W_ROW_TRANSITIONS]*ftr->rowTransitions
+         + weights->w[AI_W_COL_TRANSITIONS]*ftr->colTransitions
+         + weights->w[AI_W_LINES]*nbLines
+         + weights->w[AI_W_LANDING_HEIGHT]*landingHeight;
+}
+
+double AI_evaluatePlacement (const AI_Weights *weights, Bitboard *board, BoardFeatures *ftr, int tetrim, const Placement *placement)
+{
+    const PieceShape *shape = BB_getShape (tetrim, placement->rotation);
+    double landingHeight = NB_BLOCK_Y - placement->y - (shape->top + shape->bottom)/2.0;
+    int nbLines = FTR_addPiece (ftr, board, tetrim, placement->rotation, placement->x, placement->y);
+
+    return AI_evaluate (weights, ftr, nbLines, landingHeight);
+}
+
+Uint8 AI_bestPlacement (const SimGame *game, const AI_Weights *weights, Placement *best)
+{
+    /* Variables */
+    Placement placements[SIM_MAX_PLACEMENTS];
+    BoardFeatures base, ftr;
+    Bitboard board;
+    double value, bestValue = 0.0;
+    int nbPlacements, k;
+
+    nbPlacements = SIM_listPlacements (&game->board, game->actualTetrim, placements);
+    if (nbPlacements == 0)
+        return 0;
+
+    /* The features of the actual playfield are computed once, then updated for each placement */
+    FTR_compute (&base, &game->board);
+    for (k = 0; k < nbPlacements; k++)
+    {
+        board = game->board;
+        ftr = base;
+        value = AI_evaluatePlacement (weights, &board, &ftr, game->actualTetrim, &placements[k]);
+        if (k == 0 || value > bestValue)
+        {
+            bestValue = value;
+            *best = placements[k];
+        }
+    }
+
+    return 1;
+}
+
+Uint8 AI_bestPlacementWithNext (const SimGame *game, const AI_Weights *weights, Placement *best)
+{
+    /* Variables */
+    Placement placements[SIM_MAX_PLACEMENTS], nextPlacements[SIM_MAX_PLACEMENTS];
+    const PieceShape *shape = NULL;
+    BoardFeatures base, ftr, nextFtr;
+    Bitboard board, nextBoard;
+    double value, bestValue = 0.0, landingHeight;
+    int nbPlacements, nbNextPlacements, k, n, nbLines, nbNextLines;
+    Uint8 found = 0; /* Boolean */
+
+    nbPlacements = SIM_listPlacements (&game->board, game->actualTetrim, placements);
+    if (nbPlacements == 0)
+        return 0;
+
+    FTR_compute (&base, &game->board);
+    for (k = 0; k < nbPlacements; k++)
+    {
+        board = game->board;
+        ftr = base;
+        nbLines = FTR_addPiece (&ftr, &board, game->actualTetrim, placements[k].rotation, placements[k].x, placements[k].y);
+
+        /* The value of a placement is the value of the best placement of the next tetrimino after it */
+        nbNextPlacements = SIM_listPlacements (&board, game->nextTetrim, nextPlacements);
+        for (n = 0; n < nbNextPlacements; n++)
+        {
+            nextBoard = board;
+            nextFtr = ftr;
+            nbNextLines = FTR_addPiece (&nextFtr, &nextBoard, game->nextTetrim,
+                                        nextPlacements[n].rotation, nextPlacements[n].x, nextPlacements[n].y);
+            shape = BB_getShape (game->nextTetrim, nextPlacements[n].rotation);
+            landingHeight = NB_BLOCK_Y - nextPlacements[n].y - (shape->top + shape->bottom)/2.0;
+            value = AI_evaluate (weights, &nextFtr, nbLines + nbNextLines, landingHeight);
+            if (!found || value > bestValue)
+            {
+                bestValue = value;
+                *best = placements[k];
+                found = 1;
+            }
+        }
+    }
+
+    /* The next tetrimino cannot be placed anywhere : the active one is placed alone */
+    if (!found)
+        return AI_bestPlacement (game, weights, best);
+
+    return 1;
+}
+
+Uint8 AI_bookPlacement (const OpeningBook *book, const SimGame *game, const AI_Weights *weights, Placement *placement)
+{
+    if (book != NULL && BOOK_lookup (book, &game->board, game->actualTetrim, game->nextTetrim, placement))
+        return 1;
+
+    return AI_bestPlacementWithNext (game, weights, placement);
+}
+
+Uint32 AI_playGame (const AI_Weights *weights, Uint32 seed, int maxPieces)
+{
+    SimGame game;
+    Placement placement;
+
+    SIM_init (&game, seed);
+    while (!game.over && (maxPieces <= 0 || game.nbPieces < maxPieces))
+    {
+        if (!AI_bestPlacement (&game, weights, &placement))
+            break;
+        SIM_play (&game, &placement);
+    }
+
+    return game.score;
+}
@@ -0,0 +1,56 @@
+/** ai.h and ai.cpp choose where to drop the tetriminoes.
+
+    Each placement is evaluated with a weighted sum of the features of the playfield it leads to
+    (see boardfeatures.h). The weights can be tuned by the trainer (tools/trainer.cpp).
+**/
+
+#ifndef AI_H_INCLUDED
+#define AI_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "boardfeatures.h"
+#include "sim.h"
+#include "book.h"
+
+enum {  AI_W_AGGREGATE_HEIGHT, AI_W_MAX_HEIGHT, AI_W_HOLES, AI_W_BUMPINESS, AI_W_WELL_SUMS,
+        AI_W_ROW_TRANSITIONS, AI_W_COL_TRANSITIONS, AI_W_LINES, AI_W_LANDING_HEIGHT,
+        AI_NB_WEIGHTS };
+
+typedef struct AI_Weights AI_Weights;
+
+struct AI_Weights
+{
+    double w[AI_NB_WEIGHTS];
+};
+
+
+/** Fills the weights with values that play a correct game **/
+void AI_defaultWeights (AI_Weights*);
+
+/** Evaluates a playfield. The higher the better **/
+double AI_evaluate (const AI_Weights*, const BoardFeatures*, int nbLines, double landingHeight);
+
+/** Evaluates the placement of a tetrimino on a playfield whose features are known.
+    board and ftr are updated with the tetrimino **/
+double AI_evaluatePlacement (const AI_Weights*, Bitboard *board, BoardFeatures *ftr, int tetrim, const Placement*);
+
+/** Chooses the best placement for the active tetrimino of a game.
+    Returns a boolean : 0 if the tetrimino cannot be placed anywhere **/
+Uint8 AI_bestPlacement (const SimGame*, const AI_Weights*, Placement*);
+
+/** Chooses the best placement for the active tetrimino of a game, taking into account the best placement
+    of the next tetrimino. Slower than AI_bestPlacement but stronger.
+    Returns a boolean : 0 if the tetrimino cannot be placed anywhere **/
+Uint8 AI_bestPlacementWithNext (const SimGame*, const AI_Weights*, Placement*);
+
+/** Plays the placement of the opening book if the position is in it (see book.h), without searching.
+    Otherwise chooses it with AI_bestPlacementWithNext. book can be NULL.
+    Returns a boolean : 0 if the tetrimino cannot be placed anywhere **/
+Uint8 AI_bookPlacement (const OpeningBook*, const SimGame*, const AI_Weights*, Placement*);
+
+/** Plays a whole game with the given weights and stops after maxPieces tetriminoes (0 for no limit).
+    Returns the final score **/
+Uint32 AI_playGame (const AI_Weights*, Uint32 seed, int maxPieces);
+
+#endif // AI_H_INCLUDED
@@ -9,14 +9,120 @@
 #include "linked_list.h"
 #include "game.h"
 #include "animation.h"
+#include "render.h"
+
+/* Composes the last picture of the opening animation : the background, the borders of the playfield,
+   and the panels with their labels and their empty boxes. The game is drawn over it */
+static SDL_Surface* composeHud (Sprites *sprites, SDL_Surface *screen)
+{
+    /* Variables */
+    SDL_Surface *hud = NULL;
+    SDL_Rect part, position;
+    const Uint32 lightgrey = SDL_MapRGB(screen->format, 192, 192, 192);
+    const Uint32 white = SDL_MapRGB(screen->format, 255, 255, 255);
+    const Uint32 black = SDL_MapRGB(screen->format, 0, 0, 0);
+
+    hud = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0, 0, 0, 0));
+    if (hud == NULL)
+        return NULL;
+
+    /* The background panels have slid away from the playfield */
+    SDL_FillRect (hud, NULL, white);
+    part.x = sprites->bg_left->w - (LATERAL_PANEL + BORDER);
+    part.y = 0;
+    part.w = LATERAL_PANEL + BORDER;
+    part.h = sprites->bg_left->h;
+    position.x = 0;
+    position.y = 0;
+    SDL_BlitSurface (sprites->bg_left, &part, hud, &position);
+    position.x = LATERAL_PANEL + BORDER + PLAYFIELD;
+    position.y = 0;
+    SDL_BlitSurface (sprites->bg_right, NULL, hud, &position);
+
+    /* Sets up the left panel */
+    /* Sets up all the borders of the different panels */
+    part.w = BORDER + 4*BLOCK_SIZE + BORDER;
+    part.h = BORDER + BLOCK_SIZE + BORDER;
+    part.x = BLOCK_SIZE;
+    part.y = TXT_SCORE;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.y = SCORE;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.y = TXT_LVL;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.y = LVL;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.y = TXT_NB_LINES;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.y = NB_LINES;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE;
+    part.y = TXT_NEXT;
+    SDL_FillRect (hud, &part, lightgrey);
+    /* Sets up the empty panels */
+    part.w = 4*BLOCK_SIZE;
+    part.h = BLOCK_SIZE;
+    part.x = BLOCK_SIZE + BORDER;
+    part.y = TXT_SCORE + BORDER;
+    SDL_FillRect (hud, &part, white);
+    part.y = SCORE + BORDER;
+    SDL_FillRect (hud, &part, black);
+    part.y = TXT_LVL + BORDER;
+    SDL_FillRect (hud, &part, white);
+    part.y = LVL + BORDER;
+    SDL_FillRect (hud, &part, black);
+    part.y = TXT_NB_LINES + BORDER;
+    SDL_FillRect (hud, &part, white);
+    part.y = NB_LINES + BORDER;
+    SDL_FillRect (hud, &part, black);
+    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE + BORDER;
+    part.y = TXT_NEXT + BORDER;
+    SDL_FillRect (hud, &part, white);
+    /*Sets up the texts */
+    position.x = LATERAL_PANEL/2 - sprites->txt_score->w/2;
+    position.y = TXT_SCORE + BORDER;
+    SDL_BlitSurface (sprites->txt_score, NULL, hud, &position);
+    position.x = LATERAL_PANEL/2 - sprites->txt_lvl->w/2;
+    position.y = TXT_LVL + BORDER;
+    SDL_BlitSurface (sprites->txt_lvl, NULL, hud, &position);
+    position.x = LATERAL_PANEL/2 - sprites->txt_nbLines->w/2;
+    position.y = TXT_NB_LINES + BORDER;
+    SDL_BlitSurface (sprites->txt_nbLines, NULL, hud, &position);
+    position.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + (LATERAL_PANEL)/2 - sprites->txt_next->w/2;
+    position.y = TXT_NEXT + BORDER;
+    SDL_BlitSurface (sprites->txt_next, NULL, hud, &position);
+    /* Draw the case "next tetrim" */
+    /* Draw the borders of the case */
+    part.w = BORDER + 4*BLOCK_SIZE + BORDER;
+    part.h = BORDER + 4*BLOCK_SIZE + BORDER;
+    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + 1*BLOCK_SIZE;
+    part.y = NEXT_CASE;
+    SDL_FillRect (hud, &part, lightgrey);
+    part.w = 4*BLOCK_SIZE;
+    part.h = 4*BLOCK_SIZE;
+    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + 1*BLOCK_SIZE + BORDER;
+    part.y = NEXT_CASE + BORDER;
+    SDL_FillRect (hud, &part, black);
+
+    return hud;
+}
+
+SDL_Surface* loadImage (const char *file)
+{
+    return RND_prescale (RND_toDisplay (IMG_Load (file)), gScale);
+}
 
 Uint8 initSprites (Sprites *sprites, SDL_Surface *screen)
 {
     /* Variables */
     const SDL_Color black = {0, 0, 0};
     const SDL_Color white = {255, 255, 255};
+    const SDL_Color orange = {255, 128, 0};
     const Uint32 lightgrey = SDL_MapRGB (screen->format, 192, 192, 192);
     SDL_Rect position;
+    SDL_Surface *glyphs[10];
+    TTF_Font *pauseFont = NULL;
+    char digit[2] = "0";
     int i, j;
 
     /* initializes all pointers with NULL */
@@ -26,14 +132,17 @@ Uint8 initSprites (Sprites *sprites, SDL_Surface *screen)
     sprites->font = NULL;
     sprites->txt_next = NULL;
     sprites->txt_score = NULL;
-    sprites->score = NULL;
     sprites->txt_lvl = NULL;
-    sprites->lvl = NULL;
     sprites->txt_nbLines = NULL;
-    sprites->nbLines = NULL;
+    sprites->digits.atlas = NULL;
+    sprites->tiles.atlas = NULL;
+    sprites->hud = NULL;
+    sprites->txt_pause = NULL;
+    sprites->txt_gameOver = NULL;
+    RND_init (&sprites->drawn, 0);
 
     /* Loads the wall texture */
-    sprites->texture = IMG_Load("wall.png");
+    sprites->texture = loadImage("wall.png");
     if (sprites->texture == NULL)
     {
         fprintf(stdout, "Texture sprites has not been successfully loaded\n");
@@ -42,8 +151,8 @@ Uint8 initSprites (Sprites *sprites, SDL_Surface *screen)
     /* In order to create the opening animation, the background is divided in a left part and a right part.
         Each part is filled with the wall texture.
         The left part has a border on its right and the right part has a border on its left */
-    sprites->bg_left = SDL_CreateRGBSurface(SDL_HWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0);
-    sprites->bg_right = SDL_CreateRGBSurface(SDL_HWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0);
+    sprites->bg_left = RND_toDisplay (SDL_CreateRGBSurface(SDL_HWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0));
+    sprites->bg_right = RND_toDisplay (SDL_CreateRGBSurface(SDL_HWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0));
     SDL_FillRect (sprites->bg_left, NULL, lightgrey);
     SDL_FillRect (sprites->bg_right, NULL, lightgrey);
     for (j = 0; j*sprites->texture->h < screen->h; j++)
@@ -59,7 +168,7 @@ Uint8 initSprites (Sprites *sprites, SDL_Surface *screen)
     }
 
     /* Load the main font */
-    sprites->main_font = TTF_OpenFont("painting_with_chocolate.ttf", 80);
+    sprites->main_font = TTF_OpenFont("painting_with_chocolate.ttf", 80*gScale);
     if (sprites->main_font == NULL)
     {
         fprintf(stdout, "An error occurred during memory allocation for the main font\n");
@@ -67,17 +176,61 @@ Uint8 initSprites (Sprites *sprites, SDL_Surface *screen)
     }
 
     /* Load the panel texts of the interface */
-    sprites->font = TTF_OpenFont("high_school_usa_sans.ttf", 22);
+    sprites->font = TTF_OpenFont("high_school_usa_sans.ttf", 22*gScale);
     if (sprites->font == NULL)
     {
         fprintf(stdout, "An error occurred during memory allocation for the font\n");
         return 0;
     }
 
-    sprites->txt_score = TTF_RenderText_Shaded (sprites->font, "SCORE", black, white);
-    sprites->txt_lvl = TTF_RenderText_Shaded (sprites->font, "LEVEL", black, white);
-    sprites->txt_next = TTF_RenderText_Shaded(sprites->font, "NEXT", black, white);
-    sprites->txt_nbLines = TTF_RenderText_Shaded (sprites->font, "LINES", black, white);
+    sprites->txt_score = RND_toDisplay (TTF_RenderText_Shaded (sprites->font, "SCORE", black, white));
+    sprites->txt_lvl = RND_toDisplay (TTF_RenderText_Shaded (sprites->font, "LEVEL", black, white));
+    sprites->txt_next = RND_toDisplay (TTF_RenderText_Shaded(sprites->font, "NEXT", black, white));
+    sprites->txt_nbLines = RND_toDisplay (TTF_RenderText_Shaded (sprites->font, "LINES", black, white));
+
+    /* Render the digits of the panels once */
+    for (i = 0; i < 10; i++)
+    {
+        digit[0] = '0' + i;
+        glyphs[i] = TTF_RenderText_Shaded (sprites->font, digit, white, black);
+    }
+    j = RND_initDigits (&sprites->digits, glyphs);
+    for (i = 0; i < 10; i++)
+        SDL_FreeSurface (glyphs[i]);
+    if (!j)
+    {
+        fprintf(stdout, "An error occurred during the rendering of the digits\n");
+        return 0;
+    }
+
+    /* Fill the tiles of the cells of the playfield and of the case "next" */
+    if (!RND_initTiles (&sprites->tiles, screen->format))
+        return 0;
+
+    /* Compose the HUD once, it is used by all the games */
+    sprites->hud = composeHud (sprites, screen);
+    if (sprites->hud == NULL)
+    {
+        fprintf(stdout, "An error occurred during memory allocation for the HUD\n");
+        return 0;
+    }
+    sprites->drawn.layer = sprites->hud;
+
+    /* Render the overlays once, so pausing does not load anything */
+    pauseFont = TTF_OpenFont ("high_school_usa_sans.ttf", 60*gScale);
+    if (pauseFont == NULL)
+    {
+        fprintf(stdout, "An error occurred during memory allocation for the font of the pause\n");
+        return 0;
+    }
+    sprites->txt_pause = RND_toDisplay (TTF_RenderText_Blended (pauseFont, "PAUSE", black));
+    TTF_CloseFont (pauseFont);
+    sprites->txt_gameOver = RND_toDisplay (TTF_RenderText_Blended (sprites->main_font, "GAME OVER", orange));
+    if (sprites->txt_pause == NULL || sprites->txt_gameOver == NULL)
+    {
+        fprintf(stdout, "An error occurred during the rendering of the overlays\n");
+        return 0;
+    }
 
     return 1;
 }
@@ -93,16 +246,20 @@ void freeSprites (Sprites *sprites)
     SDL_FreeSurface (sprites->txt_score);
     SDL_FreeSurface (sprites->txt_lvl);
     SDL_FreeSurface (sprites->txt_nbLines);
+    RND_freeDigits (&sprites->digits);
+    RND_freeTiles (&sprites->tiles);
+    SDL_FreeSurface (sprites->hud);
+    SDL_FreeSurface (sprites->txt_pause);
+    SDL_FreeSurface (sprites->txt_gameOver);
 }
 
-void anim_opening (SDL_Surface *screen, Sprites *sprites)
+void anim_opening (RND_Backend *backend, Sprites *sprites)
 {
     /* Variables */
+    SDL_Surface *screen = backend->screen;
     SDL_Rect part, position;
     int delay = 0; /* At the end of the animation, its value will be half the wide of the playfield plus wide of a border */
-    const Uint32 lightgrey = SDL_MapRGB(screen->format, 192, 192, 192);
     const Uint32 white = SDL_MapRGB(screen->format, 255, 255, 255);
-    const Uint32 black = SDL_MapRGB(screen->format, 0, 0, 0);
 
     /* Blit both background panels */
     position.x = 0;
@@ -115,7 +272,7 @@ void anim_opening (SDL_Surface *screen, Sprites *sprites)
     position.x = WINDOW_WIDTH/2;
     SDL_BlitSurface (sprites->bg_right, &part, screen, &position);
 
-    SDL_Flip(screen);
+    RND_flip (backend);
     SDL_Delay (300);
 
     for (delay = 0; delay <= (PLAYFIELD+2*BORDER)/2; delay += (PLAYFIELD+2*BORDER)/10)
@@ -132,78 +289,15 @@ void anim_opening (SDL_Surface *screen, Sprites *sprites)
         position.x = WINDOW_WIDTH/2 + delay - (BORDER-part.x);
         SDL_BlitSurface (sprites->bg_right, &part, screen, &position);
 
-        SDL_Flip (screen);
+        RND_flip (backend);
         SDL_Delay(41);
     }
 
-    /* Sets up the left panel */
-    /* Sets up all the borders of the different panels */
-    part.w = BORDER + 4*BLOCK_SIZE + BORDER;
-    part.h = BORDER + BLOCK_SIZE + BORDER;
-    part.x = BLOCK_SIZE;
-    part.y = TXT_SCORE;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.y = SCORE;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.y = TXT_LVL;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.y = LVL;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.y = TXT_NB_LINES;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.y = NB_LINES;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE;
-    part.y = TXT_NEXT;
-    SDL_FillRect (screen, &part, lightgrey);
-    /* Sets up the empty panels */
-    part.w = 4*BLOCK_SIZE;
-    part.h = BLOCK_SIZE;
-    part.x = BLOCK_SIZE + BORDER;
-    part.y = TXT_SCORE + BORDER;
-    SDL_FillRect (screen, &part, white);
-    part.y = SCORE + BORDER;
-    SDL_FillRect (screen, &part, black);
-    part.y = TXT_LVL + BORDER;
-    SDL_FillRect (screen, &part, white);
-    part.y = LVL + BORDER;
-    SDL_FillRect (screen, &part, black);
-    part.y = TXT_NB_LINES + BORDER;
-    SDL_FillRect (screen, &part, white);
-    part.y = NB_LINES + BORDER;
-    SDL_FillRect (screen, &part, black);
-    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE + BORDER;
-    part.y = TXT_NEXT + BORDER;
-    SDL_FillRect (screen, &part, white);
-    /*Sets up the texts */
-    position.x = LATERAL_PANEL/2 - sprites->txt_score->w/2;
-    position.y = TXT_SCORE + BORDER;
-    SDL_BlitSurface (sprites->txt_score, NULL, screen, &position);
-    position.x = LATERAL_PANEL/2 - sprites->txt_lvl->w/2;
-    position.y = TXT_LVL + BORDER;
-    SDL_BlitSurface (sprites->txt_lvl, NULL, screen, &position);
-    position.x = LATERAL_PANEL/2 - sprites->txt_nbLines->w/2;
-    position.y = TXT_NB_LINES + BORDER;
-    SDL_BlitSurface (sprites->txt_nbLines, NULL, screen, &position);
-    position.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + (LATERAL_PANEL)/2 - sprites->txt_next->w/2;
-    position.y = TXT_NEXT + BORDER;
-    SDL_BlitSurface (sprites->txt_next, NULL, screen, &position);
-    /* Draw the case "next tetrim" */
-    /* Draw the borders of the case */
-    part.w = BORDER + 4*BLOCK_SIZE + BORDER;
-    part.h = BORDER + 4*BLOCK_SIZE + BORDER;
-    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + 1*BLOCK_SIZE;
-    part.y = NEXT_CASE;
-    SDL_FillRect (screen, &part, lightgrey);
-    part.w = 4*BLOCK_SIZE;
-    part.h = 4*BLOCK_SIZE;
-    part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + 1*BLOCK_SIZE + BORDER;
-    part.y = NEXT_CASE + BORDER;
-    SDL_FillRect (screen, &part, black);
-
+    /* The first frame of the game draws the HUD, that is the last picture of the animation, under the game */
+    RND_invalidate (&sprites->drawn);
 }
 
-Uint32 clearCompleteLines (SDL_Surface *screen, Sprites *sprites, GameElements* gameElm)
+Uint32 clearCompleteLines (RND_Backend *backend, Sprites *sprites, GameElements* gameElm)
 {
     int i, j, k;
     int completeLine[NB_BLOCK_Y] = {0}; /* Array of booleans : 1 if the line is complete, 0 otherwise */
@@ -233,7 +327,7 @@ Uint32 clearCompleteLines (SDL_Surface *screen, Sprites *sprites, GameElements*
 
     }
 
-    updateScreen(screen, sprites, gameElm);
+    updateScreen(backend, sprites, gameElm);
     actualTime = SDL_GetTicks();
     lastTime = actualTime;
     while (actualTime - lastTime < 100)
@@ -271,233 +365,102 @@ Uint32 clearCompleteLines (SDL_Surface *screen, Sprites *sprites, GameElements*
         }
     }
 
-    updateScreen (screen, sprites, gameElm);
+    updateScreen (backend, sprites, gameElm);
 
     return nbCompleteLines;
 }
 
-void updateScreen (SDL_Surface *screen, Sprites *sprites, GameElements *gameElm)
+void updateScreen (RND_Backend *backend, Sprites *sprites, GameElements *gameElm)
 {
     /* Variables */
+    SDL_Surface *screen = backend->screen;
     int i, j;
-    Uint32 tetrimColor = 0;
+    int tetrimTile, nextTile; /* Tiles of the active tetrimino and of the next one */
     SDL_Rect part;
-    SDL_Rect position;
-    double t = 0.000, bleachFactor = 0.000; /* Used to make the active tetrimino blink */
-    char data[11];
-
-    /* Color definition */
-    /* Static colors */
-    static const SDL_Color txt_white = {255, 255, 255};
-    static const SDL_Color txt_black = {0, 0, 0};
-    static const Uint32 white = SDL_MapRGB(screen->format, 255, 255, 255);
-    static const Uint32 black = SDL_MapRGB(screen->format, 0, 0, 0);
-    static const Uint32 grey = SDL_MapRGB(screen->format, 128, 128, 128);
-    static const Uint32 yellow = SDL_MapRGB (screen->format, 231, 231, 24);
-    static const Uint32 red = SDL_MapRGB (screen->format, 215, 20, 20);
-    static const Uint32 green = SDL_MapRGB (screen->format, 24, 128, 24);
-    static const Uint32 orange = SDL_MapRGB (screen->format, 231, 128, 24);
-    static const Uint32 purple = SDL_MapRGB (screen->format, 128, 64, 128);
-    static const Uint32 blue = SDL_MapRGB (screen->format, 32, 32, 160);
-    static const Uint32 cyan = SDL_MapRGB (screen->format, 40, 224, 166);
-
-    /* The color of the active tetrimino changes every time to make it blink */
-    /* The following code defines a bleach factor between 0.15 and 0.75 so the color of the active tetromino
-       is bleached from 25% to 75% then from 75% to 25% */
-    t = SDL_GetTicks()%1000;
-    if (t < 500)
-        bleachFactor = (t+250)/1000;
-    else
-        bleachFactor = (1250-t)/1000;
-    switch (gameElm->actualTetrim)
-    {
-    case TETRIM_O:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(24*bleachFactor), 255-(24*bleachFactor), 255-(231*bleachFactor));
-        break;
-    case TETRIM_Z:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(20*bleachFactor), 255-(235*bleachFactor), 255-(235*bleachFactor));
-        break;
-    case TETRIM_I:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(215*bleachFactor), 255-(31*bleachFactor), 255-(89*bleachFactor));
-        break;
-    case TETRIM_S:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(231*bleachFactor), 255-(128*bleachFactor), 255-(231*bleachFactor));
-        break;
-    case TETRIM_J:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(223*bleachFactor), 255-(223*bleachFactor), 255-(95*bleachFactor));
-        break;
-    case TETRIM_T:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(128*bleachFactor), 255-(191*bleachFactor), 255-(128*bleachFactor));
-        break;
-    case TETRIM_L:
-        tetrimColor = SDL_MapRGB (screen->format, 255-(24*bleachFactor), 255-(128*bleachFactor), 255-(231*bleachFactor));
-        break;
-    default:
-        break;
-    }
+    RND_Screen *drawn = &sprites->drawn;
+    const Uint32 values[RND_NB_PANELS] = {gameElm->score, (Uint32)gameElm->level, (Uint32)gameElm->nbCompleteLines};
+    const int panelLines[RND_NB_PANELS] = {SCORE, LVL, NB_LINES};
+    const Uint32 black = SDL_MapRGB (screen->format, 0, 0, 0);
+
+    /* After an invalidation, the HUD is drawn first */
+    RND_begin (drawn, screen);
+
+    /* The tile of the active tetrimino changes every time to make it blink */
+    tetrimTile = RND_blinkTile (gameElm->actualTetrim, SDL_GetTicks());
+    nextTile = RND_tetrimTile (gameElm->nextTetrim);
 
         /* Updates the left panel */
-        /* Updates the game data */
+        /* Updates the game data : score, level and number of complete lines, only if they have changed,
+           with the digits rendered by initSprites */
     part.x = BLOCK_SIZE + BORDER;
     part.w = 4*BLOCK_SIZE;
     part.h = BLOCK_SIZE;
-        /* Updates the score */
-    part.y = SCORE + BORDER;
-    SDL_FillRect (screen, &part, black);
-    sprintf(data, "%d", gameElm->score);
-    sprites->score = TTF_RenderText_Shaded (sprites->font, data, txt_white, txt_black);
-    position.x = LATERAL_PANEL/2 - sprites->score->w/2;
-    position.y = SCORE + BORDER;
-    SDL_BlitSurface (sprites->score, NULL, screen, &position);
-        /* Updates the level */
-    part.y = LVL + BORDER;
-    SDL_FillRect (screen, &part, black);
-    sprintf(data, "%d", gameElm->level);
-    sprites->lvl = TTF_RenderText_Shaded (sprites->font, data, txt_white, txt_black);
-    position.x = LATERAL_PANEL/2 - sprites->lvl->w/2;
-    position.y = LVL + BORDER;
-    SDL_BlitSurface (sprites->lvl, NULL, screen, &position);
-        /* Updates the number of complete lines */
-    part.y = NB_LINES + BORDER;
-    SDL_FillRect (screen, &part, black);
-    sprintf(data, "%d", gameElm->nbCompleteLines);
-    sprites->nbLines = TTF_RenderText_Shaded (sprites->font, data, txt_white, txt_black);
-    position.x = LATERAL_PANEL/2 - sprites->nbLines->w/2;
-    position.y = NB_LINES + BORDER;
-    SDL_BlitSurface (sprites->nbLines, NULL, screen, &position);
-
-        /* Updates the playfield */
-    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    for (i = 0; i < RND_NB_PANELS; i++)
     {
-        for (i = 0; i < NB_BLOCK_X; i++)
+        if (RND_setPanel (drawn, i, values[i]))
         {
-            part.x = LATERAL_PANEL + BORDER + i*BLOCK_SIZE + GRID_WIDE;
-            part.w = BLOCK_SIZE - 2*GRID_WIDE;
-            part.h = BLOCK_SIZE - 2*GRID_WIDE;
-            part.y = j*BLOCK_SIZE + GRID_WIDE - (FIRST_LINE*BLOCK_SIZE);
-            switch (gameElm->gMap[i][j])
-            {
-                case BLOCK_VOID:
-                    SDL_FillRect (screen, &part, white);
-                    break;
-                case BLOCK_CYAN:
-                    SDL_FillRect (screen, &part, cyan);
-                    break;
-                case BLOCK_GREEN:
-                    SDL_FillRect (screen, &part, green);
-                    break;
-                case BLOCK_ORANGE:
-                    SDL_FillRect (screen, &part, orange);
-                    break;
-                case BLOCK_PURPLE:
-                    SDL_FillRect (screen, &part, purple);
-                    break;
-                case BLOCK_BLUE:
-                    SDL_FillRect (screen, &part, blue);
-                    break;
-                case BLOCK_YELLOW:
-                    SDL_FillRect (screen, &part, yellow);
-                    break;
-                case BLOCK_RED:
-                    SDL_FillRect (screen, &part, red);
-                    break;
-                case BLOCK_ACTIVE:
-                    SDL_FillRect (screen, &part, tetrimColor);
-                    break;
-            }
+            part.y = panelLines[i] + BORDER;
+            RND_fill (drawn, screen, &part, black);
+            RND_drawNumber (drawn, screen, &sprites->digits, values[i], LATERAL_PANEL/2, panelLines[i] + BORDER);
         }
     }
 
+        /* Updates the playfield : only the cells whose tile has changed are drawn.
+           The tile of a locked block is its value in gMap */
+    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+            RND_setCell (drawn, screen, &sprites->tiles, i, j,
+                         (gameElm->gMap[i][j] == BLOCK_ACTIVE) ? tetrimTile : (int)gameElm->gMap[i][j]);
+    }
+
         /* Sets up the right pannel */
         /* Fills the case "next" with the tetrimino */
-    part.w = BLOCK_SIZE - 2*GRID_WIDE;
-    part.h = BLOCK_SIZE - 2*GRID_WIDE;
     for (j = 0; j < 4; j++)
     {
-        part.y = NEXT_CASE + BORDER + j*BLOCK_SIZE + GRID_WIDE;
         for (i = 0; i < 4; i++)
-        {
-            part.x = LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE + BORDER + i*BLOCK_SIZE + GRID_WIDE;
-            switch (gameElm->nextTetrimMap[i][j])
-            {
-                case BLOCK_VOID:
-                    SDL_FillRect (screen, &part, black);
-                    break;
-                case BLOCK_ACTIVE:
-                    switch (gameElm->nextTetrim)
-                    {
-                    case TETRIM_O:
-                        SDL_FillRect (screen, &part, yellow);
-                        break;
-                    case TETRIM_Z:
-                        SDL_FillRect (screen, &part, red);
-                        break;
-                    case TETRIM_I:
-                        SDL_FillRect (screen, &part, cyan);
-                        break;
-                    case TETRIM_S:
-                        SDL_FillRect (screen, &part, green);
-                        break;
-                    case TETRIM_J:
-                        SDL_FillRect (screen, &part, blue);
-                        break;
-                    case TETRIM_T:
-                        SDL_FillRect (screen, &part, purple);
-                        break;
-                    case TETRIM_L:
-                        SDL_FillRect (screen, &part, orange);
-                        break;
-                    default:
-                        SDL_FillRect (screen, &part, grey);
-                        break;
-                    }
-                    break;
-            }
-        }
+            RND_setNextCell (drawn, screen, &sprites->tiles, i, j,
+                             (gameElm->nextTetrimMap[i][j] == BLOCK_ACTIVE) ? nextTile : RND_TILE_BLACK);
     }
 
-    SDL_Flip (screen);
-
-    SDL_FreeSurface (sprites->score);
-    SDL_FreeSurface (sprites->lvl);
-    SDL_FreeSurface (sprites->nbLines);
-
+    RND_present (drawn, backend);
 }
 
-int menuControls (SDL_Surface *screen, SDL_Surface *background)
+int menuControls (RND_Backend *backend, SDL_Surface *background)
 {
+    SDL_Surface *screen = backend->screen;
     int continueProg = 1, continueControls = 1; /* Booleans */
     SDL_Event event;
     SDL_Surface *controls_bg = NULL, *external_rect = NULL, *internal_rect = NULL;
     SDL_Surface *keyboard = NULL;
-    TTF_Font *street36 = TTF_OpenFont ("high_school_usa_sans.ttf", 36);
-    TTF_Font *street18 = TTF_OpenFont ("high_school_usa_sans.ttf", 18);
+    TTF_Font *street36 = TTF_OpenFont ("high_school_usa_sans.ttf", 36*gScale);
+    TTF_Font *street18 = TTF_OpenFont ("high_school_usa_sans.ttf", 18*gScale);
     SDL_Color txt_white = {255, 255, 255};
     SDL_Surface *controls = NULL, *text = NULL;
     SDL_Rect part, position;
     int i;
 
     /* Load the keyboard image */
-    keyboard = IMG_Load("keyboard.png");
+    keyboard = loadImage("keyboard.png");
 
     /* Set up the background using the title screen's background as a model*/
-    controls_bg = SDL_CreateRGBSurface (SDL_HWSURFACE, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0, 0, 0, 0);
+    controls_bg = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0, 0, 0, 0));
     SDL_BlitSurface (background, NULL, controls_bg, NULL);
 
-    external_rect = SDL_CreateRGBSurface (SDL_HWSURFACE, WINDOW_WIDTH-2*BLOCK_SIZE, WINDOW_HEIGHT-2*BLOCK_SIZE, 32, 0, 0, 0, 0);
+    external_rect = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, WINDOW_WIDTH-2*BLOCK_SIZE, WINDOW_HEIGHT-2*BLOCK_SIZE, 32, 0, 0, 0, 0));
     SDL_FillRect ( external_rect, NULL, SDL_MapRGB(external_rect->format, 192, 192, 192) );
     position.x = BLOCK_SIZE;
     position.y = BLOCK_SIZE;
     SDL_BlitSurface (external_rect, NULL, controls_bg, &position);
 
-    internal_rect = SDL_CreateRGBSurface (SDL_HWSURFACE, external_rect->w-2*BORDER, external_rect->h-2*BORDER, 32, 0, 0, 0, 0);
+    internal_rect = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, external_rect->w-2*BORDER, external_rect->h-2*BORDER, 32, 0, 0, 0, 0));
     SDL_FillRect ( internal_rect, NULL, SDL_MapRGB(internal_rect->format, 0, 0, 0) );
     position.x += BORDER;
     position.y += BORDER;
     SDL_BlitSurface (internal_rect, NULL, controls_bg, &position);
 
     /* Prints controls screen title */
-    controls = TTF_RenderText_Blended (street36, "CONTROLS", txt_white);
+    controls = RND_toDisplay (TTF_RenderText_Blended (street36, "CONTROLS", txt_white));
     position.x += internal_rect->w/2 - controls->w/2;
     position.y += BLOCK_SIZE;
     SDL_BlitSurface (controls, NULL, controls_bg, &position);
@@ -510,28 +473,28 @@ int menuControls (SDL_Surface *screen, SDL_Surface *background)
         switch (i)
         {
         case 0:
-            part.x = 565;
-            part.y = 168;
-            text = TTF_RenderText_Blended (street18, "Rotate the tetrim", txt_white);
+            part.x = 565*gScale;
+            part.y = 168*gScale;
+            text = RND_toDisplay (TTF_RenderText_Blended (street18, "Rotate the tetrim", txt_white));
             break;
         case 1:
-            part.x = 533;
-            part.y = 201;
-            text = TTF_RenderText_Blended (street18, "Move the tetrim to the left", txt_white);
+            part.x = 533*gScale;
+            part.y = 201*gScale;
+            text = RND_toDisplay (TTF_RenderText_Blended (street18, "Move the tetrim to the left", txt_white));
             break;
         case 2:
-            part.x = 599;
-            part.y = 201;
-            text = TTF_RenderText_Blended (street18, "Move the tetrim to the right", txt_white);
+            part.x = 599*gScale;
+            part.y = 201*gScale;
+            text = RND_toDisplay (TTF_RenderText_Blended (street18, "Move the tetrim to the right", txt_white));
             break;
         case 3:
-            part.x = 565;
-            part.y = 201;
-            text = TTF_RenderText_Blended (street18, "Hard drop activation : make the tetrim fall faster and earn points", txt_white);
+            part.x = 565*gScale;
+            part.y = 201*gScale;
+            text = RND_toDisplay (TTF_RenderText_Blended (street18, "Hard drop activation : make the tetrim fall faster and earn points", txt_white));
             break;
         }
-        part.w = 34;
-        part.h = 34;
+        part.w = 34*gScale;
+        part.h = 34*gScale;
         position.x = 2*BLOCK_SIZE + BORDER;
         position.y += 2*BLOCK_SIZE;
         SDL_BlitSurface (keyboard, &part, controls_bg, &position);
@@ -543,7 +506,7 @@ int menuControls (SDL_Surface *screen, SDL_Surface *background)
 
     /* Update the screen */
     SDL_BlitSurface (controls_bg, NULL, screen, NULL);
-    SDL_Flip(screen);
+    RND_flip (backend);
 
     /* Wait for a reaction from the player */
     while (continueProg && continueControls)
@@ -569,44 +532,24 @@ int menuControls (SDL_Surface *screen, SDL_Surface *background)
     return continueProg;
 }
 
-int pause (SDL_Surface *screen)
+int pause (RND_Backend *backend, Sprites *sprites)
 {
     int continueProg = 1;
     SDL_Event event;
-    SDL_Surface *background = NULL, *pause = NULL;
-    TTF_Font *font = NULL;
-    SDL_Color black = {0, 0, 0};
-    SDL_Rect position = {0};
-
-    /* Make a copy of the actual screen */
-    background = SDL_CreateRGBSurface(SDL_HWSURFACE, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0, 0, 0, 0);
-    SDL_BlitSurface (screen, NULL, background, NULL);
-
-    /* Print pause text */
-    font = TTF_OpenFont ("high_school_usa_sans.ttf", 60);
-    pause = TTF_RenderText_Blended (font, "PAUSE", black);
-    position.x = WINDOW_WIDTH/2 - pause->w/2;
-    position.y = WINDOW_HEIGHT/2 - pause->h/2;
-    SDL_BlitSurface (pause, NULL, screen, &position);
-    SDL_Flip(screen);
+
+    /* Print pause text over the last frame */
+    RND_showOverlay (&sprites->drawn, backend, sprites->txt_pause);
 
     /* Wait for a reaction from the player */
-    while (event.type != SDL_KEYDOWN && event.type != SDL_QUIT)
+    do
     {
         SDL_WaitEvent (&event);
-    }
+    } while (event.type != SDL_KEYDOWN && event.type != SDL_QUIT);
     if (event.type == SDL_QUIT)
         continueProg = 0;
 
-    /* Refresh the screen */
-    SDL_BlitSurface (background, NULL, screen, NULL);
-    SDL_Flip(screen);
-
-    /* Free Surfaces and font */
-    TTF_CloseFont (font);
-    SDL_FreeSurface (pause);
-    SDL_FreeSurface (screen);
+    /* The game is drawn again under the text at the next frame */
+    RND_hideOverlay (&sprites->drawn, backend);
 
     return continueProg;
 }
-
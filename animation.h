@@ -12,16 +12,17 @@
 #include "constants.h"
 #include "linked_list.h"
 #include "game.h"
+#include "render.h"
 
 /* y position for the different elements of the lateral panel from the top to the bottom */
 #define TXT_NEXT        BLOCK_SIZE
 #define NEXT_CASE       TXT_NEXT + BORDER + 1*BLOCK_SIZE + BORDER + BLOCK_SIZE/4
-#define TXT_SCORE       NEXT_CASE + BORDER + 4*BLOCK_SIZE + BORDER + 88
-#define SCORE           TXT_SCORE + BORDER + BLOCK_SIZE + BORDER + 7
-#define TXT_LVL         SCORE + BORDER + BLOCK_SIZE + BORDER + 7
-#define LVL             TXT_LVL + BORDER + BLOCK_SIZE + BORDER + 7
-#define TXT_NB_LINES    LVL + BORDER + BLOCK_SIZE + BORDER + 7
-#define NB_LINES        TXT_NB_LINES + BORDER + BLOCK_SIZE + 7
+#define TXT_SCORE       NEXT_CASE + BORDER + 4*BLOCK_SIZE + BORDER + 88*gScale
+#define SCORE           TXT_SCORE + BORDER + BLOCK_SIZE + BORDER + 7*gScale
+#define TXT_LVL         SCORE + BORDER + BLOCK_SIZE + BORDER + 7*gScale
+#define LVL             TXT_LVL + BORDER + BLOCK_SIZE + BORDER + 7*gScale
+#define TXT_NB_LINES    LVL + BORDER + BLOCK_SIZE + BORDER + 7*gScale
+#define NB_LINES        TXT_NB_LINES + BORDER + BLOCK_SIZE + 7*gScale
 
 
 typedef struct Sprites /* Contains all the game sprites and the font used for the interface */
@@ -33,33 +34,42 @@ typedef struct Sprites /* Contains all the game sprites and the font used for th
     TTF_Font *font;
     SDL_Surface *txt_next;
     SDL_Surface *txt_score;
-    SDL_Surface *score;
     SDL_Surface *txt_lvl;
-    SDL_Surface *lvl;
     SDL_Surface *txt_nbLines;
-    SDL_Surface *nbLines;
+    RND_Digits digits; /* Digits of the score, the level and the number of lines, in white on black */
+    RND_Tiles tiles; /* Cells of the playfield and of the case "next" */
+    SDL_Surface *hud; /* Static part of the window during a game : background, borders, labels and empty boxes */
+    SDL_Surface *txt_pause; /* Overlays shown over the game (see RND_showOverlay) */
+    SDL_Surface *txt_gameOver;
+    RND_Screen drawn; /* What is on the screen, so only the changes are drawn */
 } Sprites;
 
 
+/** Loads an image in the pixel format of the screen (see RND_toDisplay), enlarged to the scale of the window
+    (see RND_prescale). Returns NULL if it cannot be loaded **/
+SDL_Surface* loadImage (const char *file);
+
 /** Initializes the structure Sprites.
-    Takes SDL_Surface *screen in param since it needs the information about the pixel format **/
+    Takes SDL_Surface *screen in param since it needs the information about the pixel format.
+    All the surfaces are converted to the format of the screen, so they are blitted without conversion **/
 Uint8 initSprites (Sprites*, SDL_Surface *screen);
 
 /** Frees the structure Sprites. **/
 void freeSprites (Sprites*);
 
-/** Manages the opening animation **/
-void anim_opening(SDL_Surface* screen, Sprites*);
+/** Manages the opening animation. It ends on the HUD, drawn with the game by the next updateScreen **/
+void anim_opening(RND_Backend*, Sprites*);
 
 /** Clears the completed lines with a quick animation
     Returns the number of lines that has been cleared **/
-Uint32 clearCompleteLines (SDL_Surface *screen, Sprites*, GameElements*);
+Uint32 clearCompleteLines (RND_Backend*, Sprites*, GameElements*);
 
-/** Generates the pictures for the screen **/
-void updateScreen (SDL_Surface *screen, Sprites*, GameElements*);
+/** Generates the pictures for the screen. Only the cells and the panels that have changed are drawn and presented **/
+void updateScreen (RND_Backend*, Sprites*, GameElements*);
 
-int menuControls (SDL_Surface *screen, SDL_Surface *background);
+int menuControls (RND_Backend*, SDL_Surface *background);
 
-int pause (SDL_Surface*);
+/** Shows the pause over the game until a key is pressed. Returns a boolean : 0 if the player wants to quit the program **/
+int pause (RND_Backend*, Sprites*);
 
 #endif // ANIMATION_H_INCLUDED
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+
+/* Rotation state 0 of each tetrimino, as painted by putTetrim and put in the playfield by generateNewTetrim */
+static const Uint16 spawnShapes[7][4] =
+{
+    {0x0, 0xF, 0x0, 0x0}, /* TETRIM_I */
+    {0x3, 0x3, 0x0, 0x0}, /* TETRIM_O */
+    {0x2, 0x7, 0x0, 0x0}, /* TETRIM_T */
+    {0x4, 0x7, 0x0, 0x0}, /* TETRIM_L */
+    {0x1, 0x7, 0x0, 0x0}, /* TETRIM_J */
+    {0x3, 0x6, 0x0, 0x0}, /* TETRIM_Z */
+    {0x6, 0x3, 0x0, 0x0}  /* TETRIM_S */
+};
+
+static const int dimensions[7] = {4, 2, 3, 3, 3, 3, 3};
+
+static PieceShape shapes[7][BB_NB_ROTATIONS];
+static Uint8 shapesReady = 0; /* Boolean */
+
+/* Computes the extents of a shape */
+static void measureShape (PieceShape *shape)
+{
+    int k, l;
+
+    shape->top = 4;
+    shape->bottom = -1;
+    shape->left = 4;
+    shape->right = -1;
+
+    for (l = 0; l < 4; l++)
+    {
+        if (shape->rows[l] == 0)
+            continue;
+        if (shape->top > l)
+            shape->top = l;
+        shape->bottom = l;
+        for (k = 0; k < 4; k++)
+        {
+            if (shape->rows[l] & (1 << k))
+            {
+                if (shape->left > k)
+                    shape->left = k;
+                if (shape->right < k)
+                    shape->right = k;
+            }
+        }
+    }
+}
+
+/* Builds the 4 rotation states of every tetrimino.
+   A rotation turns the square of the tetrimino clockwise, as tetrimRotates does */
+static void initShapes ()
+{
+    int tetrim, rotation, k, l, dim;
+
+    for (tetrim = 0; tetrim < 7; tetrim++)
+    {
+        dim = dimensions[tetrim];
+        for (l = 0; l < 4; l++)
+            shapes[tetrim][0].rows[l] = spawnShapes[tetrim][l];
+        measureShape (&shapes[tetrim][0]);
+
+        for (rotation = 1; rotation < BB_NB_ROTATIONS; rotation++)
+        {
+            for (l = 0; l < 4; l++)
+                shapes[tetrim][rotation].rows[l] = 0;
+            for (l = 0; l < dim; l++)
+            {
+                for (k = 0; k < dim; k++)
+                {
+                    if (shapes[tetrim][rotation-1].rows[l] & (1 << k))
+                        shapes[tetrim][rotation].rows[k] |= 1 << (dim-1-l);
+                }
+            }
+            measureShape (&shapes[tetrim][rotation]);
+        }
+    }
+
+    shapesReady = 1;
+}
+
+void BB_clear (Bitboard *board)
+{
+    int j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+        board->rows[j] = 0;
+    for (j = NB_BLOCK_Y; j < BB_NB_ROWS; j++)
+        board->rows[j] = BB_FULL_ROW;
+}
+
+void BB_fromGameMap (Bitboard *board, Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y])
+{
+    int i, j;
+
+    BB_clear (board);
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            if (gMap[i][j] != BLOCK_VOID && gMap[i][j] != BLOCK_ACTIVE)
+                board->rows[j] |= 1 << i;
+        }
+    }
+}
+
+const PieceShape* BB_getShape (int tetrim, int rotation)
+{
+    if (!shapesReady)
+        initShapes ();
+
+    return &shapes[tetrim][rotation & 3];
+}
+
+int BB_spawnColumn (int tetrim)
+{
+    return (tetrim == TETRIM_O) ? NB_BLOCK_X/2-1 : NB_BLOCK_X/2-2;
+}
+
+Uint8 BB_collides (const Bitboard *board, int tetrim, int rotation, int x, int y)
+{
+    const PieceShape *shape = BB_getShape (tetrim, rotation);
+    int l;
+
+    /* Walls */
+    if (x + shape->left < 0 || x + shape->right >= NB_BLOCK_X)
+        return 1;
+
+    /* Floor and stack. The lines above the playfield are considered empty */
+    for (l = shape->top; l <= shape->bottom; l++)
+    {
+        if (y + l < 0)
+            continue;
+        if (y + l >= BB_NB_ROWS || (board->rows[y+l] & BB_shiftRow (shape->rows[l], x)))
+            return 1;
+    }
+
+    return 0;
+}
+
+int BB_dropRow (const Bitboard *board, int tetrim, int rotation, int x)
+{
+    int y = FIRST_LINE;
+
+    if (BB_collides (board, tetrim, rotation, x, y))
+        return -1;
+
+    while (!BB_collides (board, tetrim, rotation, x, y+1))
+        y++;
+
+    return y;
+}
+
+void BB_putPiece (Bitboard *board, int tetrim, int rotation, int x, int y)
+{
+    const PieceShape *shape = BB_getShape (tetrim, rotation);
+    int l;
+
+    for (l = shape->top; l <= shape->bottom; l++)
+    {
+        if (y + l >= 0 && y + l < NB_BLOCK_Y)
+            board->rows[y+l] |= BB_shiftRow (shape->rows[l], x);
+    }
+}
+
+int BB_clearLines (Bitboard *board)
+{
+    int j, k;
+
+    /* Copies each incomplete line on the lowest free line, starting from the bottom */
+    for (j = NB_BLOCK_Y-1, k = NB_BLOCK_Y-1; j >= 0; j--)
+    {
+        if (board->rows[j] != BB_FULL_ROW)
+        {
+            board->rows[k] = board->rows[j];
+            k--;
+        }
+    }
+
+    /* k+1 lines have been removed, so the k+1 lines at the top are empty */
+    for (j = k; j >= 0; j--)
+        board->rows[j] = 0;
+
+    return k+1;
+}
@@ -0,0 +1,97 @@
+/** bitboard.h and bitboard.cpp manage a compact copy of the playfield
+
+    gMap stores one Uint32 per cell, which is convenient for the display but far too heavy when
+    the playfield has to be examined thousands of times per second (AI, analytics...).
+    A Bitboard stores each line of the playfield in a Uint16 : the bit i is set if the cell (i, j) is occupied.
+    The lines are indexed like the second dimension of gMap : line 0 is the top of the hidden part,
+    line NB_BLOCK_Y-1 is the bottom of the playfield.
+    The lines after NB_BLOCK_Y-1 are always full so they act as the floor of the playfield.
+**/
+
+#ifndef BITBOARD_H_INCLUDED
+#define BITBOARD_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+
+#define BB_NB_ROWS      32 /* Number of lines stored. 22 lines of playfield followed by 10 lines of floor */
+#define BB_FULL_ROW     ((1 << NB_BLOCK_X) - 1)
+#define BB_NB_ROTATIONS 4
+
+typedef struct Bitboard Bitboard;
+typedef struct PieceShape PieceShape;
+
+struct Bitboard
+{
+    Uint16 rows[BB_NB_ROWS];
+};
+
+/* Shape of a tetrimino in a given rotation state.
+   The shape is described in the virtual square of the tetrimino (see block1 in game.h) :
+   rows[l] contains the blocks of the line l of the square, the bit k being the column k of the square */
+struct PieceShape
+{
+    Uint16 rows[4];
+    int top, bottom; /* First and last non-empty lines of the square */
+    int left, right; /* First and last non-empty columns of the square */
+};
+
+
+/** Returns the number of bits set in a line **/
+static inline int BB_popcount (Uint32 x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(x);
+#else
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    return (((x + (x >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#endif
+}
+
+/** Moves a line of the square of a tetrimino to the column x of the playfield **/
+static inline Uint16 BB_shiftRow (Uint16 row, int x)
+{
+    return (x >= 0) ? (Uint16)(row << x) : (Uint16)(row >> -x);
+}
+
+/** Pseudo-random generator (xorshift32). Same seed, same sequence, whatever the platform.
+    The state must never be 0 **/
+static inline Uint32 BB_random (Uint32 *state)
+{
+    Uint32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/** Empties the playfield **/
+void BB_clear (Bitboard*);
+
+/** Fills the bitboard with the locked blocks of a gMap. The active tetrimino is ignored **/
+void BB_fromGameMap (Bitboard*, Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y]);
+
+/** Returns the shape of a tetrimino (TETRIM_*) in a rotation state (0 to 3). The rotations are the same
+    as the ones of tetrimRotates **/
+const PieceShape* BB_getShape (int tetrim, int rotation);
+
+/** Returns the column of block1 when a tetrimino appears in the playfield (see generateNewTetrim) **/
+int BB_spawnColumn (int tetrim);
+
+/** Returns a boolean : 1 if the tetrimino overlaps a block, a wall or the floor when its square is put at (x, y) **/
+Uint8 BB_collides (const Bitboard*, int tetrim, int rotation, int x, int y);
+
+/** Drops the tetrimino from the top of the playfield in the column x.
+    Returns the line y where the tetrimino lands, -1 if the tetrimino cannot even enter the playfield **/
+int BB_dropRow (const Bitboard*, int tetrim, int rotation, int x);
+
+/** Puts the blocks of the tetrimino in the bitboard. Does not check collisions **/
+void BB_putPiece (Bitboard*, int tetrim, int rotation, int x, int y);
+
+/** Removes the complete lines and makes the lines above fall. Returns the number of lines removed **/
+int BB_clearLines (Bitboard*);
+
+#endif // BITBOARD_H_INCLUDED
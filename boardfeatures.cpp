@@ -0,0 +1,564 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FTR_USE_SSE2
+#endif
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "boardfeatures.h"
+
+#define WALLS   (1 | (1 << (NB_BLOCK_X+1))) /* A line shifted by one column, surrounded by the walls */
+
+/* Index of the lowest bit set. x must not be 0 */
+static inline int lowestBit (Uint32 x)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Row transitions of a single line. The empty lines are ignored */
+static inline int rowTransitionsOf (Uint16 row)
+{
+    Uint32 r = ((Uint32)row << 1) | WALLS;
+
+    if (row == 0)
+        return 0;
+
+    return BB_popcount ((r ^ (r >> 1)) & ((1 << (NB_BLOCK_X+1)) - 1));
+}
+
+/* Depth of the well of a column, 0 if it is not lower than both its neighbours. The walls are higher than any column */
+static inline int wellDepthOf (const BoardFeatures *ftr, int i)
+{
+    int left = (i > 0) ? ftr->heights[i-1] : NB_BLOCK_Y;
+    int right = (i+1 < NB_BLOCK_X) ? ftr->heights[i+1] : NB_BLOCK_Y;
+    int depth = ((left < right) ? left : right) - ftr->heights[i];
+
+    return (depth > 0) ? depth : 0;
+}
+
+/* Computes all the features that only depend on the heights of the columns */
+static void summarizeHeights (BoardFeatures *ftr)
+{
+    int i, depth;
+
+    ftr->aggregateHeight = 0;
+    ftr->maxHeight = 0;
+    ftr->bumpiness = 0;
+    ftr->wellSums = 0;
+    ftr->maxWellDepth = 0;
+
+    for (i = 0; i < NB_BLOCK_X; i++)
+    {
+        ftr->aggregateHeight += ftr->heights[i];
+        if (ftr->heights[i] > ftr->maxHeight)
+            ftr->maxHeight = ftr->heights[i];
+        if (i+1 < NB_BLOCK_X)
+            ftr->bumpiness += abs (ftr->heights[i] - ftr->heights[i+1]);
+
+        depth = wellDepthOf (ftr, i);
+        ftr->wellDepths[i] = depth;
+        ftr->wellSums += depth*(depth+1)/2;
+        if (depth > ftr->maxWellDepth)
+            ftr->maxWellDepth = depth;
+    }
+}
+
+/* Updates the features that depend on the heights after the columns of raised have grown.
+   Only these columns, the bumpiness on both of their sides and the wells of their neighbours change */
+static void raiseHeights (BoardFeatures *ftr, const int newHeights[NB_BLOCK_X], Uint16 raised)
+{
+    /* Variables */
+    const Uint16 allColumns = (1 << NB_BLOCK_X) - 1;
+    Uint16 pairs = (raised | (raised >> 1)) & (allColumns >> 1); /* Bit i : the pair of the columns i and i+1 */
+    Uint16 wells = (raised | (raised << 1) | (raised >> 1)) & allColumns;
+    Uint16 bits;
+    Uint8 filled = 0; /* Boolean : 1 if the deepest well may have been filled */
+    int i, depth;
+
+    for (bits = pairs; bits; bits &= bits - 1)
+    {
+        i = lowestBit (bits);
+        ftr->bumpiness -= abs (ftr->heights[i] - ftr->heights[i+1]);
+    }
+    for (bits = raised; bits; bits &= bits - 1)
+    {
+        i = lowestBit (bits);
+        ftr->aggregateHeight += newHeights[i] - ftr->heights[i];
+        ftr->heights[i] = newHeights[i];
+        if (newHeights[i] > ftr->maxHeight)
+            ftr->maxHeight = newHeights[i];
+    }
+    for (bits = pairs; bits; bits &= bits - 1)
+    {
+        i = lowestBit (bits);
+        ftr->bumpiness += abs (ftr->heights[i] - ftr->heights[i+1]);
+    }
+
+    for (bits = wells; bits; bits &= bits - 1)
+    {
+        i = lowestBit (bits);
+        depth = wellDepthOf (ftr, i);
+        ftr->wellSums += depth*(depth+1)/2 - ftr->wellDepths[i]*(ftr->wellDepths[i]+1)/2;
+        if (ftr->wellDepths[i] == ftr->maxWellDepth && depth < ftr->maxWellDepth)
+            filled = 1;
+        ftr->wellDepths[i] = depth;
+        if (depth > ftr->maxWellDepth)
+            ftr->maxWellDepth = depth;
+    }
+    if (filled)
+    {
+        ftr->maxWellDepth = 0;
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            if (ftr->wellDepths[i] > ftr->maxWellDepth)
+                ftr->maxWellDepth = ftr->wellDepths[i];
+        }
+    }
+}
+
+/* Computes the heights of the columns from the "cover" of each line,
+   i.e. the union of this line and all the lines above it */
+static void heightsFromCover (BoardFeatures *ftr, const Uint16 cover[FTR_NB_LINES])
+{
+    int i, j;
+    Uint32 newBlocks = 0, previous = 0;
+
+    for (i = 0; i < NB_BLOCK_X; i++)
+        ftr->heights[i] = 0;
+
+    for (j = 0; j < NB_BLOCK_Y && previous != BB_FULL_ROW; j++)
+    {
+        newBlocks = cover[j] & ~previous;
+        while (newBlocks)
+        {
+            ftr->heights[lowestBit (newBlocks)] = NB_BLOCK_Y - j;
+            newBlocks &= newBlocks - 1;
+        }
+        previous = cover[j];
+    }
+}
+
+#ifdef FTR_USE_SSE2
+
+/* Number of bits set in each 16 bits lane */
+static inline __m128i popcount16 (__m128i x)
+{
+    const __m128i m1 = _mm_set1_epi16 (0x5555);
+    const __m128i m2 = _mm_set1_epi16 (0x3333);
+    const __m128i m4 = _mm_set1_epi16 (0x0F0F);
+
+    x = _mm_sub_epi16 (x, _mm_and_si128 (_mm_srli_epi16 (x, 1), m1));
+    x = _mm_add_epi16 (_mm_and_si128 (x, m2), _mm_and_si128 (_mm_srli_epi16 (x, 2), m2));
+    x = _mm_and_si128 (_mm_add_epi16 (x, _mm_srli_epi16 (x, 4)), m4);
+    x = _mm_add_epi16 (x, _mm_srli_epi16 (x, 8));
+
+    return _mm_and_si128 (x, _mm_set1_epi16 (0x1F));
+}
+
+/* Sum of the 8 lanes */
+static inline int sum16 (__m128i x)
+{
+    x = _mm_madd_epi16 (x, _mm_set1_epi16 (1));
+    x = _mm_add_epi32 (x, _mm_srli_si128 (x, 8));
+    x = _mm_add_epi32 (x, _mm_srli_si128 (x, 4));
+
+    return _mm_cvtsi128_si32 (x);
+}
+
+void FTR_compute (BoardFeatures *ftr, const Bitboard *board)
+{
+    /* Variables */
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i full = _mm_set1_epi16 (BB_FULL_ROW);
+    const __m128i walls = _mm_set1_epi16 (WALLS);
+    const __m128i lineMask = _mm_set1_epi16 ((1 << (NB_BLOCK_X+1)) - 1);
+    __m128i row, previousRows = zero, above, transitions;
+    __m128i cover, coverAbove, carry = zero;
+    Uint16 coverLines[FTR_NB_LINES];
+    int v;
+
+    ftr->holes = 0;
+    ftr->rowTransitions = 0;
+    ftr->colTransitions = 0;
+
+    /* 8 lines are processed at a time, from the top to the floor */
+    for (v = 0; v < FTR_NB_LINES; v += 8)
+    {
+        row = _mm_loadu_si128 ((const __m128i*)(board->rows + v));
+
+        /* Row transitions : the line is surrounded by the walls, then compared with itself shifted by one column */
+        above = _mm_or_si128 (_mm_slli_epi16 (row, 1), walls);
+        transitions = _mm_and_si128 (_mm_xor_si128 (above, _mm_srli_epi16 (above, 1)), lineMask);
+        transitions = _mm_andnot_si128 (_mm_cmpeq_epi16 (row, zero), popcount16 (transitions));
+        _mm_storeu_si128 ((__m128i*)(ftr->lineRowTransitions + v), transitions);
+        ftr->rowTransitions += sum16 (transitions);
+
+        /* Column transitions : each line is compared with the line above. The line above the first one is empty */
+        above = _mm_or_si128 (_mm_slli_si128 (row, 2), _mm_srli_si128 (previousRows, 14));
+        transitions = popcount16 (_mm_xor_si128 (row, above));
+        _mm_storeu_si128 ((__m128i*)(ftr->lineColTransitions + v), transitions);
+        ftr->colTransitions += sum16 (transitions);
+        previousRows = row;
+
+        /* Holes : the cover of a line is the union of all the lines above it (prefix OR).
+           An empty cell is a hole if its column is covered */
+        cover = _mm_or_si128 (row, _mm_slli_si128 (row, 2));
+        cover = _mm_or_si128 (cover, _mm_slli_si128 (cover, 4));
+        cover = _mm_or_si128 (cover, _mm_slli_si128 (cover, 8));
+        coverAbove = _mm_or_si128 (_mm_slli_si128 (cover, 2), carry);
+        cover = _mm_or_si128 (cover, carry);
+        ftr->holes += sum16 (popcount16 (_mm_andnot_si128 (row, _mm_and_si128 (coverAbove, full))));
+        _mm_storeu_si128 ((__m128i*)(coverLines + v), cover);
+
+        /* The cover of the last line is given to the next 8 lines */
+        carry = _mm_shufflehi_epi16 (cover, 0xFF);
+        carry = _mm_unpackhi_epi64 (carry, carry);
+    }
+
+    heightsFromCover (ftr, coverLines);
+    summarizeHeights (ftr);
+}
+
+#else
+
+void FTR_compute (BoardFeatures *ftr, const Bitboard *board)
+{
+    /* Variables */
+    Uint16 coverLines[FTR_NB_LINES];
+    Uint16 previousRow = 0, cover = 0;
+    int j;
+
+    ftr->holes = 0;
+    ftr->rowTransitions = 0;
+    ftr->colTransitions = 0;
+
+    for (j = 0; j < FTR_NB_LINES; j++)
+    {
+        ftr->lineRowTransitions[j] = rowTransitionsOf (board->rows[j]);
+        ftr->rowTransitions += ftr->lineRowTransitions[j];
+
+        ftr->lineColTransitions[j] = BB_popcount (board->rows[j] ^ previousRow);
+        ftr->colTransitions += ftr->lineColTransitions[j];
+        previousRow = board->rows[j];
+
+        ftr->holes += BB_popcount (cover & ~board->rows[j] & BB_FULL_ROW);
+        cover |= board->rows[j];
+        coverLines[j] = cover;
+    }
+
+    heightsFromCover (ftr, coverLines);
+    summarizeHeights (ftr);
+}
+
+#endif
+
+void FTR_computeFromGameMap (BoardFeatures *ftr, Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y])
+{
+    int i, j;
+    Uint8 full, previous, covered; /* Booleans */
+
+    memset (ftr, 0, sizeof(*ftr));
+
+    /* Scans the columns from the top to the bottom */
+    for (i = 0; i < NB_BLOCK_X; i++)
+    {
+        previous = 0;
+        covered = 0;
+        for (j = 0; j < NB_BLOCK_Y; j++)
+        {
+            full = (gMap[i][j] != BLOCK_VOID && gMap[i][j] != BLOCK_ACTIVE);
+            if (full && !covered)
+            {
+                ftr->heights[i] = NB_BLOCK_Y - j;
+                covered = 1;
+            }
+            else if (!full && covered)
+                ftr->holes++;
+            if (full != previous)
+                ftr->lineColTransitions[j]++;
+            previous = full;
+        }
+        /* The floor is full */
+        if (!previous)
+            ftr->lineColTransitions[NB_BLOCK_Y]++;
+    }
+
+    /* Scans the lines from the left to the right */
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        previous = 1; /* The left wall */
+        covered = 0;
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            full = (gMap[i][j] != BLOCK_VOID && gMap[i][j] != BLOCK_ACTIVE);
+            if (full != previous)
+                ftr->lineRowTransitions[j]++;
+            if (full)
+                covered = 1;
+            previous = full;
+        }
+        /* The right wall */
+        if (!previous)
+            ftr->lineRowTransitions[j]++;
+        if (!covered)
+            ftr->lineRowTransitions[j] = 0;
+    }
+
+    for (j = 0; j < FTR_NB_LINES; j++)
+    {
+        ftr->rowTransitions += ftr->lineRowTransitions[j];
+        ftr->colTransitions += ftr->lineColTransitions[j];
+    }
+
+    summarizeHeights (ftr);
+}
+
+int FTR_addPiece (BoardFeatures *ftr, Bitboard *board, int tetrim, int rotation, int x, int y)
+{
+    /* Variables */
+    const PieceShape *shape = BB_getShape (tetrim, rotation);
+    Uint16 pieceRows[4] = {0};
+    Uint16 columns = 0, oldRow = 0, newRow = 0;
+    Uint16 oldCover = 0, newCover = 0;
+    Uint16 seen = 0, raised = 0, bits;
+    int newHeights[NB_BLOCK_X];
+    int first = y + shape->top, last = y + shape->bottom;
+    int i, j, l;
+    Uint8 completeLine = 0; /* Boolean */
+
+    for (l = shape->top; l <= shape->bottom; l++)
+    {
+        pieceRows[l] = BB_shiftRow (shape->rows[l], x);
+        columns |= pieceRows[l];
+    }
+    if (first < 0)
+        first = 0;
+    if (last >= NB_BLOCK_Y)
+        last = NB_BLOCK_Y-1;
+
+    /* Holes : only the columns of the tetrimino can change, from the first line of the tetrimino
+       to the first line where the old and the new covers are the same again */
+    for (j = 0; j < first; j++)
+        oldCover |= board->rows[j];
+    newCover = oldCover;
+    for (j = first; j < NB_BLOCK_Y; j++)
+    {
+        oldRow = board->rows[j];
+        newRow = (j <= last) ? (oldRow | pieceRows[j-y]) : oldRow;
+        ftr->holes += BB_popcount (newCover & ~newRow & columns) - BB_popcount (oldCover & ~oldRow & columns);
+        oldCover |= oldRow;
+        newCover |= newRow;
+        board->rows[j] = newRow;
+        if (newRow == BB_FULL_ROW)
+            completeLine = 1;
+        if (j >= last && ((oldCover ^ newCover) & columns) == 0)
+            break;
+    }
+
+    /* The complete lines change the whole playfield */
+    if (completeLine)
+    {
+        l = BB_clearLines (board);
+        FTR_compute (ftr, board);
+        return l;
+    }
+
+    /* Heights : the highest block of the tetrimino in each of its columns, if it is above the column */
+    for (j = first; j <= last; j++)
+    {
+        for (bits = pieceRows[j-y] & ~seen; bits; bits &= bits - 1)
+        {
+            i = lowestBit (bits);
+            newHeights[i] = NB_BLOCK_Y - j;
+            if (newHeights[i] > ftr->heights[i])
+                raised |= 1 << i;
+        }
+        seen |= pieceRows[j-y];
+    }
+    if (raised)
+        raiseHeights (ftr, newHeights, raised);
+
+    /* Transitions of the lines of the tetrimino */
+    for (j = first; j <= last; j++)
+    {
+        ftr->rowTransitions -= ftr->lineRowTransitions[j];
+        ftr->lineRowTransitions[j] = rowTransitionsOf (board->rows[j]);
+        ftr->rowTransitions += ftr->lineRowTransitions[j];
+    }
+    for (j = first; j <= last+1; j++)
+    {
+        ftr->colTransitions -= ftr->lineColTransitions[j];
+        ftr->lineColTransitions[j] = BB_popcount (board->rows[j] ^ ((j > 0) ? board->rows[j-1] : 0));
+        ftr->colTransitions += ftr->lineColTransitions[j];
+    }
+
+    return 0;
+}
+
+Uint8 FTR_equals (const BoardFeatures *a, const BoardFeatures *b)
+{
+    int i;
+
+    for (i = 0; i < NB_BLOCK_X; i++)
+    {
+        if (a->heights[i] != b->heights[i])
+            return 0;
+    }
+
+    return a->aggregateHeight == b->aggregateHeight && a->maxHeight == b->maxHeight
+        && a->holes == b->holes && a->bumpiness == b->bumpiness
+        && a->wellSums == b->wellSums && a->maxWellDepth == b->maxWellDepth
+        && a->rowTransitions == b->rowTransitions && a->colTransitions == b->colTransitions;
+}
+
+/* A board of the benchmark dataset and the move that is played on it */
+typedef struct BenchBoard
+{
+    Bitboard board;
+    int tetrim, rotation, x, y;
+} BenchBoard;
+
+void FTR_benchmark (int nbBoards, Uint32 seed)
+{
+    /* Variables */
+    BenchBoard *boards = NULL;
+    Uint32 (*maps)[NB_BLOCK_X][NB_BLOCK_Y] = NULL;
+    BoardFeatures *features = NULL;
+    BoardFeatures ftr, reference;
+    Bitboard board;
+    const PieceShape *shape = NULL;
+    Uint32 startTime, elapsed[4];
+    Uint32 rounds[4] = {0};
+    int n, i, j, k, y, nbErrors = 0;
+    volatile int sink = 0;
+
+    if (nbBoards <= 0 || seed == 0)
+        return;
+
+    boards = (BenchBoard*)malloc(sizeof(*boards)*nbBoards);
+    maps = (Uint32(*)[NB_BLOCK_X][NB_BLOCK_Y])malloc(sizeof(*maps)*nbBoards);
+    features = (BoardFeatures*)malloc(sizeof(*features)*nbBoards);
+    if (boards == NULL || maps == NULL || features == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the benchmark\n");
+        free(boards);
+        free(maps);
+        free(features);
+        return;
+    }
+
+    /* Builds the dataset by playing random moves. The playfield is emptied when the stack reaches the top */
+    BB_clear (&board);
+    for (n = 0; n < nbBoards; n++)
+    {
+        do
+        {
+            boards[n].tetrim = BB_random (&seed) % 7;
+            boards[n].rotation = BB_random (&seed) % BB_NB_ROTATIONS;
+            shape = BB_getShape (boards[n].tetrim, boards[n].rotation);
+            boards[n].x = -shape->left + BB_random (&seed) % (NB_BLOCK_X - (shape->right - shape->left));
+            y = BB_dropRow (&board, boards[n].tetrim, boards[n].rotation, boards[n].x);
+            if (y < 0)
+                BB_clear (&board);
+        } while (y < 0);
+
+        boards[n].y = y;
+        boards[n].board = board;
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            for (j = 0; j < NB_BLOCK_Y; j++)
+                maps[n][i][j] = (board.rows[j] & (1 << i)) ? BLOCK_CYAN : BLOCK_VOID;
+        }
+
+        BB_putPiece (&board, boards[n].tetrim, boards[n].rotation, boards[n].x, y);
+        BB_clearLines (&board);
+    }
+
+    /* Checks the extractor against the reference */
+    for (n = 0; n < nbBoards; n++)
+    {
+        FTR_compute (&features[n], &boards[n].board);
+        FTR_computeFromGameMap (&reference, maps[n]);
+        if (!FTR_equals (&features[n], &reference))
+            nbErrors++;
+
+        board = boards[n].board;
+        ftr = features[n];
+        FTR_addPiece (&ftr, &board, boards[n].tetrim, boards[n].rotation, boards[n].x, boards[n].y);
+        FTR_compute (&reference, &board);
+        if (!FTR_equals (&ftr, &reference))
+            nbErrors++;
+    }
+
+    /* 0 : cell by cell scan of gMap, 1 : bitboard extractor, 2 : incremental update after one tetrimino,
+       3 : the same tetrimino put in the playfield then the extractor on the whole playfield */
+    for (k = 0; k < 4; k++)
+    {
+        startTime = SDL_GetTicks();
+        do
+        {
+            for (n = 0; n < nbBoards; n++)
+            {
+                switch (k)
+                {
+                    case 0:
+                        FTR_computeFromGameMap (&ftr, maps[n]);
+                        break;
+                    case 1:
+                        FTR_compute (&ftr, &boards[n].board);
+                        break;
+                    case 2:
+                        board = boards[n].board;
+                        ftr = features[n];
+                        FTR_addPiece (&ftr, &board, boards[n].tetrim, boards[n].rotation, boards[n].x, boards[n].y);
+                        break;
+                    case 3:
+                        board = boards[n].board;
+                        BB_putPiece (&board, boards[n].tetrim, boards[n].rotation, boards[n].x, boards[n].y);
+                        BB_clearLines (&board);
+                        FTR_compute (&ftr, &board);
+                        break;
+                }
+                sink += ftr.holes;
+            }
+            rounds[k]++;
+            elapsed[k] = SDL_GetTicks() - startTime;
+        } while (elapsed[k] < 500);
+    }
+
+    fprintf(stdout, "Feature extractor benchmark : %d boards, %d features per board%s\n", nbBoards, FTR_NB_FEATURES,
+#ifdef FTR_USE_SSE2
+            ", SSE2");
+#else
+            ", scalar");
+#endif
+    fprintf(stdout, "Mismatches with the reference : %d\n", nbErrors);
+    fprintf(stdout, "gMap scan            : %12.0f boards/s %14.0f features/s\n",
+            1000.0*rounds[0]*nbBoards/elapsed[0], 1000.0*rounds[0]*nbBoards*FTR_NB_FEATURES/elapsed[0]);
+    fprintf(stdout, "Bitboard extractor   : %12.0f boards/s %14.0f features/s\n",
+            1000.0*rounds[1]*nbBoards/elapsed[1], 1000.0*rounds[1]*nbBoards*FTR_NB_FEATURES/elapsed[1]);
+    fprintf(stdout, "Incremental update   : %12.0f boards/s %14.0f features/s\n",
+            1000.0*rounds[2]*nbBoards/elapsed[2], 1000.0*rounds[2]*nbBoards*FTR_NB_FEATURES/elapsed[2]);
+    fprintf(stdout, "Put + extractor      : %12.0f boards/s %14.0f features/s\n",
+            1000.0*rounds[3]*nbBoards/elapsed[3], 1000.0*rounds[3]*nbBoards*FTR_NB_FEATURES/elapsed[3]);
+
+    free(boards);
+    free(maps);
+    free(features);
+}
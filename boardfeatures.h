@@ -0,0 +1,60 @@
+/** boardfeatures.h and boardfeatures.cpp extract the features of a playfield used to evaluate it
+    (column heights, holes, bumpiness, wells, line and column transitions).
+
+    The features are computed on a Bitboard. When SSE2 is available, the lines of the playfield are
+    processed 8 at a time. When a single tetrimino is added to the playfield, FTR_addPiece only updates
+    the lines and the columns touched by the tetrimino instead of computing everything again.
+**/
+
+#ifndef BOARDFEATURES_H_INCLUDED
+#define BOARDFEATURES_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+
+#define FTR_NB_LINES        24 /* Lines processed by the extractor : the playfield and 2 lines of floor */
+#define FTR_NB_FEATURES     (NB_BLOCK_X + 8) /* Number of values given by the extractor (see BoardFeatures) */
+
+typedef struct BoardFeatures BoardFeatures;
+
+struct BoardFeatures
+{
+    int heights[NB_BLOCK_X]; /* Height of each column, 0 if the column is empty */
+    int aggregateHeight; /* Sum of the heights */
+    int maxHeight;
+    int holes; /* Empty cells with at least one block above them */
+    int bumpiness; /* Sum of the height differences between neighbouring columns */
+    int wellSums; /* Each well of depth d counts for 1+2+...+d */
+    int maxWellDepth;
+    int rowTransitions; /* Changes between empty and full cells along the non-empty lines, the walls being full */
+    int colTransitions; /* Changes between empty and full cells along the columns, the floor being full */
+
+    /* Details kept for the incremental update */
+    Uint16 lineRowTransitions[FTR_NB_LINES]; /* Row transitions of each line */
+    Uint16 lineColTransitions[FTR_NB_LINES]; /* Column transitions between the line j-1 and the line j */
+    Uint8 wellDepths[NB_BLOCK_X]; /* Depth of the well of each column, 0 if none */
+};
+
+
+/** Computes all the features of a playfield **/
+void FTR_compute (BoardFeatures*, const Bitboard*);
+
+/** Computes the features directly from a gMap, cell by cell. Much slower than FTR_compute.
+    Used as a reference to check the extractor **/
+void FTR_computeFromGameMap (BoardFeatures*, Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y]);
+
+/** Puts a tetrimino in the playfield and updates the features.
+    If the tetrimino completes some lines, they are removed and the features are computed again.
+    Returns the number of lines removed **/
+int FTR_addPiece (BoardFeatures*, Bitboard*, int tetrim, int rotation, int x, int y);
+
+/** Returns a boolean : 1 if both structures contain the same features **/
+Uint8 FTR_equals (const BoardFeatures*, const BoardFeatures*);
+
+/** Measures the speed of the extractor on nbBoards playfields generated by random games
+    and prints the results in the stdout file **/
+void FTR_benchmark (int nbBoards, Uint32 seed);
+
+#endif // BOARDFEATURES_H_INCLUDED
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "constants.h"
+#include "bitboard.h"
+#include "sim.h"
+#include "ai.h"
+#include "platform.h"
+#include "book.h"
+
+/* Final mix of a 64 bits hash */
+static inline Uint64 mix64 (Uint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+
+    return x;
+}
+
+Uint64 BOOK_key (const Bitboard *board, int actualTetrim, int nextTetrim)
+{
+    Uint64 key = 0, word = 0;
+    int j;
+
+    /* 6 lines are packed in each word of 60 bits, then each word is mixed in the key */
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        word = (word << NB_BLOCK_X) | board->rows[j];
+        if (j % 6 == 5 || j == NB_BLOCK_Y-1)
+        {
+            key = mix64 (key ^ word);
+            word = 0;
+        }
+    }
+
+    return mix64 (key ^ ((Uint64)(actualTetrim*7 + nextTetrim + 1) * 0x9E3779B97F4A7C15ull));
+}
+
+Uint32 BOOK_packMove (const Placement *placement)
+{
+    return (Uint32)placement->rotation | ((Uint32)(placement->x + BOOK_X_OFFSET) << 8);
+}
+
+OpeningBook* BOOK_open (const char *fileName)
+{
+    /* Variables */
+    OpeningBook *book = (OpeningBook*)malloc(sizeof(*book));
+    const Uint8 *data = NULL;
+    Uint32 size = 0, version = 0, nbEntries = 0;
+
+    if (book == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the opening book\n");
+        return NULL;
+    }
+
+    /* Maps the file */
+#ifdef _WIN32
+    book->file = CreateFileA (fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (book->file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Impossible to open the opening book %s\n", fileName);
+        free (book);
+        return NULL;
+    }
+    size = GetFileSize (book->file, NULL);
+    book->mapping = CreateFileMappingA (book->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    data = (book->mapping != NULL) ? (const Uint8*)MapViewOfFile (book->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (data == NULL)
+    {
+        fprintf(stderr, "Impossible to map the opening book %s\n", fileName);
+        if (book->mapping != NULL)
+            CloseHandle (book->mapping);
+        CloseHandle (book->file);
+        free (book);
+        return NULL;
+    }
+#else
+    int fd = open (fileName, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat (fd, &info) != 0 || info.st_size < BOOK_HEADER_SIZE)
+    {
+        fprintf(stderr, "Impossible to open the opening book %s\n", fileName);
+        if (fd >= 0)
+            close (fd);
+        free (book);
+        return NULL;
+    }
+    size = info.st_size;
+    data = (const Uint8*)mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (data == (const Uint8*)MAP_FAILED)
+    {
+        fprintf(stderr, "Impossible to map the opening book %s\n", fileName);
+        free (book);
+        return NULL;
+    }
+#endif
+
+    book->data = data;
+    book->size = size;
+
+    /* Checks the header only : the entries are used as they are in the file */
+    if (size >= BOOK_HEADER_SIZE)
+    {
+        memcpy (&version, data + 8, sizeof(Uint32));
+        memcpy (&nbEntries, data + 12, sizeof(Uint32));
+    }
+    if (size < BOOK_HEADER_SIZE || memcmp (data, BOOK_MAGIC, 8) != 0 || version != BOOK_VERSION
+        || size != BOOK_HEADER_SIZE + (Uint64)nbEntries*(sizeof(Uint64) + sizeof(Uint32)))
+    {
+        fprintf(stderr, "The file %s is not a valid opening book\n", fileName);
+        book->nbEntries = 0;
+        BOOK_close (book);
+        return NULL;
+    }
+
+    book->nbEntries = nbEntries;
+    book->keys = (const Uint64*)(data + BOOK_HEADER_SIZE);
+    book->moves = (const Uint32*)(data + BOOK_HEADER_SIZE + nbEntries*sizeof(Uint64));
+
+    return book;
+}
+
+void BOOK_close (OpeningBook *book)
+{
+    if (book == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile (book->data);
+    CloseHandle (book->mapping);
+    CloseHandle (book->file);
+#else
+    munmap ((void*)book->data, book->size);
+#endif
+
+    free (book);
+}
+
+Uint8 BOOK_lookup (const OpeningBook *book, const Bitboard *board, int actualTetrim, int nextTetrim, Placement *placement)
+{
+    Uint64 key = 0;
+    Uint32 first = 0, last = 0, middle = 0;
+
+    if (book == NULL || book->nbEntries == 0)
+        return 0;
+
+    /* Binary search of the first key that is not lower than the key */
+    key = BOOK_key (board, actualTetrim, nextTetrim);
+    last = book->nbEntries;
+    while (first < last)
+    {
+        middle = first + (last - first)/2;
+        if (book->keys[middle] < key)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    if (first == book->nbEntries || book->keys[first] != key)
+        return 0;
+
+    placement->rotation = book->moves[first] & 0xFF;
+    placement->x = (int)((book->moves[first] >> 8) & 0xFF) - BOOK_X_OFFSET;
+    placement->y = BB_dropRow (board, actualTetrim, placement->rotation, placement->x);
+
+    return placement->y >= 0;
+}
+
+void BOOK_benchmark (const char *fileName, int nbGames, Uint32 seed)
+{
+    /* Variables */
+    OpeningBook *book = BOOK_open (fileName);
+    AI_Weights weights;
+    SimGame game;
+    Placement placement;
+    Uint64 startTime, lookupTime = 0, searchTime = 0, openingTime[2] = {0, 0};
+    Uint32 nbLookups = 0, nbHits = 0, nbSearches = 0;
+    int n, k, mode;
+    Uint8 inBook; /* Boolean */
+
+    if (book == NULL || nbGames <= 0)
+    {
+        BOOK_close (book);
+        return;
+    }
+
+    AI_defaultWeights (&weights);
+    BB_getShape (0, 0);
+
+    /* Plays the opening of each game with the book, then falls back on the search of the AI */
+    for (n = 0; n < nbGames; n++)
+    {
+        SIM_init (&game, BB_random (&seed) | 1);
+        inBook = 1;
+        while (!game.over && game.nbPieces < 20)
+        {
+            /* A lookup is shorter than the resolution of the timer, so it is repeated */
+            if (inBook)
+            {
+                startTime = PLT_getTimeUs ();
+                for (k = 0; k < 100; k++)
+                    inBook = BOOK_lookup (book, &game.board, game.actualTetrim, game.nextTetrim, &placement);
+                lookupTime += PLT_getTimeUs () - startTime;
+                nbLookups += 100;
+                nbHits += inBook;
+            }
+            if (!inBook)
+            {
+                startTime = PLT_getTimeUs ();
+                AI_bestPlacementWithNext (&game, &weights, &placement);
+                searchTime += PLT_getTimeUs () - startTime;
+                nbSearches++;
+            }
+            SIM_play (&game, &placement);
+        }
+    }
+
+    /* The 20 first moves chosen by AI_bookPlacement, with the book then without it */
+    for (mode = 0; mode < 2; mode++)
+    {
+        startTime = PLT_getTimeUs ();
+        for (n = 0; n < nbGames; n++)
+        {
+            SIM_init (&game, BB_random (&seed) | 1);
+            while (!game.over && game.nbPieces < 20 && AI_bookPlacement ((mode == 0) ? book : NULL, &game, &weights, &placement))
+                SIM_play (&game, &placement);
+        }
+        openingTime[mode] = PLT_getTimeUs () - startTime;
+    }
+
+    fprintf(stdout, "Opening book benchmark : %s, %u entries, %u bytes\n", fileName, book->nbEntries, book->size);
+    fprintf(stdout, "Book moves     : %u of the first 20 moves of %d games (%.1f per game)\n",
+            nbHits, nbGames, (double)nbHits/nbGames);
+    fprintf(stdout, "Book lookup    : %10.3f us on average\n", nbLookups ? (double)lookupTime/nbLookups : 0.0);
+    fprintf(stdout, "AI search      : %10.3f us on average\n", nbSearches ? (double)searchTime/nbSearches : 0.0);
+    fprintf(stdout, "20 first moves : %10.3f ms per game with the book, %.3f ms without\n",
+            openingTime[0]/1000.0/nbGames, openingTime[1]/1000.0/nbGames);
+
+    BOOK_close (book);
+}
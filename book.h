@@ -0,0 +1,63 @@
+/** book.h and book.cpp read an opening book : a file of precomputed placements for the first tetriminoes of a game.
+
+    The book is made offline by tools/bookmaker.cpp, with a search too slow for the game. Each entry is keyed by
+    the playfield, the active tetrimino and the next one. The file is mapped in memory and used as is : the keys
+    are sorted so a placement is found by a binary search, without reading or parsing the file when it is opened.
+
+    File format (little endian) :
+        char magic[8]           "TTRMBOOK"
+        Uint32 version
+        Uint32 nbEntries
+        Uint64 keys[nbEntries]  sorted in increasing order
+        Uint32 moves[nbEntries] rotation in the bits 0-7, column of block1 + BOOK_X_OFFSET in the bits 8-15
+**/
+
+#ifndef BOOK_H_INCLUDED
+#define BOOK_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "bitboard.h"
+#include "sim.h"
+
+#define BOOK_MAGIC          "TTRMBOOK"
+#define BOOK_VERSION        1
+#define BOOK_X_OFFSET       8 /* block1 can be outside of the playfield, so the column is stored with an offset */
+#define BOOK_HEADER_SIZE    16
+
+typedef struct OpeningBook OpeningBook;
+
+struct OpeningBook
+{
+    const Uint8 *data; /* The whole file mapped in memory */
+    Uint32 size;
+    const Uint64 *keys;
+    const Uint32 *moves;
+    Uint32 nbEntries;
+#ifdef _WIN32
+    void *file, *mapping;
+#endif
+};
+
+
+/** Returns the key of a position of the book **/
+Uint64 BOOK_key (const Bitboard*, int actualTetrim, int nextTetrim);
+
+/** Packs a placement in a move of the book **/
+Uint32 BOOK_packMove (const Placement*);
+
+/** Maps a book file in memory. Returns NULL if the file cannot be opened or is not a book **/
+OpeningBook* BOOK_open (const char *fileName);
+
+/** Unmaps and frees a book **/
+void BOOK_close (OpeningBook*);
+
+/** Looks for the position in the book (binary search).
+    Returns a boolean : 1 if the position is in the book and its placement is legal on this playfield **/
+Uint8 BOOK_lookup (const OpeningBook*, const Bitboard*, int actualTetrim, int nextTetrim, Placement*);
+
+/** Compares the time of a lookup in a book with the time of the search of the AI
+    and prints the results in the stdout file **/
+void BOOK_benchmark (const char *fileName, int nbGames, Uint32 seed);
+
+#endif // BOOK_H_INCLUDED
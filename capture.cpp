@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <windows.h>
+#endif
+
+#include "constants.h"
+#include "render.h"
+#include "platform.h"
+#include "capture.h"
+
+#ifdef _WIN32
+#define NULL_DEVICE         "NUL"
+#else
+#define NULL_DEVICE         "/dev/null"
+#endif
+
+/* Reads the color of the pixel at p */
+static void getRGB (const CAP_Capture *capture, const Uint8 *p, int *r, int *g, int *b)
+{
+    /* Variables */
+    const SDL_PixelFormat *format = &capture->format;
+    Uint32 pixel;
+    Uint8 r8, g8, b8;
+
+    switch (format->BytesPerPixel)
+    {
+        case 4:
+            pixel = *(const Uint32*)p;
+            /* 8 bits per channel : no table to read */
+            if (format->Rloss == 0 && format->Gloss == 0 && format->Bloss == 0)
+            {
+                *r = (pixel >> format->Rshift) & 0xFF;
+                *g = (pixel >> format->Gshift) & 0xFF;
+                *b = (pixel >> format->Bshift) & 0xFF;
+                return;
+            }
+            break;
+        case 3:
+            pixel = p[0] | p[1] << 8 | p[2] << 16;
+            if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+                pixel = p[2] | p[1] << 8 | p[0] << 16;
+            break;
+        case 2:
+            pixel = *(const Uint16*)p;
+            break;
+        default:
+            pixel = *p;
+            break;
+    }
+
+    SDL_GetRGB (pixel, (SDL_PixelFormat*)format, &r8, &g8, &b8);
+    *r = r8;
+    *g = g8;
+    *b = b8;
+}
+
+void CAP_toYUV (const CAP_Capture *capture, const Uint8 *pixels, Uint8 *planes)
+{
+    /* Variables */
+    const int bpp = capture->format.BytesPerPixel, lineSize = capture->width*bpp;
+    const int chromaWidth = (capture->width + 1)/2, chromaHeight = (capture->height + 1)/2;
+    Uint8 *lumas = planes, *blues = planes + capture->width*capture->height, *reds = blues + chromaWidth*chromaHeight;
+    const Uint8 *line = NULL;
+    int r, g, b, sumR, sumG, sumB;
+    int x, y, i, j, dx, dy;
+
+    /* 2x2 pixels at a time : their 4 lumas and the average of their colors for the chroma */
+    for (y = 0; y < capture->height; y += 2)
+    {
+        for (x = 0; x < capture->width; x += 2)
+        {
+            sumR = sumG = sumB = 0;
+            for (j = 0; j < 2; j++)
+            {
+                /* The last line and the last column are repeated if the size is odd */
+                dy = (y + j < capture->height) ? y + j : y;
+                line = pixels + dy*lineSize;
+                for (i = 0; i < 2; i++)
+                {
+                    dx = (x + i < capture->width) ? x + i : x;
+                    getRGB (capture, line + dx*bpp, &r, &g, &b);
+                    lumas[dy*capture->width + dx] = ((66*r + 129*g + 25*b + 128) >> 8) + 16;
+                    sumR += r;
+                    sumG += g;
+                    sumB += b;
+                }
+            }
+            r = (sumR + 2) >> 2;
+            g = (sumG + 2) >> 2;
+            b = (sumB + 2) >> 2;
+            /* 128 << 8 is added before the shift so that it is done on a positive number */
+            blues[(y/2)*chromaWidth + x/2] = (-38*r - 74*g + 112*b + 128 + (128 << 8)) >> 8;
+            reds[(y/2)*chromaWidth + x/2] = (112*r - 94*g - 18*b + 128 + (128 << 8)) >> 8;
+        }
+    }
+}
+
+/* The writer thread : converts and writes the frames queued until CAP_close, then the ones left */
+static int writeFrames (void *data)
+{
+    /* Variables */
+    CAP_Capture *capture = (CAP_Capture*)data;
+    Uint64 startTime;
+    Uint32 tail;
+    int stop;
+
+    while (1)
+    {
+        /* stop is read before head : every frame queued before CAP_close is seen */
+        stop = capture->stop;
+        PLT_ACQUIRE_FENCE ();
+        tail = capture->tail;
+        if (tail == capture->head)
+        {
+            if (stop)
+                break;
+            SDL_Delay (CAP_WRITER_PERIOD);
+            continue;
+        }
+        PLT_ACQUIRE_FENCE ();
+
+        startTime = PLT_getTimeUs ();
+        if (!capture->failed)
+        {
+            CAP_toYUV (capture, capture->slots + (size_t)(tail % capture->nbSlots)*capture->frameSize, capture->planes);
+            if ((!capture->raw && fputs ("FRAME\n", capture->file) < 0)
+                || fwrite (capture->planes, 1, capture->planesSize, capture->file) != (size_t)capture->planesSize)
+            {
+                fprintf(stderr, "Impossible to write the video : the next frames are not written\n");
+                capture->failed = 1;
+            }
+            else
+                capture->nbWritten++;
+        }
+        capture->writeTime += PLT_getTimeUs () - startTime;
+
+        /* The slot can be written again */
+        PLT_RELEASE_FENCE ();
+        capture->tail = tail + 1;
+    }
+
+    return 0;
+}
+
+Uint8 CAP_open (CAP_Capture *capture, const char *target, Uint8 raw, const SDL_Surface *source, Uint32 framePeriod, int nbSlots)
+{
+    memset (capture, 0, sizeof(CAP_Capture));
+    capture->raw = raw;
+    capture->width = source->w;
+    capture->height = source->h;
+    capture->format = *source->format;
+    capture->frameSize = source->w*source->h*source->format->BytesPerPixel;
+    capture->planesSize = source->w*source->h + 2*((source->w + 1)/2)*((source->h + 1)/2);
+    capture->nbSlots = (nbSlots <= 0) ? CAP_QUEUE_SIZE : (nbSlots > CAP_MAX_SLOTS) ? CAP_MAX_SLOTS : nbSlots;
+
+    capture->slots = (Uint8*)malloc((size_t)capture->frameSize*capture->nbSlots);
+    capture->planes = (Uint8*)malloc(capture->planesSize);
+    if (capture->slots == NULL || capture->planes == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the queue of the capture\n");
+        free (capture->slots);
+        free (capture->planes);
+        return 0;
+    }
+
+    if (strcmp (target, "-") == 0)
+    {
+#ifdef _WIN32
+        _setmode (_fileno (stdout), _O_BINARY);
+#endif
+        capture->file = stdout;
+    }
+    else
+        capture->file = fopen (target, "wb");
+    if (capture->file == NULL)
+    {
+        fprintf(stderr, "Impossible to open the video %s\n", target);
+        free (capture->slots);
+        free (capture->planes);
+        return 0;
+    }
+
+    if (!raw)
+        fprintf(capture->file, "YUV4MPEG2 W%d H%d F1000:%u Ip A1:1 C420jpeg\n", capture->width, capture->height,
+                framePeriod);
+
+    capture->thread = SDL_CreateThread (writeFrames, capture);
+    if (capture->thread == NULL)
+    {
+        fprintf(stderr, "Impossible to create the writer of the video : %s\n", SDL_GetError() );
+        if (capture->file != stdout)
+            fclose (capture->file);
+        free (capture->slots);
+        free (capture->planes);
+        return 0;
+    }
+
+    return 1;
+}
+
+Uint8 CAP_submit (CAP_Capture *capture, SDL_Surface *surface, Uint8 wait)
+{
+    /* Variables */
+    const int lineSize = capture->width*capture->format.BytesPerPixel;
+    const Uint32 head = capture->head;
+    Uint64 startTime = PLT_getTimeUs (), waitTime = 0;
+    Uint32 depth = head - capture->tail;
+    Uint8 *slot = NULL;
+    int y;
+
+    capture->nbSubmitted++;
+    capture->totalDepth += depth;
+    if (depth > capture->maxDepth)
+        capture->maxDepth = depth;
+
+    if (surface->w != capture->width || surface->h != capture->height
+        || surface->format->BytesPerPixel != capture->format.BytesPerPixel || (depth == (Uint32)capture->nbSlots && !wait))
+    {
+        capture->nbDropped++;
+        capture->copyTime += PLT_getTimeUs () - startTime;
+        return 0;
+    }
+    if (depth == (Uint32)capture->nbSlots)
+    {
+        while (head - capture->tail == (Uint32)capture->nbSlots)
+            SDL_Delay (CAP_WRITER_PERIOD);
+        waitTime = PLT_getTimeUs () - startTime;
+        capture->waitTime += waitTime;
+    }
+    /* The writer has finished with the slot */
+    PLT_ACQUIRE_FENCE ();
+
+    slot = capture->slots + (size_t)(head % capture->nbSlots)*capture->frameSize;
+    if (SDL_MUSTLOCK (surface))
+        SDL_LockSurface (surface);
+    for (y = 0; y < capture->height; y++)
+        memcpy (slot + y*lineSize, (const Uint8*)surface->pixels + y*surface->pitch, lineSize);
+    if (SDL_MUSTLOCK (surface))
+        SDL_UnlockSurface (surface);
+
+    PLT_RELEASE_FENCE ();
+    capture->head = head + 1;
+    capture->copyTime += PLT_getTimeUs () - startTime - waitTime;
+
+    return 1;
+}
+
+void CAP_close (CAP_Capture *capture)
+{
+    /* Variables */
+    FILE *report = (capture->file == stdout) ? stderr : stdout;
+    Uint32 nbCopied = capture->nbSubmitted - capture->nbDropped;
+
+    if (capture->thread == NULL)
+        return;
+
+    PLT_RELEASE_FENCE ();
+    capture->stop = 1;
+    SDL_WaitThread (capture->thread, NULL);
+    capture->thread = NULL;
+
+    if (capture->file == stdout)
+        fflush (stdout);
+    else
+        fclose (capture->file);
+    capture->file = NULL;
+    free (capture->slots);
+    free (capture->planes);
+    capture->slots = NULL;
+    capture->planes = NULL;
+
+    fprintf(report, "Capture : %u frames written, %u dropped of %u (%.1f %%), %.2f frames queued on average, "
+            "%u at most of %d slots\n", capture->nbWritten, capture->nbDropped, capture->nbSubmitted,
+            (capture->nbSubmitted > 0) ? 100.0*capture->nbDropped/capture->nbSubmitted : 0.0,
+            (capture->nbSubmitted > 0) ? (double)capture->totalDepth/capture->nbSubmitted : 0.0,
+            capture->maxDepth, capture->nbSlots);
+    if (nbCopied > 0)
+        fprintf(report, "    %.2f ms per frame for the game, %.2f ms waiting for the slots, %.2f ms per frame for the writer\n",
+                capture->copyTime/1000.0/capture->nbSubmitted, capture->waitTime/1000.0/nbCopied,
+                capture->writeTime/1000.0/nbCopied);
+}
+
+void CAP_benchmark (int nbFrames, int nbSlots)
+{
+    /* Variables */
+    const char *names[3] = {"Rate of playGame", "Waiting", "Dropping"};
+    const Uint32 framePeriod = 30; /* Refresh period of playGame */
+    RND_Backend memory;
+    CAP_Capture capture;
+    SDL_Rect block;
+    Uint64 startTime, elapsed;
+    int mode, n;
+
+    /* No window : the frames are drawn in memory */
+    if (!RND_openMemory (&memory, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return;
+
+    fprintf(stdout, "Capture : %d frames of %dx%d pixels in Y4M, written in %s\n", nbFrames, WINDOW_WIDTH, WINDOW_HEIGHT,
+            NULL_DEVICE);
+
+    for (mode = 0; mode < 3; mode++)
+    {
+        if (!CAP_open (&capture, NULL_DEVICE, 0, memory.screen, framePeriod, nbSlots))
+            break;
+
+        fprintf(stdout, "%s :\n", names[mode]);
+        startTime = PLT_getTimeUs ();
+        for (n = 0; n < nbFrames; n++)
+        {
+            /* A block of a new color crosses the screen */
+            SDL_FillRect (memory.screen, NULL, SDL_MapRGB (memory.screen->format, n, 255 - n, 64));
+            block.x = (n*BLOCK_SIZE) % WINDOW_WIDTH;
+            block.y = (n*BLOCK_SIZE/2) % WINDOW_HEIGHT;
+            block.w = BLOCK_SIZE;
+            block.h = BLOCK_SIZE;
+            SDL_FillRect (memory.screen, &block, SDL_MapRGB (memory.screen->format, 255, n, 0));
+
+            CAP_submit (&capture, memory.screen, mode == 1);
+            if (mode == 0)
+            {
+                elapsed = PLT_getTimeUs () - startTime;
+                if (elapsed < (Uint64)(n + 1)*framePeriod*1000)
+                    SDL_Delay (((n + 1)*framePeriod*1000 - elapsed)/1000);
+            }
+        }
+        CAP_close (&capture);
+        elapsed = PLT_getTimeUs () - startTime;
+        fprintf(stdout, "    %.2f s, %.1f frames written per second\n", elapsed/1000000.0,
+                capture.nbWritten*1000000.0/elapsed);
+    }
+
+    RND_closeBackend (&memory);
+}
@@ -0,0 +1,87 @@
+/** capture.h and capture.cpp record the frames of a game in a video file, without slowing the game down.
+
+    The game draws each frame as usual, in the window or in a screen in memory (see render.h), then gives it to
+    CAP_submit. CAP_submit only copies the pixels in a free slot of a queue of nbSlots frames allocated once :
+    the conversion and the writing are done by a writer thread, which takes the frames in the order they came.
+    If the writer is late and every slot is taken, the frame is dropped and counted, the game never waits.
+    A tool that draws faster than real time (a replay) can ask CAP_submit to wait for a slot instead.
+
+    The writer converts the pixels to YUV 4:2:0 (BT.601, the chroma averaged over 2x2 pixels) and writes :
+        - a Y4M file : a header "YUV4MPEG2 W.. H.. F1000:framePeriod Ip A1:1 C420jpeg", then "FRAME" and the
+          Y, U and V planes for each frame. It can be read by most video tools (ffmpeg, mpv, x264...)
+        - or the planes only (raw yuv420p), the size and the rate being given to the reader
+    The target is a file, a named pipe, or - for the standard output, to pipe the video to an encoder.
+
+    The frames dropped and the depth of the queue when each frame is submitted are reported by CAP_close.
+**/
+
+#ifndef CAPTURE_H_INCLUDED
+#define CAPTURE_H_INCLUDED
+
+#include <stdio.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+
+#define CAP_QUEUE_SIZE      8 /* Slots by default, 3 MB at the scale 1 */
+#define CAP_MAX_SLOTS       256
+#define CAP_WRITER_PERIOD   1 /* Milliseconds the writer sleeps when the queue is empty */
+
+typedef struct CAP_Capture CAP_Capture;
+
+struct CAP_Capture
+{
+    FILE *file;
+    Uint8 raw; /* Boolean : 1 to write the planes only, without the headers of Y4M */
+    int width, height;
+    SDL_PixelFormat format; /* Of the surface captured, copied at CAP_open */
+    int frameSize; /* Bytes of a slot : the pixels, without the padding of the lines of the surface */
+
+    /* Queue : the game writes the slot head % nbSlots, the writer reads the slot tail % nbSlots */
+    Uint8 *slots;
+    int nbSlots;
+    volatile Uint32 head; /* Written by the game only */
+    volatile Uint32 tail; /* Written by the writer only */
+    volatile int stop;
+    SDL_Thread *thread;
+
+    /* Writer */
+    Uint8 *planes; /* Y, U and V of the frame being written */
+    int planesSize;
+    Uint8 failed; /* Boolean : 1 once a write has failed, the next frames are not written */
+
+    /* Measures */
+    Uint32 nbSubmitted, nbDropped, nbWritten;
+    Uint32 maxDepth; /* Most frames waiting in the queue when a frame was submitted */
+    Uint64 totalDepth;
+    Uint64 copyTime; /* Microseconds spent in CAP_submit by the game */
+    Uint64 waitTime; /* Microseconds spent by CAP_submit waiting for a slot */
+    Uint64 writeTime; /* Microseconds spent by the writer to convert and write the frames */
+};
+
+
+/** Opens the video towards target (- for the standard output) for the frames of surfaces of the size and the format
+    of source, shown every framePeriod milliseconds, writes its header and starts the writer thread.
+    nbSlots frames can wait in the queue (CAP_QUEUE_SIZE if 0). Returns a boolean : 0 if the video cannot be opened **/
+Uint8 CAP_open (CAP_Capture*, const char *target, Uint8 raw, const SDL_Surface *source, Uint32 framePeriod, int nbSlots);
+
+/** Gives a frame to the writer. The surface must have the size and the format given to CAP_open.
+    If every slot is taken, the frame is dropped, unless wait is 1 : CAP_submit waits for a slot then.
+    Returns a boolean : 0 if the frame has been dropped **/
+Uint8 CAP_submit (CAP_Capture*, SDL_Surface*, Uint8 wait);
+
+/** Waits until the frames queued are written, stops the writer, closes the video and prints the frames written
+    and dropped and the depth of the queue, in the stderr file if the video went to the standard output,
+    in the stdout file otherwise **/
+void CAP_close (CAP_Capture*);
+
+/** Converts the pixels of a frame copied from a surface of the format given to the planes Y, U and V of yuv420p **/
+void CAP_toYUV (const CAP_Capture*, const Uint8 *pixels, Uint8 *planes);
+
+/** Captures nbFrames frames of the size of the window in a queue of nbSlots slots, written in the null device :
+    submitted at the rate of playGame, all at once waiting for the slots, and all at once without waiting,
+    and prints the time spent by the game and by the writer, the frames dropped and the depth of the queue
+    in the stdout file **/
+void CAP_benchmark (int nbFrames, int nbSlots);
+
+#endif // CAPTURE_H_INCLUDED
@@ -7,13 +7,17 @@
 #define CONSTANTS_H_INCLUDED
 
 
-#define BLOCK_SIZE      30
+/* The sizes in pixels are multiplied by the scale of the window, chosen at startup (see RND_chooseScale) */
+extern int gScale;
+#define MAX_SCALE       4
+
+#define BLOCK_SIZE      (30*gScale)
 #define NB_BLOCK_X      10
 #define NB_BLOCK_Y      (20 + 2) /* 20 lines of the playfield are visible, 2 are hidden from the player */
 #define FIRST_LINE      2 /* Defines the first line of the playfield that appears on the screen */
-#define GRID_WIDE       1 /* The grid is the white border inside a block */
-#define BORDER          5 /* The border is the light gray/light purple border around the playfield or around the elements
-                            of the interface */
+#define GRID_WIDE       (1*gScale) /* The grid is the white border inside a block */
+#define BORDER          (5*gScale) /* The border is the light gray/light purple border around the playfield or around the elements
+                                     of the interface */
 #define LATERAL_PANEL       (6*BLOCK_SIZE + 2*BORDER) /* Wide of a lateral panel. The right and the left panels have the same */
 #define PLAYFIELD           (NB_BLOCK_X*BLOCK_SIZE) /* Wide of the playfield */
 
@@ -22,7 +26,10 @@
 
 #define START_POS           WINDOW_WIDTH/2.4
 
-#define INTERLINE           90
+#define INTERLINE           (90*gScale)
+
+#define MENU_BLINK_PERIOD   700 /* Milliseconds for the selected string of the menu to disappear and appear again */
+#define MENU_BLINK_STEPS    35 /* Opacities of the blink, one every MENU_BLINK_PERIOD/MENU_BLINK_STEPS milliseconds */
 
 enum
 {
@@ -1,6 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <time.h>
 #include <SDL/SDL.h>
 #include <SDL/SDL_ttf.h>
 
@@ -8,6 +8,14 @@
 #include "game.h"
 #include "animation.h"
 #include "linked_list.h"
+#include "rules.h"
+#include "bitboard.h"
+#include "tbp.h"
+#include "spectate.h"
+#include "telemetry.h"
+#include "capture.h"
+#include "platform.h"
+#include "pipeline.h"
 
 Uint8 initGameElements (GameElements *gameElm)
 {
@@ -62,26 +70,129 @@ void freeGameElements (GameElements *gameElm)
     LNK_freeList (gameElm->bag);
 }
 
-Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
+/* Asks the bot where to drop the new tetrimino, then turns it, moves it and drops it like the player would.
+   Returns a boolean : 1 if the tetrimino has been dropped */
+static Uint8 botDropsTetrim (TBP_Session *bot, GameElements *gameElm)
+{
+    /* Variables */
+    char cells[NB_BLOCK_Y][NB_BLOCK_X];
+    Bitboard board;
+    Placement placement;
+    int k;
+
+    BB_fromGameMap (&board, gameElm->gMap);
+    TBP_cellsFromGameMap (cells, gameElm->gMap);
+    if (!TBP_requestPlacement (bot, &board, cells, gameElm->actualTetrim, gameElm->nextTetrim,
+                               LNK_getContent (gameElm->bag), &placement))
+        return 0;
+
+    for (k = 0; k < placement.rotation; k++)
+        tetrimRotates (gameElm);
+    for (k = 0; k < NB_BLOCK_X && gameElm->block1.i > placement.x; k++)
+        tetrimMoves (gameElm, DIR_LEFT);
+    for (k = 0; k < NB_BLOCK_X && gameElm->block1.i < placement.x; k++)
+        tetrimMoves (gameElm, DIR_RIGHT);
+    while (!tetrimFalls (gameElm))
+        gameElm->score = RULE_addPoints (gameElm->score, SOFT_DROP_POINTS);
+
+    /* The bot is told where the tetrimino really is, in case a wall kick has moved it */
+    placement.rotation = gameElm->rotationState;
+    placement.x = gameElm->block1.i;
+    placement.y = gameElm->block1.j;
+    TBP_reportPlacement (bot, gameElm->actualTetrim, &placement);
+
+    return 1;
+}
+
+/* Writes the state of the game in the spectator stream */
+static void streamGame (SPEC_Encoder *spectators, GameElements *gameElm, Uint8 over)
+{
+    SPEC_Frame frame;
+    int i, j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+            frame.cells[j][i] = (gameElm->gMap[i][j] != BLOCK_ACTIVE) ? (int)gameElm->gMap[i][j] : (int)BLOCK_VOID;
+    }
+    frame.active = gameElm->tetrimActive && !over;
+    frame.tetrim = gameElm->actualTetrim;
+    frame.rotation = gameElm->rotationState;
+    frame.x = gameElm->block1.i;
+    frame.y = gameElm->block1.j;
+    frame.nextTetrim = gameElm->nextTetrim;
+    frame.score = gameElm->score;
+    frame.level = gameElm->level;
+    frame.nbCompleteLines = gameElm->nbCompleteLines;
+    frame.over = over;
+
+    SPEC_emit (spectators, &frame);
+}
+
+/* Publishes the state of the game in the telemetry segment */
+static void publishGame (TLM_Mapping *telemetry, GameElements *gameElm, Uint8 over, Uint32 gameTime, Uint32 renderTime)
+{
+    TLM_Snapshot *snapshot = &telemetry->local;
+    int i, j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+            snapshot->cells[j][i] = (gameElm->gMap[i][j] != BLOCK_ACTIVE) ? (int)gameElm->gMap[i][j] : (int)BLOCK_VOID;
+    }
+    snapshot->gameTime = gameTime;
+    snapshot->active = gameElm->tetrimActive && !over;
+    snapshot->tetrim = gameElm->actualTetrim;
+    snapshot->rotation = gameElm->rotationState;
+    snapshot->x = gameElm->block1.i;
+    snapshot->y = gameElm->block1.j;
+    snapshot->nextTetrim = gameElm->nextTetrim;
+    snapshot->over = over;
+    snapshot->score = gameElm->score;
+    snapshot->level = gameElm->level;
+    snapshot->nbCompleteLines = gameElm->nbCompleteLines;
+
+    TLM_publish (telemetry, renderTime);
+}
+
+/* Returns the TLM_INPUT_* counted for a key */
+static int telemetryInput (SDLKey key)
+{
+    switch (key)
+    {
+        case SDLK_LEFT:
+            return TLM_INPUT_LEFT;
+        case SDLK_RIGHT:
+            return TLM_INPUT_RIGHT;
+        case SDLK_UP:
+            return TLM_INPUT_ROTATE;
+        case SDLK_DOWN:
+            return TLM_INPUT_DOWN;
+        case SDLK_p:
+            return TLM_INPUT_PAUSE;
+        default:
+            return TLM_INPUT_OTHER;
+    }
+}
+
+Uint8 playGame (RND_Backend *backend, Sprites *sprites, TBP_Session *bot, SPEC_Encoder *spectators, TLM_Mapping *telemetry,
+                CAP_Capture *capture)
 {
     /* Variables */
     Uint8 continueProg = 1, continueGame = 1; /* Booleans */
     GameElements gameElm;
     SDL_Event event;
     Uint8 newTetrimGenerated = 0; /* Booleans */
-    Uint32 actualTime = 0, lastScreen_time = 0; /* time info */
+    Uint32 actualTime = 0, lastScreen_time = 0, start_time = 0; /* time info */
+    Uint64 render_time = 0; /* time info, in microseconds */
     Uint32 lastMove_time = 0, lastFall_time = 0, onStack_time = 0; /* time info */
     Uint32 movingPeriod = MOVING_PERIOD_START, falling_period; /* period info */
     Uint32 normalFalling_period = 1000; /* period info */
     Uint8 movingTetrimToLeft = 0, movingTetrimToRight = 0; /* Booleans */
     Uint8 hard_drop = 0, tetrimOnStack = 0; /* Booleans */
-    int new_points = 0;
     int nbMovesOnStack = 0;
     int nbLines = 0;
     Direction direction = DIR_LEFT;
-    SDL_Surface *gameOver = NULL;
-    SDL_Rect position;
-    SDL_Color orange = {255, 128, 0};
 
     /* Initialize game elements */
     if ( ! initGameElements (&gameElm) )
@@ -90,9 +201,6 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
         return 0;
     }
 
-    /* Set up "game over" panel */
-    gameOver = TTF_RenderText_Blended(sprites->main_font, "GAME OVER", orange);
-
     /* Update the period info */
     normalFalling_period = 1000;
     falling_period = normalFalling_period;
@@ -101,9 +209,10 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
     actualTime = SDL_GetTicks();
     lastFall_time = actualTime;
     lastMove_time = actualTime;
+    start_time = actualTime;
 
     /* Trigger the opening animation */
-    anim_opening(screen, sprites);
+    anim_opening(backend, sprites);
 
     /* Main loop */
     while (continueGame && continueProg)
@@ -115,7 +224,14 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
             putTetrim (gameElm.nextTetrimMap, gameElm.nextTetrim);
             lastFall_time = SDL_GetTicks();
             lastMove_time = lastFall_time;
-            updateScreen(screen, sprites, &gameElm);
+
+            /* The tetrimino dropped by the bot is locked without delay */
+            if (bot != NULL && newTetrimGenerated && botDropsTetrim (bot, &gameElm))
+            {
+                tetrimOnStack = 1;
+                onStack_time = lastFall_time - LOCK_DELAY;
+            }
+            updateScreen(backend, sprites, &gameElm);
         }
 
         /* Manage the events */
@@ -130,16 +246,21 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
                     if ( ( (event.active.state & SDL_APPACTIVE) == SDL_APPACTIVE
                         || (event.active.state & SDL_APPINPUTFOCUS) == SDL_APPINPUTFOCUS )
                         && event.active.gain == 0)
-                        pause (screen);
+                        pause (backend, sprites);
+                    break;
+                case SDL_VIDEOEXPOSE:
+                    RND_invalidate (&sprites->drawn);
                     break;
                 case SDL_KEYDOWN:
+                    if (telemetry != NULL)
+                        TLM_countInput (telemetry, telemetryInput (event.key.keysym.sym));
                     switch (event.key.keysym.sym)
                     {
                         case SDLK_ESCAPE:
                             continueGame = 0;
                             break;
                         case SDLK_p:
-                            continueProg = pause(screen);
+                            continueProg = pause(backend, sprites);
                             break;
                         case SDLK_UP:
                             tetrimRotates (&gameElm);
@@ -188,9 +309,7 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
                                 else
                                 {
                                     hard_drop = 1;
-                                    new_points = 2;
-                                    gameElm.score = ((gameElm.score + new_points) < SCORE_MAX) ?
-                                                                (gameElm.score + new_points) : SCORE_MAX;
+                                    gameElm.score = RULE_addPoints (gameElm.score, SOFT_DROP_POINTS);
                                 }
                             }
                             else
@@ -199,9 +318,7 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
                                 if (! tetrimOnStack)
                                 {
                                     nbMovesOnStack = 0;
-                                    new_points = 2;
-                                    gameElm.score = ((gameElm.score + new_points) < SCORE_MAX) ?
-                                                                (gameElm.score + new_points) : SCORE_MAX;
+                                    gameElm.score = RULE_addPoints (gameElm.score, SOFT_DROP_POINTS);
                                 }
                                 lastFall_time = SDL_GetTicks();
                             }
@@ -258,9 +375,7 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
                     onStack_time = SDL_GetTicks();
                 else if (hard_drop)
                 {
-                    new_points = 2;
-                    gameElm.score = ((gameElm.score + new_points) < SCORE_MAX) ?
-                                                        (gameElm.score + new_points) : SCORE_MAX;
+                    gameElm.score = RULE_addPoints (gameElm.score, SOFT_DROP_POINTS);
                 }
                 lastFall_time = actualTime;
             }
@@ -278,35 +393,17 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
             if ( locksTetrim(&gameElm) ) /* If there is at least one complete line */
             {
                 /* Clear the complete lines */
-                nbLines = clearCompleteLines (screen, sprites, &gameElm);
+                nbLines = clearCompleteLines (backend, sprites, &gameElm);
                 gameElm.nbCompleteLines += nbLines;
 
                 /* Update the score */
-                switch (nbLines)
-                {
-                    case 0:
-                        break;
-                    case 1:
-                        new_points = 100*gameElm.level;
-                        break;
-                    case 2:
-                        new_points += 300*gameElm.level;
-                        break;
-                    case 3:
-                        new_points += 500*gameElm.level;
-                        break;
-                    case 4:
-                        new_points += 800*gameElm.level;
-                        break;
-                }
-                gameElm.score = ( gameElm.score + new_points < SCORE_MAX) ?
-                                                    (gameElm.score + new_points) : SCORE_MAX;
+                gameElm.score = RULE_addPoints (gameElm.score, RULE_linesPoints (nbLines, gameElm.level));
 
                 /* Updates the level */
-                if (gameElm.nbCompleteLines >= gameElm.level*10)
+                if (RULE_nextLevel (gameElm.level, gameElm.nbCompleteLines) != gameElm.level)
                 {
                     gameElm.level++;
-                    normalFalling_period = pow( 0.8 - ((gameElm.level-1)*0.007), gameElm.level-1)*1000;
+                    normalFalling_period = RULE_fallingPeriod (gameElm.level);
                     falling_period = (falling_period == HARD_DROP_PERIOD) ?
                                                     HARD_DROP_PERIOD : normalFalling_period;
                 }
@@ -320,19 +417,28 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
         /* Refresh the screen */
         if ( actualTime - lastScreen_time >= 30 )
         {
-            updateScreen (screen, sprites, &gameElm);
+            render_time = PLT_getTimeUs ();
+            updateScreen (backend, sprites, &gameElm);
+            render_time = PLT_getTimeUs () - render_time;
             lastScreen_time = actualTime;
+            if (spectators != NULL)
+                streamGame (spectators, &gameElm, 0);
+            if (telemetry != NULL)
+                publishGame (telemetry, &gameElm, 0, actualTime - start_time, (Uint32)render_time);
+            if (capture != NULL)
+                CAP_submit (capture, backend->screen, 0);
         }
 
         /* Prints game over if the generation of a new tetrim failed */
         if (!newTetrimGenerated)
         {
-            position.w = 200;
-            position.h = 200;
-            position.x = screen->w/2 - gameOver->w/2;
-            position.y = screen->h/2 - gameOver->h/2;
-            SDL_BlitSurface(gameOver, NULL, screen, &position);
-            SDL_Flip (screen);
+            RND_showOverlay (&sprites->drawn, backend, sprites->txt_gameOver);
+            if (spectators != NULL)
+                streamGame (spectators, &gameElm, 1);
+            if (telemetry != NULL)
+                publishGame (telemetry, &gameElm, 1, actualTime - start_time, 0);
+            if (capture != NULL)
+                CAP_submit (capture, backend->screen, 0);
 
             /* Oblige the player to quit the game or the program */
             while (continueProg && continueGame)
@@ -347,9 +453,223 @@ Uint8 playGame (SDL_Surface *screen, Sprites *sprites)
         } /* Game over */
     } /* Main Loop */
 
+    if (bot != NULL)
+        TBP_stopGame (bot);
+
     freeGameElements (&gameElm);
 
-    SDL_FreeSurface (gameOver);
+    return continueProg;
+}
+
+typedef struct PipelineRenderer PipelineRenderer;
+
+/* The render thread of playPipelinedGame. It draws in a screen in memory, the main thread copies the parts
+   presented in the window when it receives an SDL_USEREVENT : only the main thread calls the video functions */
+struct PipelineRenderer
+{
+    PIPE_Game *game;
+    RND_Backend memory;
+    Sprites *sprites;
+    PIPE_Pacing pacing;
+    SDL_mutex *lock; /* Held while the screen in memory is drawn or copied */
+    Uint8 presentPending; /* Boolean : 1 once the SDL_USEREVENT is queued, until the main thread copies the screen */
+    volatile int stop;
+    volatile int exposed; /* Set by the main thread when the window must be drawn again */
+};
+
+static int renderPipeline (void *data)
+{
+    /* Variables */
+    PipelineRenderer *renderer = (PipelineRenderer*)data;
+    Sprites *sprites = renderer->sprites;
+    const PIPE_Snapshot *snapshot = NULL;
+    SDL_Event present;
+    Uint64 frameTime;
+    Uint8 fresh, overShown = 0, pauseShown = 0; /* Booleans */
+
+    present.type = SDL_USEREVENT;
+    present.user.code = 0;
+    present.user.data1 = present.user.data2 = NULL;
+
+    while (!renderer->stop)
+    {
+        frameTime = PIPE_waitFrame (&renderer->pacing);
+        if (renderer->exposed)
+        {
+            renderer->exposed = 0;
+            RND_invalidate (&sprites->drawn);
+            overShown = pauseShown = 0;
+        }
+
+        /* Nothing is drawn under an overlay until it is hidden */
+        snapshot = PIPE_latest (&renderer->game->snapshots, &fresh);
+        if (snapshot->sequence == 0 || overShown || (pauseShown && snapshot->paused))
+            continue;
+
+        SDL_LockMutex (renderer->lock);
+        if (pauseShown)
+        {
+            RND_hideOverlay (&sprites->drawn, &renderer->memory);
+            pauseShown = 0;
+        }
+
+        RND_drawFrameAt (&sprites->drawn, &renderer->memory, &sprites->tiles, &sprites->digits, &snapshot->frame,
+                         SDL_GetTicks (), PIPE_fallOffset (snapshot, frameTime));
+        /* Prints game over like playGame, once, or the pause */
+        if (snapshot->frame.over)
+        {
+            RND_showOverlay (&sprites->drawn, &renderer->memory, sprites->txt_gameOver);
+            overShown = 1;
+        }
+        else if (snapshot->paused)
+        {
+            RND_showOverlay (&sprites->drawn, &renderer->memory, sprites->txt_pause);
+            pauseShown = 1;
+        }
+
+        /* SDL_PushEvent is the only function of SDL 1.2 that can be called from any thread to reach the main one */
+        if (renderer->memory.nbPresented != 0 && !renderer->presentPending)
+            renderer->presentPending = (SDL_PushEvent (&present) == 0);
+        SDL_UnlockMutex (renderer->lock);
+
+        PIPE_endFrame (&renderer->pacing, frameTime);
+    }
+
+    return 0;
+}
+
+/* Returns the LIVE_KEY_* of a key, -1 if it is not one of the game */
+static int liveKey (SDLKey key)
+{
+    switch (key)
+    {
+        case SDLK_LEFT:
+            return LIVE_KEY_LEFT;
+        case SDLK_RIGHT:
+            return LIVE_KEY_RIGHT;
+        case SDLK_UP:
+            return LIVE_KEY_UP;
+        case SDLK_DOWN:
+            return LIVE_KEY_DOWN;
+        default:
+            return -1;
+    }
+}
+
+Uint8 playPipelinedGame (RND_Backend *backend, Sprites *sprites, int refreshRate)
+{
+    /* Variables */
+    Uint8 continueProg = 1, continueGame = 1; /* Booleans */
+    PIPE_Game *game = (PIPE_Game*)malloc(sizeof(PIPE_Game));
+    PipelineRenderer renderer;
+    SDL_Thread *thread = NULL;
+    SDL_Event event;
+    PIPE_Input input;
+
+    if (game == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the game\n");
+        return 1;
+    }
+
+    /* The screen in memory must have the format of the window, the tiles being in this format */
+    if (!RND_openMemory (&renderer.memory, backend->screen->w, backend->screen->h))
+    {
+        free (game);
+        return 1;
+    }
+    renderer.lock = SDL_CreateMutex ();
+    if (renderer.lock == NULL || renderer.memory.screen->format->Rmask != backend->screen->format->Rmask
+        || renderer.memory.screen->format->Gmask != backend->screen->format->Gmask
+        || renderer.memory.screen->format->Bmask != backend->screen->format->Bmask)
+    {
+        fprintf(stderr, "The render thread cannot draw in the format of the window, -threads is not available\n");
+        if (renderer.lock != NULL)
+            SDL_DestroyMutex (renderer.lock);
+        RND_closeBackend (&renderer.memory);
+        free (game);
+        return 1;
+    }
+
+    renderer.game = game;
+    renderer.sprites = sprites;
+    renderer.presentPending = 0;
+    renderer.stop = 0;
+    renderer.exposed = 0;
+    PIPE_initPacing (&renderer.pacing, refreshRate);
+
+    anim_opening (backend, sprites);
+
+    PIPE_init (game, ((Uint32)time (NULL) << 1) | 1);
+    if (PIPE_start (game))
+    {
+        thread = SDL_CreateThread (renderPipeline, &renderer);
+        if (thread == NULL)
+            fprintf(stderr, "Impossible to create the render thread : %s\n", SDL_GetError() );
+    }
+
+    while (thread != NULL && continueGame && continueProg && SDL_WaitEvent (&event))
+    {
+        input.time = PLT_getTimeUs ();
+        input.type = PIPE_NB_INPUTS;
+        switch (event.type)
+        {
+            case SDL_QUIT:
+                continueProg = 0;
+                break;
+            case SDL_VIDEOEXPOSE:
+                renderer.exposed = 1;
+                break;
+            case SDL_USEREVENT:
+                SDL_LockMutex (renderer.lock);
+                RND_presentCopy (&renderer.memory, backend);
+                renderer.presentPending = 0;
+                SDL_UnlockMutex (renderer.lock);
+                break;
+            case SDL_KEYDOWN:
+                if (event.key.keysym.sym == SDLK_ESCAPE)
+                    continueGame = 0;
+                else if (event.key.keysym.sym == SDLK_p)
+                    input.type = PIPE_INPUT_PAUSE;
+                else if (liveKey (event.key.keysym.sym) >= 0)
+                {
+                    input.type = PIPE_INPUT_KEY_DOWN;
+                    input.key = liveKey (event.key.keysym.sym);
+                }
+                break;
+            case SDL_KEYUP:
+                if (liveKey (event.key.keysym.sym) >= 0)
+                {
+                    input.type = PIPE_INPUT_KEY_UP;
+                    input.key = liveKey (event.key.keysym.sym);
+                }
+                break;
+            default:
+                break;
+        }
+        if (input.type != PIPE_NB_INPUTS && !PIPE_push (&game->inputs, &input))
+            fprintf(stderr, "The simulation is late : an input has been lost\n");
+    }
+
+    if (thread != NULL)
+    {
+        renderer.stop = 1;
+        SDL_WaitThread (thread, NULL);
+    }
+    PIPE_stop (game);
+    /* The last frame drawn, then the screen is the one of the main thread again */
+    RND_presentCopy (&renderer.memory, backend);
+    RND_invalidate (&sprites->drawn);
+
+    if (game->nbInputs > 0)
+        fprintf(stdout, "%llu inputs applied %.0f us after their reception on average, %llu us at most\n",
+                (unsigned long long)game->nbInputs, (double)game->totalLatency/game->nbInputs,
+                (unsigned long long)game->maxLatency);
+    PIPE_printPacing ("Frames", &renderer.pacing);
+
+    SDL_DestroyMutex (renderer.lock);
+    RND_closeBackend (&renderer.memory);
+    free (game);
 
     return continueProg;
 }
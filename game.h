@@ -10,14 +10,16 @@
 #define LOCK_DELAY              500
 #define MAX_MOVES_ON_STACK       10
 
-#define SCORE_MAX               999999999
-
 
 typedef struct Position Position;
 typedef struct GameElements GameElements;
 
 #include "animation.h"
 #include "linked_list.h"
+#include "tbp.h"
+#include "spectate.h"
+#include "telemetry.h"
+#include "capture.h"
 
 enum { TETRIM_I, TETRIM_O, TETRIM_T, TETRIM_L, TETRIM_J, TETRIM_Z, TETRIM_S };
 
@@ -59,8 +61,19 @@ Uint8 initGameElements (GameElements *gameElm);
 
 void freeGameElements (GameElements *gameElm);
 
-/** \brief The main function of the game. The one that calls all the other **/
-Uint8 playGame (SDL_Surface *screen, Sprites*);
+/** \brief The main function of the game. The one that calls all the other.
+    If bot is not NULL, the tetriminoes are placed by the bot, the player can still quit or pause the game.
+    If spectators is not NULL, the game is written in the spectator stream at each refresh of the screen.
+    If telemetry is not NULL, the game, the inputs and the times of the refreshes are published in it.
+    If capture is not NULL, the screen is given to it at each refresh : it is dropped if the writer is late **/
+Uint8 playGame (RND_Backend*, Sprites*, TBP_Session *bot, SPEC_Encoder *spectators, TLM_Mapping *telemetry,
+                CAP_Capture *capture);
+
+/** Plays a game like playGame with the inputs, the simulation and the rendering on three threads (see pipeline.h).
+    The screen is refreshed refreshRate times per second, the falling tetrimino going down between the lines.
+    Returns a boolean : 0 if the player wants to quit the program. The latency of the inputs and the pacing
+    of the frames are printed in the stdout file at the end of the game **/
+Uint8 playPipelinedGame (RND_Backend*, Sprites*, int refreshRate);
 
 /** The function returns a boolean : 1 if a new tetrimino has been generated successfully, 0 if not **/
 Uint8 generateNewTetrim (GameElements *gameElm);
@@ -165,6 +165,21 @@ int LNK_getNbElm (LNK_List *LNK_list)
     return nbElm;
 }
 
+int LNK_getContent (LNK_List *LNK_list)
+{
+        /* Variables */
+    int content = 0;
+    Element *actualElm = NULL;
+
+    if (LNK_list == NULL)
+        return 0;
+
+    for (actualElm = LNK_list->firstElm; actualElm != NULL; actualElm = actualElm->next)
+        content |= 1 << actualElm->tetrim;
+
+    return content;
+}
+
 void LNK_fillBag (LNK_List *bag)
 {
     if (bag == NULL)
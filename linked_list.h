@@ -46,6 +46,9 @@ int LNK_drawTetrim (LNK_List*);
 /** Returns the number of elements in the list (number of remaining tetriminoes in the bag) **/
 int LNK_getNbElm (LNK_List*);
 
+/** Returns the tetriminoes left in the bag : the bit t is set if the tetrimino t is in the bag **/
+int LNK_getContent (LNK_List*);
+
 /** Fills the list with all the 7 differents elements (fills the bag with the 7 different tetriminoes **/
 void LNK_fillBag (LNK_List *bag);
 
@@ -0,0 +1,363 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "sim.h"
+#include "ai.h"
+#include "live.h"
+
+/* Moves of block1 tested by tetrimRotates, for each rotation state before the turn.
+   The first table is for the I, the second one for the other tetriminoes */
+static const int kicks[2][4][5][2] =
+{
+    {
+        {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}},
+        {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}},
+        {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}},
+        {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}}
+    },
+    {
+        {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},
+        {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},
+        {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
+        {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}}
+    }
+};
+
+/* Returns a boolean : 1 if the tetrimino can be put at (x, y) without going above the playfield */
+static Uint8 fits (const LiveGame *live, int rotation, int x, int y)
+{
+    return y + BB_getShape (live->game.actualTetrim, rotation)->top >= 0
+           && !BB_collides (&live->game.board, live->game.actualTetrim, rotation, x, y);
+}
+
+/* Same as tetrimFalls : returns a boolean, 1 if the tetrimino touches the stack */
+static Uint8 falls (LiveGame *live)
+{
+    if (!fits (live, live->rotation, live->x, live->y + 1))
+        return 1;
+    live->y++;
+    return 0;
+}
+
+static void moves (LiveGame *live, Uint8 right)
+{
+    int x = live->x + (right ? 1 : -1);
+
+    if (fits (live, live->rotation, x, live->y))
+        live->x = x;
+}
+
+/* Same as tetrimRotates : returns a boolean, 1 if the tetrimino has turned */
+static Uint8 rotates (LiveGame *live)
+{
+    const int (*tests)[2] = kicks[(live->game.actualTetrim == TETRIM_I) ? 0 : 1][live->rotation];
+    int rotation = (live->rotation + 1) % BB_NB_ROTATIONS, n;
+
+    for (n = 0; n < 5; n++)
+    {
+        if (fits (live, rotation, live->x + tests[n][0], live->y + tests[n][1]))
+        {
+            live->rotation = rotation;
+            live->x += tests[n][0];
+            live->y += tests[n][1];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* A move on the stack delays the lock, a limited number of times */
+static void delaysLock (LiveGame *live)
+{
+    if (live->onStack)
+    {
+        live->nbMovesOnStack++;
+        if (live->nbMovesOnStack < MAX_MOVES_ON_STACK)
+            live->onStackTime = live->time;
+    }
+}
+
+/* Same as generateNewTetrim */
+static void bringNextTetrim (LiveGame *live)
+{
+    SimGame *game = &live->game;
+
+    game->actualTetrim = game->nextTetrim;
+    game->nextTetrim = SIM_drawTetrim (&game->bag, &game->seed);
+    live->rotation = 0;
+    live->x = BB_spawnColumn (game->actualTetrim);
+    live->y = FIRST_LINE;
+    live->lastFallTime = live->lastMoveTime = live->time;
+    if (BB_collides (&game->board, game->actualTetrim, 0, live->x, live->y))
+        game->over = 1;
+}
+
+/* Colors the blocks of the tetrimino put in the board like locksTetrim, then removes the colors of the lines
+   that are complete like BB_clearLines */
+static void paints (LiveGame *live)
+{
+    /* Variables */
+    static const Uint8 blocks[7] = {BLOCK_CYAN, BLOCK_YELLOW, BLOCK_PURPLE, BLOCK_ORANGE, BLOCK_BLUE, BLOCK_RED, BLOCK_GREEN};
+    const PieceShape *shape = BB_getShape (live->game.actualTetrim, live->rotation);
+    int i, j, l;
+
+    for (l = 0; l < 4; l++)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            if ((shape->rows[l] & (1 << i)) && live->y + l >= 0 && live->y + l < NB_BLOCK_Y
+                && live->x + i >= 0 && live->x + i < NB_BLOCK_X)
+                live->colors[live->y + l][live->x + i] = blocks[live->game.actualTetrim];
+        }
+    }
+
+    for (j = NB_BLOCK_Y-1, l = NB_BLOCK_Y-1; j >= 0; j--)
+    {
+        if (live->game.board.rows[j] == BB_FULL_ROW)
+            continue;
+        if (l != j)
+            memcpy (live->colors[l], live->colors[j], NB_BLOCK_X);
+        l--;
+    }
+    for (; l >= 0; l--)
+        memset (live->colors[l], BLOCK_VOID, NB_BLOCK_X);
+}
+
+/* Same as locksTetrim followed by the update of the lines, the score and the level */
+static void locks (LiveGame *live)
+{
+    SimGame *game = &live->game;
+    int nbLines;
+
+    while (!falls (live))
+        ;
+    BB_putPiece (&game->board, game->actualTetrim, live->rotation, live->x, live->y);
+    paints (live);
+    nbLines = BB_clearLines (&game->board);
+    game->nbPieces++;
+    game->nbCompleteLines += nbLines;
+    game->score = RULE_addPoints (game->score, RULE_linesPoints (nbLines, game->level));
+    if (RULE_nextLevel (game->level, game->nbCompleteLines) != game->level)
+    {
+        game->level++;
+        live->normalFallingPeriod = RULE_fallingPeriod (game->level);
+        live->fallingPeriod = (live->fallingPeriod == HARD_DROP_PERIOD) ? HARD_DROP_PERIOD : live->normalFallingPeriod;
+    }
+
+    live->onStack = 0;
+    live->nbMovesOnStack = 0;
+    bringNextTetrim (live);
+}
+
+void LIVE_init (LiveGame *live, Uint32 seed)
+{
+    SIM_init (&live->game, seed);
+    memset (live->colors, BLOCK_VOID, sizeof(live->colors));
+    live->rotation = 0;
+    live->x = BB_spawnColumn (live->game.actualTetrim);
+    live->y = FIRST_LINE;
+
+    live->time = 0;
+    live->lastFallTime = live->lastMoveTime = live->onStackTime = 0;
+    live->normalFallingPeriod = live->fallingPeriod = RULE_fallingPeriod (1);
+    live->movingPeriod = MOVING_PERIOD_START;
+    live->keysHeld = 0;
+    live->movingRight = 0;
+    live->onStack = 0;
+    live->softDrop = 0;
+    live->nbMovesOnStack = 0;
+}
+
+Uint8 LIVE_keyDown (LiveGame *live, int key)
+{
+    /* Variables */
+    SimGame *game = &live->game;
+    int rotation = live->rotation, x = live->x, y = live->y;
+
+    if (game->over || key < 0 || key >= LIVE_NB_KEYS)
+        return 0;
+    live->keysHeld |= 1 << key;
+
+    switch (key)
+    {
+        case LIVE_KEY_UP:
+            rotates (live);
+            delaysLock (live);
+            break;
+        case LIVE_KEY_LEFT:
+        case LIVE_KEY_RIGHT:
+            live->movingRight = (key == LIVE_KEY_RIGHT);
+            moves (live, live->movingRight);
+            live->movingPeriod = MOVING_PERIOD_START;
+            delaysLock (live);
+            live->lastMoveTime = live->time;
+            break;
+        case LIVE_KEY_DOWN:
+            live->fallingPeriod = (live->normalFallingPeriod < HARD_DROP_PERIOD) ? live->normalFallingPeriod : HARD_DROP_PERIOD;
+            if (!live->onStack)
+            {
+                live->onStack = falls (live);
+                if (live->onStack)
+                    live->onStackTime = live->time;
+                else
+                {
+                    live->softDrop = 1;
+                    game->score = RULE_addPoints (game->score, SOFT_DROP_POINTS);
+                }
+            }
+            else
+            {
+                live->onStack = falls (live);
+                if (!live->onStack)
+                {
+                    live->nbMovesOnStack = 0;
+                    game->score = RULE_addPoints (game->score, SOFT_DROP_POINTS);
+                }
+            }
+            live->lastFallTime = live->time;
+            break;
+    }
+
+    return rotation != live->rotation || x != live->x || y != live->y;
+}
+
+Uint8 LIVE_keyUp (LiveGame *live, int key)
+{
+    if (key < 0 || key >= LIVE_NB_KEYS)
+        return 0;
+    live->keysHeld &= ~(1 << key);
+
+    switch (key)
+    {
+        case LIVE_KEY_DOWN:
+            live->fallingPeriod = live->normalFallingPeriod;
+            live->softDrop = 0;
+            break;
+        case LIVE_KEY_LEFT:
+            if (live->keysHeld & (1 << LIVE_KEY_RIGHT))
+                live->movingRight = 1;
+            break;
+        case LIVE_KEY_RIGHT:
+            if (live->keysHeld & (1 << LIVE_KEY_LEFT))
+                live->movingRight = 0;
+            break;
+    }
+
+    return 0;
+}
+
+Uint8 LIVE_advance (LiveGame *live, Uint32 ms)
+{
+    /* Variables */
+    SimGame *game = &live->game;
+    Uint32 end = live->time + ms, moveTime, fallTime, lockTime, next;
+    Uint8 moving, changed = 0; /* Booleans */
+    int rotation, x, y;
+
+    /* The events of the main loop of playGame, in the order of their time */
+    while (!game->over)
+    {
+        moving = (live->keysHeld & ((1 << LIVE_KEY_LEFT) | (1 << LIVE_KEY_RIGHT))) != 0;
+        moveTime = moving ? live->lastMoveTime + live->movingPeriod : end + 1;
+        fallTime = live->lastFallTime + ((live->fallingPeriod > 0) ? live->fallingPeriod : 1); /* The period is 0 at high levels */
+        lockTime = live->onStack ? live->onStackTime + LOCK_DELAY : end + 1;
+
+        next = (moveTime < fallTime) ? moveTime : fallTime;
+        next = (lockTime < next) ? lockTime : next;
+        if (next > end)
+            break;
+        if (next > live->time)
+            live->time = next;
+
+        rotation = live->rotation;
+        x = live->x;
+        y = live->y;
+        if (next == moveTime)
+        {
+            moves (live, live->movingRight);
+            live->movingPeriod = MOVING_PERIOD;
+            live->lastMoveTime = live->time;
+        }
+        else if (next == fallTime)
+        {
+            if (!live->onStack)
+            {
+                live->onStack = falls (live);
+                if (live->onStack)
+                    live->onStackTime = live->time;
+                else if (live->softDrop)
+                    game->score = RULE_addPoints (game->score, SOFT_DROP_POINTS);
+            }
+            else
+                live->onStack = falls (live);
+            live->lastFallTime = live->time;
+        }
+        else
+        {
+            locks (live);
+            changed = 1;
+        }
+        changed |= (rotation != live->rotation || x != live->x || y != live->y);
+    }
+
+    live->time = end;
+
+    return changed;
+}
+
+void LIVE_initPilot (LIVE_Pilot *pilot, Uint32 seed)
+{
+    AI_defaultWeights (&pilot->weights);
+    pilot->key = -1;
+    pilot->piece = -1;
+    pilot->nbActions = 0;
+    pilot->seed = seed;
+    pilot->book = NULL;
+}
+
+void LIVE_pilot (LIVE_Pilot *pilot, LiveGame *live)
+{
+    Uint8 placed; /* Boolean */
+
+    if (live->game.over)
+        LIVE_init (live, BB_random (&pilot->seed) | 1);
+
+    if (live->game.nbPieces != pilot->piece)
+    {
+        if (pilot->key >= 0)
+            LIVE_keyUp (live, pilot->key);
+        pilot->key = -1;
+        pilot->piece = live->game.nbPieces;
+        pilot->nbActions = 0;
+        if (pilot->book != NULL)
+            placed = AI_bookPlacement (pilot->book, &live->game, &pilot->weights, &pilot->target);
+        else
+            placed = AI_bestPlacement (&live->game, &pilot->weights, &pilot->target);
+        if (!placed)
+            pilot->target.rotation = pilot->target.x = -100;
+    }
+    else if (pilot->key >= 0 && pilot->key != LIVE_KEY_DOWN)
+    {
+        LIVE_keyUp (live, pilot->key);
+        pilot->key = -1;
+    }
+    else if (pilot->key < 0)
+    {
+        if (live->rotation != pilot->target.rotation && pilot->target.rotation >= 0 && pilot->nbActions < 8)
+            pilot->key = LIVE_KEY_UP;
+        else if (live->x != pilot->target.x && pilot->target.rotation >= 0 && pilot->nbActions < 16)
+            pilot->key = (live->x < pilot->target.x) ? LIVE_KEY_RIGHT : LIVE_KEY_LEFT;
+        else
+            pilot->key = LIVE_KEY_DOWN;
+        LIVE_keyDown (live, pilot->key);
+        pilot->nbActions++;
+    }
+}
@@ -0,0 +1,72 @@
+/** live.h and live.cpp play a game in real time without any window, like playGame does.
+
+    The keys are the ones of playGame : LEFT and RIGHT move the tetrimino and repeat while they are held,
+    UP turns it (with the same tests as tetrimRotates), DOWN makes it fall faster and earns the soft drop points.
+    The time is given by the caller in milliseconds, so a server can make thousands of games progress
+    on its own clock. The timings (falling periods, auto-repeat, lock delay) are the ones of game.h.
+**/
+
+#ifndef LIVE_H_INCLUDED
+#define LIVE_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "bitboard.h"
+#include "sim.h"
+#include "ai.h"
+
+enum { LIVE_KEY_LEFT, LIVE_KEY_RIGHT, LIVE_KEY_UP, LIVE_KEY_DOWN, LIVE_NB_KEYS };
+
+typedef struct LiveGame LiveGame;
+typedef struct LIVE_Pilot LIVE_Pilot;
+
+struct LiveGame
+{
+    SimGame game; /* Locked blocks, bag, score, level and lines. game.over is set when a tetrimino cannot appear */
+    Uint8 colors[NB_BLOCK_Y][NB_BLOCK_X]; /* Color of the locked blocks (BLOCK_* of gMap), BLOCK_VOID elsewhere */
+    int rotation, x, y; /* Position of block1 of the active tetrimino */
+
+    Uint32 time; /* Milliseconds since the beginning of the game */
+    Uint32 lastFallTime, lastMoveTime, onStackTime;
+    Uint32 fallingPeriod, normalFallingPeriod, movingPeriod;
+    Uint8 keysHeld; /* Bit k set if the key LIVE_KEY_k is held */
+    Uint8 movingRight; /* Boolean : direction of the auto-repeat */
+    Uint8 onStack; /* Boolean : 1 if the active tetrimino touches the stack */
+    Uint8 softDrop; /* Boolean : 1 if the falls earn points */
+    int nbMovesOnStack;
+};
+
+/* Presses the keys like a player to bring each tetrimino to the placement chosen by the AI (benchmarks) */
+struct LIVE_Pilot
+{
+    AI_Weights weights;
+    Placement target;
+    int key; /* Key pressed, -1 if none */
+    int piece; /* Number of the tetrimino whose placement has been chosen */
+    int nbActions;
+    Uint32 seed; /* Seed of the next game */
+    const OpeningBook *book; /* If not NULL, the openings are played from it and the other placements searched
+                                with AI_bestPlacementWithNext (see AI_bookPlacement). NULL by default */
+};
+
+
+/** Starts a new game. The seed must not be 0 **/
+void LIVE_init (LiveGame*, Uint32 seed);
+
+/** The player presses or releases a key (LIVE_KEY_*) at the current time.
+    Returns a boolean : 1 if the active tetrimino has changed **/
+Uint8 LIVE_keyDown (LiveGame*, int key);
+Uint8 LIVE_keyUp (LiveGame*, int key);
+
+/** Makes the time go on by ms milliseconds : the held keys repeat, the tetrimino falls and is locked.
+    Returns a boolean : 1 if the playfield or the active tetrimino has changed **/
+Uint8 LIVE_advance (LiveGame*, Uint32 ms);
+
+/** Prepares a pilot. The seed must not be 0 **/
+void LIVE_initPilot (LIVE_Pilot*, Uint32 seed);
+
+/** Presses or releases a key before the next tick, and starts a new game if the game is over.
+    A key is pressed for one tick, except DOWN that is held until the tetrimino is locked **/
+void LIVE_pilot (LIVE_Pilot*, LiveGame*);
+
+#endif // LIVE_H_INCLUDED
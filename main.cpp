@@ -2,7 +2,7 @@
  *
  *  This source code use the SDL library version 1.2 with the extensions SDL_image and SDL_ttf
  *
- *  The source code is composed of 4 header and 4 source code files:
+ *  The source code is composed of 24 header and 24 source code files:
  *  constants.h
  *  main.cpp
  *  game.h
@@ -11,12 +11,56 @@
  *  animation.cpp
  *  linked_chain.h
  *  linked_chain.cpp
+ *  bitboard.h
+ *  bitboard.cpp
+ *  boardfeatures.h
+ *  boardfeatures.cpp
+ *  rules.h
+ *  rules.cpp
+ *  platform.h
+ *  platform.cpp
+ *  sim.h
+ *  sim.cpp
+ *  ai.h
+ *  ai.cpp
+ *  pcsolver.h
+ *  pcsolver.cpp
+ *  book.h
+ *  book.cpp
+ *  search.h
+ *  search.cpp
+ *  placecache.h
+ *  placecache.cpp
+ *  tbp.h
+ *  tbp.cpp
+ *  versus.h
+ *  versus.cpp
+ *  live.h
+ *  live.cpp
+ *  server.h
+ *  server.cpp
+ *  spectate.h
+ *  spectate.cpp
+ *  telemetry.h
+ *  telemetry.cpp
+ *  render.h
+ *  render.cpp
+ *  pipeline.h
+ *  pipeline.cpp
+ *  wall.h
+ *  wall.cpp
+ *  capture.h
+ *  capture.cpp
+ *
+ *  The tools directory contains command line programs that use the game files without the window (benchmarks...)
  *
  */
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <SDL/SDL.h>
 #include <SDL/SDL_image.h>
@@ -25,20 +69,117 @@
 #include "constants.h"
 #include "game.h"
 #include "animation.h"
+#include "tbp.h"
+#include "spectate.h"
+#include "telemetry.h"
+#include "render.h"
+#include "pipeline.h"
+#include "wall.h"
+#include "capture.h"
+
+/* Opens a file towards the bot of -tbp with the mode given, - for the standard file */
+static FILE* openBotFile (const char *name, const char *mode, FILE *standard)
+{
+    FILE *file = NULL;
+
+    if (strcmp (name, "-") == 0)
+    {
+#ifdef _WIN32
+        /* SDLmain writes the stdout file in stdout.txt and the program has no console to read */
+        fprintf(stderr, "-tbp cannot use the standard files on Windows : give two named pipes (\\\\.\\pipe\\name) "
+                        "or play with tbpgame\n");
+        return NULL;
+#else
+        return standard;
+#endif
+    }
+
+    file = fopen (name, mode);
+    if (file == NULL)
+        fprintf(stderr, "Impossible to open %s towards the bot\n", name);
+
+    return file;
+}
 
 int main ( int argc, char** argv )
 {
     /* Variables */
     SDL_Surface *screen = NULL, *title = NULL;
     SDL_Surface *start = NULL, *controls = NULL, *credits = NULL;
-    SDL_Surface *background = NULL, *cache = NULL;
-    double t, alpha;
+    SDL_Surface *background = NULL, *menu = NULL;
+    RND_Backend window;
+    Uint8 blink[MENU_BLINK_STEPS]; /* Opacity of the background over the selected string at each step */
+    int t, step, lastStep = -1;
+    Uint8 menuShown = 0; /* Boolean : 0 if the whole title screen must be drawn again */
     SDL_Color blue = {70, 140, 210};
-    SDL_Rect part, cache_part, position;
+    SDL_Rect part, selection, position;
     SDL_Event event;
     int continueProg = 1; // Boolean
     int player_choice = MENU_PLAY;
     Sprites sprites;
+    static TBP_Session botSession; /* Too big for the stack of some systems */
+    TBP_Session *bot = NULL;
+    FILE *toBot = NULL, *fromBot = NULL;
+    SPEC_Encoder spectatorStream;
+    SPEC_Encoder *spectators = NULL;
+    TLM_Mapping *telemetry = NULL;
+    const char *videoName = NULL;
+    CAP_Capture video;
+    CAP_Capture *capture = NULL;
+    Uint8 pipelined = 0; /* Boolean */
+    int refreshRate = PIPE_REFRESH_RATE;
+    int nbWallBoards = 0;
+    int scale = 0;
+    int n;
+
+    for (n = 1; n < argc; n++)
+    {
+        /* With -tbp toBot fromBot, the tetriminoes are placed by a bot (see tbp.h) : the messages are written in
+           the file toBot and the answers read in the file fromBot, two named pipes, opened in this order :
+               mkfifo to_bot from_bot
+               tbpbot < to_bot > from_bot &
+               tetrims -tbp to_bot from_bot
+           On Windows, the pipes are \\.\pipe\name, created by the program that runs the bot.
+           - stands for the stdout or the stdin file, only outside Windows, where the program has no console */
+        if (strcmp (argv[n], "-tbp") == 0 && n+2 < argc && bot == NULL)
+        {
+            toBot = openBotFile (argv[++n], "wb", stdout);
+            fromBot = (toBot != NULL) ? openBotFile (argv[++n], "rb", stdin) : NULL;
+            if (fromBot == NULL || !TBP_openSession (&botSession, fromBot, toBot))
+                exit (EXIT_FAILURE);
+            bot = &botSession;
+        }
+        /* With -spectate file or -spectate tcp:port, the games are streamed to the spectators (see spectate.h) */
+        else if (strcmp (argv[n], "-spectate") == 0 && n+1 < argc && spectators == NULL)
+        {
+            if (!SPEC_openStream (&spectatorStream, argv[++n], 30))
+                exit (EXIT_FAILURE);
+            spectators = &spectatorStream;
+        }
+        /* With -telemetry [name], the games are published in shared memory for local tools (see telemetry.h) */
+        else if (strcmp (argv[n], "-telemetry") == 0 && telemetry == NULL)
+        {
+            telemetry = TLM_openPublisher ((n+1 < argc && argv[n+1][0] != '-') ? argv[++n] : TLM_DEFAULT_NAME);
+            if (telemetry == NULL)
+                exit (EXIT_FAILURE);
+        }
+        /* With -threads, the inputs, the simulation and the rendering run on three threads (see pipeline.h).
+           The bot, the spectators, the telemetry and the capture are not available then */
+        else if (strcmp (argv[n], "-threads") == 0)
+            pipelined = 1;
+        /* With -refresh rate, the threads refresh the screen rate times per second, the refresh rate of the display */
+        else if (strcmp (argv[n], "-refresh") == 0 && n+1 < argc)
+            refreshRate = atoi (argv[++n]);
+        /* With -wall nbBoards, the window shows nbBoards games played by the AI instead of the game (see wall.h) */
+        else if (strcmp (argv[n], "-wall") == 0 && n+1 < argc)
+            nbWallBoards = atoi (argv[++n]);
+        /* With -scale n, the window is n times larger (1 to MAX_SCALE). By default, the largest one that fits the desktop */
+        else if (strcmp (argv[n], "-scale") == 0 && n+1 < argc)
+            scale = atoi (argv[++n]);
+        /* With -capture file, the frames of the games are recorded in a Y4M video (see capture.h), - for the stdout file */
+        else if (strcmp (argv[n], "-capture") == 0 && n+1 < argc)
+            videoName = argv[++n];
+    }
 
     /* SDL initialization */
     if ( SDL_Init( SDL_INIT_VIDEO ) < 0 )
@@ -58,12 +199,33 @@ int main ( int argc, char** argv )
     SDL_Surface *icon = IMG_Load("wall.png");
     SDL_WM_SetIcon (icon, NULL);
     SDL_WM_SetCaption ("Urban Tetrims", NULL);
-    screen = SDL_SetVideoMode(WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_HWSURFACE|SDL_DOUBLEBUF);
-    if (screen == NULL)
+    /* The scale is chosen before anything is sized with it */
+    RND_chooseScale (scale);
+    /* Software surface : the game presents only the parts of the window that have changed (see render.h) */
+    if (!RND_openWindow (&window, WINDOW_WIDTH, WINDOW_HEIGHT))
     {
         fprintf(stderr, "Impossible to open the window\n");
         exit(EXIT_FAILURE);
     }
+    screen = window.screen;
+
+    if (nbWallBoards > 0)
+    {
+        WALL_watch (&window, nbWallBoards, refreshRate, ((Uint32)time (NULL) << 1) | 1);
+        TLM_close (telemetry);
+        TTF_Quit();
+        RND_closeBackend (&window);
+        SDL_Quit();
+        return EXIT_SUCCESS;
+    }
+
+    /* The frames have the size and the format of the window */
+    if (videoName != NULL)
+    {
+        if (!CAP_open (&video, videoName, 0, screen, 30, 0))
+            exit (EXIT_FAILURE);
+        capture = &video;
+    }
 
     /* Load the sprites */
     if (!initSprites (&sprites, screen))
@@ -73,7 +235,7 @@ int main ( int argc, char** argv )
     }
 
     /* Print the background */
-    background = SDL_CreateRGBSurface (SDL_HWSURFACE, screen->w, screen->h, 32, 0, 0, 0, 0);
+    background = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, screen->w, screen->h, 32, 0, 0, 0, 0));
     position.x = 0;
     position.y = 0;
     SDL_BlitSurface (sprites.bg_left, NULL, background, &position);
@@ -84,54 +246,46 @@ int main ( int argc, char** argv )
     position.x = WINDOW_WIDTH/2;
     position.y = 0;
     SDL_BlitSurface (sprites.bg_right, &part, background, &position);
-    position.x = 0;
-    position.y = 0;
-    SDL_BlitSurface (background, NULL, screen, &position);
 
-    /* Write the menu's strings */
+    /* Compose the title screen once : the background and the menu's strings */
+    menu = RND_toDisplay (SDL_CreateRGBSurface (SDL_HWSURFACE, screen->w, screen->h, 32, 0, 0, 0, 0));
+    SDL_BlitSurface (background, NULL, menu, NULL);
     /* title */
-    title = TTF_RenderText_Blended (sprites.main_font, "URBAN TETRIMS", blue);
-    position.x = screen->w/2 - title->w/2;
-    position.y = screen->h/4 - title->h/2;
-    SDL_BlitSurface(title, NULL, screen, &position);
+    title = RND_toDisplay (TTF_RenderText_Blended (sprites.main_font, "URBAN TETRIMS", blue));
+    position.x = WINDOW_WIDTH/2 - title->w/2;
+    position.y = WINDOW_WIDTH/4 - title->h/2;
+    SDL_BlitSurface(title, NULL, menu, &position);
     /* start menu */
-    start = TTF_RenderText_Blended (sprites.main_font, "START", blue);
-    position.x = screen->w/2 - start->w/2;
+    start = RND_toDisplay (TTF_RenderText_Blended (sprites.main_font, "START", blue));
+    position.x = WINDOW_WIDTH/2 - start->w/2;
     position.y = START_POS;
-    SDL_BlitSurface(start, NULL, screen, &position);
+    SDL_BlitSurface(start, NULL, menu, &position);
     /* controls menu */
-    controls = TTF_RenderText_Blended (sprites.main_font, "CONTROLS", blue);
-    position.x = screen->w/2 - controls->w/2;
+    controls = RND_toDisplay (TTF_RenderText_Blended (sprites.main_font, "CONTROLS", blue));
+    position.x = WINDOW_WIDTH/2 - controls->w/2;
     position.y = START_POS + INTERLINE;
-    SDL_BlitSurface(controls, NULL, screen, &position);
+    SDL_BlitSurface(controls, NULL, menu, &position);
     /* credits menu */
-    credits = TTF_RenderText_Blended (sprites.main_font, "CREDITS", blue);
-    position.x = screen->w/2 - credits->w/2;
+    credits = RND_toDisplay (TTF_RenderText_Blended (sprites.main_font, "CREDITS", blue));
+    position.x = WINDOW_WIDTH/2 - credits->w/2;
     position.y = START_POS + 2*INTERLINE;
-    SDL_BlitSurface(credits, NULL, screen, &position);
+    SDL_BlitSurface(credits, NULL, menu, &position);
 
-    /* Prepares the cache */
-    cache = SDL_CreateRGBSurface (SDL_HWSURFACE, screen->w, screen->h, 32, 0, 0, 0, 0);
-    position.x = 0;
-    position.y = 0;
-    SDL_BlitSurface (background, NULL, cache, &position);
-
-    /* The color of the active tetrimino changes every time to make it blink */
-    /* The following code defines a bleach factor between 0.15 and 0.75 so the color of the active tetromino
-       is bleached from 25% to 75% then from 75% to 25% */
-    t = SDL_GetTicks() % 700;
-    if (t < 350)
-        alpha = 255*(t/350);
-    else
-        alpha = 255*((700-t)/350);
-    SDL_SetAlpha (cache, SDL_SRCALPHA, alpha);
-    cache_part.x = screen->w/2 - controls->w/2;
-    cache_part.y = START_POS;
-    cache_part.w = controls->w;
-    cache_part.h = controls->h;
-    SDL_BlitSurface (cache, &cache_part, screen, &cache_part);
-
-    SDL_Flip(screen);
+    /* The selected string blinks : the background covers it with an opacity going from 0 to 255 then from 255 to 0
+       every MENU_BLINK_PERIOD milliseconds. The opacities are computed once */
+    for (step = 0; step < MENU_BLINK_STEPS; step++)
+    {
+        t = step*MENU_BLINK_PERIOD/MENU_BLINK_STEPS;
+        if (t < MENU_BLINK_PERIOD/2)
+            blink[step] = 255*t/(MENU_BLINK_PERIOD/2);
+        else
+            blink[step] = 255*(MENU_BLINK_PERIOD-t)/(MENU_BLINK_PERIOD/2);
+    }
+    /* Part of the screen of the selected string, as wide as the widest one */
+    selection.x = WINDOW_WIDTH/2 - controls->w/2;
+    selection.y = START_POS;
+    selection.w = controls->w;
+    selection.h = controls->h;
 
     /* Main Loop */
     while (continueProg)
@@ -152,71 +306,71 @@ int main ( int argc, char** argv )
                     switch (player_choice)
                     {
                     case MENU_PLAY:
-                        continueProg = playGame (screen, &sprites);
+                        if (pipelined)
+                            continueProg = playPipelinedGame (&window, &sprites, refreshRate);
+                        else
+                            continueProg = playGame (&window, &sprites, bot, spectators, telemetry, capture);
                         break;
                     case MENU_CONTROLS:
-                        continueProg = menuControls (screen, background);
+                        continueProg = menuControls (&window, background);
                         break;
                     }
+                    menuShown = 0;
                     break;
                 case SDLK_DOWN:
                     if (player_choice + 1 != MENU_OUT)
                     {
                         player_choice++;
-                        cache_part.y += INTERLINE;
+                        /* The string left is shown again without blinking */
+                        position = selection;
+                        SDL_BlitSurface (menu, &selection, screen, &position);
+                        RND_updateRects (&window, 1, &selection);
+                        selection.y += INTERLINE;
+                        lastStep = -1;
                     }
                     break;
                 case SDLK_UP:
                     if (player_choice - 1 >= 0)
                     {
                         player_choice--;
-                        cache_part.y -= INTERLINE;
+                        /* The string left is shown again without blinking */
+                        position = selection;
+                        SDL_BlitSurface (menu, &selection, screen, &position);
+                        RND_updateRects (&window, 1, &selection);
+                        selection.y -= INTERLINE;
+                        lastStep = -1;
                     }
                     break;
                 default:
                     break;
                 }
         }
+        else
+            SDL_Delay (MENU_BLINK_PERIOD/MENU_BLINK_STEPS/2);
 
         if (continueProg)
         {
-            /* Refresh the title screen */
-            position.x = 0;
-            position.y = 0;
-            SDL_BlitSurface (background, NULL, screen, &position);
-
-            position.x = WINDOW_WIDTH/2 - title->w/2;
-            position.y = WINDOW_WIDTH/4 - title->h/2;
-            SDL_BlitSurface(title, NULL, screen, &position);
-
-            position.x = WINDOW_WIDTH/2 - start->w/2;
-            position.y = START_POS;
-            SDL_BlitSurface(start, NULL, screen, &position);
-
-            position.x = WINDOW_WIDTH/2 - controls->w/2;
-            position.y = START_POS + INTERLINE;
-            SDL_BlitSurface(controls, NULL, screen, &position);
-
-            position.x = WINDOW_WIDTH/2 - credits->w/2;
-            position.y = START_POS + 2*INTERLINE;
-            SDL_BlitSurface(credits, NULL, screen, &position);
-
-            t = SDL_GetTicks() % 700;
-            if (t < 350)
-                alpha = 255*(t/350);
-            else
-                alpha = 255*((700-t)/350);
-            SDL_SetAlpha (cache, SDL_SRCALPHA, alpha);
-            cache_part.x = screen->w/2 - controls->w/2;
-            cache_part.w = controls->w;
-            cache_part.h = controls->h;
-            SDL_BlitSurface (cache, &cache_part, screen, &cache_part);
-            SDL_Flip(screen);
+            if (!menuShown)
+            {
+                SDL_BlitSurface (menu, NULL, screen, NULL);
+                RND_flip (&window);
+                menuShown = 1;
+                lastStep = -1;
+            }
+
+            /* Only the selected string is drawn and presented, when its opacity changes */
+            step = (SDL_GetTicks() % MENU_BLINK_PERIOD) * MENU_BLINK_STEPS / MENU_BLINK_PERIOD;
+            if (step != lastStep)
+            {
+                RND_blend (screen, menu, background, &selection, blink[step]);
+                RND_updateRects (&window, 1, &selection);
+                lastStep = step;
+            }
         }
     }
 
     SDL_FreeSurface (background);
-    SDL_FreeSurface (cache);
+    SDL_FreeSurface (menu);
     SDL_FreeSurface (title);
     SDL_FreeSurface (start);
     SDL_FreeSurface (controls);
@@ -225,8 +379,23 @@ int main ( int argc, char** argv )
 
     freeSprites (&sprites);
 
+    if (bot != NULL)
+    {
+        TBP_closeSession (bot);
+        if (toBot != stdout)
+            fclose (toBot);
+        if (fromBot != stdin)
+            fclose (fromBot);
+    }
+    if (spectators != NULL)
+        SPEC_closeStream (spectators);
+    TLM_close (telemetry);
+    if (capture != NULL)
+        CAP_close (capture);
+
     TTF_Quit();
 
+    RND_closeBackend (&window);
     SDL_Quit();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "sim.h"
+#include "platform.h"
+#include "pcsolver.h"
+
+#define EVEN_COLUMNS    0x155 /* Columns 0, 2, 4, 6 and 8 */
+#define EVERY_LINE      0x0004010040100401ull /* Bit 0 of each line : a line mask times this one gives the same columns on every line */
+#define EMPTY_KEY       (~(Uint64)0) /* Impossible key : its lines would be full */
+
+/* The search works on a packed window : the bit k*NB_BLOCK_X+i is the column i of the line k, counted from the bottom */
+#define LINE_OF(window, k)      ((Uint16)((window) >> ((k)*NB_BLOCK_X)) & BB_FULL_ROW)
+#define WINDOW_MASK(nbLines)    (((Uint64)1 << ((nbLines)*NB_BLOCK_X)) - 1)
+
+typedef struct MemoEntry
+{
+    Uint64 key;
+    Uint32 stamp; /* The entry is only valid if its stamp is the one of the actual search */
+} MemoEntry;
+
+/* A tetrimino in a rotation state and a column, ready to be dropped on a packed window */
+typedef struct Drop
+{
+    Uint64 blocks; /* Blocks of the tetrimino when its lowest line is the bottom line of the window */
+    int rotation, x;
+    int y; /* Placement y when the lowest line of the tetrimino is the bottom line of the playfield */
+    int nbLines; /* Number of lines covered by the tetrimino */
+} Drop;
+
+struct PC_Solver
+{
+    MemoEntry *memo;
+    Uint32 memoMask;
+    Uint32 stamp;
+    Drop drops[7][SIM_MAX_PLACEMENTS];
+    int nbDrops[7];
+
+    /* The actual search */
+    const int *queue;
+    int nbPieces;
+    Uint8 findAll; /* Boolean */
+    Uint32 nodeLimit; /* 0 if the search is not limited */
+    Uint32 timeLimit; /* Microseconds, 0 if the search is not limited */
+    Uint64 deadline; /* PLT_getTimeUs when the actual search must stop */
+    int parityCapacity[PC_MAX_PIECES+1]; /* parityCapacity[n] : column parity the n first tetriminoes can fix */
+    int nbI[PC_MAX_PIECES+1]; /* nbI[n] : number of I among the n first tetriminoes */
+    Placement path[PC_MAX_PIECES];
+    Placement *solution;
+    int *nbUsed;
+    PC_Stats stats;
+};
+
+/* Number of rotations giving different blocks once dropped (the other ones are translations of these) */
+static const int nbRotations[7] = {2, 1, 4, 4, 4, 2, 2};
+
+/* Largest difference between the even and the odd columns a tetrimino can fill */
+static int parityOf (int tetrim)
+{
+    switch (tetrim)
+    {
+        case TETRIM_I:
+            return 4; /* Vertical I */
+        case TETRIM_T:
+        case TETRIM_L:
+        case TETRIM_J:
+            return 2;
+        default:
+            return 0; /* O, S and Z always fill 2 even and 2 odd cells */
+    }
+}
+
+static inline int popcount64 (Uint64 x)
+{
+    return BB_popcount ((Uint32)x) + BB_popcount ((Uint32)(x >> 32));
+}
+
+static inline Uint32 memoSlot (const PC_Solver *solver, Uint64 key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+
+    return (Uint32)key & solver->memoMask;
+}
+
+/* Fills the drops of every tetrimino, sorted by rotation then by column */
+static void initDrops (PC_Solver *solver)
+{
+    const PieceShape *shape = NULL;
+    Drop *drop = NULL;
+    int tetrim, rotation, x, l;
+
+    for (tetrim = 0; tetrim < 7; tetrim++)
+    {
+        solver->nbDrops[tetrim] = 0;
+        for (rotation = 0; rotation < nbRotations[tetrim]; rotation++)
+        {
+            shape = BB_getShape (tetrim, rotation);
+            for (x = -shape->left; x + shape->right < NB_BLOCK_X; x++)
+            {
+                drop = &solver->drops[tetrim][solver->nbDrops[tetrim]++];
+                drop->rotation = rotation;
+                drop->x = x;
+                drop->y = NB_BLOCK_Y-1 - shape->bottom;
+                drop->nbLines = shape->bottom - shape->top + 1;
+                drop->blocks = 0;
+                for (l = shape->top; l <= shape->bottom; l++)
+                    drop->blocks |= (Uint64)BB_shiftRow (shape->rows[l], x) << ((shape->bottom-l)*NB_BLOCK_X);
+            }
+        }
+    }
+}
+
+/* Removes the full lines of a packed window and returns their number */
+static inline int clearLines (Uint64 *window, int nbLines)
+{
+    Uint64 kept = 0;
+    Uint16 line;
+    int k, nbKept = 0;
+
+    for (k = 0; k < nbLines; k++)
+    {
+        line = LINE_OF (*window, k);
+        if (line != BB_FULL_ROW)
+            kept |= (Uint64)line << (nbKept++ * NB_BLOCK_X);
+    }
+    *window = kept;
+
+    return nbLines - nbKept;
+}
+
+/* Returns a boolean : 0 if the nbLines bottom lines can certainly not be filled by the tetriminoes from index */
+static Uint8 canBeFilled (const PC_Solver *solver, Uint64 window, int index, int nbLines)
+{
+    /* Variables */
+    Uint64 empty = ~window & WINDOW_MASK (nbLines), pairs;
+    int i, k, emptyCells, parity, nbNeeded, groupCells, nbNarrowPieces = 0;
+    Uint16 linked = 0, group = 0;
+
+    /* Area : the empty cells must be exactly filled by the next tetriminoes */
+    emptyCells = popcount64 (empty);
+    if (emptyCells % 4 != 0)
+        return 0;
+    nbNeeded = emptyCells / 4;
+    if (index + nbNeeded > solver->nbPieces)
+        return 0;
+
+    /* Parity : the tetriminoes that will be used must be able to fill the difference between the even and the odd columns */
+    parity = 2*popcount64 (empty & (EVEN_COLUMNS * EVERY_LINE)) - emptyCells;
+    if (abs (parity) > solver->parityCapacity[index + nbNeeded] - solver->parityCapacity[index])
+        return 0;
+
+    /* Clearing lines only brings together the cells of a same column. So two neighbouring columns that are never
+       empty on a same line will never be joined : the empty cells of each group of linked columns
+       must be filled by whole tetriminoes. A group of one column can only be filled by vertical I */
+    pairs = empty & (empty >> 1) & ((BB_FULL_ROW >> 1) * EVERY_LINE);
+    for (k = 0; k < nbLines; k++)
+        linked |= LINE_OF (pairs, k); /* The bit i is set if the columns i and i+1 are empty on a same line */
+    for (i = 0; i < NB_BLOCK_X; i++)
+    {
+        group |= 1 << i;
+        if (linked & (1 << i))
+            continue;
+        groupCells = popcount64 (empty & (group * EVERY_LINE));
+        if (groupCells % 4 != 0)
+            return 0;
+        if (group == (1 << i))
+            nbNarrowPieces += groupCells / 4;
+        group = 0;
+    }
+    if (nbNarrowPieces > solver->nbI[index + nbNeeded] - solver->nbI[index])
+        return 0;
+
+    return 1;
+}
+
+/* Lists the drops that stay in the nbLines bottom lines, with the line where each one lands. A tetrimino dropped
+   straight down stops above the highest block of each column it covers, so the window is first filled down from
+   the top of each column : the tetrimino lands on the lowest line where it does not meet this solid part.
+   The lowest drops come first : the bottom lines are the first to be completed */
+static int listDrops (const PC_Solver *solver, Uint64 window, int tetrim, int nbLines,
+                        const Drop *drops[SIM_MAX_PLACEMENTS], int landings[SIM_MAX_PLACEMENTS])
+{
+    const Drop *drop = NULL;
+    Uint64 solid = window;
+    int k, n, landing, nbListed = 0;
+
+    solid |= solid >> NB_BLOCK_X;
+    solid |= solid >> (2*NB_BLOCK_X);
+    solid |= solid >> (4*NB_BLOCK_X);
+
+    for (n = 0; n < solver->nbDrops[tetrim]; n++)
+    {
+        drop = &solver->drops[tetrim][n];
+        for (landing = 0; landing + drop->nbLines <= nbLines && (drop->blocks << (landing*NB_BLOCK_X) & solid); landing++);
+        if (landing + drop->nbLines > nbLines)
+            continue;
+
+        for (k = nbListed; k > 0 && landings[k-1] > landing; k--)
+        {
+            drops[k] = drops[k-1];
+            landings[k] = landings[k-1];
+        }
+        drops[k] = drop;
+        landings[k] = landing;
+        nbListed++;
+    }
+
+    return nbListed;
+}
+
+/* The playfield has already passed canBeFilled */
+static Uint8 search (PC_Solver *solver, Uint64 window, int index, int nbLines)
+{
+    /* Variables */
+    const Drop *drops[SIM_MAX_PLACEMENTS];
+    int landings[SIM_MAX_PLACEMENTS];
+    MemoEntry *entry = NULL;
+    Uint64 key, next;
+    int nbListed, k, nextLines;
+    Uint8 found = 0; /* Boolean */
+
+    /* All the lines have been cleared */
+    if (nbLines == 0)
+    {
+        if (solver->stats.solutions == 0)
+        {
+            for (k = 0; k < index; k++)
+                solver->solution[k] = solver->path[k];
+            *solver->nbUsed = index;
+        }
+        solver->stats.solutions++;
+        return 1;
+    }
+
+    key = window | (Uint64)index << (PC_MAX_LINES*NB_BLOCK_X);
+    entry = &solver->memo[memoSlot (solver, key)];
+    if (entry->stamp == solver->stamp && entry->key == key)
+    {
+        solver->stats.memoHits++;
+        return 0;
+    }
+
+    nbListed = listDrops (solver, window, solver->queue[index], nbLines, drops, landings);
+    for (k = 0; k < nbListed && (!found || solver->findAll); k++)
+    {
+        solver->stats.nodes++;
+        if ((solver->nodeLimit != 0 && solver->stats.nodes > solver->nodeLimit)
+            || (solver->timeLimit != 0 && solver->stats.nodes % PC_CLOCK_PERIOD == 0 && PLT_getTimeUs () > solver->deadline))
+            solver->stats.aborted = 1;
+        if (solver->stats.aborted)
+            break;
+
+        /* The cuts are made before recursing, so the dead playfields cost neither a call nor a memo lookup */
+        next = window | drops[k]->blocks << (landings[k]*NB_BLOCK_X);
+        nextLines = nbLines - clearLines (&next, nbLines);
+        if (nextLines > 0 && !canBeFilled (solver, next, index+1, nextLines))
+            continue;
+
+        solver->path[index].rotation = drops[k]->rotation;
+        solver->path[index].x = drops[k]->x;
+        solver->path[index].y = drops[k]->y - landings[k];
+        if (search (solver, next, index+1, nextLines))
+            found = 1;
+    }
+
+    if (!found && !solver->stats.aborted)
+    {
+        entry->key = key;
+        entry->stamp = solver->stamp;
+    }
+
+    return found;
+}
+
+PC_Solver* PC_createSolver (int memoBits)
+{
+    PC_Solver *solver = (PC_Solver*)malloc(sizeof(*solver));
+    Uint32 k;
+
+    if (solver == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the perfect clear solver\n");
+        return NULL;
+    }
+
+    if (memoBits < 8)
+        memoBits = 8;
+    else if (memoBits > 28)
+        memoBits = 28;
+    solver->memoMask = (1u << memoBits) - 1;
+    solver->memo = (MemoEntry*)malloc(sizeof(MemoEntry)*(solver->memoMask+1));
+    if (solver->memo == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the perfect clear memo\n");
+        free (solver);
+        return NULL;
+    }
+    for (k = 0; k <= solver->memoMask; k++)
+    {
+        solver->memo[k].key = EMPTY_KEY;
+        solver->memo[k].stamp = 0;
+    }
+    initDrops (solver);
+    solver->stamp = 0;
+    solver->nodeLimit = 0;
+    solver->timeLimit = 0;
+
+    return solver;
+}
+
+void PC_freeSolver (PC_Solver *solver)
+{
+    if (solver == NULL)
+        return;
+
+    free (solver->memo);
+    free (solver);
+}
+
+void PC_setNodeLimit (PC_Solver *solver, Uint32 nodeLimit)
+{
+    solver->nodeLimit = nodeLimit;
+}
+
+void PC_setTimeLimit (PC_Solver *solver, Uint32 timeLimit)
+{
+    solver->timeLimit = timeLimit;
+}
+
+int PC_solve (PC_Solver *solver, const Bitboard *board, const int *queue, int nbPieces, int nbLines, Uint8 findAll,
+                Placement solution[PC_MAX_PIECES], int *nbUsed, PC_Stats *stats)
+{
+    Uint64 window = 0;
+    int j, k, dummy = 0;
+    Uint8 found = 0; /* Boolean */
+
+    if (solver == NULL || nbLines <= 0 || nbLines > PC_MAX_LINES)
+        return PC_NONE;
+
+    /* Every block must already be in the lines to clear */
+    for (j = 0; j < NB_BLOCK_Y-nbLines; j++)
+    {
+        if (board->rows[j] != 0)
+            return PC_NONE;
+    }
+
+    if (nbPieces > PC_MAX_PIECES)
+        nbPieces = PC_MAX_PIECES;
+
+    /* A new stamp forgets the failures of the previous searches, which used another queue */
+    solver->stamp++;
+    if (solver->stamp == 0)
+    {
+        for (k = 0; k <= (int)solver->memoMask; k++)
+            solver->memo[k].stamp = 0;
+        solver->stamp = 1;
+    }
+
+    solver->queue = queue;
+    solver->nbPieces = nbPieces;
+    solver->findAll = findAll;
+    solver->solution = solution;
+    solver->nbUsed = (nbUsed != NULL) ? nbUsed : &dummy;
+    *solver->nbUsed = 0;
+    solver->stats.nodes = 0;
+    solver->stats.solutions = 0;
+    solver->stats.memoHits = 0;
+    solver->stats.aborted = 0;
+
+    solver->parityCapacity[0] = 0;
+    solver->nbI[0] = 0;
+    for (k = 0; k < nbPieces; k++)
+    {
+        solver->parityCapacity[k+1] = solver->parityCapacity[k] + parityOf (queue[k]);
+        solver->nbI[k+1] = solver->nbI[k] + (queue[k] == TETRIM_I);
+    }
+
+    for (k = 0; k < nbLines; k++)
+        window |= (Uint64)board->rows[NB_BLOCK_Y-1-k] << (k*NB_BLOCK_X);
+
+    solver->deadline = PLT_getTimeUs () + solver->timeLimit;
+    if (canBeFilled (solver, window, 0, nbLines))
+        found = search (solver, window, 0, nbLines);
+
+    if (stats != NULL)
+        *stats = solver->stats;
+
+    if (found)
+        return PC_FOUND;
+    return solver->stats.aborted ? PC_UNKNOWN : PC_NONE;
+}
+
+void PC_benchmark (int nbGames, Uint32 seed)
+{
+    /* Variables */
+    PC_Solver *solver = PC_createSolver (20);
+    Placement solution[PC_MAX_PIECES];
+    PC_Stats stats;
+    Bitboard board;
+    Uint8 bag;
+    Uint32 gameSeed;
+    int queue[10];
+    int n, k, nbUsed, nbSolved = 0;
+    int nbHints[3] = {0, 0, 0}; /* Results of the searches within PC_HINT_TIME */
+    Uint64 startTime, elapsed;
+    Uint64 solvedTime = 0, failedTime = 0, maxSolvedTime = 0, allTime = 0, maxHintTime = 0;
+    Uint64 nbNodes = 0, nbSolutions = 0;
+
+    if (solver == NULL || nbGames <= 0)
+    {
+        PC_freeSolver (solver);
+        return;
+    }
+
+    BB_clear (&board);
+    for (n = 0; n < nbGames; n++)
+    {
+        /* The first 10 tetriminoes of a game : the whole first bag and 3 tetriminoes of the second one */
+        bag = SIM_FULL_BAG;
+        gameSeed = BB_random (&seed) | 1;
+        for (k = 0; k < 10; k++)
+            queue[k] = SIM_drawTetrim (&bag, &gameSeed);
+
+        /* Time to the first solution, as the in-game hint would need */
+        startTime = PLT_getTimeUs ();
+        if (PC_solve (solver, &board, queue, 10, 4, 0, solution, &nbUsed, &stats) == PC_FOUND)
+        {
+            elapsed = PLT_getTimeUs () - startTime;
+            nbSolved++;
+            solvedTime += elapsed;
+            if (elapsed > maxSolvedTime)
+                maxSolvedTime = elapsed;
+        }
+        else
+            failedTime += PLT_getTimeUs () - startTime;
+
+        /* The same search within the budget of a hint */
+        PC_setTimeLimit (solver, PC_HINT_TIME);
+        startTime = PLT_getTimeUs ();
+        nbHints[PC_solve (solver, &board, queue, 10, 4, 0, solution, &nbUsed, &stats)]++;
+        elapsed = PLT_getTimeUs () - startTime;
+        if (elapsed > maxHintTime)
+            maxHintTime = elapsed;
+        PC_setTimeLimit (solver, 0);
+
+        /* Exhaustive search */
+        startTime = PLT_getTimeUs ();
+        PC_solve (solver, &board, queue, 10, 4, 1, solution, &nbUsed, &stats);
+        allTime += PLT_getTimeUs () - startTime;
+        nbNodes += stats.nodes;
+        nbSolutions += stats.solutions;
+    }
+
+    fprintf(stdout, "Perfect clear benchmark : 4 lines, first 10 tetriminoes of %d games\n", nbGames);
+    fprintf(stdout, "Sequences with a perfect clear : %d / %d\n", nbSolved, nbGames);
+    if (nbSolved > 0)
+        fprintf(stdout, "First solution    : %8.3f ms on average, %8.3f ms at most\n",
+                solvedTime/1000.0/nbSolved, maxSolvedTime/1000.0);
+    if (nbSolved < nbGames)
+        fprintf(stdout, "Proof of failure  : %8.3f ms on average\n", failedTime/1000.0/(nbGames-nbSolved));
+    fprintf(stdout, "Within %.1f ms     : %d found, %d without solution, %d unknown, %8.3f ms at most\n",
+            PC_HINT_TIME/1000.0, nbHints[PC_FOUND], nbHints[PC_NONE], nbHints[PC_UNKNOWN], maxHintTime/1000.0);
+    fprintf(stdout, "All solutions     : %8.3f ms on average, %12.0f solutions/s, %12.0f nodes/s\n",
+            allTime/1000.0/nbGames, nbSolutions*1000000.0/(allTime+1), nbNodes*1000000.0/(allTime+1));
+
+    PC_freeSolver (solver);
+}
@@ -0,0 +1,66 @@
+/** pcsolver.h and pcsolver.cpp look for a perfect clear : a way to drop a known sequence of tetriminoes
+    so that the bottom lines of the playfield are completely cleared and nothing is left.
+
+    The search only uses the bottom nbLines lines of the playfield, packed in 64 bits. It prunes the playfields
+    that cannot be filled anymore (number of empty cells, parity of the columns, groups of columns that
+    line clears can never join) before searching them, and remembers the playfields that have already failed.
+
+    The tetriminoes are only dropped straight down from above : no slide or rotation under an overhang.
+    PC_NONE means that there is no perfect clear this way, not that there is none at all.
+    Proving that there is none can take much longer than finding one, so a search can be limited in
+    nodes or in time : PC_UNKNOWN is returned when it stops before it knows.
+**/
+
+#ifndef PCSOLVER_H_INCLUDED
+#define PCSOLVER_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "bitboard.h"
+#include "sim.h"
+
+#define PC_MAX_LINES        6 /* The 6 bottom lines fit in the 60 first bits of a memo key */
+#define PC_MAX_PIECES       (PC_MAX_LINES*NB_BLOCK_X/4)
+#define PC_HINT_TIME        2000 /* Microseconds of search for a hint during a game */
+#define PC_CLOCK_PERIOD     256 /* Nodes between two readings of the clock when the time is limited */
+
+enum { PC_NONE, PC_FOUND, PC_UNKNOWN }; /* Results of PC_solve */
+
+typedef struct PC_Solver PC_Solver;
+typedef struct PC_Stats PC_Stats;
+
+struct PC_Stats
+{
+    Uint32 nodes; /* Number of playfields examined */
+    Uint32 solutions; /* Number of solutions found */
+    Uint32 memoHits; /* Number of playfields recognized as already failed */
+    Uint8 aborted; /* Boolean : 1 if the search has been stopped by the node or the time limit */
+};
+
+
+/** Creates a solver that remembers at most 2^memoBits failed playfields **/
+PC_Solver* PC_createSolver (int memoBits);
+
+/** Frees a solver **/
+void PC_freeSolver (PC_Solver*);
+
+/** Stops the next searches after nodeLimit playfields (0 for no limit), so the solver can be used
+    with a time budget, e.g. for a hint during a game **/
+void PC_setNodeLimit (PC_Solver*, Uint32 nodeLimit);
+
+/** Stops the next searches after timeLimit microseconds (0 for no limit) **/
+void PC_setTimeLimit (PC_Solver*, Uint32 timeLimit);
+
+/** Looks for a perfect clear of the nbLines bottom lines, dropping the tetriminoes of queue in this order.
+    If findAll is 1, all the solutions are counted; otherwise the search stops at the first one.
+    The first solution found is written in solution (one placement per tetrimino used) and its length in nbUsed.
+    stats can be NULL. Returns PC_FOUND if there is at least one solution, PC_NONE if there is none with straight drops,
+    PC_UNKNOWN if the search has been stopped by a limit before finding one **/
+int PC_solve (PC_Solver*, const Bitboard*, const int *queue, int nbPieces, int nbLines, Uint8 findAll,
+                Placement solution[PC_MAX_PIECES], int *nbUsed, PC_Stats *stats);
+
+/** Solves the 4 lines perfect clear of the first 10 tetriminoes of nbGames seeded games, without limit
+    then within PC_HINT_TIME, and prints the speed of the solver and the results in the stdout file **/
+void PC_benchmark (int nbGames, Uint32 seed);
+
+#endif // PCSOLVER_H_INCLUDED
@@ -0,0 +1,491 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "live.h"
+#include "spectate.h"
+#include "render.h"
+#include "platform.h"
+#include "pipeline.h"
+
+/* Exchange of the slots between the threads, the fences being in platform.h */
+#if defined(__GNUC__)
+#define EXCHANGE(p, v)      __atomic_exchange_n ((p), (v), __ATOMIC_ACQ_REL)
+#else
+#define EXCHANGE(p, v)      (Uint32)InterlockedExchange ((volatile LONG*)(p), (LONG)(v))
+#endif
+
+void PIPE_initBuffer (PIPE_TripleBuffer *buffer)
+{
+    memset (buffer->slots, 0, sizeof(buffer->slots));
+    buffer->writing = 0;
+    buffer->middle = 1;
+    buffer->reading = 2;
+}
+
+PIPE_Snapshot* PIPE_writeSlot (PIPE_TripleBuffer *buffer)
+{
+    return &buffer->slots[buffer->writing];
+}
+
+void PIPE_publish (PIPE_TripleBuffer *buffer)
+{
+    /* The slot given back is either the one the render thread has left, or the previous snapshot it has not taken */
+    buffer->writing = EXCHANGE (&buffer->middle, (Uint32)buffer->writing | PIPE_FRESH) & ~PIPE_FRESH;
+}
+
+const PIPE_Snapshot* PIPE_latest (PIPE_TripleBuffer *buffer, Uint8 *fresh)
+{
+    *fresh = (buffer->middle & PIPE_FRESH) != 0;
+    if (*fresh)
+        buffer->reading = EXCHANGE (&buffer->middle, (Uint32)buffer->reading) & ~PIPE_FRESH;
+
+    return &buffer->slots[buffer->reading];
+}
+
+Uint8 PIPE_push (PIPE_Queue *queue, const PIPE_Input *input)
+{
+    Uint32 head = queue->head;
+
+    if (head - queue->tail == PIPE_QUEUE_SIZE)
+        return 0;
+
+    queue->inputs[head % PIPE_QUEUE_SIZE] = *input;
+    PLT_RELEASE_FENCE ();
+    queue->head = head + 1;
+
+    return 1;
+}
+
+Uint8 PIPE_pop (PIPE_Queue *queue, PIPE_Input *input)
+{
+    Uint32 tail = queue->tail;
+
+    if (tail == queue->head)
+        return 0;
+
+    PLT_ACQUIRE_FENCE ();
+    *input = queue->inputs[tail % PIPE_QUEUE_SIZE];
+    PLT_RELEASE_FENCE ();
+    queue->tail = tail + 1;
+
+    return 1;
+}
+
+/* Publishes the state of the game */
+static void publishGame (PIPE_Game *game)
+{
+    PIPE_Snapshot *snapshot = PIPE_writeSlot (&game->snapshots);
+
+    SPEC_frameFromLive (&snapshot->frame, &game->live);
+    snapshot->gameTime = game->live.time;
+    snapshot->sequence = ++game->nbPublished;
+    snapshot->publishTime = PLT_getTimeUs ();
+    snapshot->piece = game->live.game.nbPieces;
+    snapshot->lastFallTime = game->live.lastFallTime;
+    snapshot->fallingPeriod = game->live.fallingPeriod;
+    snapshot->falling = !game->live.game.over && !BB_collides (&game->live.game.board, game->live.game.actualTetrim,
+                                                                game->live.rotation, game->live.x, game->live.y + 1);
+    snapshot->paused = game->paused;
+    PIPE_publish (&game->snapshots);
+}
+
+void PIPE_init (PIPE_Game *game, Uint32 seed)
+{
+    LIVE_init (&game->live, seed);
+    PIPE_initBuffer (&game->snapshots);
+    game->inputs.head = game->inputs.tail = 0;
+    game->lastStepTime = PLT_getTimeUs ();
+    game->paused = 0;
+    game->stop = 0;
+    game->thread = NULL;
+    game->nbInputs = game->totalLatency = game->maxLatency = 0;
+    game->nbPublished = 0;
+
+    publishGame (game);
+}
+
+void PIPE_step (PIPE_Game *game)
+{
+    /* Variables */
+    PIPE_Input input;
+    Uint64 now = PLT_getTimeUs (), latency;
+    Uint32 ms = (Uint32)((now - game->lastStepTime)/1000);
+    Uint8 changed = 0; /* Boolean */
+
+    game->lastStepTime += (Uint64)ms*1000;
+    if (!game->paused && ms > 0)
+        changed = LIVE_advance (&game->live, ms);
+
+    while (PIPE_pop (&game->inputs, &input))
+    {
+        switch (input.type)
+        {
+            case PIPE_INPUT_KEY_DOWN:
+                if (!game->paused)
+                    changed |= LIVE_keyDown (&game->live, input.key);
+                break;
+            case PIPE_INPUT_KEY_UP:
+                changed |= LIVE_keyUp (&game->live, input.key);
+                break;
+            case PIPE_INPUT_PAUSE:
+                game->paused = !game->paused;
+                changed = 1;
+                break;
+            default:
+                break;
+        }
+
+        latency = PLT_getTimeUs () - input.time;
+        game->nbInputs++;
+        game->totalLatency += latency;
+        if (latency > game->maxLatency)
+            game->maxLatency = latency;
+    }
+
+    if (changed)
+        publishGame (game);
+}
+
+static int simulate (void *data)
+{
+    PIPE_Game *game = (PIPE_Game*)data;
+
+    while (!game->stop)
+    {
+        PIPE_step (game);
+        SDL_Delay (PIPE_SIM_PERIOD);
+    }
+
+    return 0;
+}
+
+Uint8 PIPE_start (PIPE_Game *game)
+{
+    game->stop = 0;
+    game->lastStepTime = PLT_getTimeUs ();
+    game->thread = SDL_CreateThread (simulate, game);
+    if (game->thread == NULL)
+    {
+        fprintf(stderr, "Impossible to create the thread of the simulation : %s\n", SDL_GetError() );
+        return 0;
+    }
+
+    return 1;
+}
+
+void PIPE_stop (PIPE_Game *game)
+{
+    if (game->thread == NULL)
+        return;
+
+    game->stop = 1;
+    SDL_WaitThread (game->thread, NULL);
+    game->thread = NULL;
+}
+
+int PIPE_fallOffset (const PIPE_Snapshot *snapshot, Uint64 now)
+{
+    double gameTime = snapshot->gameTime, progress;
+
+    if (!snapshot->falling || snapshot->fallingPeriod == 0)
+        return 0;
+
+    /* The game has gone on since the snapshot was published, unless it is paused */
+    if (!snapshot->paused && now > snapshot->publishTime)
+        gameTime += (now - snapshot->publishTime)/1000.0;
+    progress = (gameTime - snapshot->lastFallTime)/snapshot->fallingPeriod;
+    if (progress <= 0)
+        return 0;
+    if (progress >= 1)
+        return BLOCK_SIZE-1;
+
+    return (int)(progress*BLOCK_SIZE);
+}
+
+void PIPE_initPacing (PIPE_Pacing *pacing, int refreshRate)
+{
+    memset (pacing, 0, sizeof(PIPE_Pacing));
+    pacing->period = 1000000/((refreshRate > 0) ? refreshRate : PIPE_REFRESH_RATE);
+    pacing->nextFrame = PLT_getTimeUs ();
+}
+
+Uint64 PIPE_waitFrame (PIPE_Pacing *pacing)
+{
+    Uint64 now = PLT_getTimeUs ();
+    Uint32 interval;
+
+    /* SDL_Delay sleeps whole milliseconds : the rest is waited by giving the processor to the other threads */
+    if (pacing->nextFrame > now + 1000)
+        SDL_Delay ((Uint32)((pacing->nextFrame - now)/1000));
+    for (now = PLT_getTimeUs (); now < pacing->nextFrame; now = PLT_getTimeUs ())
+        SDL_Delay (0);
+
+    if (pacing->lastFrame > 0)
+    {
+        interval = (Uint32)(now - pacing->lastFrame);
+        pacing->bars[(interval/PIPE_PACING_STEP < PIPE_PACING_BARS) ? interval/PIPE_PACING_STEP : PIPE_PACING_BARS-1]++;
+        pacing->nbFrames++;
+        pacing->totalInterval += interval;
+        pacing->totalSquares += (Uint64)interval*interval;
+        if (interval > pacing->maxInterval)
+            pacing->maxInterval = interval;
+        if (interval > pacing->period + pacing->period/2)
+            pacing->nbLate++;
+    }
+    pacing->lastFrame = now;
+
+    /* A late frame does not make the next ones come sooner */
+    pacing->nextFrame += pacing->period;
+    if (pacing->nextFrame < now)
+        pacing->nextFrame = now + pacing->period;
+
+    return now;
+}
+
+void PIPE_endFrame (PIPE_Pacing *pacing, Uint64 frameTime)
+{
+    Uint32 duration = (Uint32)(PLT_getTimeUs () - frameTime);
+
+    pacing->totalDraw += duration;
+    if (duration > pacing->maxDraw)
+        pacing->maxDraw = duration;
+}
+
+/* Returns the interval under which there is a given part of the intervals, in milliseconds */
+static double pacingPercentile (const PIPE_Pacing *pacing, double part)
+{
+    Uint64 count = 0;
+    int n;
+
+    for (n = 0; n < PIPE_PACING_BARS; n++)
+    {
+        count += pacing->bars[n];
+        if (count >= part*pacing->nbFrames)
+            break;
+    }
+
+    return (n+1)*PIPE_PACING_STEP/1000.0;
+}
+
+void PIPE_printPacing (const char *name, const PIPE_Pacing *pacing)
+{
+    double mean, deviation;
+
+    if (pacing->nbFrames == 0)
+        return;
+
+    mean = (double)pacing->totalInterval/pacing->nbFrames;
+    deviation = (double)pacing->totalSquares/pacing->nbFrames - mean*mean;
+    deviation = (deviation > 0) ? sqrt (deviation) : 0;
+    fprintf(stdout, "%s : %u frames, %.1f per second (%.1f expected), interval of %.2f ms (deviation %.2f ms), "
+            "50%% under %.2f ms, 99%% under %.2f ms, %.2f ms at most, %u late\n",
+            name, pacing->nbFrames, 1e6/mean, 1e6/pacing->period, mean/1e3, deviation/1e3,
+            pacingPercentile (pacing, 0.5), pacingPercentile (pacing, 0.99), pacing->maxInterval/1e3, pacing->nbLate);
+    fprintf(stdout, "%*s   drawn and presented in %.2f ms on average, %.2f ms at most\n", (int)strlen (name), "",
+            (double)pacing->totalDraw/pacing->nbFrames/1e3, pacing->maxDraw/1e3);
+}
+
+typedef struct BenchKeys BenchKeys;
+
+/* Presses keys at random times, like a player, in the queue of the simulation */
+struct BenchKeys
+{
+    PIPE_Queue *queue;
+    volatile int stop;
+    Uint32 seed;
+    Uint32 nbLost;
+};
+
+static int pressKeys (void *data)
+{
+    BenchKeys *keys = (BenchKeys*)data;
+    PIPE_Input input;
+    static const int pressed[3] = {LIVE_KEY_LEFT, LIVE_KEY_RIGHT, LIVE_KEY_UP};
+
+    while (!keys->stop)
+    {
+        SDL_Delay (5 + BB_random (&keys->seed)%35);
+        input.key = pressed[BB_random (&keys->seed)%3];
+        input.type = PIPE_INPUT_KEY_DOWN;
+        input.time = PLT_getTimeUs ();
+        keys->nbLost += !PIPE_push (keys->queue, &input);
+        input.type = PIPE_INPUT_KEY_UP;
+        keys->nbLost += !PIPE_push (keys->queue, &input);
+    }
+
+    return 0;
+}
+
+void PIPE_benchmark (int seconds, int presentMs, Uint32 seed)
+{
+    /* Variables */
+    const int presents[2] = {0, presentMs};
+    RND_Backend memory;
+    SDL_Surface *hud = NULL; /* Not drawn by the pipeline */
+    PIPE_Game *game = (PIPE_Game*)malloc(sizeof(PIPE_Game));
+    const PIPE_Snapshot *snapshot = NULL;
+    RND_Screen drawn;
+    RND_Digits digits;
+    RND_Tiles tiles;
+    BenchKeys keys;
+    SDL_Thread *thread = NULL;
+    Uint64 startTime, now, nextFrame;
+    Uint32 nbFrames, nbDrawn;
+    Uint8 threaded, fresh; /* Booleans */
+    int p;
+
+    if (game == NULL || !RND_openBenchRenderer (&memory, &hud, NULL, &digits, &tiles))
+    {
+        free (game);
+        return;
+    }
+
+    fprintf(stdout, "Pipeline : %d s for each run, a frame every %d ms, keys pressed every 5 to 40 ms\n",
+            seconds, PIPE_REFRESH_PERIOD);
+
+    for (threaded = 0; threaded < 2; threaded++)
+    {
+        for (p = 0; p < 2; p++)
+        {
+            PIPE_init (game, seed);
+            RND_init (&drawn, 0);
+            keys.queue = &game->inputs;
+            keys.stop = 0;
+            keys.seed = seed;
+            keys.nbLost = 0;
+            thread = SDL_CreateThread (pressKeys, &keys);
+            if (threaded)
+                PIPE_start (game);
+
+            /* The loop of playGame, or the render thread of PIPE_play */
+            nbFrames = nbDrawn = 0;
+            startTime = nextFrame = PLT_getTimeUs ();
+            for (now = startTime; now - startTime < (Uint64)seconds*1000000; now = PLT_getTimeUs ())
+            {
+                if (!threaded)
+                    PIPE_step (game);
+
+                if (now >= nextFrame)
+                {
+                    snapshot = PIPE_latest (&game->snapshots, &fresh);
+                    RND_drawFrame (&drawn, &memory, &tiles, &digits, &snapshot->frame, (Uint32)((now - startTime)/1000));
+                    SDL_Delay (presents[p]);
+                    nbFrames++;
+                    nbDrawn += fresh;
+                    nextFrame += PIPE_REFRESH_PERIOD*1000;
+                    if (nextFrame < PLT_getTimeUs ())
+                        nextFrame = PLT_getTimeUs ();
+                }
+                else
+                    SDL_Delay (PIPE_SIM_PERIOD);
+            }
+
+            keys.stop = 1;
+            if (thread != NULL)
+                SDL_WaitThread (thread, NULL);
+            PIPE_stop (game);
+            /* The inputs of the last step */
+            PIPE_step (game);
+
+            fprintf(stdout, "    %s, present of %2d ms : latency of the inputs %.2f ms on average, %.2f ms at most "
+                    "(%llu inputs, %u lost), %u frames, %u snapshots published, %u drawn\n",
+                    threaded ? "Two threads" : "One thread ", presents[p],
+                    game->nbInputs ? game->totalLatency/1e3/game->nbInputs : 0.0, game->maxLatency/1e3,
+                    (unsigned long long)game->nbInputs, keys.nbLost, nbFrames, game->nbPublished, nbDrawn);
+        }
+    }
+
+    RND_closeBenchRenderer (&memory, hud, &digits, &tiles);
+    free (game);
+}
+
+void PIPE_pacingBenchmark (int seconds, int refreshRate, Uint32 seed)
+{
+    /* Variables */
+    RND_Backend memory;
+    SDL_Surface *hud = NULL; /* Not drawn by the pipeline */
+    PIPE_Game *game = (PIPE_Game*)malloc(sizeof(PIPE_Game));
+    const PIPE_Snapshot *snapshot = NULL;
+    RND_Screen drawn;
+    RND_Digits digits;
+    RND_Tiles tiles;
+    PIPE_Pacing pacing;
+    BenchKeys keys;
+    SDL_Thread *thread = NULL;
+    Uint64 startTime, frameTime;
+    Uint32 lastPiece, nbMoves, totalMove;
+    Uint8 interpolated, fresh; /* Booleans */
+    int offset, pixel, lastPixel, maxMove;
+
+    if (game == NULL || !RND_openBenchRenderer (&memory, &hud, NULL, &digits, &tiles))
+    {
+        free (game);
+        return;
+    }
+
+    fprintf(stdout, "Pacing : %d s for each run, %d frames per second, a step of the simulation every %d ms\n",
+            seconds, refreshRate, PIPE_SIM_PERIOD);
+
+    for (interpolated = 0; interpolated < 2; interpolated++)
+    {
+        PIPE_init (game, seed);
+        RND_init (&drawn, 0);
+        keys.queue = &game->inputs;
+        keys.stop = 0;
+        keys.seed = seed;
+        keys.nbLost = 0;
+        thread = SDL_CreateThread (pressKeys, &keys);
+        PIPE_start (game);
+        PIPE_initPacing (&pacing, refreshRate);
+
+        /* The moves of the active tetrimino down the screen between two frames */
+        lastPiece = 0xFFFFFFFF;
+        lastPixel = 0;
+        nbMoves = totalMove = 0;
+        maxMove = 0;
+
+        startTime = PLT_getTimeUs ();
+        do
+        {
+            frameTime = PIPE_waitFrame (&pacing);
+            snapshot = PIPE_latest (&game->snapshots, &fresh);
+            offset = interpolated ? PIPE_fallOffset (snapshot, frameTime) : 0;
+            RND_drawFrameAt (&drawn, &memory, &tiles, &digits, &snapshot->frame, (Uint32)((frameTime - startTime)/1000), offset);
+            PIPE_endFrame (&pacing, frameTime);
+
+            pixel = snapshot->frame.y*BLOCK_SIZE + offset;
+            if (snapshot->piece == lastPiece && pixel > lastPixel)
+            {
+                nbMoves++;
+                totalMove += pixel - lastPixel;
+                if (pixel - lastPixel > maxMove)
+                    maxMove = pixel - lastPixel;
+            }
+            lastPiece = snapshot->piece;
+            lastPixel = pixel;
+        } while (frameTime - startTime < (Uint64)seconds*1000000);
+
+        keys.stop = 1;
+        if (thread != NULL)
+            SDL_WaitThread (thread, NULL);
+        PIPE_stop (game);
+
+        PIPE_printPacing (interpolated ? "    Tetrimino between the lines" : "    Tetrimino on the lines     ", &pacing);
+        fprintf(stdout, "        it goes down in %u frames of %u, by %.1f pixels on average, %d pixels at most\n",
+                nbMoves, pacing.nbFrames + 1, nbMoves ? (double)totalMove/nbMoves : 0.0, maxMove);
+    }
+
+    RND_closeBenchRenderer (&memory, hud, &digits, &tiles);
+    free (game);
+}
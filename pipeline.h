@@ -0,0 +1,177 @@
+/** pipeline.h and pipeline.cpp play a game with the simulation, the rendering and the inputs on three threads.
+
+    In playGame, the events, the falls of the tetrimino and the refreshes of the screen follow one another on one
+    thread : an input or a fall waits until the screen has been presented. Here :
+        - the main thread waits for the events of SDL and queues the keys, with the time they have been received
+        - the simulation thread plays a LiveGame (see live.h) : it applies the keys queued, makes the time go on
+          and publishes a PIPE_Snapshot of the game when it has changed
+        - the render thread draws the last snapshot published at the refresh rate of the display and presents it
+    The keys go from the main thread to the simulation in a queue with one writer and one reader, the snapshots
+    from the simulation to the render thread in a triple buffer : the simulation writes a slot of its own then
+    exchanges it with the middle slot, the render thread exchanges its slot with the middle one if a new snapshot
+    is there. Nobody waits for anybody : a slow present only makes the render thread skip snapshots.
+
+    The simulation keeps its own rate, whatever the refresh rate. Between two falls, the render thread draws the
+    active tetrimino on its way to the next line, from the time the snapshot tells it has last fallen and the time
+    that has passed since it was published (PIPE_fallOffset). The intervals between the frames are measured
+    in a PIPE_Pacing.
+
+    playPipelinedGame (game.h) plays in the window this way. The video and event functions of SDL 1.2 are not
+    thread-safe (on X11, all of them use one display connection) : the render thread draws in a screen in memory
+    and asks the main thread with an SDL_USEREVENT to copy the parts presented in the window (RND_presentCopy).
+    A frame reaches the window once the main thread has handled the events queued before it.
+**/
+
+#ifndef PIPELINE_H_INCLUDED
+#define PIPELINE_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "live.h"
+#include "spectate.h"
+
+#define PIPE_QUEUE_SIZE         64 /* Inputs waiting for the simulation, a power of 2 */
+#define PIPE_SIM_PERIOD         1 /* Milliseconds between two steps of the simulation */
+#define PIPE_REFRESH_PERIOD     30 /* Milliseconds between two frames, like playGame */
+#define PIPE_REFRESH_RATE       60 /* Frames per second of the render thread by default */
+#define PIPE_PACING_BARS        256 /* Bars of the histogram of the intervals between frames */
+#define PIPE_PACING_STEP        250 /* Microseconds per bar. The last bar holds the longer intervals */
+#define PIPE_FRESH              4 /* Set in the middle slot of a triple buffer until the render thread takes it */
+
+enum { PIPE_INPUT_KEY_DOWN, PIPE_INPUT_KEY_UP, PIPE_INPUT_PAUSE, PIPE_NB_INPUTS };
+
+typedef struct PIPE_Snapshot PIPE_Snapshot;
+typedef struct PIPE_TripleBuffer PIPE_TripleBuffer;
+typedef struct PIPE_Input PIPE_Input;
+typedef struct PIPE_Queue PIPE_Queue;
+typedef struct PIPE_Game PIPE_Game;
+typedef struct PIPE_Pacing PIPE_Pacing;
+
+/* State of the game published by the simulation. It is not modified once published */
+struct PIPE_Snapshot
+{
+    SPEC_Frame frame;
+    Uint32 gameTime; /* Milliseconds since the beginning of the game */
+    Uint32 sequence; /* Number of the snapshot since the beginning of the game, 0 if none has been published */
+    Uint64 publishTime; /* Microseconds of PLT_getTimeUs */
+    Uint32 piece; /* Number of the active tetrimino since the beginning of the game */
+    Uint32 lastFallTime, fallingPeriod; /* Milliseconds of the game */
+    Uint8 falling; /* Boolean : 1 if the active tetrimino will go down one line at lastFallTime + fallingPeriod */
+    Uint8 paused; /* Boolean */
+};
+
+struct PIPE_TripleBuffer
+{
+    PIPE_Snapshot slots[3];
+    volatile Uint32 middle; /* Slot exchanged between the threads, with PIPE_FRESH if it has not been taken */
+    int writing; /* Slot of the simulation thread */
+    int reading; /* Slot of the render thread */
+};
+
+struct PIPE_Input
+{
+    Uint8 type; /* PIPE_INPUT_* */
+    Uint8 key; /* LIVE_KEY_* */
+    Uint64 time; /* When it has been received, in microseconds of PLT_getTimeUs */
+};
+
+/* Inputs from one writer to one reader */
+struct PIPE_Queue
+{
+    PIPE_Input inputs[PIPE_QUEUE_SIZE];
+    volatile Uint32 head; /* Written by the writer only */
+    volatile Uint32 tail; /* Written by the reader only */
+};
+
+struct PIPE_Game
+{
+    LiveGame live; /* Only accessed by the simulation */
+    PIPE_TripleBuffer snapshots;
+    PIPE_Queue inputs;
+    Uint64 lastStepTime; /* Microseconds, the part of a millisecond not simulated yet is kept */
+    Uint8 paused; /* Boolean */
+    volatile int stop;
+    SDL_Thread *thread;
+
+    /* Measures of the simulation */
+    Uint64 nbInputs, totalLatency, maxLatency; /* From the reception of an input to its application, in microseconds */
+    Uint32 nbPublished;
+};
+
+/* Intervals between the frames of a render loop */
+struct PIPE_Pacing
+{
+    Uint32 period; /* Microseconds expected between two frames */
+    Uint64 nextFrame, lastFrame; /* Microseconds of PLT_getTimeUs */
+    Uint32 bars[PIPE_PACING_BARS];
+    Uint32 nbFrames; /* Measured, the first one excepted */
+    Uint32 nbLate; /* Frames that came more than half a period late */
+    Uint64 totalInterval, totalSquares; /* Sums of the intervals and of their squares, in microseconds */
+    Uint32 maxInterval;
+    Uint64 totalDraw; /* Time spent to draw and to present, in microseconds */
+    Uint32 maxDraw;
+};
+
+
+/** Prepares an empty triple buffer **/
+void PIPE_initBuffer (PIPE_TripleBuffer*);
+
+/** Slot where the simulation writes the next snapshot **/
+PIPE_Snapshot* PIPE_writeSlot (PIPE_TripleBuffer*);
+
+/** Makes the snapshot written in PIPE_writeSlot the last one published. The simulation gets another slot **/
+void PIPE_publish (PIPE_TripleBuffer*);
+
+/** Last snapshot published, that stays valid until the next call. *fresh is set to 1 if it has not been returned
+    before. Its sequence is 0 if nothing has been published yet **/
+const PIPE_Snapshot* PIPE_latest (PIPE_TripleBuffer*, Uint8 *fresh);
+
+/** Queues an input. Returns a boolean : 0 if the queue is full **/
+Uint8 PIPE_push (PIPE_Queue*, const PIPE_Input*);
+
+/** Takes the oldest input. Returns a boolean : 0 if the queue is empty **/
+Uint8 PIPE_pop (PIPE_Queue*, PIPE_Input*);
+
+/** Starts a new game and publishes its first snapshot. The seed must not be 0 **/
+void PIPE_init (PIPE_Game*, Uint32 seed);
+
+/** Applies the inputs queued, makes the time go on until now, and publishes a snapshot if the game has changed **/
+void PIPE_step (PIPE_Game*);
+
+/** Calls PIPE_step every PIPE_SIM_PERIOD milliseconds on a thread of its own until PIPE_stop.
+    Returns a boolean : 0 if the thread cannot be created **/
+Uint8 PIPE_start (PIPE_Game*);
+
+/** Stops the thread of the simulation **/
+void PIPE_stop (PIPE_Game*);
+
+/** Number of pixels the active tetrimino of the snapshot has gone down to the next line at a time of PLT_getTimeUs,
+    from 0 to BLOCK_SIZE-1. 0 if it is not falling **/
+int PIPE_fallOffset (const PIPE_Snapshot*, Uint64 now);
+
+/** Prepares the measures of a render loop of refreshRate frames per second **/
+void PIPE_initPacing (PIPE_Pacing*, int refreshRate);
+
+/** Waits for the time of the next frame and measures the interval since the previous one.
+    Returns the time of the frame, in microseconds of PLT_getTimeUs **/
+Uint64 PIPE_waitFrame (PIPE_Pacing*);
+
+/** Measures the time spent to draw and to present the frame started at frameTime **/
+void PIPE_endFrame (PIPE_Pacing*, Uint64 frameTime);
+
+/** Prints the rate, the percentiles and the deviation of the intervals, the late frames and the time to draw
+    in the stdout file **/
+void PIPE_printPacing (const char *name, const PIPE_Pacing*);
+
+/** Plays seconds seconds with keys pressed at random times, then with the simulation and the rendering on one thread
+    like playGame, then on two threads, for presents of 0 and presentMs milliseconds (the present is replaced by
+    a wait). Prints the latency of the inputs and the snapshots drawn and skipped in the stdout file **/
+void PIPE_benchmark (int seconds, int presentMs, Uint32 seed);
+
+/** Draws seconds seconds of a game played by an AI on the simulation thread at refreshRate frames per second,
+    with the active tetrimino drawn on its line then on its way to the next line. Prints the pacing of the frames
+    and the moves of the tetrimino on the screen between two frames in the stdout file **/
+void PIPE_pacingBenchmark (int seconds, int refreshRate, Uint32 seed);
+
+#endif // PIPELINE_H_INCLUDED
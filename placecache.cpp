@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+#include "boardfeatures.h"
+#include "sim.h"
+#include "placecache.h"
+
+#define HEIGHT_BITS     5 /* A height goes from 0 to NB_BLOCK_Y */
+#define NO_ENTRY        -1
+
+/* Above this height, a tetrimino can be blocked before entering the playfield, which does not only
+   depend on the surface : the cache is not used */
+#define MAX_CACHED_HEIGHT   (NB_BLOCK_Y - FIRST_LINE - 4)
+
+typedef struct CachedPlacement CachedPlacement;
+typedef struct CacheEntry CacheEntry;
+
+/* A placement whose line is counted from the lowest column of the surface */
+struct CachedPlacement
+{
+    Uint8 rotation;
+    Sint8 x;
+    Uint8 y;
+};
+
+struct CacheEntry
+{
+    Uint64 key;
+    Sint32 nextInBucket;
+    Sint32 newer, older; /* Neighbours in the list of the entries sorted by last use */
+    Uint8 nbPlacements;
+    CachedPlacement placements[SIM_MAX_PLACEMENTS];
+};
+
+struct PlacementCache
+{
+    CacheEntry *entries;
+    Sint32 *buckets; /* First entry of each bucket of the hash table */
+    Uint32 capacity, nbEntries;
+    Uint32 bucketMask;
+    Sint32 newest, oldest;
+    CacheStats stats;
+};
+
+PlacementCache* CACHE_create (Uint32 maxBytes)
+{
+    /* Variables */
+    PlacementCache *cache = NULL;
+    Uint32 capacity, nbBuckets = 1;
+
+    /* One bucket per entry at most, the number of buckets being a power of 2 */
+    capacity = (maxBytes > sizeof(PlacementCache)) ? (maxBytes - sizeof(PlacementCache)) / (sizeof(CacheEntry) + sizeof(Sint32)) : 0;
+    if (capacity < 1)
+    {
+        fprintf(stderr, "The placement cache needs more than %u bytes\n", maxBytes);
+        return NULL;
+    }
+    while (nbBuckets*2 <= capacity)
+        nbBuckets *= 2;
+
+    cache = (PlacementCache*)malloc(sizeof(PlacementCache));
+    if (cache == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the placement cache\n");
+        return NULL;
+    }
+    cache->entries = (CacheEntry*)malloc(sizeof(CacheEntry)*capacity);
+    cache->buckets = (Sint32*)malloc(sizeof(Sint32)*nbBuckets);
+    if (cache->entries == NULL || cache->buckets == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the placement cache\n");
+        CACHE_free (cache);
+        return NULL;
+    }
+
+    cache->capacity = capacity;
+    cache->nbEntries = 0;
+    cache->bucketMask = nbBuckets - 1;
+    cache->newest = cache->oldest = NO_ENTRY;
+    for (nbBuckets = 0; nbBuckets <= cache->bucketMask; nbBuckets++)
+        cache->buckets[nbBuckets] = NO_ENTRY;
+    CACHE_resetStats (cache);
+    cache->stats.capacity = capacity;
+
+    return cache;
+}
+
+void CACHE_free (PlacementCache *cache)
+{
+    if (cache == NULL)
+        return;
+
+    free (cache->entries);
+    free (cache->buckets);
+    free (cache);
+}
+
+static Uint32 bucketOf (const PlacementCache *cache, Uint64 key)
+{
+    key *= 0x9E3779B97F4A7C15ull;
+    return (Uint32)(key >> 32) & cache->bucketMask;
+}
+
+/* Removes an entry from the list sorted by last use */
+static void unlinkEntry (PlacementCache *cache, Sint32 n)
+{
+    CacheEntry *entry = &cache->entries[n];
+
+    if (entry->newer != NO_ENTRY)
+        cache->entries[entry->newer].older = entry->older;
+    else
+        cache->newest = entry->older;
+    if (entry->older != NO_ENTRY)
+        cache->entries[entry->older].newer = entry->newer;
+    else
+        cache->oldest = entry->newer;
+}
+
+/* Puts an entry at the head of the list sorted by last use */
+static void makeNewest (PlacementCache *cache, Sint32 n)
+{
+    cache->entries[n].newer = NO_ENTRY;
+    cache->entries[n].older = cache->newest;
+    if (cache->newest != NO_ENTRY)
+        cache->entries[cache->newest].newer = n;
+    else
+        cache->oldest = n;
+    cache->newest = n;
+}
+
+/* Takes a free entry, or the one used the least recently */
+static Sint32 allocateEntry (PlacementCache *cache)
+{
+    Sint32 n, *link = NULL;
+
+    if (cache->nbEntries < cache->capacity)
+        return cache->nbEntries++;
+
+    n = cache->oldest;
+    unlinkEntry (cache, n);
+    for (link = &cache->buckets[bucketOf (cache, cache->entries[n].key)]; *link != n;
+         link = &cache->entries[*link].nextInBucket);
+    *link = cache->entries[n].nextInBucket;
+    cache->stats.evictions++;
+
+    return n;
+}
+
+int CACHE_listPlacements (PlacementCache *cache, const Bitboard *board, const BoardFeatures *ftr, int tetrim,
+                          Placement placements[SIM_MAX_PLACEMENTS])
+{
+    /* Variables */
+    CacheEntry *entry = NULL;
+    Uint64 key = 0;
+    Uint32 bucket;
+    Sint32 n;
+    int minHeight = NB_BLOCK_Y, nbPlacements, i, k;
+
+    if (cache == NULL)
+        return SIM_listPlacements (board, tetrim, placements);
+    if (ftr->maxHeight > MAX_CACHED_HEIGHT)
+    {
+        cache->stats.bypasses++;
+        return SIM_listPlacements (board, tetrim, placements);
+    }
+
+    /* Key : the heights relative to the lowest column, then the tetrimino */
+    for (i = 0; i < NB_BLOCK_X; i++)
+    {
+        if (ftr->heights[i] < minHeight)
+            minHeight = ftr->heights[i];
+    }
+    for (i = 0; i < NB_BLOCK_X; i++)
+        key = (key << HEIGHT_BITS) | (Uint64)(ftr->heights[i] - minHeight);
+    key = (key << 3) | (Uint64)tetrim;
+
+    bucket = bucketOf (cache, key);
+    for (n = cache->buckets[bucket]; n != NO_ENTRY && cache->entries[n].key != key; n = cache->entries[n].nextInBucket);
+
+    if (n != NO_ENTRY)
+    {
+        cache->stats.hits++;
+        entry = &cache->entries[n];
+        unlinkEntry (cache, n);
+        makeNewest (cache, n);
+        for (k = 0; k < entry->nbPlacements; k++)
+        {
+            placements[k].rotation = entry->placements[k].rotation;
+            placements[k].x = entry->placements[k].x;
+            placements[k].y = entry->placements[k].y - minHeight;
+        }
+        return entry->nbPlacements;
+    }
+
+    /* Miss : the list is computed and stored for this surface */
+    cache->stats.misses++;
+    nbPlacements = SIM_listPlacements (board, tetrim, placements);
+
+    n = allocateEntry (cache);
+    entry = &cache->entries[n];
+    entry->key = key;
+    entry->nbPlacements = nbPlacements;
+    for (k = 0; k < nbPlacements; k++)
+    {
+        entry->placements[k].rotation = placements[k].rotation;
+        entry->placements[k].x = placements[k].x;
+        entry->placements[k].y = placements[k].y + minHeight;
+    }
+    entry->nextInBucket = cache->buckets[bucket];
+    cache->buckets[bucket] = n;
+    makeNewest (cache, n);
+
+    return nbPlacements;
+}
+
+void CACHE_getStats (const PlacementCache *cache, CacheStats *stats)
+{
+    *stats = cache->stats;
+    stats->nbEntries = cache->nbEntries;
+}
+
+void CACHE_resetStats (PlacementCache *cache)
+{
+    cache->stats.hits = 0;
+    cache->stats.misses = 0;
+    cache->stats.evictions = 0;
+    cache->stats.bypasses = 0;
+}
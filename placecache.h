@@ -0,0 +1,53 @@
+/** placecache.h and placecache.cpp remember the placements of a tetrimino for the surfaces already seen.
+
+    A tetrimino is dropped straight down, so where it lands only depends on the height of each column,
+    not on the holes below. Once the heights are taken relative to the lowest column, many playfields
+    met during a search share the same surface. The cache is keyed by this surface and the tetrimino
+    (5 bits per column, so the key is exact) and gives back the list of SIM_listPlacements.
+
+    The memory used is bounded : when the cache is full, the surface used the least recently is forgotten.
+    A cache is not protected against concurrent accesses : each thread must use its own.
+**/
+
+#ifndef PLACECACHE_H_INCLUDED
+#define PLACECACHE_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "bitboard.h"
+#include "boardfeatures.h"
+#include "sim.h"
+
+typedef struct PlacementCache PlacementCache;
+typedef struct CacheStats CacheStats;
+
+struct CacheStats
+{
+    Uint64 hits;
+    Uint64 misses;
+    Uint64 evictions; /* Surfaces forgotten to make room for new ones */
+    Uint64 bypasses; /* Lists computed without the cache because the stack is too close to the top */
+    Uint32 nbEntries;
+    Uint32 capacity;
+};
+
+
+/** Creates a cache that uses at most maxBytes bytes. Returns NULL if maxBytes is too small or
+    if the memory cannot be allocated **/
+PlacementCache* CACHE_create (Uint32 maxBytes);
+
+/** Frees a cache **/
+void CACHE_free (PlacementCache*);
+
+/** Same as SIM_listPlacements, the heights of the columns being the ones of ftr.
+    The cache can be NULL. Returns the number of placements written in the array **/
+int CACHE_listPlacements (PlacementCache*, const Bitboard*, const BoardFeatures *ftr, int tetrim,
+                          Placement placements[SIM_MAX_PLACEMENTS]);
+
+/** Copies the counters of the cache **/
+void CACHE_getStats (const PlacementCache*, CacheStats*);
+
+/** Resets the counters of the cache, not its content **/
+void CACHE_resetStats (PlacementCache*);
+
+#endif // PLACECACHE_H_INCLUDED
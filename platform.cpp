@@ -0,0 +1,55 @@
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "platform.h"
+
+int PLT_getNbCores ()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo (&info);
+    return (info.dwNumberOfProcessors > 0) ? info.dwNumberOfProcessors : 1;
+#else
+    long nbCores = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return (nbCores > 0) ? nbCores : 1;
+#endif
+}
+
+Uint64 PLT_getTimeUs ()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency (&frequency);
+    QueryPerformanceCounter (&counter);
+
+    return (Uint64)(counter.QuadPart / frequency.QuadPart) * 1000000
+            + (Uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return (Uint64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+Uint8 PLT_replaceFile (const char *from, const char *to)
+{
+#ifdef _WIN32
+    /* rename fails on Windows when the destination exists */
+    return MoveFileExA (from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename (from, to) == 0;
+#endif
+}
@@ -0,0 +1,29 @@
+/** platform.h and platform.cpp give access to the few system services SDL 1.2 does not provide **/
+
+#ifndef PLATFORM_H_INCLUDED
+#define PLATFORM_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+/* Order of the memory accesses between threads : the writes before PLT_RELEASE_FENCE are seen by a thread
+   that reads what was written after it, then passes PLT_ACQUIRE_FENCE */
+#if defined(__GNUC__)
+#define PLT_RELEASE_FENCE()     __atomic_thread_fence (__ATOMIC_RELEASE)
+#define PLT_ACQUIRE_FENCE()     __atomic_thread_fence (__ATOMIC_ACQUIRE)
+#else
+#include <windows.h>
+#define PLT_RELEASE_FENCE()     MemoryBarrier ()
+#define PLT_ACQUIRE_FENCE()     MemoryBarrier ()
+#endif
+
+/** Returns the number of processors available, at least 1 **/
+int PLT_getNbCores ();
+
+/** Returns a time in microseconds. Only the difference between two calls is meaningful **/
+Uint64 PLT_getTimeUs ();
+
+/** Replaces the file to by the file from in one step : to is either the old file or the new one, never missing.
+    Returns a boolean : 0 if the file cannot be replaced **/
+Uint8 PLT_replaceFile (const char *from, const char *to);
+
+#endif // PLATFORM_H_INCLUDED
@@ -0,0 +1,1361 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "animation.h"
+#include "bitboard.h"
+#include "live.h"
+#include "spectate.h"
+#include "platform.h"
+#include "render.h"
+
+/* Lines of 32 bits pixels are filled 8 or 4 pixels at a time */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define RND_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RND_USE_SSE2
+#endif
+
+int gScale = 1;
+
+Uint8 RND_openWindow (RND_Backend *backend, int w, int h)
+{
+    memset (backend, 0, sizeof(RND_Backend));
+    backend->type = RND_BACKEND_WINDOW;
+    backend->screen = SDL_SetVideoMode (w, h, 32, SDL_SWSURFACE);
+
+    return (backend->screen != NULL);
+}
+
+Uint8 RND_openMemory (RND_Backend *backend, int w, int h)
+{
+    memset (backend, 0, sizeof(RND_Backend));
+    backend->type = RND_BACKEND_MEMORY;
+    backend->pixels = (Uint32*)calloc(w*h, sizeof(Uint32));
+    if (backend->pixels == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for a screen in memory\n");
+        return 0;
+    }
+    backend->screen = SDL_CreateRGBSurfaceFrom (backend->pixels, w, h, 32, w*4, 0xFF0000, 0xFF00, 0xFF, 0);
+    if (backend->screen == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for a screen in memory\n");
+        free (backend->pixels);
+        backend->pixels = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+void RND_closeBackend (RND_Backend *backend)
+{
+    if (backend->type == RND_BACKEND_MEMORY)
+    {
+        SDL_FreeSurface (backend->screen);
+        free (backend->pixels);
+    }
+    backend->screen = NULL;
+    backend->pixels = NULL;
+}
+
+void RND_updateRects (RND_Backend *backend, int nbRects, SDL_Rect *rects)
+{
+    int n;
+
+    switch (backend->type)
+    {
+        case RND_BACKEND_WINDOW:
+            SDL_UpdateRects (backend->screen, nbRects, rects);
+            break;
+        case RND_BACKEND_MEMORY:
+            if (backend->nbPresented + nbRects > RND_MAX_RECTS)
+                backend->nbPresented = RND_MAX_RECTS + 1;
+            else
+            {
+                memcpy (backend->presented + backend->nbPresented, rects, nbRects*sizeof(SDL_Rect));
+                backend->nbPresented += nbRects;
+            }
+            break;
+    }
+
+    for (n = 0; n < nbRects; n++)
+        backend->nbPixelsPresented += rects[n].w*rects[n].h;
+    backend->nbPresents++;
+}
+
+void RND_flip (RND_Backend *backend)
+{
+    switch (backend->type)
+    {
+        case RND_BACKEND_WINDOW:
+            SDL_Flip (backend->screen);
+            break;
+        case RND_BACKEND_MEMORY:
+            backend->nbPresented = RND_MAX_RECTS + 1;
+            break;
+    }
+
+    backend->nbPixelsPresented += backend->screen->w*backend->screen->h;
+    backend->nbPresents++;
+}
+
+void RND_presentCopy (RND_Backend *memory, RND_Backend *target)
+{
+    SDL_Rect part;
+    int n;
+
+    if (memory->nbPresented > RND_MAX_RECTS)
+    {
+        SDL_BlitSurface (memory->screen, NULL, target->screen, NULL);
+        RND_flip (target);
+    }
+    else if (memory->nbPresented > 0)
+    {
+        for (n = 0; n < memory->nbPresented; n++)
+        {
+            part = memory->presented[n];
+            SDL_BlitSurface (memory->screen, &memory->presented[n], target->screen, &part);
+        }
+        RND_updateRects (target, memory->nbPresented, memory->presented);
+    }
+    memory->nbPresented = 0;
+}
+
+Uint32 RND_checksum (RND_Backend *backend)
+{
+    /* Variables */
+    SDL_Surface *screen = backend->screen;
+    const Uint8 *row = NULL;
+    Uint32 hash = 2166136261u;
+    int x, y, size = screen->w*screen->format->BytesPerPixel;
+
+    if (SDL_MUSTLOCK (screen) && SDL_LockSurface (screen) < 0)
+        return 0;
+
+    for (y = 0; y < screen->h; y++)
+    {
+        row = (const Uint8*)screen->pixels + y*screen->pitch;
+        for (x = 0; x < size; x++)
+        {
+            hash ^= row[x];
+            hash *= 16777619u;
+        }
+    }
+
+    if (SDL_MUSTLOCK (screen))
+        SDL_UnlockSurface (screen);
+
+    return hash;
+}
+
+void RND_init (RND_Screen *drawn, Uint8 fullRepaint)
+{
+    memset (drawn, 0, sizeof(RND_Screen));
+    drawn->fullRepaint = fullRepaint;
+}
+
+void RND_begin (RND_Screen *drawn, SDL_Surface *screen)
+{
+    if ((!drawn->valid || drawn->fullRepaint) && drawn->layer != NULL)
+    {
+        SDL_BlitSurface (drawn->layer, NULL, screen, NULL);
+        drawn->nbPixelsDrawn += drawn->layer->w*drawn->layer->h;
+        drawn->overlay.w = 0;
+    }
+}
+
+void RND_invalidate (RND_Screen *drawn)
+{
+    drawn->valid = 0;
+}
+
+/* Returns a boolean : 1 if the rectangle (x, y, w, h) overlaps the part */
+static Uint8 overlaps (const SDL_Rect *part, int x, int y, int w, int h)
+{
+    return (part->x < x + w && x < part->x + part->w && part->y < y + h && y < part->y + part->h);
+}
+
+void RND_showOverlay (RND_Screen *drawn, RND_Backend *backend, SDL_Surface *overlay)
+{
+    SDL_Rect position;
+
+    if (overlay == NULL)
+        return;
+    RND_hideOverlay (drawn, backend);
+
+    drawn->overlay.x = backend->screen->w/2 - overlay->w/2;
+    drawn->overlay.y = backend->screen->h/2 - overlay->h/2;
+    drawn->overlay.w = overlay->w;
+    drawn->overlay.h = overlay->h;
+    position = drawn->overlay;
+    SDL_BlitSurface (overlay, NULL, backend->screen, &position);
+    RND_updateRects (backend, 1, &drawn->overlay);
+}
+
+void RND_hideOverlay (RND_Screen *drawn, RND_Backend *backend)
+{
+    /* Variables */
+    const int panelLines[RND_NB_PANELS] = {SCORE, LVL, NB_LINES};
+    SDL_Rect part = drawn->overlay, position = drawn->overlay;
+    int i, j;
+
+    if (drawn->overlay.w == 0)
+        return;
+    drawn->overlay.w = 0;
+    if (drawn->layer == NULL)
+    {
+        RND_invalidate (drawn);
+        return;
+    }
+
+    SDL_BlitSurface (drawn->layer, &part, backend->screen, &position);
+    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            if (overlaps (&part, LATERAL_PANEL + BORDER + i*BLOCK_SIZE, (j-FIRST_LINE)*BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE))
+                drawn->cells[j][i] = RND_NB_TILES;
+        }
+    }
+    for (j = 0; j < 4; j++)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            if (overlaps (&part, LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE + BORDER + i*BLOCK_SIZE,
+                          NEXT_CASE + BORDER + j*BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE))
+                drawn->next[j][i] = RND_NB_TILES;
+        }
+    }
+    for (i = 0; i < RND_NB_PANELS; i++)
+    {
+        if (overlaps (&part, BLOCK_SIZE + BORDER, panelLines[i] + BORDER, 4*BLOCK_SIZE, BLOCK_SIZE))
+            drawn->panels[i] = RND_NO_VALUE;
+    }
+    RND_addRect (drawn, &part);
+}
+
+void RND_addRect (RND_Screen *drawn, const SDL_Rect *part)
+{
+    SDL_Rect *last = (drawn->nbRects > 0) ? &drawn->rects[drawn->nbRects-1] : NULL;
+
+    if (!drawn->valid || drawn->fullRepaint || part->w == 0 || part->h == 0)
+        return;
+
+    /* The cells of a line are drawn from the left to the right : a cell next to the previous one extends it */
+    if (last != NULL && last->y == part->y && last->h == part->h
+        && part->x >= last->x && part->x <= last->x + last->w + 2*GRID_WIDE)
+    {
+        if (part->x + part->w > last->x + last->w)
+            last->w = part->x + part->w - last->x;
+        return;
+    }
+
+    if (drawn->nbRects == RND_MAX_RECTS)
+    {
+        drawn->valid = 0;
+        return;
+    }
+    drawn->rects[drawn->nbRects++] = *part;
+}
+
+void RND_fill (RND_Screen *drawn, SDL_Surface *screen, SDL_Rect *part, Uint32 color)
+{
+    SDL_FillRect (screen, part, color);
+    drawn->nbPixelsDrawn += part->w*part->h;
+    RND_addRect (drawn, part);
+}
+
+void RND_blit (RND_Screen *drawn, SDL_Surface *source, SDL_Rect *part, SDL_Surface *screen, SDL_Rect *position)
+{
+    SDL_BlitSurface (source, part, screen, position);
+    drawn->nbPixelsDrawn += position->w*position->h;
+    RND_addRect (drawn, position);
+}
+
+/* Writes the cells waiting in the pixels of the screen, or blits their tiles if the screen is not in 32 bits */
+static void drawCells (RND_Screen *drawn, SDL_Surface *screen)
+{
+    SDL_Rect part, position;
+    int n;
+
+    if (drawn->nbWaiting == 0)
+        return;
+
+    if (screen->format->BytesPerPixel == 4)
+        RND_fillCells (screen, drawn->waiting, drawn->nbWaiting, BLOCK_SIZE - 2*GRID_WIDE);
+    else
+    {
+        for (n = 0; n < drawn->nbWaiting; n++)
+        {
+            part = drawn->tiles->tiles[drawn->waiting[n].tile];
+            if (drawn->waiting[n].h > 0)
+                part.h = drawn->waiting[n].h;
+            position.x = drawn->waiting[n].x;
+            position.y = drawn->waiting[n].y;
+            SDL_BlitSurface (drawn->tiles->atlas, &part, screen, &position);
+        }
+    }
+    drawn->nbWaiting = 0;
+}
+
+/* Keeps a cell until the end of the frame. The cells are drawn in the order they are given */
+static void waitCell (RND_Screen *drawn, SDL_Surface *screen, const RND_Tiles *tiles, int x, int y, int h, int tile)
+{
+    RND_Cell *cell = NULL;
+    SDL_Rect position;
+
+    if (drawn->nbWaiting == RND_MAX_CELLS)
+        drawCells (drawn, screen);
+    cell = &drawn->waiting[drawn->nbWaiting++];
+
+    cell->x = x;
+    cell->y = y;
+    cell->h = h;
+    cell->tile = tile;
+    cell->color = tiles->colors[tile];
+    drawn->tiles = tiles;
+
+    position.x = x;
+    position.y = y;
+    position.w = tiles->tiles[tile].w;
+    position.h = (h > 0) ? h : tiles->tiles[tile].h;
+    drawn->nbPixelsDrawn += position.w*position.h;
+    RND_addRect (drawn, &position);
+}
+
+Uint8 RND_setCell (RND_Screen *drawn, SDL_Surface *screen, const RND_Tiles *tiles, int i, int j, int tile)
+{
+    if (j < FIRST_LINE || (drawn->valid && !drawn->fullRepaint && drawn->cells[j][i] == tile))
+        return 0;
+
+    waitCell (drawn, screen, tiles, LATERAL_PANEL + BORDER + i*BLOCK_SIZE + GRID_WIDE,
+              j*BLOCK_SIZE + GRID_WIDE - (FIRST_LINE*BLOCK_SIZE), 0, tile);
+    drawn->cells[j][i] = tile;
+
+    return 1;
+}
+
+Uint8 RND_setNextCell (RND_Screen *drawn, SDL_Surface *screen, const RND_Tiles *tiles, int i, int j, int tile)
+{
+    if (drawn->valid && !drawn->fullRepaint && drawn->next[j][i] == tile)
+        return 0;
+
+    waitCell (drawn, screen, tiles, LATERAL_PANEL + BORDER + PLAYFIELD + BORDER + BLOCK_SIZE + BORDER + i*BLOCK_SIZE + GRID_WIDE,
+              NEXT_CASE + BORDER + j*BLOCK_SIZE + GRID_WIDE, 0, tile);
+    drawn->next[j][i] = tile;
+
+    return 1;
+}
+
+Uint8 RND_setPanel (RND_Screen *drawn, int panel, Uint32 value)
+{
+    if (drawn->valid && !drawn->fullRepaint && drawn->panels[panel] == value)
+        return 0;
+
+    drawn->panels[panel] = value;
+
+    return 1;
+}
+
+void RND_present (RND_Screen *drawn, RND_Backend *backend)
+{
+    SDL_Surface *screen = backend->screen;
+    int n;
+
+    drawCells (drawn, screen);
+
+    if (!drawn->valid || drawn->fullRepaint)
+    {
+        RND_flip (backend);
+        drawn->nbPixelsPresented += screen->w*screen->h;
+        drawn->nbRectsPresented++;
+    }
+    else if (drawn->nbRects > 0)
+    {
+        RND_updateRects (backend, drawn->nbRects, drawn->rects);
+        for (n = 0; n < drawn->nbRects; n++)
+            drawn->nbPixelsPresented += drawn->rects[n].w*drawn->rects[n].h;
+        drawn->nbRectsPresented += drawn->nbRects;
+    }
+
+    drawn->nbRects = 0;
+    drawn->nbFrames++;
+    drawn->valid = ((screen->flags & SDL_DOUBLEBUF) != SDL_DOUBLEBUF);
+}
+
+Uint8 RND_initDigits (RND_Digits *digits, SDL_Surface *glyphs[10])
+{
+    SDL_Rect position;
+    int width = 0, height = 0, n;
+
+    digits->atlas = NULL;
+    for (n = 0; n < 10; n++)
+    {
+        if (glyphs[n] == NULL)
+            return 0;
+        width += glyphs[n]->w;
+        if (glyphs[n]->h > height)
+            height = glyphs[n]->h;
+    }
+
+    digits->atlas = SDL_CreateRGBSurface (SDL_SWSURFACE, width, height, 32, 0, 0, 0, 0);
+    if (digits->atlas == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the digits\n");
+        return 0;
+    }
+
+    for (n = 0, width = 0; n < 10; n++)
+    {
+        digits->glyphs[n].x = width;
+        digits->glyphs[n].y = 0;
+        digits->glyphs[n].w = glyphs[n]->w;
+        digits->glyphs[n].h = glyphs[n]->h;
+        position.x = width;
+        position.y = 0;
+        SDL_BlitSurface (glyphs[n], NULL, digits->atlas, &position);
+        width += glyphs[n]->w;
+    }
+    digits->atlas = RND_toDisplay (digits->atlas);
+
+    return 1;
+}
+
+void RND_freeDigits (RND_Digits *digits)
+{
+    SDL_FreeSurface (digits->atlas);
+    digits->atlas = NULL;
+}
+
+int RND_numberWidth (const RND_Digits *digits, Uint32 value)
+{
+    int width = 0;
+
+    do
+    {
+        width += digits->glyphs[value%10].w;
+        value /= 10;
+    } while (value > 0);
+
+    return width;
+}
+
+void RND_drawNumber (RND_Screen *drawn, SDL_Surface *screen, const RND_Digits *digits, Uint32 value, int centerX, int y)
+{
+    /* Variables */
+    int figures[10], nbFigures = 0, x = centerX - RND_numberWidth (digits, value)/2, n;
+    SDL_Rect part, position;
+
+    do
+    {
+        figures[nbFigures++] = value%10;
+        value /= 10;
+    } while (value > 0);
+
+    for (n = nbFigures-1; n >= 0; n--)
+    {
+        part = digits->glyphs[figures[n]];
+        position.x = x;
+        position.y = y;
+        RND_blit (drawn, digits->atlas, &part, screen, &position);
+        x += digits->glyphs[figures[n]].w;
+    }
+}
+
+Uint32 RND_blinkColor (const SDL_PixelFormat *format, int tetrim, Uint32 time)
+{
+    double t = time%1000, bleachFactor;
+
+    /* The bleach factor goes from 0.25 to 0.75 then from 0.75 to 0.25 */
+    if (t < 500)
+        bleachFactor = (t+250)/1000;
+    else
+        bleachFactor = (1250-t)/1000;
+
+    switch (tetrim)
+    {
+    case TETRIM_O:
+        return SDL_MapRGB (format, 255-(24*bleachFactor), 255-(24*bleachFactor), 255-(231*bleachFactor));
+    case TETRIM_Z:
+        return SDL_MapRGB (format, 255-(20*bleachFactor), 255-(235*bleachFactor), 255-(235*bleachFactor));
+    case TETRIM_I:
+        return SDL_MapRGB (format, 255-(215*bleachFactor), 255-(31*bleachFactor), 255-(89*bleachFactor));
+    case TETRIM_S:
+        return SDL_MapRGB (format, 255-(231*bleachFactor), 255-(128*bleachFactor), 255-(231*bleachFactor));
+    case TETRIM_J:
+        return SDL_MapRGB (format, 255-(223*bleachFactor), 255-(223*bleachFactor), 255-(95*bleachFactor));
+    case TETRIM_T:
+        return SDL_MapRGB (format, 255-(128*bleachFactor), 255-(191*bleachFactor), 255-(128*bleachFactor));
+    case TETRIM_L:
+        return SDL_MapRGB (format, 255-(24*bleachFactor), 255-(128*bleachFactor), 255-(231*bleachFactor));
+    default:
+        return 0;
+    }
+}
+
+Uint8 RND_initTiles (RND_Tiles *tiles, const SDL_PixelFormat *format)
+{
+    /* Variables */
+    static const Uint8 colors[RND_TILE_BLINK][3] = { {255, 255, 255}, {128, 128, 128},
+        {231, 231, 24}, {215, 20, 20}, {40, 224, 166}, {24, 128, 24}, {32, 32, 160}, {128, 64, 128}, {231, 128, 24},
+        {0, 0, 0} };
+    const int size = BLOCK_SIZE - 2*GRID_WIDE;
+    int tile, step;
+    Uint32 color;
+
+    tiles->atlas = SDL_CreateRGBSurface (SDL_SWSURFACE, RND_TILES_PER_LINE*size,
+                                         (RND_NB_TILES + RND_TILES_PER_LINE-1)/RND_TILES_PER_LINE*size,
+                                         format->BitsPerPixel, format->Rmask, format->Gmask, format->Bmask, 0);
+    if (tiles->atlas == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the tiles\n");
+        return 0;
+    }
+
+    for (tile = 0; tile < RND_NB_TILES; tile++)
+    {
+        tiles->tiles[tile].x = (tile%RND_TILES_PER_LINE)*size;
+        tiles->tiles[tile].y = (tile/RND_TILES_PER_LINE)*size;
+        tiles->tiles[tile].w = size;
+        tiles->tiles[tile].h = size;
+
+        /* The color of a step of the blink cycle is the one of the middle of the step */
+        if (tile < RND_TILE_BLINK)
+            color = SDL_MapRGB (tiles->atlas->format, colors[tile][0], colors[tile][1], colors[tile][2]);
+        else
+        {
+            step = (tile - RND_TILE_BLINK)%RND_BLINK_STEPS;
+            color = RND_blinkColor (tiles->atlas->format, (tile - RND_TILE_BLINK)/RND_BLINK_STEPS,
+                                    (2*step+1)*1000/(2*RND_BLINK_STEPS));
+        }
+        SDL_FillRect (tiles->atlas, &tiles->tiles[tile], color);
+        tiles->colors[tile] = color;
+    }
+
+    return 1;
+}
+
+void RND_freeTiles (RND_Tiles *tiles)
+{
+    SDL_FreeSurface (tiles->atlas);
+    tiles->atlas = NULL;
+}
+
+/* Fills w pixels of 32 bits from row */
+static void fillRow (Uint32 *row, int w, Uint32 color)
+{
+    int x = 0;
+#if defined(RND_USE_AVX2)
+    const __m256i pixels8 = _mm256_set1_epi32 ((int)color);
+
+    for (; x+8 <= w; x += 8)
+        _mm256_storeu_si256 ((__m256i*)(row + x), pixels8);
+#endif
+#if defined(RND_USE_AVX2) || defined(RND_USE_SSE2)
+    const __m128i pixels4 = _mm_set1_epi32 ((int)color);
+
+    for (; x+4 <= w; x += 4)
+        _mm_storeu_si128 ((__m128i*)(row + x), pixels4);
+#endif
+
+    for (; x < w; x++)
+        row[x] = color;
+}
+
+void RND_fillCells (SDL_Surface *surface, const RND_Cell *cells, int nbCells, int size)
+{
+    /* Variables */
+    SDL_Rect part;
+    Uint8 *row = NULL;
+    int n, l, h;
+
+    if (surface->format->BytesPerPixel != 4)
+    {
+        for (n = 0; n < nbCells; n++)
+        {
+            part.x = cells[n].x;
+            part.y = cells[n].y;
+            part.w = size;
+            part.h = (cells[n].h > 0) ? cells[n].h : size;
+            SDL_FillRect (surface, &part, cells[n].color);
+        }
+        return;
+    }
+
+    if (SDL_MUSTLOCK (surface) && SDL_LockSurface (surface) < 0)
+        return;
+
+    for (n = 0; n < nbCells; n++)
+    {
+        h = (cells[n].h > 0) ? cells[n].h : size;
+        if (cells[n].x < 0 || cells[n].y < 0 || cells[n].x + size > surface->w || cells[n].y + h > surface->h)
+            continue;
+
+        row = (Uint8*)surface->pixels + cells[n].y*surface->pitch + cells[n].x*4;
+        for (l = 0; l < h; l++, row += surface->pitch)
+            fillRow ((Uint32*)row, size, cells[n].color);
+    }
+
+    if (SDL_MUSTLOCK (surface))
+        SDL_UnlockSurface (surface);
+}
+
+/* Returns a boolean : 1 if the surfaces have the same format of 32 bits */
+static Uint8 sameFormat (const SDL_Surface *a, const SDL_Surface *b)
+{
+    return (a->format->BytesPerPixel == 4 && b->format->BytesPerPixel == 4
+            && a->format->Rmask == b->format->Rmask && a->format->Gmask == b->format->Gmask
+            && a->format->Bmask == b->format->Bmask);
+}
+
+void RND_blend (SDL_Surface *destination, SDL_Surface *under, SDL_Surface *over, SDL_Rect *part, Uint8 alpha)
+{
+    /* Variables */
+    const Uint32 a = alpha + (alpha >> 7), b = 256 - a; /* From 0 to 256 */
+    const Uint32 *u = NULL, *o = NULL;
+    Uint32 *d = NULL;
+    SDL_Rect position = *part;
+    int x, y;
+
+    if (!sameFormat (destination, under) || !sameFormat (destination, over))
+    {
+        SDL_BlitSurface (under, part, destination, &position);
+        position = *part;
+        SDL_SetAlpha (over, SDL_SRCALPHA, alpha);
+        SDL_BlitSurface (over, part, destination, &position);
+        SDL_SetAlpha (over, 0, SDL_ALPHA_OPAQUE);
+        return;
+    }
+
+    SDL_LockSurface (destination);
+    SDL_LockSurface (under);
+    SDL_LockSurface (over);
+    for (y = part->y; y < part->y + part->h && y < destination->h; y++)
+    {
+        d = (Uint32*)((Uint8*)destination->pixels + y*destination->pitch);
+        u = (const Uint32*)((const Uint8*)under->pixels + y*under->pitch);
+        o = (const Uint32*)((const Uint8*)over->pixels + y*over->pitch);
+        /* Two channels at a time : the bytes 0 and 2, then the bytes 1 and 3 */
+        for (x = part->x; x < part->x + part->w && x < destination->w; x++)
+            d[x] = (((o[x] & 0x00FF00FF)*a + (u[x] & 0x00FF00FF)*b) >> 8 & 0x00FF00FF)
+                   | (((o[x] >> 8 & 0x00FF00FF)*a + (u[x] >> 8 & 0x00FF00FF)*b) & 0xFF00FF00);
+    }
+    SDL_UnlockSurface (over);
+    SDL_UnlockSurface (under);
+    SDL_UnlockSurface (destination);
+}
+
+int RND_tetrimTile (int tetrim)
+{
+    static const int blocks[7] = {BLOCK_CYAN, BLOCK_YELLOW, BLOCK_PURPLE, BLOCK_ORANGE, BLOCK_BLUE, BLOCK_RED, BLOCK_GREEN};
+
+    return (tetrim >= 0 && tetrim < 7) ? blocks[tetrim] : BLOCK_ACTIVE;
+}
+
+int RND_blinkTile (int tetrim, Uint32 time)
+{
+    if (tetrim < 0 || tetrim >= 7)
+        return BLOCK_ACTIVE;
+
+    return RND_TILE_BLINK + tetrim*RND_BLINK_STEPS + (time%1000)*RND_BLINK_STEPS/1000;
+}
+
+/* Returns a boolean : 1 if the surface has no transparent pixel */
+static Uint8 isOpaque (SDL_Surface *surface)
+{
+    Uint32 *line;
+    Uint8 opaque = 1; /* Boolean */
+    int x, y;
+
+    if (surface->format->Amask == 0)
+        return 1;
+    if (surface->format->BytesPerPixel != 4)
+        return 0;
+
+    SDL_LockSurface (surface);
+    for (y = 0; y < surface->h && opaque; y++)
+    {
+        line = (Uint32*)((Uint8*)surface->pixels + y*surface->pitch);
+        for (x = 0; x < surface->w && opaque; x++)
+            opaque = ((line[x] & surface->format->Amask) == surface->format->Amask);
+    }
+    SDL_UnlockSurface (surface);
+
+    return opaque;
+}
+
+SDL_Surface* RND_toDisplay (SDL_Surface *surface)
+{
+    SDL_Surface *converted = NULL;
+
+    if (surface == NULL || SDL_GetVideoSurface () == NULL)
+        return surface;
+
+    if ((surface->flags & SDL_SRCALPHA) == SDL_SRCALPHA && !isOpaque (surface))
+        converted = SDL_DisplayFormatAlpha (surface);
+    else
+    {
+        SDL_SetAlpha (surface, 0, SDL_ALPHA_OPAQUE);
+        converted = SDL_DisplayFormat (surface);
+    }
+    if (converted == NULL)
+        return surface;
+
+    SDL_FreeSurface (surface);
+
+    return converted;
+}
+
+int RND_chooseScale (int requested)
+{
+    const SDL_VideoInfo *info = SDL_GetVideoInfo ();
+    const int w = WINDOW_WIDTH/gScale, h = WINDOW_HEIGHT/gScale; /* Window at the scale 1 */
+
+    if (requested > 0)
+        gScale = (requested < MAX_SCALE) ? requested : MAX_SCALE;
+    else
+    {
+        /* The largest window that leaves a tenth of the height of the desktop to the task bars */
+        for (gScale = MAX_SCALE; gScale > 1; gScale--)
+        {
+            if (info != NULL && gScale*w <= info->current_w && gScale*h <= info->current_h*9/10)
+                break;
+        }
+    }
+
+    return gScale;
+}
+
+SDL_Surface* RND_prescale (SDL_Surface *surface, int factor)
+{
+    /* Variables */
+    SDL_Surface *scaled = NULL;
+    const Uint8 *source = NULL;
+    Uint8 *line = NULL;
+    int bpp, x, y, k;
+
+    if (surface == NULL || factor <= 1)
+        return surface;
+
+    bpp = surface->format->BytesPerPixel;
+    scaled = SDL_CreateRGBSurface (SDL_SWSURFACE, surface->w*factor, surface->h*factor, surface->format->BitsPerPixel,
+                                   surface->format->Rmask, surface->format->Gmask, surface->format->Bmask,
+                                   surface->format->Amask);
+    if (scaled == NULL)
+        return surface;
+    if (surface->format->palette != NULL)
+        SDL_SetColors (scaled, surface->format->palette->colors, 0, surface->format->palette->ncolors);
+    if ((surface->flags & SDL_SRCCOLORKEY) == SDL_SRCCOLORKEY)
+        SDL_SetColorKey (scaled, SDL_SRCCOLORKEY, surface->format->colorkey);
+    SDL_SetAlpha (scaled, surface->flags & SDL_SRCALPHA, surface->format->alpha);
+
+    /* Each pixel is repeated factor times on a line, then the line factor times */
+    SDL_LockSurface (surface);
+    SDL_LockSurface (scaled);
+    for (y = 0; y < surface->h; y++)
+    {
+        source = (const Uint8*)surface->pixels + y*surface->pitch;
+        line = (Uint8*)scaled->pixels + y*factor*scaled->pitch;
+        for (x = 0; x < surface->w; x++)
+        {
+            for (k = 0; k < factor; k++)
+                memcpy (line + (x*factor + k)*bpp, source + x*bpp, bpp);
+        }
+        for (k = 1; k < factor; k++)
+            memcpy (line + k*scaled->pitch, line, scaled->w*bpp);
+    }
+    SDL_UnlockSurface (scaled);
+    SDL_UnlockSurface (surface);
+
+    SDL_FreeSurface (surface);
+
+    return scaled;
+}
+
+/* Creates a surface of the benchmark in the format of IMG_Load (RGBA in the order of the bytes)
+   or of TTF_RenderText_Blended (ARGB), with the alpha of a texture (opaque) or of a text */
+static SDL_Surface* createAsset (int w, int h, Uint8 image, Uint8 opaque)
+{
+    SDL_Surface *surface = NULL;
+    Uint8 r, g, b, a;
+    int x, y;
+
+    if (image)
+        surface = SDL_CreateRGBSurface (SDL_SWSURFACE|SDL_SRCALPHA, w, h, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+    else
+        surface = SDL_CreateRGBSurface (SDL_SWSURFACE|SDL_SRCALPHA, w, h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (surface == NULL)
+        return NULL;
+    SDL_SetAlpha (surface, SDL_SRCALPHA, SDL_ALPHA_OPAQUE);
+
+    SDL_LockSurface (surface);
+    for (y = 0; y < h; y++)
+    {
+        for (x = 0; x < w; x++)
+        {
+            r = (Uint8)(x*7 + y*3);
+            g = (Uint8)(x*5 + y*11);
+            b = (Uint8)(x + y*2);
+            /* A text is transparent around the strokes of its letters, and blended on their edges */
+            a = (opaque || (x/3 + y/5)%4 == 0) ? 255 : ((x/3 + y/5)%4 == 1) ? 128 : 0;
+            ((Uint32*)((Uint8*)surface->pixels + y*surface->pitch))[x] = SDL_MapRGBA (surface->format, r, g, b, a);
+        }
+    }
+    SDL_UnlockSurface (surface);
+
+    return surface;
+}
+
+/* Blits like anim_opening, with the background composed from the wall texture like initSprites.
+   Returns the number of pixels blitted */
+static Uint64 blitOpening (SDL_Surface *screen, SDL_Surface *texture, SDL_Surface *bg_left, SDL_Surface *bg_right)
+{
+    SDL_Rect part, position;
+    Uint64 nbPixels = 0;
+    int delay, i, j;
+
+    for (j = 0; j*texture->h < screen->h; j++)
+    {
+        position.y = j*texture->h;
+        for (i = 0; i*texture->w < WINDOW_WIDTH/2; i++)
+        {
+            position.x = bg_left->w - BORDER - (i+1)*texture->w;
+            SDL_BlitSurface (texture, NULL, bg_left, &position);
+            nbPixels += position.w*position.h;
+            position.x = BORDER + i*texture->w;
+            SDL_BlitSurface (texture, NULL, bg_right, &position);
+            nbPixels += position.w*position.h;
+        }
+    }
+
+    part.y = 0;
+    part.w = bg_right->w;
+    part.h = bg_right->h;
+    for (delay = 0; delay <= (PLAYFIELD+2*BORDER)/2; delay += (PLAYFIELD+2*BORDER)/10)
+    {
+        part.x = delay;
+        position.x = 0;
+        position.y = 0;
+        SDL_BlitSurface (bg_left, &part, screen, &position);
+        nbPixels += position.w*position.h;
+        part.x = (delay < BORDER) ? delay : 0;
+        position.x = WINDOW_WIDTH/2 + delay - (BORDER-part.x);
+        position.y = 0;
+        SDL_BlitSurface (bg_right, &part, screen, &position);
+        nbPixels += position.w*position.h;
+    }
+
+    return nbPixels;
+}
+
+/* Blits like the title menu and menuControls. Returns the number of pixels blitted */
+static Uint64 blitMenus (SDL_Surface *screen, SDL_Surface *background, SDL_Surface *titles[4],
+                         SDL_Surface *keyboard, SDL_Surface *texts[4])
+{
+    SDL_Rect part, position;
+    Uint64 nbPixels = 0;
+    int n;
+
+    position.x = 0;
+    position.y = 0;
+    SDL_BlitSurface (background, NULL, screen, &position);
+    nbPixels += position.w*position.h;
+    for (n = 0; n < 4; n++)
+    {
+        position.x = screen->w/2 - titles[n]->w/2;
+        position.y = n*INTERLINE;
+        SDL_BlitSurface (titles[n], NULL, screen, &position);
+        nbPixels += position.w*position.h;
+    }
+
+    part.w = 34;
+    part.h = 34;
+    for (n = 0; n < 4; n++)
+    {
+        part.x = 533 + 33*n;
+        part.y = 168 + 33*(n > 0);
+        position.x = 2*BLOCK_SIZE + BORDER;
+        position.y = 120 + 2*BLOCK_SIZE*n;
+        SDL_BlitSurface (keyboard, &part, screen, &position);
+        nbPixels += position.w*position.h;
+        position.x += 34 + BLOCK_SIZE/2;
+        SDL_BlitSurface (texts[n], NULL, screen, &position);
+        nbPixels += position.w*position.h;
+    }
+
+    return nbPixels;
+}
+
+void RND_assetBenchmark (int nbRepeats)
+{
+    /* Variables */
+    SDL_Surface *screen = NULL, *texture = NULL, *bg_left = NULL, *bg_right = NULL, *background = NULL;
+    SDL_Surface *keyboard = NULL, *titles[4], *texts[4];
+    Uint64 startTime, time[2][2] = {{0, 0}, {0, 0}}, nbPixels[2][2] = {{0, 0}, {0, 0}};
+    const char *names[2] = {"Opening animation", "Menus"};
+    int converted, n, k;
+
+    if (SDL_getenv ("SDL_VIDEODRIVER") == NULL)
+        SDL_putenv ((char*)"SDL_VIDEODRIVER=dummy");
+    if (SDL_Init (SDL_INIT_VIDEO) < 0)
+    {
+        fprintf(stderr, "Error during SDL initialization : %s\n", SDL_GetError() );
+        return;
+    }
+    screen = SDL_SetVideoMode (WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_SWSURFACE);
+    if (screen == NULL)
+    {
+        fprintf(stderr, "Impossible to open the screen of the benchmark : %s\n", SDL_GetError() );
+        SDL_Quit ();
+        return;
+    }
+
+    /* The assets as they are loaded */
+    texture = createAsset (100, 100, 1, 1);
+    bg_left = SDL_CreateRGBSurface (SDL_SWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0);
+    bg_right = SDL_CreateRGBSurface (SDL_SWSURFACE, WINDOW_WIDTH/2+BORDER, screen->h, 32, 0, 0, 0, 0);
+    background = SDL_CreateRGBSurface (SDL_SWSURFACE, screen->w, screen->h, 32, 0, 0, 0, 0);
+    keyboard = createAsset (800, 254, 1, 0);
+    for (n = 0; n < 4; n++)
+    {
+        titles[n] = createAsset (400, 80, 0, 0);
+        texts[n] = createAsset (300, 22, 0, 0);
+    }
+
+    for (converted = 0; converted < 2; converted++)
+    {
+        if (converted)
+        {
+            texture = RND_toDisplay (texture);
+            bg_left = RND_toDisplay (bg_left);
+            bg_right = RND_toDisplay (bg_right);
+            background = RND_toDisplay (background);
+            keyboard = RND_toDisplay (keyboard);
+            for (n = 0; n < 4; n++)
+            {
+                titles[n] = RND_toDisplay (titles[n]);
+                texts[n] = RND_toDisplay (texts[n]);
+            }
+        }
+
+        for (k = 0; k < nbRepeats; k++)
+        {
+            startTime = PLT_getTimeUs ();
+            nbPixels[0][converted] += blitOpening (screen, texture, bg_left, bg_right);
+            time[0][converted] += PLT_getTimeUs () - startTime;
+
+            startTime = PLT_getTimeUs ();
+            nbPixels[1][converted] += blitMenus (screen, background, titles, keyboard, texts);
+            time[1][converted] += PLT_getTimeUs () - startTime;
+        }
+    }
+
+    fprintf(stdout, "Blits of the assets : %d repetitions\n", nbRepeats);
+    for (n = 0; n < 2; n++)
+    {
+        if (time[n][0] == 0 || time[n][1] == 0)
+            continue;
+        fprintf(stdout, "    %s : %.1f Mpixels/s as loaded, %.1f Mpixels/s in the format of the screen (%.1f times faster)\n",
+                names[n], (double)nbPixels[n][0]/time[n][0], (double)nbPixels[n][1]/time[n][1],
+                ((double)nbPixels[n][1]/time[n][1]) / ((double)nbPixels[n][0]/time[n][0]));
+    }
+
+    SDL_FreeSurface (texture);
+    SDL_FreeSurface (bg_left);
+    SDL_FreeSurface (bg_right);
+    SDL_FreeSurface (background);
+    SDL_FreeSurface (keyboard);
+    for (n = 0; n < 4; n++)
+    {
+        SDL_FreeSurface (titles[n]);
+        SDL_FreeSurface (texts[n]);
+    }
+    SDL_Quit ();
+}
+
+/* Fills the cells of the benchmark with SDL_FillRect (direct is 0) or RND_fillCells.
+   Returns the time spent in microseconds */
+static Uint64 fillMany (SDL_Surface *surface, RND_Cell *cells, int nbCells, int size, const RND_Tiles *tiles,
+                        int nbFrames, Uint8 direct)
+{
+    Uint64 startTime = PLT_getTimeUs ();
+    SDL_Rect part;
+    int frame, n;
+
+    for (frame = 0; frame < nbFrames; frame++)
+    {
+        for (n = 0; n < nbCells; n++)
+            cells[n].color = tiles->colors[(n*7 + frame)%RND_NB_TILES];
+
+        if (direct)
+            RND_fillCells (surface, cells, nbCells, size);
+        else
+        {
+            for (n = 0; n < nbCells; n++)
+            {
+                part.x = cells[n].x;
+                part.y = cells[n].y;
+                part.w = size;
+                part.h = size;
+                SDL_FillRect (surface, &part, cells[n].color);
+            }
+        }
+    }
+
+    return PLT_getTimeUs () - startTime;
+}
+
+void RND_fillBenchmark (int nbFrames)
+{
+    /* Variables */
+    const int scales[3] = {1, 2, 4};
+    SDL_Surface *surfaces[2] = {NULL, NULL};
+    RND_Cell cells[RND_MAX_CELLS];
+    RND_Tiles tiles;
+    Uint64 time[2];
+    int block, size, nbCells, scale, mode, nbDifferent, i, j, y;
+
+#if defined(RND_USE_AVX2)
+    fprintf(stdout, "Cells of the playfield and of the case \"next\" : %d frames, AVX2\n", nbFrames);
+#elif defined(RND_USE_SSE2)
+    fprintf(stdout, "Cells of the playfield and of the case \"next\" : %d frames, SSE2\n", nbFrames);
+#else
+    fprintf(stdout, "Cells of the playfield and of the case \"next\" : %d frames, scalar\n", nbFrames);
+#endif
+
+    for (scale = 0; scale < 3; scale++)
+    {
+        block = scales[scale]*BLOCK_SIZE;
+        size = block - 2*scales[scale]*GRID_WIDE;
+
+        /* The playfield, then the case "next" at its right */
+        for (mode = 0; mode < 2; mode++)
+            surfaces[mode] = SDL_CreateRGBSurface (SDL_SWSURFACE, (NB_BLOCK_X+5)*block, (NB_BLOCK_Y-FIRST_LINE)*block,
+                                                   32, 0, 0, 0, 0);
+        if (surfaces[0] == NULL || surfaces[1] == NULL || !RND_initTiles (&tiles, surfaces[0]->format))
+        {
+            fprintf(stderr, "An error occurred during memory allocation for the surfaces of the benchmark\n");
+            SDL_FreeSurface (surfaces[0]);
+            SDL_FreeSurface (surfaces[1]);
+            return;
+        }
+
+        nbCells = 0;
+        for (j = 0; j < NB_BLOCK_Y-FIRST_LINE; j++)
+        {
+            for (i = 0; i < NB_BLOCK_X; i++)
+            {
+                cells[nbCells].h = 0;
+                cells[nbCells].x = i*block + scales[scale]*GRID_WIDE;
+                cells[nbCells++].y = j*block + scales[scale]*GRID_WIDE;
+            }
+        }
+        for (j = 0; j < 4; j++)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                cells[nbCells].h = 0;
+                cells[nbCells].x = (NB_BLOCK_X+1+i)*block + scales[scale]*GRID_WIDE;
+                cells[nbCells++].y = j*block + scales[scale]*GRID_WIDE;
+            }
+        }
+
+        for (mode = 0; mode < 2; mode++)
+        {
+            SDL_FillRect (surfaces[mode], NULL, 0);
+            time[mode] = fillMany (surfaces[mode], cells, nbCells, size, &tiles, nbFrames, mode);
+        }
+
+        /* The last frames must be the same */
+        nbDifferent = 0;
+        for (y = 0; y < surfaces[0]->h; y++)
+        {
+            if (memcmp ((Uint8*)surfaces[0]->pixels + y*surfaces[0]->pitch, (Uint8*)surfaces[1]->pixels + y*surfaces[1]->pitch,
+                        surfaces[0]->w*4) != 0)
+                nbDifferent++;
+        }
+
+        fprintf(stdout, "    Blocks of %d pixels : SDL_FillRect %.2f us per frame, direct %.2f us per frame (%.1f times faster), %.0f Mpixels/s%s\n",
+                block, (double)time[0]/nbFrames, (double)time[1]/nbFrames, time[1] > 0 ? (double)time[0]/time[1] : 0.0,
+                time[1] > 0 ? (double)nbCells*size*size*nbFrames/time[1] : 0.0,
+                nbDifferent ? ", DIFFERENT PIXELS" : "");
+
+        RND_freeTiles (&tiles);
+        SDL_FreeSurface (surfaces[0]);
+        SDL_FreeSurface (surfaces[1]);
+    }
+}
+
+void RND_drawFrame (RND_Screen *drawn, RND_Backend *backend, const RND_Tiles *tiles, const RND_Digits *digits,
+                    const SPEC_Frame *frame, Uint32 time)
+{
+    RND_drawFrameAt (drawn, backend, tiles, digits, frame, time, 0);
+}
+
+/* Draws the active tetrimino offset pixels lower than the line j of block1, in the cells it covers */
+static void drawFalling (RND_Screen *drawn, SDL_Surface *screen, const RND_Tiles *tiles, const PieceShape *shape,
+                         int x, int y, int tile, int offset)
+{
+    const int size = BLOCK_SIZE - 2*GRID_WIDE;
+    int i, j, k, l, top;
+
+    for (l = 0; l < 4; l++)
+    {
+        for (k = 0; k < 4; k++)
+        {
+            i = x + k;
+            j = y + l;
+            if (!(shape->rows[l] & (1 << k)) || i < 0 || i >= NB_BLOCK_X || j+1 < FIRST_LINE || j+1 >= NB_BLOCK_Y)
+                continue;
+
+            /* The bottom of the cell j, then the top of the cell j+1 */
+            top = j*BLOCK_SIZE + GRID_WIDE - (FIRST_LINE*BLOCK_SIZE);
+            if (j >= FIRST_LINE && offset < size)
+            {
+                waitCell (drawn, screen, tiles, LATERAL_PANEL + BORDER + i*BLOCK_SIZE + GRID_WIDE, top + offset,
+                          size - offset, tile);
+                drawn->cells[j][i] = RND_NB_TILES;
+            }
+            if (offset > 2*GRID_WIDE)
+            {
+                waitCell (drawn, screen, tiles, LATERAL_PANEL + BORDER + i*BLOCK_SIZE + GRID_WIDE, top + BLOCK_SIZE,
+                          offset - 2*GRID_WIDE, tile);
+                drawn->cells[j+1][i] = RND_NB_TILES;
+            }
+        }
+    }
+}
+
+void RND_drawFrameAt (RND_Screen *drawn, RND_Backend *backend, const RND_Tiles *tiles, const RND_Digits *digits,
+                      const SPEC_Frame *frame, Uint32 time, int offset)
+{
+    /* Variables */
+    SDL_Surface *screen = backend->screen;
+    const Uint32 black = SDL_MapRGB (screen->format, 0, 0, 0);
+    const int active = RND_blinkTile (frame->tetrim, time), nextTile = RND_tetrimTile (frame->nextTetrim);
+    const PieceShape *shape = frame->active ? BB_getShape (frame->tetrim, frame->rotation) : NULL;
+    const PieceShape *next = BB_getShape (frame->nextTetrim, 0);
+    const Uint32 values[RND_NB_PANELS] = {frame->score, (Uint32)frame->level, (Uint32)frame->nbCompleteLines};
+    const int panelLines[RND_NB_PANELS] = {SCORE, LVL, NB_LINES};
+    SDL_Rect part;
+    int i, j, l, tile;
+
+    RND_begin (drawn, screen);
+
+    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    {
+        l = j - frame->y;
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            tile = frame->cells[j][i];
+            if (shape != NULL && offset == 0 && l >= 0 && l < 4 && i >= frame->x && (shape->rows[l] & (1 << (i - frame->x))))
+                tile = active;
+            RND_setCell (drawn, screen, tiles, i, j, tile);
+        }
+    }
+    if (shape != NULL && offset > 0)
+        drawFalling (drawn, screen, tiles, shape, frame->x, frame->y, active, offset);
+
+    for (j = 0; j < 4; j++)
+    {
+        for (i = 0; i < 4; i++)
+            RND_setNextCell (drawn, screen, tiles, i, j, (next->rows[j] & (1 << i)) ? nextTile : RND_TILE_BLACK);
+    }
+
+    for (i = 0; i < RND_NB_PANELS; i++)
+    {
+        if (RND_setPanel (drawn, i, values[i]))
+        {
+            part.x = BLOCK_SIZE + BORDER;
+            part.y = panelLines[i] + BORDER;
+            part.w = 4*BLOCK_SIZE;
+            part.h = BLOCK_SIZE;
+            RND_fill (drawn, screen, &part, black);
+            RND_drawNumber (drawn, screen, digits, values[i], LATERAL_PANEL/2, part.y);
+        }
+    }
+
+    RND_present (drawn, backend);
+}
+
+Uint8 RND_openBenchRenderer (RND_Backend *memory, SDL_Surface **hud, SDL_Surface *texture, RND_Digits *digits,
+                             RND_Tiles *tiles)
+{
+    /* Variables */
+    SDL_Surface *glyphs[10];
+    SDL_Rect position;
+    Uint8 ok; /* Boolean */
+    int n;
+
+    if (!RND_openMemory (memory, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return 0;
+    BB_getShape (0, 0);
+
+    /* There is no font : the digits are white rectangles of the size of the ones of the panels */
+    for (n = 0; n < 10; n++)
+    {
+        glyphs[n] = SDL_CreateRGBSurface (SDL_SWSURFACE, 11*gScale, 24*gScale, 32, 0, 0, 0, 0);
+        if (glyphs[n] != NULL)
+            SDL_FillRect (glyphs[n], NULL, SDL_MapRGB (glyphs[n]->format, 255, 255, 255));
+    }
+    ok = RND_initDigits (digits, glyphs);
+    for (n = 0; n < 10; n++)
+        SDL_FreeSurface (glyphs[n]);
+    *hud = SDL_CreateRGBSurface (SDL_SWSURFACE, WINDOW_WIDTH, WINDOW_HEIGHT, 32, 0, 0, 0, 0);
+    if (!ok || *hud == NULL || !RND_initTiles (tiles, memory->screen->format))
+    {
+        RND_freeDigits (digits);
+        SDL_FreeSurface (*hud);
+        RND_closeBackend (memory);
+        return 0;
+    }
+
+    SDL_FillRect (*hud, NULL, SDL_MapRGB ((*hud)->format, 192, 192, 192));
+    for (position.y = 0; texture != NULL && position.y < (*hud)->h; position.y += texture->h)
+    {
+        for (position.x = 0; position.x < (*hud)->w; position.x += texture->w)
+            SDL_BlitSurface (texture, NULL, *hud, &position);
+    }
+
+    return 1;
+}
+
+void RND_closeBenchRenderer (RND_Backend *memory, SDL_Surface *hud, RND_Digits *digits, RND_Tiles *tiles)
+{
+    RND_freeTiles (tiles);
+    RND_freeDigits (digits);
+    SDL_FreeSurface (hud);
+    RND_closeBackend (memory);
+}
+
+/* Draws nbGames games of seconds seconds played by an AI at the refresh rate of playGame.
+   Returns the time spent to draw them, in microseconds */
+static Uint64 drawBenchGames (RND_Screen *drawn, RND_Backend *memory, const RND_Tiles *tiles, const RND_Digits *digits,
+                              int nbGames, int seconds, Uint32 seed)
+{
+    /* Variables */
+    const Uint32 tickPeriod = 30; /* Refresh period of playGame */
+    LIVE_Pilot pilot;
+    LiveGame live;
+    SPEC_Frame frame;
+    Uint64 drawTime = 0, startTime;
+    Uint32 tick, nbTicksPerGame = seconds*1000/tickPeriod;
+    int n;
+
+    LIVE_initPilot (&pilot, seed);
+    for (n = 0; n < nbGames; n++)
+    {
+        LIVE_init (&live, BB_random (&pilot.seed) | 1);
+        RND_invalidate (drawn);
+        for (tick = 0; tick < nbTicksPerGame; tick++)
+        {
+            LIVE_pilot (&pilot, &live);
+            LIVE_advance (&live, tickPeriod);
+            SPEC_frameFromLive (&frame, &live);
+
+            startTime = PLT_getTimeUs ();
+            RND_drawFrame (drawn, memory, tiles, digits, &frame, tick*tickPeriod);
+            drawTime += PLT_getTimeUs () - startTime;
+        }
+    }
+
+    return drawTime;
+}
+
+void RND_benchmark (int nbGames, int seconds, Uint32 seed)
+{
+    /* Variables */
+    const char *names[2] = {"Whole window", "Changes only"};
+    SDL_Surface *hud = NULL;
+    RND_Backend memory;
+    RND_Screen drawn;
+    RND_Digits digits;
+    RND_Tiles tiles;
+    Uint64 drawTime;
+    Uint32 checksums[2] = {0, 0};
+    double pixelsPerFrame[2] = {0, 0};
+    int mode;
+
+    /* No window : the frames are drawn in memory */
+    if (!RND_openBenchRenderer (&memory, &hud, NULL, &digits, &tiles))
+        return;
+
+    fprintf(stdout, "Renderer : %d games of %d s, a frame every 30 ms, window of %dx%d pixels\n",
+            nbGames, seconds, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    /* The same games are drawn in both modes */
+    for (mode = 0; mode < 2; mode++)
+    {
+        RND_init (&drawn, mode == 0);
+        drawn.layer = hud;
+        drawTime = drawBenchGames (&drawn, &memory, &tiles, &digits, nbGames, seconds, seed);
+        if (drawn.nbFrames == 0)
+            break;
+
+        pixelsPerFrame[mode] = (double)drawn.nbPixelsPresented/drawn.nbFrames;
+        checksums[mode] = RND_checksum (&memory);
+        fprintf(stdout, "    %s : %.2f us per frame, %.0f pixels drawn, %.0f pixels presented in %.1f rectangles per frame, "
+                "last frame %08X\n", names[mode], (double)drawTime/drawn.nbFrames, (double)drawn.nbPixelsDrawn/drawn.nbFrames,
+                pixelsPerFrame[mode], (double)drawn.nbRectsPresented/drawn.nbFrames, checksums[mode]);
+    }
+    if (pixelsPerFrame[1] > 0)
+        fprintf(stdout, "    %.1f times less pixels presented, %s last frames\n", pixelsPerFrame[0]/pixelsPerFrame[1],
+                (checksums[0] == checksums[1]) ? "same" : "DIFFERENT");
+
+    RND_closeBenchRenderer (&memory, hud, &digits, &tiles);
+}
+
+void RND_scaleBenchmark (int nbGames, int seconds, Uint32 seed)
+{
+    /* Variables */
+    const int scale = gScale;
+    SDL_Surface *hud = NULL, *texture = NULL;
+    RND_Backend memory;
+    RND_Screen drawn;
+    RND_Digits digits;
+    RND_Tiles tiles;
+    Uint64 startTime, prescaleTime, drawTime[2];
+    Uint32 nbFrames[2];
+    int mode;
+
+    fprintf(stdout, "Scales : %d games of %d s at each scale, a frame every 30 ms\n", nbGames, seconds);
+
+    for (gScale = 1; gScale <= MAX_SCALE; gScale++)
+    {
+        /* The assets are prescaled once, like initSprites does */
+        startTime = PLT_getTimeUs ();
+        texture = RND_prescale (createAsset (64, 64, 1, 1), gScale);
+        if (texture == NULL || !RND_openBenchRenderer (&memory, &hud, texture, &digits, &tiles))
+        {
+            SDL_FreeSurface (texture);
+            break;
+        }
+        prescaleTime = PLT_getTimeUs () - startTime;
+
+        for (mode = 0; mode < 2; mode++)
+        {
+            RND_init (&drawn, mode == 0);
+            drawn.layer = hud;
+            drawTime[mode] = drawBenchGames (&drawn, &memory, &tiles, &digits, nbGames, seconds, seed);
+            nbFrames[mode] = drawn.nbFrames ? drawn.nbFrames : 1;
+        }
+
+        fprintf(stdout, "    %dx, window of %4dx%4d : prescaled in %5.2f ms, whole window %7.1f us per frame "
+                "(%.2f ns per pixel), changes only %5.2f us per frame\n",
+                gScale, WINDOW_WIDTH, WINDOW_HEIGHT, prescaleTime/1e3, (double)drawTime[0]/nbFrames[0],
+                1e3*drawTime[0]/nbFrames[0]/(WINDOW_WIDTH*WINDOW_HEIGHT), (double)drawTime[1]/nbFrames[1]);
+
+        RND_closeBenchRenderer (&memory, hud, &digits, &tiles);
+        SDL_FreeSurface (texture);
+    }
+
+    gScale = scale;
+}
@@ -0,0 +1,269 @@
+/** render.h and render.cpp draw the game on the screen, only where it has changed since the last frame.
+
+    The colors of the cells of the playfield and of the case "next", and the values of the panels, that are on
+    the screen are kept. A cell or a panel is drawn again only if it is different, and only the rectangles that
+    have been drawn are presented with SDL_UpdateRects, instead of the whole window with SDL_Flip.
+    After anything else has been drawn over the game (opening animation, window exposed...),
+    RND_invalidate makes the next frame draw and present everything, over the layer of the static parts of the
+    window (the HUD) if there is one.
+
+    The numbers of the panels are composed with the digits of an atlas rendered once, without any TTF call.
+    The tiles of the cells are filled once : one per color of block, and the colors of the blink cycle of each
+    active tetrimino. The cells that have changed are kept until the end of the frame, then written directly in
+    the pixels of the screen, locked once, a line of pixels at a time with SSE2 or AVX2 stores (a loop of pixels
+    if the processor has none of them). On a screen that is not in 32 bits, they are blitted from the atlas of
+    the tiles.
+
+    The sizes in pixels are multiplied by gScale (see constants.h). The images are enlarged once when they are
+    loaded (RND_prescale), the fonts are opened at their size times gScale, and the tiles, the digits and the HUD
+    are built at the size of the window : no blit has to scale anything, a larger window only costs more pixels.
+
+    A screen with double buffering must be entirely drawn at each frame : the frame is drawn in the buffer
+    that was presented two frames ago. So the window is created with a software surface.
+
+    The game draws in the surface of a RND_Backend and presents it with RND_flip and RND_updateRects, never with
+    SDL_Flip on the window directly. RND_openWindow opens the window of SDL. RND_openMemory creates a surface on
+    pixels in memory without any video driver, where presenting only counts the pixels and keeps the rectangles
+    presented : the frames can be drawn, measured and compared with RND_checksum on a machine without display,
+    or drawn by a thread and copied in the window by the main thread with RND_presentCopy, the video functions
+    of SDL 1.2 working on the main thread only.
+**/
+
+#ifndef RENDER_H_INCLUDED
+#define RENDER_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "spectate.h"
+
+#define RND_MAX_RECTS       64 /* Beyond, the whole window is presented */
+#define RND_BLINK_STEPS     20 /* Colors of the active tetrimino during a blink cycle of one second */
+#define RND_TILES_PER_LINE  16 /* Tiles in a line of the atlas */
+#define RND_NO_VALUE        0xFFFFFFFF /* Value of a panel that must be printed again */
+#define RND_MAX_CELLS       ((NB_BLOCK_Y-FIRST_LINE)*NB_BLOCK_X + 16 + 8) /* Cells of the playfield, of the case "next"
+                                                                             and parts of the active tetrimino */
+
+enum { RND_BACKEND_WINDOW, RND_BACKEND_MEMORY };
+enum { RND_PANEL_SCORE, RND_PANEL_LEVEL, RND_PANEL_LINES, RND_NB_PANELS };
+
+/* Tiles : the tiles 0 to RND_TILE_BLACK-1 are the colors of the blocks, in the order of the BLOCK_* of gMap
+   (BLOCK_VOID is white, BLOCK_ACTIVE is grey). The blink cycle of each tetrimino follows the other tiles */
+enum { RND_TILE_BLACK = 9, RND_TILE_BLINK, RND_NB_TILES = RND_TILE_BLINK + 7*RND_BLINK_STEPS };
+
+typedef struct RND_Backend RND_Backend;
+typedef struct RND_Cell RND_Cell;
+typedef struct RND_Screen RND_Screen;
+typedef struct RND_Digits RND_Digits;
+typedef struct RND_Tiles RND_Tiles;
+
+/* Where the frames are drawn and presented */
+struct RND_Backend
+{
+    int type; /* RND_BACKEND_* */
+    SDL_Surface *screen; /* Surface to draw in */
+    Uint32 *pixels; /* RND_BACKEND_MEMORY : pixels of the screen, 0x00RRGGBB. NULL for the window */
+    SDL_Rect presented[RND_MAX_RECTS]; /* RND_BACKEND_MEMORY : presented since the last RND_presentCopy */
+    int nbPresented; /* More than RND_MAX_RECTS when the whole screen has been presented */
+
+    /* Measures */
+    Uint32 nbPresents;
+    Uint64 nbPixelsPresented;
+};
+
+/* A cell to write in the pixels of the screen */
+struct RND_Cell
+{
+    Sint16 x, y; /* Top left pixel, inside the grid */
+    Sint16 h; /* Lines of pixels filled from y, 0 for the whole cell */
+    Uint16 tile;
+    Uint32 color; /* Pixel of the tile */
+};
+
+struct RND_Screen
+{
+    Uint16 cells[NB_BLOCK_Y][NB_BLOCK_X]; /* Tile drawn in each visible cell of the playfield */
+    Uint16 next[4][4]; /* Tile drawn in each cell of the case "next" */
+    Uint32 panels[RND_NB_PANELS]; /* Value printed in each panel */
+    Uint8 valid; /* Boolean : 0 if everything must be drawn and presented at the next frame */
+    Uint8 fullRepaint; /* Boolean : 1 to draw everything at each frame and flip the whole window */
+    SDL_Surface *layer; /* Static parts of the window, drawn under the game when everything is drawn. Can be NULL */
+    SDL_Rect overlay; /* Part of the screen covered by an overlay, w is 0 if there is none */
+    SDL_Rect rects[RND_MAX_RECTS]; /* Drawn since the last presentation */
+    int nbRects;
+    const RND_Tiles *tiles; /* Tiles of the cells waiting */
+    RND_Cell waiting[RND_MAX_CELLS]; /* Cells changed since the beginning of the frame, written by RND_present */
+    int nbWaiting;
+
+    /* Measures */
+    Uint32 nbFrames;
+    Uint64 nbPixelsDrawn, nbPixelsPresented, nbRectsPresented;
+};
+
+/* The digits 0 to 9 side by side in one surface */
+struct RND_Digits
+{
+    SDL_Surface *atlas;
+    SDL_Rect glyphs[10]; /* Part of the atlas of each digit */
+};
+
+/* The tiles of the cells */
+struct RND_Tiles
+{
+    SDL_Surface *atlas;
+    SDL_Rect tiles[RND_NB_TILES]; /* Part of the atlas of each tile */
+    Uint32 colors[RND_NB_TILES]; /* Pixel of each tile, in the format of the screen */
+};
+
+
+/** Opens the window of SDL, with a software surface of 32 bits. SDL_Init must have been called with SDL_INIT_VIDEO.
+    Returns a boolean : 0 if it cannot be opened **/
+Uint8 RND_openWindow (RND_Backend*, int w, int h);
+
+/** Creates a screen of 32 bits in memory, without any video driver. Returns a boolean : 0 if it cannot be created **/
+Uint8 RND_openMemory (RND_Backend*, int w, int h);
+
+/** Frees the screen in memory. The window is closed by SDL_Quit **/
+void RND_closeBackend (RND_Backend*);
+
+/** Presents the rectangles of the screen **/
+void RND_updateRects (RND_Backend*, int nbRects, SDL_Rect *rects);
+
+/** Presents the whole screen **/
+void RND_flip (RND_Backend*);
+
+/** Copies the parts of the screen in memory presented since the last call in the screen of another backend,
+    and presents them there **/
+void RND_presentCopy (RND_Backend *memory, RND_Backend *target);
+
+/** FNV-1a hash of the pixels of the screen, to compare frames **/
+Uint32 RND_checksum (RND_Backend*);
+
+/** Prepares the state of the screen. The first frame is drawn entirely **/
+void RND_init (RND_Screen*, Uint8 fullRepaint);
+
+/** Starts a frame : draws the layer if everything must be drawn **/
+void RND_begin (RND_Screen*, SDL_Surface *screen);
+
+/** Something else has been drawn over the game : the next frame is drawn and presented entirely **/
+void RND_invalidate (RND_Screen*);
+
+/** Draws the tile in the cell (i, j) of the playfield (j in the lines of gMap, the hidden ones are ignored)
+    at the end of the frame if it has changed. Returns a boolean : 1 if it will be drawn **/
+Uint8 RND_setCell (RND_Screen*, SDL_Surface *screen, const RND_Tiles*, int i, int j, int tile);
+
+/** Same as RND_setCell for the cell (i, j) of the case "next" **/
+Uint8 RND_setNextCell (RND_Screen*, SDL_Surface *screen, const RND_Tiles*, int i, int j, int tile);
+
+/** Returns a boolean : 1 if the panel (RND_PANEL_*) must be drawn again to print value **/
+Uint8 RND_setPanel (RND_Screen*, int panel, Uint32 value);
+
+/** Fills a rectangle of the screen and presents it at the end of the frame **/
+void RND_fill (RND_Screen*, SDL_Surface *screen, SDL_Rect *part, Uint32 color);
+
+/** Blits a part of a surface (all of it if part is NULL) on the screen and presents it at the end of the frame **/
+void RND_blit (RND_Screen*, SDL_Surface *source, SDL_Rect *part, SDL_Surface *screen, SDL_Rect *position);
+
+/** Blits a surface (pause, game over...) centered over the last frame and presents it at once.
+    Nothing must be drawn until RND_hideOverlay **/
+void RND_showOverlay (RND_Screen*, RND_Backend*, SDL_Surface *overlay);
+
+/** Draws the layer again where the overlay was, and the cells and the panels it covered at the next frame.
+    Nothing is copied from the screen and nothing is allocated **/
+void RND_hideOverlay (RND_Screen*, RND_Backend*);
+
+/** Presents a rectangle at the end of the frame **/
+void RND_addRect (RND_Screen*, const SDL_Rect*);
+
+/** Ends the frame : writes the cells that have changed, then presents the rectangles drawn, or the whole window **/
+void RND_present (RND_Screen*, RND_Backend*);
+
+/** Draws a frame like updateScreen from the state of a game (the active tetrimino blinks with time, in milliseconds)
+    and presents it **/
+void RND_drawFrame (RND_Screen*, RND_Backend*, const RND_Tiles*, const RND_Digits*, const SPEC_Frame*, Uint32 time);
+
+/** Same as RND_drawFrame with the active tetrimino offset pixels (0 to BLOCK_SIZE-1) lower, on its way to the next line.
+    Its blocks are cut by the lines of the grid, and the cells they cover are drawn again at the next frame **/
+void RND_drawFrameAt (RND_Screen*, RND_Backend*, const RND_Tiles*, const RND_Digits*, const SPEC_Frame*,
+                      Uint32 time, int offset);
+
+/** Builds the atlas from the surfaces of the digits 0 to 9 (rendered with the same font and colors).
+    Returns a boolean : 0 if the atlas cannot be created **/
+Uint8 RND_initDigits (RND_Digits*, SDL_Surface *glyphs[10]);
+
+/** Frees the atlas **/
+void RND_freeDigits (RND_Digits*);
+
+/** Width in pixels of a number written with the atlas **/
+int RND_numberWidth (const RND_Digits*, Uint32 value);
+
+/** Writes a number centered on centerX, its top at y, and presents it at the end of the frame **/
+void RND_drawNumber (RND_Screen*, SDL_Surface *screen, const RND_Digits*, Uint32 value, int centerX, int y);
+
+/** Color of the active tetrimino, that blinks : it is bleached from 25% to 75% then from 75% to 25% each second **/
+Uint32 RND_blinkColor (const SDL_PixelFormat*, int tetrim, Uint32 time);
+
+/** Fills the tiles in the pixel format of the screen. Returns a boolean : 0 if the atlas cannot be created **/
+Uint8 RND_initTiles (RND_Tiles*, const SDL_PixelFormat*);
+
+/** Frees the atlas **/
+void RND_freeTiles (RND_Tiles*);
+
+/** Fills squares of size pixels (or their h first lines) at the positions of the cells, in their colors, in the pixels of the surface.
+    A surface that is not in 32 bits is filled with SDL_FillRect. The cells out of the surface are ignored **/
+void RND_fillCells (SDL_Surface*, const RND_Cell*, int nbCells, int size);
+
+/** Writes in a part of the destination the pixels of under covered by the ones of over with an opacity of alpha,
+    like a blit of under then a blit of over with SDL_SetAlpha, without changing the surfaces. The pixels are mixed
+    directly if the three surfaces are in the same format of 32 bits **/
+void RND_blend (SDL_Surface *destination, SDL_Surface *under, SDL_Surface *over, SDL_Rect *part, Uint8 alpha);
+
+/** Tile of the locked blocks of a tetrimino **/
+int RND_tetrimTile (int tetrim);
+
+/** Tile of the active tetrimino at a time in milliseconds **/
+int RND_blinkTile (int tetrim, Uint32 time);
+
+/** Sets the scale of the window (gScale) : requested if it is between 1 and MAX_SCALE, otherwise the largest one
+    whose window fits the desktop. Must be called before the window is opened and the sprites are loaded.
+    Returns the scale **/
+int RND_chooseScale (int requested);
+
+/** Enlarges a surface factor times, each pixel becoming a square of factor pixels, once at loading so the blits
+    never have to scale it. The surface given is freed. Returns the surface given if factor is 1 or if it fails **/
+SDL_Surface* RND_prescale (SDL_Surface*, int factor);
+
+/** Converts a surface to the pixel format of the screen, so its blits do not have to convert it any more.
+    The alpha of the pixels is kept only if one of them is not opaque. The surface given is freed.
+    Returns the surface given if there is no screen yet or if the conversion fails **/
+SDL_Surface* RND_toDisplay (SDL_Surface*);
+
+/** Blits the opening animation and the menus with surfaces in the pixel formats they are loaded in
+    (IMG_Load, TTF_RenderText_Blended), then converted by RND_toDisplay, and prints the pixels blitted per second
+    in the stdout file. The screen is opened with the dummy video driver **/
+void RND_assetBenchmark (int nbRepeats);
+
+/** Fills the cells of the playfield and of the case "next" nbFrames times in other colors, with SDL_FillRect then
+    with RND_fillCells, for blocks of 1, 2 and 4 times BLOCK_SIZE (and GRID_WIDE), checks that both give the same
+    pixels and prints the time per frame in the stdout file **/
+void RND_fillBenchmark (int nbFrames);
+
+/** Opens the screen of the benchmarks in memory, a HUD of one color with the texture repeated on it if there is one
+    (texture can be NULL), and digits and tiles at the scale of the window. There is no font : the digits are white
+    rectangles. Returns a boolean : 0 if they cannot be created **/
+Uint8 RND_openBenchRenderer (RND_Backend *memory, SDL_Surface **hud, SDL_Surface *texture, RND_Digits*, RND_Tiles*);
+
+/** Frees what RND_openBenchRenderer has created **/
+void RND_closeBenchRenderer (RND_Backend *memory, SDL_Surface *hud, RND_Digits*, RND_Tiles*);
+
+/** Draws nbGames games of seconds seconds played by an AI that presses the keys like a player, at the refresh
+    rate of playGame, entirely then only where they change, in a screen in memory. Prints the pixels drawn and
+    presented, the time per frame and the checksum of the last frame, that must be the same in both modes,
+    in the stdout file **/
+void RND_benchmark (int nbGames, int seconds, Uint32 seed);
+
+/** Draws the games of RND_benchmark at the scales 1 to MAX_SCALE, and prints the time to prescale the assets
+    and the time per frame at each scale, the whole window then only the changes, in the stdout file **/
+void RND_scaleBenchmark (int nbGames, int seconds, Uint32 seed);
+
+#endif // RENDER_H_INCLUDED
@@ -0,0 +1,36 @@
+#include <math.h>
+#include <SDL/SDL.h>
+
+#include "rules.h"
+
+Uint32 RULE_linesPoints (int nbLines, int level)
+{
+    switch (nbLines)
+    {
+        case 1:
+            return 100*level;
+        case 2:
+            return 300*level;
+        case 3:
+            return 500*level;
+        case 4:
+            return 800*level;
+        default:
+            return 0;
+    }
+}
+
+Uint32 RULE_addPoints (Uint32 score, Uint32 points)
+{
+    return (score + points < SCORE_MAX) ? (score + points) : SCORE_MAX;
+}
+
+int RULE_nextLevel (int level, int nbCompleteLines)
+{
+    return (nbCompleteLines >= level*LINES_PER_LEVEL) ? level+1 : level;
+}
+
+Uint32 RULE_fallingPeriod (int level)
+{
+    return pow( 0.8 - ((level-1)*0.007), level-1)*1000;
+}
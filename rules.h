@@ -0,0 +1,29 @@
+/** rules.h and rules.cpp gather the rules of the game that do not depend on the display :
+    the points earned, the levels and the speed of the fall.
+    They are shared by playGame and by the headless simulation so both count the points the same way. **/
+
+#ifndef RULES_H_INCLUDED
+#define RULES_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#define SCORE_MAX               999999999
+
+#define SOFT_DROP_POINTS        2 /* Points earned each time the tetrimino falls one line with the DOWN key pressed */
+#define LINES_PER_LEVEL         10
+
+
+/** Returns the points earned when nbLines lines are completed at once at the given level
+    (100, 300, 500 or 800 times the level) **/
+Uint32 RULE_linesPoints (int nbLines, int level);
+
+/** Adds points to a score without going over SCORE_MAX **/
+Uint32 RULE_addPoints (Uint32 score, Uint32 points);
+
+/** Returns the new level once the total number of complete lines is known **/
+int RULE_nextLevel (int level, int nbCompleteLines);
+
+/** Returns the time in milliseconds the tetrimino needs to fall one line at the given level **/
+Uint32 RULE_fallingPeriod (int level);
+
+#endif // RULES_H_INCLUDED
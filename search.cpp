@@ -0,0 +1,553 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+#include "boardfeatures.h"
+#include "sim.h"
+#include "ai.h"
+#include "platform.h"
+#include "search.h"
+
+#define LOST_VALUE      -1e9 /* Value of a playfield where a tetrimino cannot be placed */
+
+typedef struct Child Child;
+typedef struct SearchJob SearchJob;
+typedef struct Search Search;
+typedef struct WorkerStats WorkerStats;
+
+/* A playfield after a placement, with its value according to the weights */
+struct Child
+{
+    Placement placement;
+    Bitboard board;
+    BoardFeatures ftr;
+    int nbLines; /* Lines completed since the root of the search */
+    double value;
+};
+
+/* One branch of a chance node of the first level : the placement of the next tetrimino (index next)
+   after the placement of the active one (index root), followed by the tetrimino tetrim */
+struct SearchJob
+{
+    int root, next;
+    int tetrim;
+    Uint8 bag;
+    double value;
+};
+
+struct Search
+{
+    const AI_Weights *weights;
+    const SearchParams *params;
+    int depth;
+    Uint64 deadline; /* 0 if there is no time budget */
+    volatile Uint8 aborted; /* Boolean */
+
+    Child rootChildren[SRCH_MAX_WIDTH];
+    int nbRootChildren;
+    Child nextChildren[SRCH_MAX_WIDTH][SRCH_MAX_WIDTH];
+    int nbNextChildren[SRCH_MAX_WIDTH];
+
+    /* Shared by the worker threads */
+    SDL_mutex *lock;
+    SearchJob *jobs;
+    int nbJobs;
+    int nextJob;
+    Uint64 nodes;
+    Uint32 chanceCuts;
+    int nbWorkers; /* Number of workers started, each one using the cache of its index */
+};
+
+/* Counters and cache of a worker, the counters being added to the ones of the search when the worker stops */
+struct WorkerStats
+{
+    Uint64 nodes;
+    Uint32 chanceCuts;
+    PlacementCache *cache;
+};
+
+/* Evaluates every placement of a tetrimino and keeps the width best ones, sorted from the best.
+   Returns the number of children kept */
+static int expand (const Child *parent, int tetrim, const AI_Weights *weights, int width,
+                   Child children[SRCH_MAX_WIDTH], Uint64 *nodes, PlacementCache *cache)
+{
+    /* Variables */
+    Placement placements[SIM_MAX_PLACEMENTS];
+    const PieceShape *shape = NULL;
+    Child child;
+    double landingHeight;
+    int nbPlacements, nbChildren = 0, k, n;
+
+    nbPlacements = CACHE_listPlacements (cache, &parent->board, &parent->ftr, tetrim, placements);
+    *nodes += nbPlacements;
+
+    for (k = 0; k < nbPlacements; k++)
+    {
+        child.placement = placements[k];
+        child.board = parent->board;
+        child.ftr = parent->ftr;
+        child.nbLines = parent->nbLines + FTR_addPiece (&child.ftr, &child.board, tetrim,
+                                                        placements[k].rotation, placements[k].x, placements[k].y);
+        shape = BB_getShape (tetrim, placements[k].rotation);
+        landingHeight = NB_BLOCK_Y - placements[k].y - (shape->top + shape->bottom)/2.0;
+        child.value = AI_evaluate (weights, &child.ftr, child.nbLines, landingHeight);
+
+        /* Insertion in the sorted list of the children kept */
+        if (nbChildren == width && child.value <= children[nbChildren-1].value)
+            continue;
+        n = (nbChildren < width) ? nbChildren++ : nbChildren-1;
+        for (; n > 0 && children[n-1].value < child.value; n--)
+            children[n] = children[n-1];
+        children[n] = child;
+    }
+
+    return nbChildren;
+}
+
+static double maxValue (Search *search, const Child *parent, int tetrim, Uint8 bag, int depth, WorkerStats *stats);
+
+/* Average of the values of a playfield over the tetriminoes that can come from the bag.
+   Stops as soon as the average cannot be greater than alpha */
+static double chanceValue (Search *search, const Child *child, Uint8 bag, int depth, double alpha, WorkerStats *stats)
+{
+    /* Variables */
+    Uint8 outcomes = (bag != 0) ? bag : SIM_FULL_BAG;
+    int nbOutcomes = BB_popcount (outcomes), nbDone = 0, tetrim;
+    double sum = 0.0, optimistic = child->value + search->params->pruneMargin;
+
+    for (tetrim = 0; tetrim < 7; tetrim++)
+    {
+        if (!(outcomes & (1 << tetrim)))
+            continue;
+
+        sum += maxValue (search, child, tetrim, outcomes & ~(1 << tetrim), depth, stats);
+        nbDone++;
+
+        if (search->params->pruneMargin >= 0.0 && nbDone < nbOutcomes
+            && sum + (nbOutcomes - nbDone)*optimistic <= alpha*nbOutcomes)
+        {
+            stats->chanceCuts++;
+            return (sum + (nbOutcomes - nbDone)*optimistic)/nbOutcomes;
+        }
+    }
+
+    return sum/nbOutcomes;
+}
+
+/* Best value of the placements of a known tetrimino, each one being followed by depth unknown tetriminoes */
+static double maxValue (Search *search, const Child *parent, int tetrim, Uint8 bag, int depth, WorkerStats *stats)
+{
+    /* Variables */
+    Child children[SRCH_MAX_WIDTH];
+    double value, best = LOST_VALUE;
+    int nbChildren, k;
+
+    if (search->aborted)
+        return LOST_VALUE;
+    if (search->deadline != 0 && PLT_getTimeUs () > search->deadline)
+    {
+        search->aborted = 1;
+        return LOST_VALUE;
+    }
+
+    nbChildren = expand (parent, tetrim, search->weights, (depth > 0) ? search->params->width : 1,
+                         children, &stats->nodes, stats->cache);
+    if (nbChildren == 0)
+        return LOST_VALUE;
+    if (depth == 0)
+        return children[0].value;
+
+    for (k = 0; k < nbChildren; k++)
+    {
+        value = chanceValue (search, &children[k], bag, depth-1, (k == 0) ? LOST_VALUE : best, stats);
+        if (value > best)
+            best = value;
+    }
+
+    return best;
+}
+
+static int worker (void *data)
+{
+    Search *search = (Search*)data;
+    SearchJob *job = NULL;
+    WorkerStats stats = {0, 0, NULL};
+    int n;
+
+    SDL_LockMutex (search->lock);
+    if (search->params->caches != NULL)
+        stats.cache = search->params->caches[search->nbWorkers];
+    search->nbWorkers++;
+    SDL_UnlockMutex (search->lock);
+
+    while (!search->aborted)
+    {
+        SDL_LockMutex (search->lock);
+        n = search->nextJob++;
+        SDL_UnlockMutex (search->lock);
+
+        if (n >= search->nbJobs)
+            break;
+
+        job = &search->jobs[n];
+        job->value = maxValue (search, &search->nextChildren[job->root][job->next], job->tetrim,
+                               job->bag, search->depth-1, &stats);
+    }
+
+    SDL_LockMutex (search->lock);
+    search->nodes += stats.nodes;
+    search->chanceCuts += stats.chanceCuts;
+    SDL_UnlockMutex (search->lock);
+
+    return 0;
+}
+
+/* Searches the first chance nodes at the depth of the search on all the threads,
+   then chooses the root placement. Returns a boolean : 0 if the time is over */
+static Uint8 searchDepth (Search *search, Placement *best)
+{
+    /* Variables */
+    SDL_Thread *threads[SRCH_MAX_THREADS];
+    int nbThreads = search->params->nbThreads, nbOutcomes, n, r, j;
+    double nextValue, rootValue, bestValue = LOST_VALUE;
+
+    if (nbThreads < 1)
+        nbThreads = 1;
+    if (nbThreads > SRCH_MAX_THREADS)
+        nbThreads = SRCH_MAX_THREADS;
+
+    search->nextJob = 0;
+    search->nbWorkers = 0;
+    for (n = 0; n < nbThreads-1; n++)
+        threads[n] = SDL_CreateThread (worker, search);
+    worker (search);
+    for (n = 0; n < nbThreads-1; n++)
+    {
+        /* If a thread could not be created, the work has been done by the remaining ones */
+        if (threads[n] != NULL)
+            SDL_WaitThread (threads[n], NULL);
+    }
+    if (search->aborted)
+        return 0;
+
+    /* The jobs are sorted by root placement, then by placement of the next tetrimino */
+    for (n = 0, r = 0; r < search->nbRootChildren; r++)
+    {
+        rootValue = LOST_VALUE;
+        for (j = 0; j < search->nbNextChildren[r]; j++)
+        {
+            nextValue = 0.0;
+            nbOutcomes = 0;
+            while (n < search->nbJobs && search->jobs[n].root == r && search->jobs[n].next == j)
+            {
+                nextValue += search->jobs[n].value;
+                nbOutcomes++;
+                n++;
+            }
+            nextValue /= nbOutcomes;
+            if (nextValue > rootValue)
+                rootValue = nextValue;
+        }
+        if (r == 0 || rootValue > bestValue)
+        {
+            bestValue = rootValue;
+            *best = search->rootChildren[r].placement;
+        }
+    }
+
+    return 1;
+}
+
+void SRCH_defaultParams (SearchParams *params)
+{
+    params->maxDepth = 2;
+    params->timeBudget = 20000;
+    params->width = 5;
+    params->pruneMargin = 2.0;
+    params->nbThreads = PLT_getNbCores ();
+    params->caches = NULL;
+}
+
+Uint8 SRCH_expectimax (const SimGame *game, const AI_Weights *weights, const SearchParams *params,
+                       Placement *best, SearchStats *stats)
+{
+    /* Variables */
+    Search *search = NULL;
+    Child root;
+    Uint64 startTime = PLT_getTimeUs ();
+    Uint8 outcomes = (game->bag != 0) ? game->bag : SIM_FULL_BAG;
+    int r, j, tetrim, nbJobs = 0, depth;
+
+    search = (Search*)malloc(sizeof(Search));
+    if (search == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the search\n");
+        return AI_bestPlacementWithNext (game, weights, best);
+    }
+    search->weights = weights;
+    search->params = params;
+    search->deadline = (params->timeBudget != 0) ? startTime + params->timeBudget : 0;
+    search->aborted = 0;
+    search->nodes = 0;
+    search->chanceCuts = 0;
+
+    /* The two known tetriminoes are expanded once for all the depths */
+    root.board = game->board;
+    FTR_compute (&root.ftr, &game->board);
+    root.nbLines = 0;
+    root.value = 0.0;
+    search->nbRootChildren = expand (&root, game->actualTetrim, weights, params->width,
+                                     search->rootChildren, &search->nodes, (params->caches != NULL) ? params->caches[0] : NULL);
+    if (search->nbRootChildren == 0)
+    {
+        free (search);
+        return 0;
+    }
+    for (r = 0; r < search->nbRootChildren; r++)
+    {
+        search->nbNextChildren[r] = expand (&search->rootChildren[r], game->nextTetrim, weights, params->width,
+                                            search->nextChildren[r], &search->nodes,
+                                            (params->caches != NULL) ? params->caches[0] : NULL);
+        nbJobs += search->nbNextChildren[r]*BB_popcount (outcomes);
+    }
+
+    /* Depth 0 : the best pair of placements of the known tetriminoes */
+    search->depth = 0;
+    *best = search->rootChildren[0].placement;
+    for (r = 0, root.value = LOST_VALUE; r < search->nbRootChildren; r++)
+    {
+        if (search->nbNextChildren[r] > 0 && search->nextChildren[r][0].value > root.value)
+        {
+            root.value = search->nextChildren[r][0].value;
+            *best = search->rootChildren[r].placement;
+        }
+    }
+
+    /* Then one more unknown tetrimino at each iteration, until the time is over */
+    search->jobs = (SearchJob*)malloc(sizeof(SearchJob)*(nbJobs+1));
+    search->lock = SDL_CreateMutex ();
+    if (search->jobs != NULL && search->lock != NULL)
+    {
+        search->nbJobs = 0;
+        for (r = 0; r < search->nbRootChildren; r++)
+        {
+            for (j = 0; j < search->nbNextChildren[r]; j++)
+            {
+                for (tetrim = 0; tetrim < 7; tetrim++)
+                {
+                    if (!(outcomes & (1 << tetrim)))
+                        continue;
+                    search->jobs[search->nbJobs].root = r;
+                    search->jobs[search->nbJobs].next = j;
+                    search->jobs[search->nbJobs].tetrim = tetrim;
+                    search->jobs[search->nbJobs].bag = outcomes & ~(1 << tetrim);
+                    search->nbJobs++;
+                }
+            }
+        }
+
+        for (depth = 1; depth <= params->maxDepth && depth <= SRCH_MAX_DEPTH; depth++)
+        {
+            search->depth = depth;
+            if (!searchDepth (search, best))
+            {
+                search->depth = depth-1;
+                break;
+            }
+        }
+    }
+    else
+        fprintf(stderr, "An error occurred during the preparation of the search\n");
+
+    if (stats != NULL)
+    {
+        stats->nodes = search->nodes;
+        stats->chanceCuts = search->chanceCuts;
+        stats->depth = search->depth;
+        stats->time = (Uint32)(PLT_getTimeUs () - startTime);
+    }
+
+    if (search->lock != NULL)
+        SDL_DestroyMutex (search->lock);
+    free (search->jobs);
+    free (search);
+
+    return 1;
+}
+
+Uint8 SRCH_beam (const SimGame *game, const AI_Weights *weights, int width, Placement *best, SearchStats *stats)
+{
+    /* Variables */
+    Child *beam = NULL, *children = NULL, *candidates = NULL;
+    Placement roots[SRCH_MAX_WIDTH], candidateRoots[SRCH_MAX_WIDTH*SRCH_MAX_WIDTH];
+    Child root;
+    Uint64 startTime = PLT_getTimeUs (), nodes = 0;
+    int tetrims[2] = {game->actualTetrim, game->nextTetrim};
+    int nbBeam, nbChildren, nbCandidates, layer, b, k, n;
+
+    if (width < 1)
+        width = 1;
+    if (width > SRCH_MAX_WIDTH)
+        width = SRCH_MAX_WIDTH;
+
+    beam = (Child*)malloc(sizeof(Child)*width);
+    children = (Child*)malloc(sizeof(Child)*SRCH_MAX_WIDTH);
+    candidates = (Child*)malloc(sizeof(Child)*width*SRCH_MAX_WIDTH);
+    if (beam == NULL || children == NULL || candidates == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the search\n");
+        free (beam);
+        free (children);
+        free (candidates);
+        return AI_bestPlacementWithNext (game, weights, best);
+    }
+
+    root.board = game->board;
+    FTR_compute (&root.ftr, &game->board);
+    root.nbLines = 0;
+    nbBeam = expand (&root, tetrims[0], weights, width, beam, &nodes, NULL);
+    for (b = 0; b < nbBeam; b++)
+        roots[b] = beam[b].placement;
+
+    /* Each layer keeps the width best playfields among the children of the playfields of the beam */
+    for (layer = 1; layer < 2 && nbBeam > 0; layer++)
+    {
+        nbCandidates = 0;
+        for (b = 0; b < nbBeam; b++)
+        {
+            nbChildren = expand (&beam[b], tetrims[layer], weights, width, children, &nodes, NULL);
+            for (k = 0; k < nbChildren; k++)
+            {
+                for (n = nbCandidates; n > 0 && candidates[n-1].value < children[k].value; n--)
+                {
+                    candidates[n] = candidates[n-1];
+                    candidateRoots[n] = candidateRoots[n-1];
+                }
+                candidates[n] = children[k];
+                candidateRoots[n] = roots[b];
+                nbCandidates++;
+            }
+        }
+
+        /* The next tetrimino cannot be placed anywhere : the beam of the active one is kept */
+        if (nbCandidates == 0)
+            break;
+        nbBeam = (nbCandidates < width) ? nbCandidates : width;
+        for (b = 0; b < nbBeam; b++)
+        {
+            beam[b] = candidates[b];
+            roots[b] = candidateRoots[b];
+        }
+    }
+
+    if (nbBeam > 0)
+        *best = roots[0];
+
+    if (stats != NULL)
+    {
+        stats->nodes = nodes;
+        stats->chanceCuts = 0;
+        stats->depth = 0;
+        stats->time = (Uint32)(PLT_getTimeUs () - startTime);
+    }
+
+    free (beam);
+    free (children);
+    free (candidates);
+
+    return nbBeam > 0;
+}
+
+void SRCH_benchmark (int nbGames, int maxPieces, Uint32 seed)
+{
+    /* Variables */
+    const char *names[6] = {"Beam search (width 8)", "Expectimax depth 1", "Expectimax depth 2",
+                            "Expectimax depth 2, no pruning", "Expectimax depth 3, 20 ms", "Expectimax depth 2, cache"};
+    AI_Weights weights;
+    SearchParams params;
+    SearchStats stats;
+    PlacementCache *caches[SRCH_MAX_THREADS];
+    CacheStats cacheStats, total = {0, 0, 0, 0, 0, 0};
+    SimGame game;
+    Placement placement;
+    Uint64 nodes, time, score, pieces, depths;
+    Uint32 gameSeed;
+    int method, nbCaches, n;
+    Uint8 placed; /* Boolean */
+
+    AI_defaultWeights (&weights);
+    BB_getShape (0, 0);
+
+    fprintf(stdout, "Search benchmark : %d games of at most %d tetriminoes on %d threads\n",
+            nbGames, maxPieces, PLT_getNbCores ());
+    for (method = 0; method < 6; method++)
+    {
+        SRCH_defaultParams (&params);
+        params.maxDepth = (method == 1) ? 1 : (method == 4) ? 3 : 2;
+        if (method == 3)
+            params.pruneMargin = -1.0;
+        if (method != 4)
+            params.timeBudget = 0;
+
+        /* 4 MB of placement cache per thread */
+        nbCaches = 0;
+        if (method == 5)
+        {
+            for (nbCaches = 0; nbCaches < params.nbThreads && nbCaches < SRCH_MAX_THREADS; nbCaches++)
+            {
+                caches[nbCaches] = CACHE_create (4 << 20);
+                if (caches[nbCaches] == NULL)
+                    break;
+            }
+            if (nbCaches == params.nbThreads)
+                params.caches = caches;
+        }
+
+        nodes = time = score = pieces = depths = 0;
+        gameSeed = seed;
+        for (n = 0; n < nbGames; n++)
+        {
+            SIM_init (&game, BB_random (&gameSeed) | 1);
+            while (!game.over && (maxPieces <= 0 || game.nbPieces < maxPieces))
+            {
+                if (method == 0)
+                    placed = SRCH_beam (&game, &weights, 8, &placement, &stats);
+                else
+                    placed = SRCH_expectimax (&game, &weights, &params, &placement, &stats);
+                if (!placed)
+                    break;
+                nodes += stats.nodes;
+                time += stats.time;
+                depths += stats.depth;
+                SIM_play (&game, &placement);
+            }
+            score += game.score;
+            pieces += game.nbPieces;
+        }
+
+        fprintf(stdout, "%-32s : %8.1f points per tetrimino, %9.0f nodes/s, %8.3f ms per move, depth %.2f\n",
+                names[method], pieces ? (double)score/pieces : 0.0, time ? nodes*1e6/time : 0.0,
+                pieces ? time/1000.0/pieces : 0.0, pieces ? (double)depths/pieces : 0.0);
+
+        for (n = 0; n < nbCaches; n++)
+        {
+            CACHE_getStats (caches[n], &cacheStats);
+            total.hits += cacheStats.hits;
+            total.misses += cacheStats.misses;
+            total.evictions += cacheStats.evictions;
+            total.bypasses += cacheStats.bypasses;
+            total.nbEntries += cacheStats.nbEntries;
+            total.capacity += cacheStats.capacity;
+            CACHE_free (caches[n]);
+        }
+        if (nbCaches > 0)
+        {
+            fprintf(stdout, "Placement cache : %.1f %% hits, %llu misses, %llu evictions, %llu bypasses, %u / %u entries\n",
+                    100.0*total.hits/(total.hits + total.misses + 1), (unsigned long long)total.misses,
+                    (unsigned long long)total.evictions, (unsigned long long)total.bypasses,
+                    total.nbEntries, total.capacity);
+        }
+    }
+}
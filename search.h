@@ -0,0 +1,69 @@
+/** search.h and search.cpp look further than the next tetrimino to choose a placement.
+
+    Only the active tetrimino and the next one are known, but the bag (see LNK_drawTetrim) tells which
+    tetriminoes can come after them : the ones still in the bag, or any of the 7 if the bag is empty.
+    The expectimax search averages the value of the playfield over these tetriminoes only, each of them
+    being equally likely, and keeps the best placement of each one (max nodes).
+
+    To stay within a budget, the search goes deeper one unknown tetrimino at a time until the time is over,
+    only expands the best placements of each max node, and stops averaging a chance node as soon as
+    it cannot beat the best placement already found even if its remaining tetriminoes were all good.
+    The branches of the first chance nodes are shared between threads.
+
+    The beam search is the usual baseline : it keeps the best playfields after each known tetrimino.
+**/
+
+#ifndef SEARCH_H_INCLUDED
+#define SEARCH_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "sim.h"
+#include "ai.h"
+#include "placecache.h"
+
+#define SRCH_MAX_DEPTH      4
+#define SRCH_MAX_WIDTH      SIM_MAX_PLACEMENTS
+#define SRCH_MAX_THREADS    64
+
+typedef struct SearchParams SearchParams;
+typedef struct SearchStats SearchStats;
+
+struct SearchParams
+{
+    int maxDepth; /* Number of unknown tetriminoes looked at, from 0 to SRCH_MAX_DEPTH */
+    Uint32 timeBudget; /* Time allowed for a search in microseconds, 0 for no limit */
+    int width; /* Number of placements expanded by a max node, the best ones according to the weights */
+    double pruneMargin; /* The value of a placement is supposed to gain at most pruneMargin when it is searched
+                           deeper : a chance node stops when even that gain on the tetriminoes left could not beat
+                           the best placement. It is a heuristic, not a bound : a placement that would gain more is
+                           cut anyway. A negative margin disables the pruning of the chance nodes */
+    int nbThreads;
+    PlacementCache **caches; /* One placement cache per thread, or NULL to list the placements without cache */
+};
+
+struct SearchStats
+{
+    Uint64 nodes; /* Number of placements evaluated */
+    Uint32 chanceCuts; /* Number of chance nodes not completely averaged */
+    int depth; /* Depth of the last search completed within the time budget */
+    Uint32 time; /* Duration of the search in microseconds */
+};
+
+
+/** Fills the parameters with a depth of 2 and a budget of 20 ms on all the processors, without cache **/
+void SRCH_defaultParams (SearchParams*);
+
+/** Chooses the placement of the active tetrimino of a game with an expectimax search.
+    stats can be NULL. Returns a boolean : 0 if the tetrimino cannot be placed anywhere **/
+Uint8 SRCH_expectimax (const SimGame*, const AI_Weights*, const SearchParams*, Placement*, SearchStats *stats);
+
+/** Chooses the placement of the active tetrimino of a game with a beam search of width playfields
+    over the known tetriminoes. stats can be NULL. Returns a boolean : 0 if the tetrimino cannot be placed anywhere **/
+Uint8 SRCH_beam (const SimGame*, const AI_Weights*, int width, Placement*, SearchStats *stats);
+
+/** Plays nbGames seeded games of at most maxPieces tetriminoes with the beam search and the expectimax search,
+    then prints the score per tetrimino and the speed of each search in the stdout file **/
+void SRCH_benchmark (int nbGames, int maxPieces, Uint32 seed);
+
+#endif // SEARCH_H_INCLUDED
@@ -0,0 +1,617 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <SDL/SDL.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#include "constants.h"
+#include "bitboard.h"
+#include "live.h"
+#include "platform.h"
+#include "server.h"
+
+#define IN_BUFFER_SIZE      (32*sizeof(SRV_Input)) /* Inputs kept for the next tick, the others wait in the socket */
+#define OUT_BUFFER_SIZE     (4*sizeof(SRV_State)) /* States not sent yet because the socket is full */
+#define MAX_EVENTS          256
+#define MAX_ACCEPTS         16 /* Connections accepted by a loop at once, so the other loops get some too */
+#define LISTEN_ID           0xFFFFFFFFu
+#define TIMER_ID            0xFFFFFFFEu
+
+static volatile sig_atomic_t stopRequested = 0;
+
+void SRV_defaultParams (SRV_Params *params)
+{
+    params->unixPath = NULL;
+    params->port = 7777;
+    params->nbLoops = PLT_getNbCores ();
+    params->maxConnections = 10000;
+    params->tick = 16;
+    params->duration = 0;
+}
+
+void SRV_stop ()
+{
+    stopRequested = 1;
+}
+
+void SRV_clearHistogram (SRV_Histogram *histogram)
+{
+    memset (histogram, 0, sizeof(SRV_Histogram));
+}
+
+void SRV_addSample (SRV_Histogram *histogram, Uint32 time)
+{
+    Uint32 bar = time / SRV_HISTOGRAM_STEP;
+
+    histogram->bars[(bar < SRV_HISTOGRAM_SIZE) ? bar : SRV_HISTOGRAM_SIZE-1]++;
+    histogram->nbSamples++;
+    if (time > histogram->max)
+        histogram->max = time;
+}
+
+void SRV_mergeHistogram (SRV_Histogram *total, const SRV_Histogram *histogram)
+{
+    int n;
+
+    for (n = 0; n < SRV_HISTOGRAM_SIZE; n++)
+        total->bars[n] += histogram->bars[n];
+    total->nbSamples += histogram->nbSamples;
+    if (histogram->max > total->max)
+        total->max = histogram->max;
+}
+
+Uint32 SRV_percentile (const SRV_Histogram *histogram, double part)
+{
+    Uint64 rank = (Uint64)(part*histogram->nbSamples), count = 0;
+    Uint32 time;
+    int n;
+
+    for (n = 0; n < SRV_HISTOGRAM_SIZE; n++)
+    {
+        count += histogram->bars[n];
+        if (count > rank)
+            break;
+    }
+
+    /* Upper bound of the bar, the maximum in the last one */
+    time = (n+1)*SRV_HISTOGRAM_STEP;
+    return (n >= SRV_HISTOGRAM_SIZE-1 || time > histogram->max) ? histogram->max : time;
+}
+
+void SRV_printPercentiles (const char *name, const SRV_Histogram *histogram)
+{
+    fprintf(stdout, "%s : 50%% %u us, 90%% %u us, 99%% %u us, 99.9%% %u us, max %u us (%llu samples)\n", name,
+            SRV_percentile (histogram, 0.5), SRV_percentile (histogram, 0.9), SRV_percentile (histogram, 0.99),
+            SRV_percentile (histogram, 0.999), histogram->max, (unsigned long long)histogram->nbSamples);
+}
+
+#ifdef __linux__
+
+typedef struct Connection Connection;
+typedef struct Loop Loop;
+
+struct Connection
+{
+    int fd; /* -1 if the slot is free */
+    int activeIndex; /* Place in the list of the connections of the loop */
+    LiveGame live;
+    Uint8 in[IN_BUFFER_SIZE];
+    Uint32 inLength;
+    Uint8 out[OUT_BUFFER_SIZE];
+    Uint32 outLength;
+    Uint32 echoTime;
+    Uint16 nbEchoed; /* Inputs applied since the last state sent, also counted when a state is dropped */
+    Uint8 moreToRead; /* Boolean : 1 if the inputs did not fit in the buffer */
+};
+
+struct Loop
+{
+    const SRV_Params *params;
+    int listenFd;
+    int epollFd, timerFd;
+
+    /* Connections allocated when the server starts */
+    Connection *connections;
+    int capacity;
+    int *freeSlots, nbFree;
+    int *active, nbActive;
+    Uint32 seed; /* State of the random generator of the games */
+
+    /* Clock */
+    Uint64 startTime; /* Time of the tick 0 in microseconds */
+    Uint32 tick;
+
+    /* Measures */
+    SRV_Histogram lateness, tickWork;
+    Uint64 nbInputs, nbStates, nbDropped;
+    Uint32 nbAccepted, nbRejected, maxActive;
+};
+
+static void closeConnection (Loop *loop, int slot)
+{
+    Connection *connection = &loop->connections[slot];
+    int last;
+
+    if (connection->fd < 0)
+        return;
+    last = loop->active[--loop->nbActive];
+    close (connection->fd); /* Also removes it from the epoll */
+    connection->fd = -1;
+
+    /* The last connection of the list takes its place */
+    loop->active[connection->activeIndex] = last;
+    loop->connections[last].activeIndex = connection->activeIndex;
+    loop->freeSlots[loop->nbFree++] = slot;
+}
+
+static void acceptConnections (Loop *loop)
+{
+    /* Variables */
+    struct epoll_event event;
+    Connection *connection = NULL;
+    int fd, slot, n, one = 1;
+
+    for (n = 0; n < MAX_ACCEPTS; n++)
+    {
+        fd = accept4 (loop->listenFd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0)
+            return;
+        if (loop->nbFree == 0)
+        {
+            loop->nbRejected++;
+            close (fd);
+            continue;
+        }
+        if (loop->params->unixPath == NULL)
+            setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        slot = loop->freeSlots[--loop->nbFree];
+        connection = &loop->connections[slot];
+        connection->fd = fd;
+        connection->inLength = connection->outLength = 0;
+        connection->echoTime = 0;
+        connection->nbEchoed = 0;
+        connection->moreToRead = 0;
+        LIVE_init (&connection->live, BB_random (&loop->seed) | 1);
+
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLRDHUP;
+        event.data.u32 = slot;
+        if (epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            close (fd);
+            connection->fd = -1;
+            loop->freeSlots[loop->nbFree++] = slot;
+            continue;
+        }
+
+        connection->activeIndex = loop->nbActive;
+        loop->active[loop->nbActive++] = slot;
+        if ((Uint32)loop->nbActive > loop->maxActive)
+            loop->maxActive = loop->nbActive;
+        loop->nbAccepted++;
+    }
+}
+
+/* Reads the inputs until the socket or the buffer is empty. Returns a boolean : 0 if the connection is closed */
+static Uint8 readInputs (Loop *loop, int slot)
+{
+    Connection *connection = &loop->connections[slot];
+    ssize_t length;
+
+    connection->moreToRead = 0;
+    while (connection->inLength < IN_BUFFER_SIZE)
+    {
+        length = read (connection->fd, connection->in + connection->inLength, IN_BUFFER_SIZE - connection->inLength);
+        if (length > 0)
+            connection->inLength += length;
+        else if (length < 0 && errno == EINTR)
+            continue;
+        else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        else
+        {
+            closeConnection (loop, slot);
+            return 0;
+        }
+    }
+
+    connection->moreToRead = 1;
+    return 1;
+}
+
+/* Sends the states waiting in the buffer. Returns a boolean : 0 if the connection is closed */
+static Uint8 flush (Loop *loop, int slot)
+{
+    Connection *connection = &loop->connections[slot];
+    ssize_t length;
+
+    while (connection->outLength > 0)
+    {
+        length = send (connection->fd, connection->out, connection->outLength, MSG_NOSIGNAL);
+        if (length > 0)
+        {
+            connection->outLength -= length;
+            memmove (connection->out, connection->out + length, connection->outLength);
+        }
+        else if (length < 0 && errno == EINTR)
+            continue;
+        else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        else
+        {
+            closeConnection (loop, slot);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Writes the state of the game after the buffer. A state that does not fit is dropped,
+   the next one will replace it anyway */
+static Uint8 sendState (Loop *loop, int slot, Uint32 lateness)
+{
+    Connection *connection = &loop->connections[slot];
+    const LiveGame *live = &connection->live;
+    SRV_State state;
+
+    if (connection->outLength + sizeof(SRV_State) > OUT_BUFFER_SIZE)
+    {
+        loop->nbDropped++;
+        return flush (loop, slot);
+    }
+
+    state.tick = loop->tick;
+    state.echoTime = connection->echoTime;
+    state.tickLateness = lateness;
+    state.score = live->game.score;
+    state.level = live->game.level;
+    state.nbCompleteLines = live->game.nbCompleteLines;
+    state.actualTetrim = live->game.actualTetrim;
+    state.nextTetrim = live->game.nextTetrim;
+    state.rotation = live->rotation;
+    state.over = live->game.over;
+    state.x = live->x;
+    state.y = live->y;
+    state.nbEchoed = connection->nbEchoed;
+    memcpy (state.rows, live->game.board.rows, sizeof(state.rows));
+
+    memcpy (connection->out + connection->outLength, &state, sizeof(SRV_State));
+    connection->outLength += sizeof(SRV_State);
+    connection->echoTime = 0;
+    connection->nbEchoed = 0;
+    loop->nbStates++;
+
+    return flush (loop, slot);
+}
+
+/* Applies the inputs, makes the games progress by nbTicks ticks and sends the states */
+static void runTick (Loop *loop, Uint32 nbTicks)
+{
+    /* Variables */
+    Connection *connection = NULL;
+    SRV_Input input;
+    Uint64 now = PLT_getTimeUs (), planned;
+    Uint32 lateness, n, nbInputs;
+    Uint8 changed; /* Boolean */
+    int k, slot;
+
+    loop->tick += nbTicks;
+    planned = loop->startTime + (Uint64)loop->tick*loop->params->tick*1000;
+    lateness = (now > planned) ? (Uint32)(now - planned) : 0;
+    SRV_addSample (&loop->lateness, lateness);
+
+    /* From the end, so a closed connection is replaced by one already done */
+    for (k = loop->nbActive-1; k >= 0; k--)
+    {
+        slot = loop->active[k];
+        connection = &loop->connections[slot];
+        changed = 0;
+
+        nbInputs = connection->inLength / sizeof(SRV_Input);
+        for (n = 0; n < nbInputs; n++)
+        {
+            memcpy (&input, connection->in + n*sizeof(SRV_Input), sizeof(SRV_Input));
+            switch (input.type)
+            {
+                case SRV_INPUT_KEY_DOWN:
+                    changed |= LIVE_keyDown (&connection->live, input.key);
+                    break;
+                case SRV_INPUT_KEY_UP:
+                    changed |= LIVE_keyUp (&connection->live, input.key);
+                    break;
+                case SRV_INPUT_RESTART:
+                    LIVE_init (&connection->live, BB_random (&loop->seed) | 1);
+                    changed = 1;
+                    break;
+            }
+            connection->echoTime = input.clientTime;
+            connection->nbEchoed++;
+        }
+        loop->nbInputs += nbInputs;
+        connection->inLength -= nbInputs*sizeof(SRV_Input);
+        memmove (connection->in, connection->in + nbInputs*sizeof(SRV_Input), connection->inLength);
+        if (connection->moreToRead && !readInputs (loop, slot))
+            continue;
+
+        changed |= LIVE_advance (&connection->live, nbTicks*loop->params->tick);
+        if (changed || connection->nbEchoed != 0)
+            sendState (loop, slot, lateness);
+    }
+
+    SRV_addSample (&loop->tickWork, (Uint32)(PLT_getTimeUs () - now));
+}
+
+static int runLoop (void *data)
+{
+    /* Variables */
+    Loop *loop = (Loop*)data;
+    struct epoll_event events[MAX_EVENTS];
+    Uint64 endTime = 0, expirations;
+    Uint32 id;
+    int nbEvents, n;
+
+    if (loop->params->duration > 0)
+        endTime = PLT_getTimeUs () + (Uint64)loop->params->duration*1000000;
+
+    while (!stopRequested && (endTime == 0 || PLT_getTimeUs () < endTime))
+    {
+        nbEvents = epoll_wait (loop->epollFd, events, MAX_EVENTS, 100);
+        for (n = 0; n < nbEvents; n++)
+        {
+            id = events[n].data.u32;
+            if (id == LISTEN_ID)
+                acceptConnections (loop);
+            else if (id == TIMER_ID)
+            {
+                if (read (loop->timerFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                    runTick (loop, (Uint32)expirations);
+            }
+            else if (loop->connections[id].fd >= 0)
+            {
+                if (events[n].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+                    closeConnection (loop, id);
+                else if (!(events[n].events & EPOLLIN) || readInputs (loop, id))
+                {
+                    if (events[n].events & EPOLLOUT)
+                        flush (loop, id);
+                }
+            }
+        }
+    }
+
+    while (loop->nbActive > 0)
+        closeConnection (loop, loop->active[loop->nbActive-1]);
+
+    return 0;
+}
+
+/* Creates the socket the clients connect to. Returns -1 if it cannot be created */
+static int openListenSocket (const SRV_Params *params)
+{
+    struct sockaddr_in address;
+    struct sockaddr_un unixAddress;
+    int fd, one = 1, ok;
+
+    if (params->unixPath != NULL)
+    {
+        fd = socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        memset (&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        strncpy (unixAddress.sun_path, params->unixPath, sizeof(unixAddress.sun_path)-1);
+        unlink (params->unixPath);
+        ok = (fd >= 0 && bind (fd, (struct sockaddr*)&unixAddress, sizeof(unixAddress)) == 0);
+    }
+    else
+    {
+        fd = socket (AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        memset (&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons (params->port);
+        address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+        ok = (fd >= 0 && setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0
+              && bind (fd, (struct sockaddr*)&address, sizeof(address)) == 0);
+    }
+
+    if (!ok || listen (fd, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, "Impossible to listen to %s : %s\n", (params->unixPath != NULL) ? params->unixPath : "the TCP port",
+                strerror (errno));
+        if (fd >= 0)
+            close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Allocates the connections of a loop and creates its epoll and its timer. Returns a boolean */
+static Uint8 initLoop (Loop *loop, const SRV_Params *params, int listenFd, int index, Uint64 startTime)
+{
+    struct epoll_event event;
+    struct itimerspec period;
+    int n;
+
+    memset (loop, 0, sizeof(Loop));
+    loop->params = params;
+    loop->listenFd = listenFd;
+    loop->capacity = params->maxConnections/params->nbLoops + 1;
+    loop->seed = 2463534242u + index;
+    loop->startTime = startTime;
+    SRV_clearHistogram (&loop->lateness);
+    SRV_clearHistogram (&loop->tickWork);
+
+    loop->connections = (Connection*)malloc(sizeof(Connection)*loop->capacity);
+    loop->freeSlots = (int*)malloc(sizeof(int)*loop->capacity);
+    loop->active = (int*)malloc(sizeof(int)*loop->capacity);
+    loop->epollFd = epoll_create1 (0);
+    loop->timerFd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (loop->connections == NULL || loop->freeSlots == NULL || loop->active == NULL
+        || loop->epollFd < 0 || loop->timerFd < 0)
+    {
+        fprintf(stderr, "An error occurred during the creation of the event loop %d\n", index);
+        return 0;
+    }
+    for (n = 0; n < loop->capacity; n++)
+    {
+        loop->connections[n].fd = -1;
+        loop->freeSlots[n] = loop->capacity-1 - n;
+    }
+    loop->nbFree = loop->capacity;
+
+    /* All the loops wait for the clients, but only one of them is woken up for each client */
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u32 = LISTEN_ID;
+    if (epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0)
+    {
+        fprintf(stderr, "Impossible to wait for the clients in the event loop %d\n", index);
+        return 0;
+    }
+
+    /* The timers of all the loops start at the same time */
+    period.it_interval.tv_sec = params->tick/1000;
+    period.it_interval.tv_nsec = (params->tick%1000)*1000000;
+    period.it_value.tv_sec = (startTime + params->tick*1000)/1000000;
+    period.it_value.tv_nsec = ((startTime + params->tick*1000)%1000000)*1000;
+    event.events = EPOLLIN;
+    event.data.u32 = TIMER_ID;
+    if (timerfd_settime (loop->timerFd, TFD_TIMER_ABSTIME, &period, NULL) != 0
+        || epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, loop->timerFd, &event) != 0)
+    {
+        fprintf(stderr, "Impossible to start the clock of the event loop %d\n", index);
+        return 0;
+    }
+
+    return 1;
+}
+
+static void freeLoop (Loop *loop)
+{
+    if (loop->epollFd > 0)
+        close (loop->epollFd);
+    if (loop->timerFd > 0)
+        close (loop->timerFd);
+    free (loop->connections);
+    free (loop->freeSlots);
+    free (loop->active);
+}
+
+Uint8 SRV_run (const SRV_Params *params)
+{
+    /* Variables */
+    Loop *loops = NULL;
+    SDL_Thread *threads[SRV_MAX_LOOPS];
+    SRV_Histogram *lateness = NULL, *tickWork = NULL;
+    Uint64 startTime, nbInputs = 0, nbStates = 0, nbDropped = 0, nbTicks = 0;
+    Uint32 nbAccepted = 0, nbRejected = 0, maxActive = 0;
+    int listenFd, nbLoops, n;
+    Uint8 ok = 1; /* Boolean */
+
+    nbLoops = (params->nbLoops < 1) ? 1 : (params->nbLoops > SRV_MAX_LOOPS) ? SRV_MAX_LOOPS : params->nbLoops;
+    if (params->tick == 0 || params->maxConnections < 1)
+    {
+        fprintf(stderr, "The tick and the number of connections of the server must be positive\n");
+        return 0;
+    }
+
+    listenFd = openListenSocket (params);
+    if (listenFd < 0)
+        return 0;
+
+    loops = (Loop*)calloc(nbLoops, sizeof(Loop));
+    lateness = (SRV_Histogram*)malloc(sizeof(SRV_Histogram));
+    tickWork = (SRV_Histogram*)malloc(sizeof(SRV_Histogram));
+    if (loops == NULL || lateness == NULL || tickWork == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the server\n");
+        free (loops);
+        free (lateness);
+        free (tickWork);
+        close (listenFd);
+        return 0;
+    }
+
+    /* The loops are ready before the first client comes */
+    BB_getShape (0, 0);
+    stopRequested = 0;
+    startTime = PLT_getTimeUs ();
+    for (n = 0; n < nbLoops && ok; n++)
+        ok = initLoop (&loops[n], params, listenFd, n, startTime);
+
+    if (ok)
+    {
+        if (params->unixPath != NULL)
+            fprintf(stdout, "Server listening to %s", params->unixPath);
+        else
+            fprintf(stdout, "Server listening to 127.0.0.1:%d", params->port);
+        fprintf(stdout, " with %d loops, %d connections at most, a tick of %u ms\n",
+                nbLoops, params->maxConnections, params->tick);
+        fflush (stdout);
+
+        for (n = 1; n < nbLoops; n++)
+            threads[n] = SDL_CreateThread (runLoop, &loops[n]);
+        runLoop (&loops[0]);
+        for (n = 1; n < nbLoops; n++)
+        {
+            if (threads[n] != NULL)
+                SDL_WaitThread (threads[n], NULL);
+        }
+
+        SRV_clearHistogram (lateness);
+        SRV_clearHistogram (tickWork);
+        for (n = 0; n < nbLoops; n++)
+        {
+            SRV_mergeHistogram (lateness, &loops[n].lateness);
+            SRV_mergeHistogram (tickWork, &loops[n].tickWork);
+            nbInputs += loops[n].nbInputs;
+            nbStates += loops[n].nbStates;
+            nbDropped += loops[n].nbDropped;
+            nbTicks += loops[n].tick;
+            nbAccepted += loops[n].nbAccepted;
+            nbRejected += loops[n].nbRejected;
+            maxActive += loops[n].maxActive;
+        }
+
+        fprintf(stdout, "%u connections accepted, %u rejected, %u at most at the same time\n",
+                nbAccepted, nbRejected, maxActive);
+        fprintf(stdout, "%llu ticks, %llu inputs, %llu states sent, %llu states dropped\n",
+                (unsigned long long)nbTicks, (unsigned long long)nbInputs,
+                (unsigned long long)nbStates, (unsigned long long)nbDropped);
+        SRV_printPercentiles ("Tick lateness", lateness);
+        SRV_printPercentiles ("Tick duration", tickWork);
+    }
+
+    for (n = 0; n < nbLoops; n++)
+        freeLoop (&loops[n]);
+    free (loops);
+    free (lateness);
+    free (tickWork);
+    close (listenFd);
+    if (params->unixPath != NULL)
+        unlink (params->unixPath);
+
+    return ok;
+}
+
+#else
+
+Uint8 SRV_run (const SRV_Params*)
+{
+    fprintf(stderr, "The server needs epoll, it only works on Linux\n");
+    return 0;
+}
+
+#endif
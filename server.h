@@ -0,0 +1,102 @@
+/** server.h and server.cpp host many games played in real time by remote clients.
+
+    A client connects with TCP or with a UNIX socket, then sends SRV_Input messages (keys pressed and released).
+    The server is the authority : each game is a LiveGame that progresses on a fixed tick of the server clock.
+    At each tick, the inputs received since the last tick are applied, the games progress by the length
+    of the tick, and the clients whose game has changed receive an SRV_State.
+    A SRV_State answering inputs gives back the time written by the client in the last one and the number of
+    inputs applied since the previous state, so the client can measure the latency of each input (the inputs are
+    applied in the order they are sent), and how late the tick was on the server clock (jitter).
+
+    There is one event loop (epoll) per processor, each one with its own connections, its own clock
+    and its own connection states allocated when the server starts, so the loops never wait for each other.
+    The messages are fixed-size structures : the clients must run on the same kind of machine as the server.
+    The server only works on Linux, SRV_run fails on the other systems.
+**/
+
+#ifndef SERVER_H_INCLUDED
+#define SERVER_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "live.h"
+
+#define SRV_MAX_LOOPS           64
+#define SRV_HISTOGRAM_STEP      10 /* Width of a bar of the histograms in microseconds */
+#define SRV_HISTOGRAM_SIZE      20000 /* 200 ms, the longer times are counted in the last bar */
+
+enum { SRV_INPUT_KEY_DOWN, SRV_INPUT_KEY_UP, SRV_INPUT_RESTART };
+
+typedef struct SRV_Input SRV_Input;
+typedef struct SRV_State SRV_State;
+typedef struct SRV_Params SRV_Params;
+typedef struct SRV_Histogram SRV_Histogram;
+
+struct SRV_Input
+{
+    Uint8 type; /* SRV_INPUT_* */
+    Uint8 key; /* LIVE_KEY_* */
+    Uint16 reserved;
+    Uint32 clientTime; /* Any non-zero value, sent back in the next state */
+};
+
+struct SRV_State
+{
+    Uint32 tick; /* Number of the tick of the loop of the connection */
+    Uint32 echoTime; /* clientTime of the last input applied since the previous state, 0 if there is none */
+    Uint32 tickLateness; /* Delay between the planned time of the tick and the time it started, in microseconds */
+    Uint32 score;
+    Uint16 level;
+    Uint16 nbCompleteLines;
+    Uint8 actualTetrim, nextTetrim, rotation, over;
+    Sint8 x, y; /* Position of block1 of the active tetrimino */
+    Uint16 nbEchoed; /* Inputs applied since the previous state, the last one being echoTime */
+    Uint16 rows[NB_BLOCK_Y]; /* Locked blocks, as in a Bitboard */
+};
+
+struct SRV_Params
+{
+    const char *unixPath; /* Path of the UNIX socket, or NULL to listen to TCP */
+    int port; /* TCP port on the loopback interface */
+    int nbLoops; /* Number of event loops, one per thread */
+    int maxConnections; /* Shared between the loops */
+    Uint32 tick; /* Period of the ticks in milliseconds */
+    Uint32 duration; /* Seconds before the server stops, 0 to wait for SRV_stop */
+};
+
+/* Counts of times, SRV_HISTOGRAM_STEP microseconds per bar */
+struct SRV_Histogram
+{
+    Uint32 bars[SRV_HISTOGRAM_SIZE];
+    Uint64 nbSamples;
+    Uint32 max;
+};
+
+
+/** Fills the parameters with TCP on the port 7777, one loop per processor, 10000 connections and a tick of 16 ms **/
+void SRV_defaultParams (SRV_Params*);
+
+/** Runs the server until the duration is over or SRV_stop is called, then prints its measures in the stdout file.
+    Returns a boolean : 0 if the server could not start **/
+Uint8 SRV_run (const SRV_Params*);
+
+/** Asks the server to stop. Can be called from a signal handler **/
+void SRV_stop ();
+
+/** Empties a histogram **/
+void SRV_clearHistogram (SRV_Histogram*);
+
+/** Adds a time in microseconds to a histogram **/
+void SRV_addSample (SRV_Histogram*, Uint32 time);
+
+/** Adds the samples of a histogram to another one **/
+void SRV_mergeHistogram (SRV_Histogram *total, const SRV_Histogram*);
+
+/** Returns the time under which there is a given part (from 0 to 1) of the samples, in microseconds **/
+Uint32 SRV_percentile (const SRV_Histogram*, double part);
+
+/** Prints the 50th, 90th, 99th and 99.9th percentiles and the maximum of a histogram in the stdout file **/
+void SRV_printPercentiles (const char *name, const SRV_Histogram*);
+
+#endif // SERVER_H_INCLUDED
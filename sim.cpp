@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "sim.h"
+
+/* Makes the next tetrimino the active one, as generateNewTetrim does */
+static void bringNextTetrim (SimGame *game)
+{
+    game->actualTetrim = game->nextTetrim;
+    game->nextTetrim = SIM_drawTetrim (&game->bag, &game->seed);
+
+    if (BB_collides (&game->board, game->actualTetrim, 0, BB_spawnColumn (game->actualTetrim), FIRST_LINE))
+        game->over = 1;
+}
+
+void SIM_init (SimGame *game, Uint32 seed)
+{
+    BB_clear (&game->board);
+    game->seed = (seed != 0) ? seed : 1;
+    game->bag = SIM_FULL_BAG;
+    game->score = 0;
+    game->level = 1;
+    game->nbCompleteLines = 0;
+    game->nbPieces = 0;
+    game->over = 0;
+
+    /* Same order as initGameElements and generateNewTetrim */
+    game->nextTetrim = SIM_drawTetrim (&game->bag, &game->seed);
+    bringNextTetrim (game);
+}
+
+int SIM_drawTetrim (Uint8 *bag, Uint32 *seed)
+{
+    int tetrim, nElmToPick;
+
+    if (*bag == 0)
+        *bag = SIM_FULL_BAG;
+
+    nElmToPick = BB_random (seed) % BB_popcount (*bag);
+    for (tetrim = 0; ; tetrim++)
+    {
+        if ((*bag & (1 << tetrim)) && nElmToPick-- == 0)
+            break;
+    }
+    *bag &= ~(1 << tetrim);
+
+    return tetrim;
+}
+
+int SIM_listPlacements (const Bitboard *board, int tetrim, Placement placements[SIM_MAX_PLACEMENTS])
+{
+    /* Variables */
+    const PieceShape *shape = NULL;
+    Uint16 cells[SIM_MAX_PLACEMENTS][4];
+    int firstLine[SIM_MAX_PLACEMENTS];
+    int nbPlacements = 0;
+    int rotation, x, y, l, k;
+    Uint8 duplicate; /* Boolean */
+
+    for (rotation = 0; rotation < BB_NB_ROTATIONS; rotation++)
+    {
+        shape = BB_getShape (tetrim, rotation);
+        for (x = -shape->left; x + shape->right < NB_BLOCK_X; x++)
+        {
+            y = BB_dropRow (board, tetrim, rotation, x);
+            if (y < 0)
+                continue;
+
+            /* Some rotations give the same blocks at another position of block1 (O, I, S, Z) */
+            for (l = 0; l < 4; l++)
+                cells[nbPlacements][l] = (shape->top+l <= shape->bottom) ? BB_shiftRow (shape->rows[shape->top+l], x) : 0;
+            firstLine[nbPlacements] = y + shape->top;
+            duplicate = 0;
+            for (k = 0; k < nbPlacements && !duplicate; k++)
+            {
+                duplicate = (firstLine[k] == firstLine[nbPlacements]);
+                for (l = 0; l < 4 && duplicate; l++)
+                    duplicate = (cells[k][l] == cells[nbPlacements][l]);
+            }
+            if (duplicate)
+                continue;
+
+            placements[nbPlacements].rotation = rotation;
+            placements[nbPlacements].x = x;
+            placements[nbPlacements].y = y;
+            nbPlacements++;
+        }
+    }
+
+    return nbPlacements;
+}
+
+Uint32 SIM_softDropPoints (int y)
+{
+    return (y > FIRST_LINE) ? (y - FIRST_LINE)*SOFT_DROP_POINTS : 0;
+}
+
+int SIM_play (SimGame *game, const Placement *placement)
+{
+    int nbLines = 0;
+
+    if (game->over)
+        return 0;
+
+    BB_putPiece (&game->board, game->actualTetrim, placement->rotation, placement->x, placement->y);
+    nbLines = BB_clearLines (&game->board);
+    game->nbPieces++;
+
+    game->score = RULE_addPoints (game->score, SIM_softDropPoints (placement->y));
+    game->score = RULE_addPoints (game->score, RULE_linesPoints (nbLines, game->level));
+    game->nbCompleteLines += nbLines;
+    game->level = RULE_nextLevel (game->level, game->nbCompleteLines);
+
+    bringNextTetrim (game);
+
+    return nbLines;
+}
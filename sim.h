@@ -0,0 +1,62 @@
+/** sim.h and sim.cpp simulate a game without any window nor timer.
+
+    The tetriminoes are drawn from a bag of 7 like LNK_drawTetrim does, but with a seeded random
+    generator so the same seed always gives the same game. A tetrimino is played with a Placement :
+    it is turned, moved and dropped straight down from the top of the playfield.
+    The points are counted with the rules of playGame (see rules.h), the tetrimino being dropped
+    with the DOWN key pressed.
+**/
+
+#ifndef SIM_H_INCLUDED
+#define SIM_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+
+#define SIM_MAX_PLACEMENTS      (BB_NB_ROTATIONS*NB_BLOCK_X)
+#define SIM_FULL_BAG            0x7F /* One bit per tetrimino */
+
+typedef struct Placement Placement;
+typedef struct SimGame SimGame;
+
+struct Placement
+{
+    int rotation;
+    int x, y; /* Position of block1 (see game.h) when the tetrimino is locked */
+};
+
+struct SimGame
+{
+    Bitboard board;
+    Uint32 seed; /* State of the random generator */
+    Uint8 bag; /* The bit t is set if the tetrimino t is still in the bag */
+    int actualTetrim;
+    int nextTetrim;
+    Uint32 score;
+    int level;
+    int nbCompleteLines;
+    int nbPieces; /* Number of tetriminoes locked since the beginning */
+    Uint8 over; /* Boolean : 1 if the last tetrimino could not enter the playfield */
+};
+
+
+/** Starts a new game. The seed must not be 0 **/
+void SIM_init (SimGame*, Uint32 seed);
+
+/** Picks a tetrimino from the bag. The bag is filled again when it is empty **/
+int SIM_drawTetrim (Uint8 *bag, Uint32 *seed);
+
+/** Lists all the different places where a tetrimino can be dropped.
+    Returns the number of placements written in the array **/
+int SIM_listPlacements (const Bitboard*, int tetrim, Placement placements[SIM_MAX_PLACEMENTS]);
+
+/** Locks the active tetrimino, updates the score, the level and the number of lines,
+    then brings the next tetrimino. Returns the number of complete lines **/
+int SIM_play (SimGame*, const Placement*);
+
+/** Returns the points earned by dropping a tetrimino from the top to the line y with the DOWN key pressed **/
+Uint32 SIM_softDropPoints (int y);
+
+#endif // SIM_H_INCLUDED
@@ -0,0 +1,531 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "sim.h"
+#include "ai.h"
+#include "live.h"
+#include "platform.h"
+#include "spectate.h"
+
+/* Content of a frame */
+#define FLAG_KEY        0x01 /* Keyframe : everything is written, the score and the lines are not differences */
+#define FLAG_ROWS       0x02
+#define FLAG_POSE       0x04
+#define FLAG_NEXT       0x08
+#define FLAG_SCORE      0x10
+#define FLAG_LEVEL      0x20
+#define FLAG_LINES      0x40
+#define FLAG_OVER       0x80 /* Not a change : set while the game is over */
+
+#define ALL_ROWS        ((1u << NB_BLOCK_Y) - 1)
+
+static int writeVarint (Uint8 *out, Uint32 value)
+{
+    int length = 0;
+
+    while (value >= 0x80)
+    {
+        out[length++] = (Uint8)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (Uint8)value;
+
+    return length;
+}
+
+/* Returns the number of bytes read, 0 if the varint goes beyond length or is too long */
+static int readVarint (const Uint8 *data, int length, Uint32 *value)
+{
+    int n;
+
+    *value = 0;
+    for (n = 0; n < length && n < 5; n++)
+    {
+        *value |= (Uint32)(data[n] & 0x7F) << (7*n);
+        if (!(data[n] & 0x80))
+            return n+1;
+    }
+
+    return 0;
+}
+
+void SPEC_frameFromLive (SPEC_Frame *frame, const LiveGame *live)
+{
+    int i, j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+            frame->cells[j][i] = live->colors[j][i];
+    }
+    frame->active = !live->game.over;
+    frame->tetrim = live->game.actualTetrim;
+    frame->rotation = live->rotation;
+    frame->x = live->x;
+    frame->y = live->y;
+    frame->nextTetrim = live->game.nextTetrim;
+    frame->score = live->game.score;
+    frame->level = live->game.level;
+    frame->nbCompleteLines = live->game.nbCompleteLines;
+    frame->over = live->game.over;
+}
+
+int SPEC_encodeHeader (Uint8 out[SPEC_HEADER_SIZE], Uint16 tickPeriod)
+{
+    memcpy (out, SPEC_MAGIC, 4);
+    out[4] = SPEC_VERSION;
+    out[5] = (Uint8)(tickPeriod & 0xFF);
+    out[6] = (Uint8)(tickPeriod >> 8);
+
+    return SPEC_HEADER_SIZE;
+}
+
+void SPEC_initEncoder (SPEC_Encoder *encoder, FILE *file, Uint16 tickPeriod, Uint32 keyPeriod)
+{
+    Uint8 header[SPEC_HEADER_SIZE];
+
+    memset (encoder, 0, sizeof(SPEC_Encoder));
+    encoder->file = file;
+    encoder->socket = -1;
+    encoder->tickPeriod = tickPeriod;
+    encoder->keyPeriod = (keyPeriod > 0) ? keyPeriod : 1;
+    encoder->nbBytes = SPEC_encodeHeader (header, tickPeriod);
+    if (file != NULL)
+    {
+        fwrite (header, 1, SPEC_HEADER_SIZE, file);
+        fflush (file);
+    }
+}
+
+int SPEC_encodeFrame (SPEC_Encoder *encoder, const SPEC_Frame *frame, Uint8 out[SPEC_MAX_FRAME])
+{
+    /* Variables */
+    const SPEC_Frame *last = &encoder->last;
+    Uint8 payload[SPEC_MAX_FRAME];
+    Uint32 rows = 0;
+    int length = 0, l, k;
+    Uint8 flags = 0, key; /* Booleans */
+
+    encoder->nbTicks++;
+    encoder->ticksSinceKey++;
+    encoder->ticksSinceFrame++;
+
+    /* The differences of the score and of the lines cannot be negative : a new game starts with a keyframe */
+    key = !encoder->started || encoder->ticksSinceKey >= encoder->keyPeriod
+          || frame->score < last->score || frame->nbCompleteLines < last->nbCompleteLines;
+
+    if (key)
+    {
+        flags = FLAG_KEY | FLAG_ROWS | FLAG_POSE | FLAG_NEXT | FLAG_SCORE | FLAG_LEVEL | FLAG_LINES;
+        rows = ALL_ROWS;
+    }
+    else
+    {
+        for (l = 0; l < NB_BLOCK_Y; l++)
+        {
+            if (memcmp (frame->cells[l], last->cells[l], NB_BLOCK_X) != 0)
+                rows |= 1u << l;
+        }
+        if (rows != 0)
+            flags |= FLAG_ROWS;
+        if (frame->active != last->active || (frame->active && (frame->tetrim != last->tetrim
+            || frame->rotation != last->rotation || frame->x != last->x || frame->y != last->y)))
+            flags |= FLAG_POSE;
+        if (frame->nextTetrim != last->nextTetrim)
+            flags |= FLAG_NEXT;
+        if (frame->score != last->score)
+            flags |= FLAG_SCORE;
+        if (frame->level != last->level)
+            flags |= FLAG_LEVEL;
+        if (frame->nbCompleteLines != last->nbCompleteLines)
+            flags |= FLAG_LINES;
+        if (flags == 0 && frame->over == last->over)
+            return 0;
+    }
+    if (frame->over)
+        flags |= FLAG_OVER;
+
+    length += writeVarint (payload + length, encoder->ticksSinceFrame);
+    payload[length++] = flags;
+    if (flags & FLAG_ROWS)
+    {
+        payload[length++] = (Uint8)(rows & 0xFF);
+        payload[length++] = (Uint8)((rows >> 8) & 0xFF);
+        payload[length++] = (Uint8)(rows >> 16);
+        for (l = 0; l < NB_BLOCK_Y; l++)
+        {
+            if (!(rows & (1u << l)))
+                continue;
+            for (k = 0; k < SPEC_ROW_SIZE; k++)
+                payload[length++] = (Uint8)((frame->cells[l][2*k] & 0x0F) | (frame->cells[l][2*k+1] << 4));
+        }
+    }
+    if (flags & FLAG_POSE)
+    {
+        payload[length++] = (Uint8)((frame->active << 7) | ((frame->rotation & 3) << 3) | (frame->tetrim & 7));
+        payload[length++] = (Uint8)(Sint8)frame->x;
+        payload[length++] = (Uint8)(Sint8)frame->y;
+    }
+    if (flags & FLAG_NEXT)
+        payload[length++] = (Uint8)frame->nextTetrim;
+    if (flags & FLAG_SCORE)
+        length += writeVarint (payload + length, key ? frame->score : frame->score - last->score);
+    if (flags & FLAG_LEVEL)
+        length += writeVarint (payload + length, frame->level);
+    if (flags & FLAG_LINES)
+        length += writeVarint (payload + length, key ? frame->nbCompleteLines : frame->nbCompleteLines - last->nbCompleteLines);
+
+    /* The length of the frame comes first */
+    k = writeVarint (out, length);
+    memcpy (out + k, payload, length);
+    length += k;
+
+    encoder->last = *frame;
+    encoder->started = 1;
+    encoder->ticksSinceFrame = 0;
+    if (key)
+    {
+        encoder->ticksSinceKey = 0;
+        encoder->nbKeyframes++;
+    }
+    encoder->nbFrames++;
+    encoder->nbBytes += length;
+
+    return length;
+}
+
+/* Sends as much of the outbox as the socket takes without waiting. Closes the socket if the viewer has left */
+static void flushOutbox (SPEC_Encoder *encoder)
+{
+#ifndef _WIN32
+    int sent;
+
+    while (encoder->socket >= 0 && encoder->outboxLength > 0)
+    {
+        sent = send (encoder->socket, encoder->outbox, encoder->outboxLength, 0);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (sent <= 0)
+        {
+            fprintf(stderr, "The spectator has left, the stream stops\n");
+            close (encoder->socket);
+            encoder->socket = -1;
+            return;
+        }
+
+        encoder->outboxLength -= sent;
+        memmove (encoder->outbox, encoder->outbox + sent, encoder->outboxLength);
+    }
+#endif
+}
+
+void SPEC_emit (SPEC_Encoder *encoder, const SPEC_Frame *frame)
+{
+    Uint8 out[SPEC_MAX_FRAME];
+    Uint32 ticks = encoder->ticksSinceFrame;
+    int length = SPEC_encodeFrame (encoder, frame, out);
+
+    if (length == 0)
+        return;
+
+    /* Flushed at once so the spectators are not late */
+    if (encoder->file != NULL)
+    {
+        fwrite (out, 1, length, encoder->file);
+        fflush (encoder->file);
+    }
+    else if (encoder->socket >= 0)
+    {
+        flushOutbox (encoder);
+        if (encoder->outboxLength + length <= SPEC_OUTBOX_SIZE)
+        {
+            memcpy (encoder->outbox + encoder->outboxLength, out, length);
+            encoder->outboxLength += length;
+            flushOutbox (encoder);
+        }
+        else
+        {
+            /* The differences of the next frame would be from a state the viewer does not have */
+            encoder->ticksSinceFrame = ticks + 1;
+            encoder->started = 0;
+            encoder->nbDropped++;
+        }
+    }
+}
+
+Uint8 SPEC_openStream (SPEC_Encoder *encoder, const char *target, Uint16 tickPeriod)
+{
+    FILE *file = NULL;
+#ifndef _WIN32
+    struct sockaddr_in address;
+    int fd;
+
+    if (strncmp (target, "tcp:", 4) == 0)
+    {
+        fd = socket (AF_INET, SOCK_STREAM, 0);
+        memset (&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons (atoi (target + 4));
+        address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+        /* The socket is made non-blocking once connected : a slow viewer must not stop the game */
+        if (fd < 0 || connect (fd, (struct sockaddr*)&address, sizeof(address)) != 0
+            || fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK) != 0)
+        {
+            fprintf(stderr, "Impossible to open the spectator stream %s\n", target);
+            if (fd >= 0)
+                close (fd);
+            return 0;
+        }
+
+        /* A viewer that leaves must not stop the game */
+        signal (SIGPIPE, SIG_IGN);
+
+        SPEC_initEncoder (encoder, NULL, tickPeriod, SPEC_KEY_PERIOD);
+        encoder->socket = fd;
+        encoder->outboxLength = SPEC_encodeHeader (encoder->outbox, tickPeriod);
+        flushOutbox (encoder);
+
+        return 1;
+    }
+#else
+    if (strncmp (target, "tcp:", 4) == 0)
+    {
+        fprintf(stderr, "The spectator streams over TCP do not work on Windows : %s is not opened\n", target);
+        return 0;
+    }
+#endif
+
+    file = fopen (target, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Impossible to open the spectator stream %s\n", target);
+        return 0;
+    }
+
+    SPEC_initEncoder (encoder, file, tickPeriod, SPEC_KEY_PERIOD);
+
+    return 1;
+}
+
+void SPEC_closeStream (SPEC_Encoder *encoder)
+{
+    double seconds = encoder->nbTicks*encoder->tickPeriod/1000.0;
+
+    if (encoder->file != NULL)
+        fclose (encoder->file);
+    encoder->file = NULL;
+#ifndef _WIN32
+    /* What the viewer has not taken yet is lost */
+    flushOutbox (encoder);
+    if (encoder->socket >= 0)
+        close (encoder->socket);
+    encoder->socket = -1;
+#endif
+
+    fprintf(stdout, "Spectator stream : %u ticks, %u frames (%u keyframes), %llu bytes, %.0f bytes per second, "
+                    "%u frames dropped\n",
+            encoder->nbTicks, encoder->nbFrames, encoder->nbKeyframes, (unsigned long long)encoder->nbBytes,
+            (seconds > 0.0) ? encoder->nbBytes/seconds : 0.0, encoder->nbDropped);
+}
+
+void SPEC_initDecoder (SPEC_Decoder *decoder)
+{
+    memset (decoder, 0, sizeof(SPEC_Decoder));
+}
+
+Uint16 SPEC_decodeHeader (const Uint8 *data, int length)
+{
+    if (length < SPEC_HEADER_SIZE || memcmp (data, SPEC_MAGIC, 4) != 0 || data[4] != SPEC_VERSION)
+        return 0;
+
+    return data[5] | (data[6] << 8);
+}
+
+int SPEC_decodeFrame (SPEC_Decoder *decoder, const Uint8 *data, int length)
+{
+    /* Variables */
+    SPEC_Frame *frame = &decoder->frame;
+    const Uint8 *payload = NULL;
+    Uint32 size, ticks, value, rows = 0;
+    int start, n, read, l, k;
+    Uint8 flags;
+
+    start = readVarint (data, length, &size);
+    if (start == 0)
+        return (length >= 5) ? -1 : 0;
+    if (size == 0 || size > SPEC_MAX_FRAME)
+        return -1;
+    if (start + (int)size > length)
+        return 0;
+    payload = data + start;
+
+    n = readVarint (payload, size, &ticks);
+    if (n == 0 || n >= (int)size)
+        return -1;
+    flags = payload[n++];
+    decoder->tick += ticks;
+
+    /* The differences are useless until the first keyframe */
+    if (!(flags & FLAG_KEY) && !decoder->synced)
+        return start + size;
+
+    if (flags & FLAG_ROWS)
+    {
+        if (n + 3 > (int)size)
+            return -1;
+        rows = payload[n] | (payload[n+1] << 8) | (payload[n+2] << 16);
+        n += 3;
+        for (l = 0; l < NB_BLOCK_Y; l++)
+        {
+            if (!(rows & (1u << l)))
+                continue;
+            if (n + SPEC_ROW_SIZE > (int)size)
+                return -1;
+            for (k = 0; k < SPEC_ROW_SIZE; k++, n++)
+            {
+                frame->cells[l][2*k] = payload[n] & 0x0F;
+                frame->cells[l][2*k+1] = payload[n] >> 4;
+            }
+        }
+    }
+    if (flags & FLAG_POSE)
+    {
+        if (n + 3 > (int)size)
+            return -1;
+        frame->active = payload[n] >> 7;
+        frame->rotation = (payload[n] >> 3) & 3;
+        frame->tetrim = payload[n] & 7;
+        frame->x = (Sint8)payload[n+1];
+        frame->y = (Sint8)payload[n+2];
+        n += 3;
+    }
+    if (flags & FLAG_NEXT)
+    {
+        if (n >= (int)size)
+            return -1;
+        frame->nextTetrim = payload[n++];
+    }
+    if (flags & FLAG_SCORE)
+    {
+        if ((read = readVarint (payload + n, size - n, &value)) == 0)
+            return -1;
+        frame->score = (flags & FLAG_KEY) ? value : frame->score + value;
+        n += read;
+    }
+    if (flags & FLAG_LEVEL)
+    {
+        if ((read = readVarint (payload + n, size - n, &value)) == 0)
+            return -1;
+        frame->level = value;
+        n += read;
+    }
+    if (flags & FLAG_LINES)
+    {
+        if ((read = readVarint (payload + n, size - n, &value)) == 0)
+            return -1;
+        frame->nbCompleteLines = (flags & FLAG_KEY) ? value : frame->nbCompleteLines + value;
+        n += read;
+    }
+    frame->over = (flags & FLAG_OVER) != 0;
+    decoder->synced = 1;
+
+    return start + size;
+}
+
+/* Returns a boolean : 1 if a spectator sees the same thing in both frames */
+static Uint8 sameFrames (const SPEC_Frame *a, const SPEC_Frame *b)
+{
+    return memcmp (a->cells, b->cells, sizeof(a->cells)) == 0 && a->active == b->active
+           && (!a->active || (a->tetrim == b->tetrim && a->rotation == b->rotation && a->x == b->x && a->y == b->y))
+           && a->nextTetrim == b->nextTetrim && a->score == b->score && a->level == b->level
+           && a->nbCompleteLines == b->nbCompleteLines && a->over == b->over;
+}
+
+void SPEC_benchmark (int nbGames, int seconds, Uint32 seed)
+{
+    /* Variables */
+    const Uint32 tickPeriod = 30; /* Refresh period of playGame */
+    LIVE_Pilot pilot;
+    LiveGame live;
+    SPEC_Encoder encoder;
+    SPEC_Decoder decoder;
+    SPEC_Frame frame;
+    Uint8 out[SPEC_MAX_FRAME];
+    Uint64 encodeTime = 0, decodeTime = 0, startTime, nbTicks = 0, nbBytes = 0, nbFrames = 0, nbKeyframes = 0;
+    Uint32 nbMismatches = 0, tick, nbTicksPerGame = seconds*1000/tickPeriod;
+    int length, n;
+    double streamRate, packedRate, gMapRate;
+
+    LIVE_initPilot (&pilot, seed);
+    BB_getShape (0, 0);
+
+    for (n = 0; n < nbGames; n++)
+    {
+        LIVE_init (&live, BB_random (&pilot.seed) | 1);
+        SPEC_initEncoder (&encoder, NULL, tickPeriod, SPEC_KEY_PERIOD);
+        SPEC_initDecoder (&decoder);
+
+        for (tick = 0; tick < nbTicksPerGame; tick++)
+        {
+            LIVE_pilot (&pilot, &live);
+            LIVE_advance (&live, tickPeriod);
+
+            /* Streamed and rebuilt at once */
+            SPEC_frameFromLive (&frame, &live);
+            startTime = PLT_getTimeUs ();
+            length = SPEC_encodeFrame (&encoder, &frame, out);
+            encodeTime += PLT_getTimeUs () - startTime;
+            if (length > 0)
+            {
+                startTime = PLT_getTimeUs ();
+                if (SPEC_decodeFrame (&decoder, out, length) != length)
+                    nbMismatches++;
+                decodeTime += PLT_getTimeUs () - startTime;
+            }
+            if (!sameFrames (&decoder.frame, &frame))
+                nbMismatches++;
+        }
+
+        nbTicks += encoder.nbTicks;
+        nbBytes += encoder.nbBytes;
+        nbFrames += encoder.nbFrames;
+        nbKeyframes += encoder.nbKeyframes;
+    }
+    if (nbTicks == 0)
+        return;
+
+    /* Full snapshots : the packed playfield with the same fields as a keyframe, or gMap as it is */
+    streamRate = nbBytes*1000.0/(nbTicks*tickPeriod);
+    packedRate = (3 + NB_BLOCK_Y*SPEC_ROW_SIZE + 3 + 1 + 4 + 1 + 2)*1000.0/tickPeriod;
+    gMapRate = (sizeof(Uint32)*NB_BLOCK_X*NB_BLOCK_Y + 8*sizeof(int))*1000.0/tickPeriod;
+
+    fprintf(stdout, "Spectator stream : %d games of %d s, a tick every %u ms, a keyframe every %d ticks\n",
+            nbGames, seconds, tickPeriod, SPEC_KEY_PERIOD);
+    fprintf(stdout, "    %llu frames written for %llu ticks (%llu keyframes), %.1f bytes per frame\n",
+            (unsigned long long)nbFrames, (unsigned long long)nbTicks, (unsigned long long)nbKeyframes,
+            nbFrames ? (double)(nbBytes - nbGames*SPEC_HEADER_SIZE)/nbFrames : 0.0);
+    fprintf(stdout, "    Stream           : %8.0f bytes per second per game\n", streamRate);
+    fprintf(stdout, "    Packed snapshots : %8.0f bytes per second per game (%.1f times more)\n", packedRate, packedRate/streamRate);
+    fprintf(stdout, "    gMap snapshots   : %8.0f bytes per second per game (%.1f times more)\n", gMapRate, gMapRate/streamRate);
+    fprintf(stdout, "    Encoding %.2f us, decoding %.2f us per tick, %u ticks not rebuilt exactly\n",
+            (double)encodeTime/nbTicks, (double)decodeTime/nbTicks, nbMismatches);
+}
@@ -0,0 +1,122 @@
+/** spectate.h and spectate.cpp write and read the stream that lets spectators follow a game.
+
+    At each tick (each refresh of the screen in playGame), the state of the game is compared with the one of
+    the previous tick and only the differences are written :
+        - the lines of the playfield whose locked blocks have changed, 4 bits per block (the color of gMap)
+        - the position of the active tetrimino (3 bytes), drawn by the viewer from BB_getShape
+        - the changes of the score and of the number of lines, the level and the next tetrimino
+    A tick without any difference is not written at all. A keyframe containing the whole state is written
+    every keyPeriod ticks, so a viewer can join a stream that has already started.
+
+    Each frame starts with its length, so a viewer can skip the frames it cannot use before the first keyframe.
+    The numbers are written as varints (7 bits per byte, the high bit telling that another byte follows).
+    The stream starts with a header giving the period of the ticks.
+
+    A viewer connected with TCP must never slow the game down : the socket is non-blocking and the frames
+    wait in an outbox of SPEC_OUTBOX_SIZE bytes. A frame that does not fit is dropped, and its ticks are given
+    to the next frame, a keyframe, so the viewer only misses the ticks in between.
+**/
+
+#ifndef SPECTATE_H_INCLUDED
+#define SPECTATE_H_INCLUDED
+
+#include <stdio.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "live.h"
+
+#define SPEC_MAGIC          "TSPC"
+#define SPEC_VERSION        1
+#define SPEC_HEADER_SIZE    7 /* Magic, version and tick period */
+#define SPEC_MAX_FRAME      256 /* A keyframe takes about 130 bytes */
+#define SPEC_ROW_SIZE       (NB_BLOCK_X/2) /* Bytes of a line of the playfield */
+#define SPEC_KEY_PERIOD     100 /* Ticks between two keyframes, 3 seconds in playGame */
+#define SPEC_OUTBOX_SIZE    4096 /* Bytes waiting for a slow viewer, about 30 keyframes */
+
+typedef struct SPEC_Frame SPEC_Frame;
+typedef struct SPEC_Encoder SPEC_Encoder;
+typedef struct SPEC_Decoder SPEC_Decoder;
+
+/* State of the game seen by a spectator */
+struct SPEC_Frame
+{
+    Uint8 cells[NB_BLOCK_Y][NB_BLOCK_X]; /* Color of the locked blocks (BLOCK_* of gMap), BLOCK_VOID elsewhere */
+    Uint8 active; /* Boolean : 1 if there is an active tetrimino */
+    int tetrim, rotation, x, y; /* Active tetrimino and position of block1 */
+    int nextTetrim;
+    Uint32 score;
+    int level;
+    int nbCompleteLines;
+    Uint8 over; /* Boolean */
+};
+
+struct SPEC_Encoder
+{
+    FILE *file; /* Where the frames are written, NULL to only encode them */
+    int socket; /* Non-blocking socket of a viewer instead of the file, -1 if there is none */
+    Uint8 outbox[SPEC_OUTBOX_SIZE]; /* Frames not taken by the socket yet */
+    int outboxLength;
+    SPEC_Frame last; /* State known by the spectators */
+    Uint8 started; /* Boolean : 0 until the first keyframe */
+    Uint32 keyPeriod;
+    Uint32 ticksSinceKey;
+    Uint32 ticksSinceFrame;
+    Uint16 tickPeriod; /* Milliseconds */
+
+    /* Measures */
+    Uint64 nbBytes; /* Header included */
+    Uint32 nbTicks, nbFrames, nbKeyframes;
+    Uint32 nbDropped; /* Frames that did not fit in the outbox */
+};
+
+struct SPEC_Decoder
+{
+    SPEC_Frame frame; /* State rebuilt from the stream */
+    Uint8 synced; /* Boolean : 1 once a keyframe has been read */
+    Uint32 tick; /* Tick of the last frame read */
+};
+
+
+/** Fills a frame with the state of a game played without window. A Bitboard has no colors,
+    so all the locked blocks are BLOCK_YELLOW **/
+void SPEC_frameFromLive (SPEC_Frame*, const LiveGame*);
+
+/** Prepares an encoder. file can be NULL. Writes the header in the file **/
+void SPEC_initEncoder (SPEC_Encoder*, FILE *file, Uint16 tickPeriod, Uint32 keyPeriod);
+
+/** Opens a stream towards a file, or towards a viewer listening to a TCP port of this machine
+    if target is "tcp:port". TCP does not work on Windows, "tcp:port" is refused there.
+    Returns a boolean : 0 if the stream cannot be opened **/
+Uint8 SPEC_openStream (SPEC_Encoder*, const char *target, Uint16 tickPeriod);
+
+/** Closes the stream opened by SPEC_openStream and prints the number of bytes per second and the frames dropped
+    in the stdout file **/
+void SPEC_closeStream (SPEC_Encoder*);
+
+/** Writes the header of a stream. Returns SPEC_HEADER_SIZE **/
+int SPEC_encodeHeader (Uint8 out[SPEC_HEADER_SIZE], Uint16 tickPeriod);
+
+/** Ends a tick : writes the differences between the frame and the previous one in out.
+    Returns the number of bytes written, 0 if nothing has changed **/
+int SPEC_encodeFrame (SPEC_Encoder*, const SPEC_Frame*, Uint8 out[SPEC_MAX_FRAME]);
+
+/** Same as SPEC_encodeFrame, the frame being written in the file or sent to the socket of the encoder,
+    without waiting **/
+void SPEC_emit (SPEC_Encoder*, const SPEC_Frame*);
+
+/** Prepares a decoder **/
+void SPEC_initDecoder (SPEC_Decoder*);
+
+/** Reads the header of a stream. Returns the tick period in milliseconds, 0 if the header is not correct **/
+Uint16 SPEC_decodeHeader (const Uint8 *data, int length);
+
+/** Reads the frame at the beginning of data and updates the state of the decoder.
+    Returns the number of bytes read, 0 if the frame is not complete, -1 if the stream is not correct **/
+int SPEC_decodeFrame (SPEC_Decoder*, const Uint8 *data, int length);
+
+/** Plays nbGames games of seconds seconds with an AI that presses the keys like a player, streams them,
+    checks that the viewer rebuilds every tick, and prints the bytes per second compared to full snapshots **/
+void SPEC_benchmark (int nbGames, int seconds, Uint32 seed);
+
+#endif // SPECTATE_H_INCLUDED
@@ -0,0 +1,763 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "sim.h"
+#include "platform.h"
+#include "tbp.h"
+
+static const char pieceLetters[] = "IOTLJZS"; /* Same order as the TETRIM_* constants */
+static const char *orientations[4] = {"north", "east", "south", "west"};
+static const char *messageTypes[] = {"", "info", "ready", "error", "suggestion",
+                                     "rules", "start", "stop", "suggest", "play", "new_piece", "quit"};
+
+/* Position of the center of the tetrimino in its square, for each orientation (column, line from the top) */
+static const int centerI[4][2] = {{1, 1}, {2, 1}, {2, 2}, {1, 2}};
+static const int centerO[4][2] = {{0, 1}, {0, 0}, {1, 0}, {1, 1}};
+static const int center3[2] = {1, 1};
+
+
+/*******************/
+/** Conversions   **/
+/*******************/
+
+static void getCenter (int tetrim, int orientation, int *column, int *line)
+{
+    if (tetrim == TETRIM_I)
+    {
+        *column = centerI[orientation & 3][0];
+        *line = centerI[orientation & 3][1];
+    }
+    else if (tetrim == TETRIM_O)
+    {
+        *column = centerO[orientation & 3][0];
+        *line = centerO[orientation & 3][1];
+    }
+    else
+    {
+        *column = center3[0];
+        *line = center3[1];
+    }
+}
+
+void TBP_toLocation (int tetrim, const Placement *placement, int *orientation, int *x, int *y)
+{
+    int column, line;
+
+    getCenter (tetrim, placement->rotation, &column, &line);
+    *orientation = placement->rotation & 3;
+    *x = placement->x + column;
+    *y = NB_BLOCK_Y-1 - (placement->y + line);
+}
+
+void TBP_fromLocation (int tetrim, int orientation, int x, int y, Placement *placement)
+{
+    int column, line;
+
+    getCenter (tetrim, orientation, &column, &line);
+    placement->rotation = orientation & 3;
+    placement->x = x - column;
+    placement->y = NB_BLOCK_Y-1 - y - line;
+}
+
+void TBP_cellsFromGameMap (char cells[NB_BLOCK_Y][NB_BLOCK_X], Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y])
+{
+    int i, j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            /* Colors given by locksTetrim */
+            switch (gMap[i][j])
+            {
+                case BLOCK_CYAN:
+                    cells[j][i] = 'I';
+                    break;
+                case BLOCK_YELLOW:
+                    cells[j][i] = 'O';
+                    break;
+                case BLOCK_PURPLE:
+                    cells[j][i] = 'T';
+                    break;
+                case BLOCK_ORANGE:
+                    cells[j][i] = 'L';
+                    break;
+                case BLOCK_BLUE:
+                    cells[j][i] = 'J';
+                    break;
+                case BLOCK_RED:
+                    cells[j][i] = 'Z';
+                    break;
+                case BLOCK_GREEN:
+                    cells[j][i] = 'S';
+                    break;
+                default:
+                    cells[j][i] = 0;
+                    break;
+            }
+        }
+    }
+}
+
+void TBP_cellsFromBitboard (char cells[NB_BLOCK_Y][NB_BLOCK_X], const Bitboard *board)
+{
+    int i, j;
+
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+            cells[j][i] = (board->rows[j] & (1 << i)) ? 'G' : 0;
+    }
+}
+
+
+/*******************/
+/** Encoding      **/
+/*******************/
+
+static void append (TBP_Buffer *buffer, const char *text)
+{
+    while (*text != '\0' && buffer->length < TBP_MAX_MESSAGE-2)
+        buffer->data[buffer->length++] = *text++;
+}
+
+static void appendChar (TBP_Buffer *buffer, char c)
+{
+    if (buffer->length < TBP_MAX_MESSAGE-2)
+        buffer->data[buffer->length++] = c;
+}
+
+static void appendInt (TBP_Buffer *buffer, int value)
+{
+    char digits[12];
+    int n = 0;
+    unsigned int u = (value < 0) ? -(unsigned int)value : (unsigned int)value;
+
+    if (value < 0)
+        appendChar (buffer, '-');
+    do
+    {
+        digits[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    while (n > 0)
+        appendChar (buffer, digits[--n]);
+}
+
+static void appendPiece (TBP_Buffer *buffer, int tetrim)
+{
+    appendChar (buffer, '"');
+    appendChar (buffer, pieceLetters[tetrim]);
+    appendChar (buffer, '"');
+}
+
+static void appendMove (TBP_Buffer *buffer, int tetrim, const Placement *placement)
+{
+    int orientation, x, y;
+
+    TBP_toLocation (tetrim, placement, &orientation, &x, &y);
+    append (buffer, "{\"location\":{\"type\":");
+    appendPiece (buffer, tetrim);
+    append (buffer, ",\"orientation\":\"");
+    append (buffer, orientations[orientation]);
+    append (buffer, "\",\"x\":");
+    appendInt (buffer, x);
+    append (buffer, ",\"y\":");
+    appendInt (buffer, y);
+    append (buffer, "},\"spin\":\"none\"}");
+}
+
+static void beginMessage (TBP_Buffer *buffer, const char *type)
+{
+    buffer->length = 0;
+    append (buffer, "{\"type\":\"");
+    append (buffer, type);
+    appendChar (buffer, '"');
+}
+
+static void endMessage (TBP_Buffer *buffer)
+{
+    buffer->data[buffer->length++] = '}';
+    buffer->data[buffer->length++] = '\n';
+    buffer->data[buffer->length] = '\0';
+}
+
+void TBP_encodeInfo (TBP_Buffer *buffer, const char *name)
+{
+    beginMessage (buffer, "info");
+    append (buffer, ",\"name\":\"");
+    append (buffer, name);
+    append (buffer, "\",\"version\":\"1.0\",\"author\":\"Urban Tetrims\",\"features\":[]");
+    endMessage (buffer);
+}
+
+void TBP_encodeReady (TBP_Buffer *buffer)
+{
+    beginMessage (buffer, "ready");
+    endMessage (buffer);
+}
+
+void TBP_encodeRules (TBP_Buffer *buffer)
+{
+    beginMessage (buffer, "rules");
+    append (buffer, ",\"randomizer\":\"seven_bag\"");
+    endMessage (buffer);
+}
+
+void TBP_encodeStart (TBP_Buffer *buffer, const char cells[NB_BLOCK_Y][NB_BLOCK_X], const int *queue, int nbQueue, Uint8 bag)
+{
+    int i, y, n;
+
+    beginMessage (buffer, "start");
+    append (buffer, ",\"hold\":null,\"queue\":[");
+    for (n = 0; n < nbQueue; n++)
+    {
+        if (n > 0)
+            appendChar (buffer, ',');
+        appendPiece (buffer, queue[n]);
+    }
+    append (buffer, "],\"combo\":0,\"back_to_back\":false,\"board\":[");
+
+    /* The first line of the protocol is the bottom of the playfield */
+    for (y = 0; y < TBP_NB_ROWS; y++)
+    {
+        append (buffer, (y > 0) ? ",[" : "[");
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            if (i > 0)
+                appendChar (buffer, ',');
+            if (y < NB_BLOCK_Y && cells[NB_BLOCK_Y-1-y][i] != 0)
+            {
+                appendChar (buffer, '"');
+                appendChar (buffer, cells[NB_BLOCK_Y-1-y][i]);
+                appendChar (buffer, '"');
+            }
+            else
+                append (buffer, "null");
+        }
+        appendChar (buffer, ']');
+    }
+
+    append (buffer, "],\"randomizer\":{\"type\":\"seven_bag\",\"bag_state\":[");
+    if (bag == 0)
+        bag = SIM_FULL_BAG;
+    for (n = 0, i = 0; n < 7; n++)
+    {
+        if (bag & (1 << n))
+        {
+            if (i++ > 0)
+                appendChar (buffer, ',');
+            appendPiece (buffer, n);
+        }
+    }
+    append (buffer, "]}");
+    endMessage (buffer);
+}
+
+void TBP_encodeSuggest (TBP_Buffer *buffer)
+{
+    beginMessage (buffer, "suggest");
+    endMessage (buffer);
+}
+
+void TBP_encodeSuggestion (TBP_Buffer *buffer, int tetrim, const Placement *moves, int nbMoves)
+{
+    int n;
+
+    beginMessage (buffer, "suggestion");
+    append (buffer, ",\"moves\":[");
+    for (n = 0; n < nbMoves; n++)
+    {
+        if (n > 0)
+            appendChar (buffer, ',');
+        appendMove (buffer, tetrim, &moves[n]);
+    }
+    appendChar (buffer, ']');
+    endMessage (buffer);
+}
+
+void TBP_encodePlay (TBP_Buffer *buffer, int tetrim, const Placement *placement)
+{
+    beginMessage (buffer, "play");
+    append (buffer, ",\"move\":");
+    appendMove (buffer, tetrim, placement);
+    endMessage (buffer);
+}
+
+void TBP_encodeNewPiece (TBP_Buffer *buffer, int tetrim)
+{
+    beginMessage (buffer, "new_piece");
+    append (buffer, ",\"piece\":");
+    appendPiece (buffer, tetrim);
+    endMessage (buffer);
+}
+
+void TBP_encodeStop (TBP_Buffer *buffer)
+{
+    beginMessage (buffer, "stop");
+    endMessage (buffer);
+}
+
+void TBP_encodeQuit (TBP_Buffer *buffer)
+{
+    beginMessage (buffer, "quit");
+    endMessage (buffer);
+}
+
+
+/*******************/
+/** Decoding      **/
+/*******************/
+
+/* The messages are read in place : the functions below walk through the JSON text
+   and return a pointer on the value that is looked for, NULL if there is none */
+
+static const char* skipSpaces (const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+        p++;
+    return p;
+}
+
+/* Returns the end of the value that starts at p */
+static const char* skipValue (const char *p)
+{
+    int depth = 0;
+
+    if (*p != '"' && *p != '{' && *p != '[')
+    {
+        while (*p != '\0' && *p != ',' && *p != '}' && *p != ']')
+            p++;
+        return p;
+    }
+
+    do
+    {
+        if (*p == '"')
+        {
+            for (p++; *p != '\0' && *p != '"'; p++)
+            {
+                if (*p == '\\' && p[1] != '\0')
+                    p++;
+            }
+        }
+        else if (*p == '{' || *p == '[')
+            depth++;
+        else if (*p == '}' || *p == ']')
+            depth--;
+        if (*p != '\0')
+            p++;
+    } while (depth > 0 && *p != '\0');
+
+    return p;
+}
+
+/* Returns the value of a member of the object that starts at p */
+static const char* findMember (const char *p, const char *key)
+{
+    const char *name = NULL;
+    size_t length = strlen (key);
+
+    if (p == NULL)
+        return NULL;
+    p = skipSpaces (p);
+    if (*p != '{')
+        return NULL;
+    p = skipSpaces (p+1);
+
+    while (*p == '"')
+    {
+        name = p+1;
+        p = skipSpaces (skipValue (p));
+        if (*p != ':')
+            return NULL;
+        if ((size_t)(p - name) >= length+1 && strncmp (name, key, length) == 0 && name[length] == '"')
+            return skipSpaces (p+1);
+
+        p = skipSpaces (skipValue (skipSpaces (p+1)));
+        if (*p != ',')
+            return NULL;
+        p = skipSpaces (p+1);
+    }
+
+    return NULL;
+}
+
+/* Returns the element that follows the one that starts at p in an array */
+static const char* nextElement (const char *p)
+{
+    if (p == NULL)
+        return NULL;
+    p = skipSpaces (skipValue (p));
+
+    return (*p == ',') ? skipSpaces (p+1) : NULL;
+}
+
+/* Returns the nth element of the array that starts at p */
+static const char* findElement (const char *p, int n)
+{
+    if (p == NULL)
+        return NULL;
+    p = skipSpaces (p);
+    if (*p != '[')
+        return NULL;
+    p = skipSpaces (p+1);
+    if (*p == ']')
+        return NULL;
+
+    for (; n > 0 && p != NULL; n--)
+        p = nextElement (p);
+
+    return p;
+}
+
+/* Returns the tetrimino of a value like "T", -1 if it is not a tetrimino */
+static int readPiece (const char *p)
+{
+    const char *letter = NULL;
+
+    if (p == NULL || p[0] != '"' || p[1] == '\0' || p[2] != '"')
+        return -1;
+    letter = strchr (pieceLetters, p[1]);
+
+    return (letter != NULL) ? (int)(letter - pieceLetters) : -1;
+}
+
+static Uint8 stringEquals (const char *p, const char *text)
+{
+    size_t length = strlen (text);
+
+    return p != NULL && *p == '"' && strncmp (p+1, text, length) == 0 && p[length+1] == '"';
+}
+
+int TBP_messageType (const char *message)
+{
+    const char *type = findMember (message, "type");
+    int n;
+
+    for (n = TBP_MSG_INFO; n <= TBP_MSG_QUIT; n++)
+    {
+        if (stringEquals (type, messageTypes[n]))
+            return n;
+    }
+
+    return TBP_MSG_UNKNOWN;
+}
+
+Uint8 TBP_decodeMove (const char *message, int n, int *tetrim, Placement *placement)
+{
+    const char *move = NULL, *location = NULL, *x = NULL, *y = NULL, *orientation = NULL;
+    int k;
+
+    if (TBP_messageType (message) == TBP_MSG_PLAY)
+        move = (n == 0) ? findMember (message, "move") : NULL;
+    else
+        move = findElement (findMember (message, "moves"), n);
+    if (move == NULL || (location = findMember (move, "location")) == NULL)
+        return 0;
+
+    *tetrim = readPiece (findMember (location, "type"));
+    orientation = findMember (location, "orientation");
+    x = findMember (location, "x");
+    y = findMember (location, "y");
+    if (*tetrim < 0 || orientation == NULL || x == NULL || y == NULL)
+        return 0;
+
+    for (k = 0; k < 4 && !stringEquals (orientation, orientations[k]); k++);
+    if (k == 4)
+        return 0;
+
+    TBP_fromLocation (*tetrim, k, atoi (x), atoi (y), placement);
+
+    return 1;
+}
+
+Uint8 TBP_decodeStart (const char *message, Bitboard *board, int queue[TBP_MAX_QUEUE], int *nbQueue)
+{
+    const char *row = NULL, *cell = NULL, *piece = NULL;
+    int i, y;
+
+    /* The lines of the protocol above the playfield are ignored */
+    BB_clear (board);
+    row = findElement (findMember (message, "board"), 0);
+    for (y = 0; y < NB_BLOCK_Y; y++, row = nextElement (row))
+    {
+        cell = findElement (row, 0);
+        for (i = 0; i < NB_BLOCK_X; i++, cell = nextElement (cell))
+        {
+            if (cell == NULL)
+                return 0;
+            if (*cell == '"')
+                board->rows[NB_BLOCK_Y-1-y] |= 1 << i;
+        }
+    }
+
+    piece = findMember (message, "queue");
+    for (*nbQueue = 0; *nbQueue < TBP_MAX_QUEUE; (*nbQueue)++)
+    {
+        queue[*nbQueue] = readPiece (findElement (piece, *nbQueue));
+        if (queue[*nbQueue] < 0)
+            break;
+    }
+
+    return 1;
+}
+
+int TBP_decodeNewPiece (const char *message)
+{
+    return readPiece (findMember (message, "piece"));
+}
+
+
+/*******************/
+/** Session       **/
+/*******************/
+
+static void sendMessage (TBP_Session *session)
+{
+    fwrite (session->buffer.data, 1, session->buffer.length, session->out);
+    fflush (session->out);
+    session->nbSent++;
+    session->bytesSent += session->buffer.length;
+}
+
+/* Reads the next message of the bot. Returns its type, -1 if the bot has closed the connection */
+static int receiveMessage (TBP_Session *session)
+{
+    Uint64 startTime = PLT_getTimeUs ();
+    size_t length;
+    int c;
+
+    do
+    {
+        if (fgets (session->line, TBP_MAX_MESSAGE, session->in) == NULL)
+            return -1;
+        length = strlen (session->line);
+
+        /* A message too long is ignored */
+        if (length > 0 && session->line[length-1] != '\n' && !feof (session->in))
+        {
+            while ((c = fgetc (session->in)) != EOF && c != '\n');
+            session->line[0] = '\0';
+        }
+    } while (*skipSpaces (session->line) != '{');
+
+    session->waitingTime += PLT_getTimeUs () - startTime;
+    session->nbReceived++;
+    session->bytesReceived += length;
+
+    return TBP_messageType (session->line);
+}
+
+Uint8 TBP_openSession (TBP_Session *session, FILE *in, FILE *out)
+{
+    const char *name = NULL;
+    int type, n;
+
+    session->in = in;
+    session->out = out;
+    session->started = 0;
+    session->nbSent = session->nbReceived = 0;
+    session->bytesSent = session->bytesReceived = 0;
+    session->encodingTime = session->waitingTime = 0;
+    strcpy (session->botName, "unknown");
+
+    /* The bot introduces itself first */
+    type = receiveMessage (session);
+    if (type != TBP_MSG_INFO)
+    {
+        fprintf(stderr, "The bot did not send its info\n");
+        return 0;
+    }
+    name = findMember (session->line, "name");
+    if (name != NULL && *name == '"')
+    {
+        for (n = 0; n < 63 && name[n+1] != '"' && name[n+1] != '\0'; n++)
+            session->botName[n] = name[n+1];
+        session->botName[n] = '\0';
+    }
+
+    TBP_encodeRules (&session->buffer);
+    sendMessage (session);
+
+    type = receiveMessage (session);
+    if (type != TBP_MSG_READY)
+    {
+        fprintf(stderr, "The bot %s is not ready\n", session->botName);
+        return 0;
+    }
+
+    return 1;
+}
+
+Uint8 TBP_requestPlacement (TBP_Session *session, const Bitboard *board, const char cells[NB_BLOCK_Y][NB_BLOCK_X],
+                            int actualTetrim, int nextTetrim, Uint8 bag, Placement *placement)
+{
+    /* Variables */
+    char boardCells[NB_BLOCK_Y][NB_BLOCK_X];
+    int queue[2] = {actualTetrim, nextTetrim};
+    Uint64 startTime = PLT_getTimeUs ();
+    int tetrim, n;
+
+    /* The whole playfield is only sent at the beginning, then the bot follows the game with "play" */
+    if (!session->started)
+    {
+        if (cells == NULL)
+        {
+            TBP_cellsFromBitboard (boardCells, board);
+            cells = boardCells;
+        }
+        TBP_encodeStart (&session->buffer, cells, queue, 2, bag);
+        session->started = 1;
+    }
+    else
+        TBP_encodeNewPiece (&session->buffer, nextTetrim);
+    sendMessage (session);
+    TBP_encodeSuggest (&session->buffer);
+    sendMessage (session);
+    session->encodingTime += PLT_getTimeUs () - startTime;
+
+    if (receiveMessage (session) != TBP_MSG_SUGGESTION)
+    {
+        fprintf(stderr, "The bot %s did not send a suggestion\n", session->botName);
+        return 0;
+    }
+
+    /* The first move that can be done by dropping the tetrimino straight down is played */
+    startTime = PLT_getTimeUs ();
+    for (n = 0; TBP_decodeMove (session->line, n, &tetrim, placement); n++)
+    {
+        if (tetrim == actualTetrim && placement->x >= -4 && placement->x <= NB_BLOCK_X
+            && placement->y == BB_dropRow (board, tetrim, placement->rotation, placement->x))
+        {
+            session->encodingTime += PLT_getTimeUs () - startTime;
+            return 1;
+        }
+    }
+    session->encodingTime += PLT_getTimeUs () - startTime;
+
+    fprintf(stderr, "No move suggested by the bot %s can be played\n", session->botName);
+    return 0;
+}
+
+void TBP_reportPlacement (TBP_Session *session, int tetrim, const Placement *placement)
+{
+    Uint64 startTime = PLT_getTimeUs ();
+
+    TBP_encodePlay (&session->buffer, tetrim, placement);
+    sendMessage (session);
+    session->encodingTime += PLT_getTimeUs () - startTime;
+}
+
+void TBP_stopGame (TBP_Session *session)
+{
+    if (!session->started)
+        return;
+
+    TBP_encodeStop (&session->buffer);
+    sendMessage (session);
+    session->started = 0;
+}
+
+void TBP_closeSession (TBP_Session *session)
+{
+    TBP_stopGame (session);
+    TBP_encodeQuit (&session->buffer);
+    sendMessage (session);
+}
+
+Uint32 TBP_playGame (TBP_Session *session, Uint32 seed, int maxPieces, int *nbPieces)
+{
+    SimGame game;
+    Placement placement;
+
+    SIM_init (&game, seed);
+    while (!game.over && (maxPieces <= 0 || game.nbPieces < maxPieces))
+    {
+        if (!TBP_requestPlacement (session, &game.board, NULL, game.actualTetrim, game.nextTetrim,
+                                   game.bag, &placement))
+            break;
+        TBP_reportPlacement (session, game.actualTetrim, &placement);
+        SIM_play (&game, &placement);
+    }
+    TBP_stopGame (session);
+
+    if (nbPieces != NULL)
+        *nbPieces = game.nbPieces;
+
+    return game.score;
+}
+
+void TBP_benchmark (int nbMessages)
+{
+    /* Variables */
+    static TBP_Buffer buffer; /* Too big for the stack of some systems */
+    char cells[NB_BLOCK_Y][NB_BLOCK_X];
+    Placement placements[SIM_MAX_PLACEMENTS], placement;
+    SimGame game;
+    Bitboard board;
+    int queue[TBP_MAX_QUEUE], nbQueue, nbPlacements, tetrim, n, k;
+    Uint64 startTime, time, bytes;
+    Uint32 check = 0;
+
+    if (nbMessages <= 0)
+        return;
+
+    /* A playfield in the middle of a game */
+    SIM_init (&game, 2463534242u);
+    for (n = 0; n < 30 && !game.over; n++)
+    {
+        SIM_listPlacements (&game.board, game.actualTetrim, placements);
+        SIM_play (&game, &placements[n % 3]);
+    }
+    TBP_cellsFromBitboard (cells, &game.board);
+    queue[0] = game.actualTetrim;
+    queue[1] = game.nextTetrim;
+    nbPlacements = SIM_listPlacements (&game.board, game.actualTetrim, placements);
+
+    fprintf(stdout, "TBP benchmark : %d messages of each kind\n", nbMessages);
+    for (k = 0; k < 6; k++)
+    {
+        bytes = 0;
+        startTime = PLT_getTimeUs ();
+        for (n = 0; n < nbMessages; n++)
+        {
+            switch (k)
+            {
+                case 0:
+                    TBP_encodeStart (&buffer, cells, queue, 2, game.bag);
+                    break;
+                case 1:
+                    check += TBP_decodeStart (buffer.data, &board, queue, &nbQueue);
+                    break;
+                case 2:
+                    TBP_encodeSuggestion (&buffer, game.actualTetrim, placements, (nbPlacements < 5) ? nbPlacements : 5);
+                    break;
+                case 3:
+                    check += TBP_decodeMove (buffer.data, n % 5, &tetrim, &placement);
+                    break;
+                case 4:
+                    TBP_encodePlay (&buffer, game.actualTetrim, &placements[n % nbPlacements]);
+                    break;
+                case 5:
+                    check += TBP_decodeMove (buffer.data, 0, &tetrim, &placement) + TBP_messageType (buffer.data);
+                    break;
+            }
+            bytes += buffer.length;
+        }
+        time = PLT_getTimeUs () - startTime;
+
+        fprintf(stdout, "%-32s : %8.0f ns per message, %5d bytes\n",
+                (k == 0) ? "Encode start" : (k == 1) ? "Decode start" : (k == 2) ? "Encode suggestion (5 moves)" :
+                (k == 3) ? "Decode a move of a suggestion" : (k == 4) ? "Encode play" : "Decode play",
+                time*1000.0/nbMessages, (int)(bytes/nbMessages));
+    }
+
+    if (check == 0 || memcmp (&board, &game.board, sizeof(Bitboard)) != 0)
+        fprintf(stdout, "Warning : the decoded messages do not match the encoded ones\n");
+}
@@ -0,0 +1,123 @@
+/** tbp.h and tbp.cpp let an external bot play the game with the Tetris Bot Protocol (TBP).
+
+    Each message is a JSON object on one line. The game (front-end) sends "rules", "start", "suggest",
+    "play", "new_piece", "stop" and "quit"; the bot answers "info", "ready", "suggestion" or "error".
+    A piece location is the center of the tetrimino in the SRS sense, with y going up from the bottom line
+    and an orientation among "north", "east", "south" and "west" (the rotation states of tetrimRotates).
+
+    Differences with the other TBP front-ends :
+        - there is no hold, so "hold" is always null and the queue is the active and the next tetriminoes
+        - the tetriminoes are dropped straight down from the top of the playfield, so the first move of
+          a suggestion that can be dropped this way is played
+        - the bag is given with the randomizer extension ("seven_bag" and the tetriminoes left in the bag)
+
+    The messages are written in a fixed buffer and read in a fixed line, with no allocation at all,
+    because bots are pitted against each other at thousands of moves per second.
+**/
+
+#ifndef TBP_H_INCLUDED
+#define TBP_H_INCLUDED
+
+#include <stdio.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+#include "sim.h"
+
+#define TBP_MAX_MESSAGE     16384 /* A "start" message takes about 2.5 kB, the moves of a suggestion 100 B each */
+#define TBP_NB_ROWS         40 /* Lines of the board in the protocol, from the bottom */
+#define TBP_MAX_QUEUE       16
+
+enum {  TBP_MSG_UNKNOWN, TBP_MSG_INFO, TBP_MSG_READY, TBP_MSG_ERROR, TBP_MSG_SUGGESTION,
+        TBP_MSG_RULES, TBP_MSG_START, TBP_MSG_STOP, TBP_MSG_SUGGEST, TBP_MSG_PLAY, TBP_MSG_NEW_PIECE, TBP_MSG_QUIT };
+
+typedef struct TBP_Buffer TBP_Buffer;
+typedef struct TBP_Session TBP_Session;
+
+struct TBP_Buffer
+{
+    char data[TBP_MAX_MESSAGE];
+    int length;
+};
+
+/* The front-end side of a connection with a bot */
+struct TBP_Session
+{
+    FILE *in, *out;
+    char line[TBP_MAX_MESSAGE]; /* Last message received */
+    TBP_Buffer buffer; /* Message being sent */
+    char botName[64];
+    Uint8 started; /* Boolean : 1 if the bot knows the playfield */
+
+    /* Measures */
+    Uint32 nbSent, nbReceived;
+    Uint64 bytesSent, bytesReceived;
+    Uint64 encodingTime; /* Time spent to build the messages and to read the answers, in microseconds */
+    Uint64 waitingTime; /* Time spent waiting for the suggestions, in microseconds */
+};
+
+
+/** Converts a placement to a location of the protocol **/
+void TBP_toLocation (int tetrim, const Placement*, int *orientation, int *x, int *y);
+
+/** Converts a location of the protocol to a placement **/
+void TBP_fromLocation (int tetrim, int orientation, int x, int y, Placement*);
+
+/** Fills cells with the letter of the tetrimino of each locked block of a gMap, 0 for the empty cells **/
+void TBP_cellsFromGameMap (char cells[NB_BLOCK_Y][NB_BLOCK_X], Uint32 gMap[NB_BLOCK_X][NB_BLOCK_Y]);
+
+/** Fills cells with 'G' (garbage) for each block of a bitboard, 0 for the empty cells **/
+void TBP_cellsFromBitboard (char cells[NB_BLOCK_Y][NB_BLOCK_X], const Bitboard*);
+
+/** Writes a message in a buffer. The message ends with a new line **/
+void TBP_encodeInfo (TBP_Buffer*, const char *name);
+void TBP_encodeReady (TBP_Buffer*);
+void TBP_encodeRules (TBP_Buffer*);
+void TBP_encodeStart (TBP_Buffer*, const char cells[NB_BLOCK_Y][NB_BLOCK_X], const int *queue, int nbQueue, Uint8 bag);
+void TBP_encodeSuggest (TBP_Buffer*);
+void TBP_encodeSuggestion (TBP_Buffer*, int tetrim, const Placement *moves, int nbMoves);
+void TBP_encodePlay (TBP_Buffer*, int tetrim, const Placement*);
+void TBP_encodeNewPiece (TBP_Buffer*, int tetrim);
+void TBP_encodeStop (TBP_Buffer*);
+void TBP_encodeQuit (TBP_Buffer*);
+
+/** Returns the type of a message (TBP_MSG_*) **/
+int TBP_messageType (const char *message);
+
+/** Reads the nth move of a "suggestion" or the move of a "play".
+    Returns a boolean : 0 if there is no such move **/
+Uint8 TBP_decodeMove (const char *message, int n, int *tetrim, Placement*);
+
+/** Reads the playfield and the queue of a "start". Returns a boolean : 0 if the message is not correct **/
+Uint8 TBP_decodeStart (const char *message, Bitboard*, int queue[TBP_MAX_QUEUE], int *nbQueue);
+
+/** Reads the tetrimino of a "new_piece". Returns -1 if the message is not correct **/
+int TBP_decodeNewPiece (const char *message);
+
+/** Reads the "info" of the bot, sends the rules and waits for the bot to be ready.
+    Returns a boolean : 0 if the bot does not answer correctly **/
+Uint8 TBP_openSession (TBP_Session*, FILE *in, FILE *out);
+
+/** Asks the bot where to drop the active tetrimino. The playfield is sent with "start" the first time,
+    then only the new tetrimino of the queue is sent.
+    cells can be NULL (see TBP_cellsFromBitboard). Returns a boolean : 0 if no move of the bot can be played **/
+Uint8 TBP_requestPlacement (TBP_Session*, const Bitboard*, const char cells[NB_BLOCK_Y][NB_BLOCK_X],
+                            int actualTetrim, int nextTetrim, Uint8 bag, Placement*);
+
+/** Tells the bot where the tetrimino has actually been locked **/
+void TBP_reportPlacement (TBP_Session*, int tetrim, const Placement*);
+
+/** Tells the bot that the game is over. The next request sends the playfield again **/
+void TBP_stopGame (TBP_Session*);
+
+/** Tells the bot to quit **/
+void TBP_closeSession (TBP_Session*);
+
+/** Plays a game without window, driven by the bot. Returns the final score **/
+Uint32 TBP_playGame (TBP_Session*, Uint32 seed, int maxPieces, int *nbPieces);
+
+/** Measures the time needed to write and read the messages and prints it in the stdout file **/
+void TBP_benchmark (int nbMessages);
+
+#endif // TBP_H_INCLUDED
@@ -0,0 +1,326 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "constants.h"
+#include "platform.h"
+#include "telemetry.h"
+
+/* Maps the segment, created if create is 1. Returns NULL if it cannot be mapped */
+static TLM_Mapping* mapSegment (const char *name, Uint8 create)
+{
+    TLM_Mapping *mapping = (TLM_Mapping*)calloc(1, sizeof(TLM_Mapping));
+    void *data = NULL;
+#ifndef _WIN32
+    char path[80];
+    int fd;
+#endif
+
+    if (mapping == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the telemetry\n");
+        return NULL;
+    }
+    strncpy (mapping->name, name, sizeof(mapping->name)-1);
+    mapping->owner = create;
+
+#ifdef _WIN32
+    if (create)
+        mapping->handle = CreateFileMappingA (INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(TLM_Segment), name);
+    else
+        mapping->handle = OpenFileMappingA (FILE_MAP_READ, FALSE, name);
+    if (mapping->handle != NULL)
+        data = MapViewOfFile (mapping->handle, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, sizeof(TLM_Segment));
+    if (data == NULL && mapping->handle != NULL)
+        CloseHandle (mapping->handle);
+#else
+    sprintf(path, "/%.70s", name);
+    fd = shm_open (path, create ? (O_CREAT | O_RDWR) : O_RDONLY, 0644);
+    if (fd >= 0 && (!create || ftruncate (fd, sizeof(TLM_Segment)) == 0))
+    {
+        data = mmap (NULL, sizeof(TLM_Segment), create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+            data = NULL;
+    }
+    if (fd >= 0)
+        close (fd); /* The mapping stays */
+    if (data == NULL && create)
+        shm_unlink (path);
+#endif
+
+    if (data == NULL)
+    {
+        fprintf(stderr, "Impossible to %s the telemetry segment %s\n", create ? "create" : "open", name);
+        free (mapping);
+        return NULL;
+    }
+    mapping->segment = (TLM_Segment*)data;
+
+    return mapping;
+}
+
+TLM_Mapping* TLM_openPublisher (const char *name)
+{
+    TLM_Mapping *mapping = mapSegment (name, 1);
+
+    if (mapping == NULL)
+        return NULL;
+
+    /* The magic is written last, so a reader never sees a segment that is not ready */
+    mapping->segment->sequence = 0;
+    mapping->segment->version = TLM_VERSION;
+    mapping->segment->size = sizeof(TLM_Snapshot);
+    PLT_RELEASE_FENCE ();
+    memcpy (mapping->segment->magic, TLM_MAGIC, 8);
+    mapping->lastPublishTime = PLT_getTimeUs ();
+
+    return mapping;
+}
+
+TLM_Mapping* TLM_openReader (const char *name)
+{
+    TLM_Mapping *mapping = mapSegment (name, 0);
+
+    if (mapping == NULL)
+        return NULL;
+
+    if (memcmp (mapping->segment->magic, TLM_MAGIC, 8) != 0 || mapping->segment->version != TLM_VERSION
+        || mapping->segment->size != sizeof(TLM_Snapshot))
+    {
+        fprintf(stderr, "The segment %s is not a telemetry segment of this version of the game\n", name);
+        TLM_close (mapping);
+        return NULL;
+    }
+
+    return mapping;
+}
+
+void TLM_close (TLM_Mapping *mapping)
+{
+#ifndef _WIN32
+    char path[80];
+#endif
+
+    if (mapping == NULL)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile (mapping->segment);
+    CloseHandle (mapping->handle);
+#else
+    munmap (mapping->segment, sizeof(TLM_Segment));
+    if (mapping->owner)
+    {
+        sprintf(path, "/%.70s", mapping->name);
+        shm_unlink (path);
+    }
+#endif
+
+    free (mapping);
+}
+
+void TLM_countInput (TLM_Mapping *mapping, int input)
+{
+    if (input >= 0 && input < TLM_NB_INPUTS)
+        mapping->local.inputs[input]++;
+}
+
+void TLM_publish (TLM_Mapping *mapping, Uint32 renderTime)
+{
+    /* Variables */
+    TLM_Snapshot *local = &mapping->local;
+    TLM_Segment *segment = mapping->segment;
+    Uint64 now = PLT_getTimeUs ();
+    Uint32 sequence = segment->sequence;
+
+    local->frame++;
+    local->frameInterval = (Uint32)(now - mapping->lastPublishTime);
+    local->renderTime = renderTime;
+    if (mapping->windowFrames++ % TLM_WINDOW == 0)
+    {
+        local->maxFrameInterval = 0;
+        local->maxRenderTime = 0;
+    }
+    if (local->frameInterval > local->maxFrameInterval)
+        local->maxFrameInterval = local->frameInterval;
+    if (renderTime > local->maxRenderTime)
+        local->maxRenderTime = renderTime;
+    mapping->lastPublishTime = now;
+
+    /* Odd while the snapshot is being copied */
+    segment->sequence = sequence + 1;
+    PLT_RELEASE_FENCE ();
+    memcpy (&segment->snapshot, local, sizeof(TLM_Snapshot));
+    PLT_RELEASE_FENCE ();
+    segment->sequence = sequence + 2;
+}
+
+/* Copies the snapshot. Returns the number of copies needed, 0 if none was complete */
+static int readSnapshot (const TLM_Segment *segment, TLM_Snapshot *snapshot)
+{
+    Uint32 before, after;
+    int n;
+
+    for (n = 1; n <= TLM_MAX_RETRIES; n++)
+    {
+        before = segment->sequence;
+        PLT_ACQUIRE_FENCE ();
+        if (before == 0)
+            return 0;
+        if (before & 1)
+            continue;
+
+        memcpy (snapshot, (const void*)&segment->snapshot, sizeof(TLM_Snapshot));
+        PLT_ACQUIRE_FENCE ();
+        after = segment->sequence;
+        if (after == before)
+            return n;
+    }
+
+    return 0;
+}
+
+Uint8 TLM_read (const TLM_Mapping *mapping, TLM_Snapshot *snapshot)
+{
+    return readSnapshot (mapping->segment, snapshot) > 0;
+}
+
+typedef struct BenchReader BenchReader;
+
+struct BenchReader
+{
+    const TLM_Segment *segment;
+    volatile int *stop;
+    Uint64 nbReads, nbRetries, nbTorn, nbFailed;
+};
+
+/* A snapshot of the benchmark is complete if all its fields come from the same publication */
+static Uint8 isComplete (const TLM_Snapshot *snapshot)
+{
+    int i, j;
+
+    if (snapshot->score != snapshot->frame || snapshot->nbCompleteLines != snapshot->frame)
+        return 0;
+    for (j = 0; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            if (snapshot->cells[j][i] != (Uint8)snapshot->frame)
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int benchReader (void *data)
+{
+    BenchReader *reader = (BenchReader*)data;
+    TLM_Snapshot snapshot;
+    int copies;
+
+    while (!*reader->stop)
+    {
+        copies = readSnapshot (reader->segment, &snapshot);
+        if (copies == 0)
+        {
+            reader->nbFailed++;
+            continue;
+        }
+        reader->nbReads++;
+        reader->nbRetries += copies - 1;
+        if (!isComplete (&snapshot))
+            reader->nbTorn++;
+    }
+
+    return 0;
+}
+
+/* Publishes nbPublications snapshots of the benchmark. Returns the time spent in microseconds */
+static Uint64 publishMany (TLM_Mapping *mapping, int nbPublications)
+{
+    Uint64 startTime = PLT_getTimeUs ();
+    int n;
+
+    for (n = 0; n < nbPublications; n++)
+    {
+        memset (mapping->local.cells, (Uint8)(mapping->local.frame + 1), sizeof(mapping->local.cells));
+        mapping->local.score = mapping->local.nbCompleteLines = mapping->local.frame + 1;
+        TLM_publish (mapping, 0);
+    }
+
+    return PLT_getTimeUs () - startTime;
+}
+
+void TLM_benchmark (int nbPublications, int nbReaders)
+{
+    /* Variables */
+    TLM_Mapping *publisher = NULL, *reader = NULL;
+    BenchReader readers[16];
+    SDL_Thread *threads[16];
+    TLM_Snapshot snapshot;
+    volatile int stop = 0;
+    Uint64 alone, shared, readTime, nbReads = 0, nbRetries = 0, nbTorn = 0, nbFailed = 0;
+    int nbReadsAlone = 1000000, n;
+
+    if (nbReaders > 16)
+        nbReaders = 16;
+    publisher = TLM_openPublisher (TLM_DEFAULT_NAME "_bench");
+    if (publisher == NULL)
+        return;
+    reader = TLM_openReader (TLM_DEFAULT_NAME "_bench");
+    if (reader == NULL)
+    {
+        TLM_close (publisher);
+        return;
+    }
+
+    /* Without readers */
+    alone = publishMany (publisher, nbPublications);
+    readTime = PLT_getTimeUs ();
+    for (n = 0; n < nbReadsAlone; n++)
+        TLM_read (reader, &snapshot);
+    readTime = PLT_getTimeUs () - readTime;
+
+    /* With readers copying the snapshot without a break */
+    for (n = 0; n < nbReaders; n++)
+    {
+        readers[n].segment = reader->segment;
+        readers[n].stop = &stop;
+        readers[n].nbReads = readers[n].nbRetries = readers[n].nbTorn = readers[n].nbFailed = 0;
+        threads[n] = SDL_CreateThread (benchReader, &readers[n]);
+    }
+    shared = publishMany (publisher, nbPublications);
+    stop = 1;
+    for (n = 0; n < nbReaders; n++)
+    {
+        if (threads[n] != NULL)
+            SDL_WaitThread (threads[n], NULL);
+        nbReads += readers[n].nbReads;
+        nbRetries += readers[n].nbRetries;
+        nbTorn += readers[n].nbTorn;
+        nbFailed += readers[n].nbFailed;
+    }
+
+    fprintf(stdout, "Telemetry : snapshot of %u bytes, %d publications\n", (Uint32)sizeof(TLM_Snapshot), nbPublications);
+    fprintf(stdout, "    Publication : %.1f ns alone, %.1f ns with %d readers reading without a break\n",
+            alone*1e3/nbPublications, shared*1e3/nbPublications, nbReaders);
+    fprintf(stdout, "    Read : %.1f ns without publications\n", readTime*1e3/nbReadsAlone);
+    fprintf(stdout, "    During the publications : %llu reads, %llu copies started again, %llu failed, %llu torn\n",
+            (unsigned long long)nbReads, (unsigned long long)nbRetries, (unsigned long long)nbFailed,
+            (unsigned long long)nbTorn);
+
+    TLM_close (reader);
+    TLM_close (publisher);
+}
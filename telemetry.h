@@ -0,0 +1,113 @@
+/** telemetry.h and telemetry.cpp publish the state of the running game in shared memory for local tools
+    (dashboards, overlays...).
+
+    The game writes a TLM_Snapshot in a named shared memory segment after each refresh of the screen.
+    The segment is protected by a sequence lock : the game makes the sequence odd, copies the snapshot,
+    then makes it even again. It never waits for the readers, so they cannot slow the game down.
+    A reader copies the snapshot from the mapped segment, without any system call, and starts again if the
+    sequence was odd or has changed during the copy.
+
+    Segment layout :
+        char magic[8]           "TTRMTLM"
+        Uint32 version
+        Uint32 size             size of the snapshot
+        Uint32 sequence         odd while the game is writing
+        Uint32 reserved
+        TLM_Snapshot snapshot
+**/
+
+#ifndef TELEMETRY_H_INCLUDED
+#define TELEMETRY_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+
+#define TLM_MAGIC           "TTRMTLM"
+#define TLM_VERSION         1
+#define TLM_DEFAULT_NAME    "urban_tetrims_telemetry"
+#define TLM_MAX_RETRIES     1000 /* Copies tried by TLM_read before giving up */
+#define TLM_WINDOW          64 /* Frames over which the longest times are kept */
+
+enum { TLM_INPUT_LEFT, TLM_INPUT_RIGHT, TLM_INPUT_ROTATE, TLM_INPUT_DOWN, TLM_INPUT_PAUSE, TLM_INPUT_OTHER, TLM_NB_INPUTS };
+
+typedef struct TLM_Snapshot TLM_Snapshot;
+typedef struct TLM_Segment TLM_Segment;
+typedef struct TLM_Mapping TLM_Mapping;
+
+struct TLM_Snapshot
+{
+    Uint32 frame; /* Number of the refresh of the screen, since the program started */
+    Uint32 gameTime; /* Milliseconds since the game started */
+
+    /* Game */
+    Uint8 cells[NB_BLOCK_Y][NB_BLOCK_X]; /* Color of the locked blocks (BLOCK_* of gMap), BLOCK_VOID elsewhere */
+    Uint8 active; /* Boolean : 1 if there is an active tetrimino */
+    Uint8 tetrim, rotation, nextTetrim;
+    Sint8 x, y; /* Position of block1 */
+    Uint8 over; /* Boolean */
+    Uint8 reserved;
+    Uint32 score;
+    Uint32 level;
+    Uint32 nbCompleteLines;
+
+    /* Frames, in microseconds */
+    Uint32 frameInterval; /* Between the last two refreshes */
+    Uint32 maxFrameInterval; /* Longest interval of the last TLM_WINDOW frames */
+    Uint32 renderTime; /* Duration of the last refresh */
+    Uint32 maxRenderTime; /* Longest refresh of the last TLM_WINDOW frames */
+
+    /* Inputs since the program started */
+    Uint32 inputs[TLM_NB_INPUTS];
+};
+
+struct TLM_Segment
+{
+    char magic[8];
+    Uint32 version;
+    Uint32 size;
+    volatile Uint32 sequence;
+    Uint32 reserved;
+    TLM_Snapshot snapshot;
+};
+
+/* A segment mapped by the game (publisher) or by a tool (reader) */
+struct TLM_Mapping
+{
+    TLM_Segment *segment;
+    TLM_Snapshot local; /* Snapshot being filled by the game before it is published */
+    Uint8 owner; /* Boolean : 1 for the game, which removes the segment when it closes it */
+    char name[64];
+    Uint64 lastPublishTime;
+    int windowFrames; /* Frames since the maxima have been reset */
+#ifdef _WIN32
+    void *handle;
+#endif
+};
+
+
+/** Creates the segment. Returns NULL if it cannot be created **/
+TLM_Mapping* TLM_openPublisher (const char *name);
+
+/** Maps a segment created by a game, read only. Returns NULL if there is no such segment **/
+TLM_Mapping* TLM_openReader (const char *name);
+
+/** Unmaps a segment, and removes it if it was created by TLM_openPublisher **/
+void TLM_close (TLM_Mapping*);
+
+/** Counts an input (TLM_INPUT_*) in the snapshot of the game. It is published at the next TLM_publish **/
+void TLM_countInput (TLM_Mapping*, int input);
+
+/** Publishes the local snapshot of the game, after its game fields have been filled.
+    The frame fields are updated from renderTime and from the time since the last publication **/
+void TLM_publish (TLM_Mapping*, Uint32 renderTime);
+
+/** Copies the last snapshot published. Returns a boolean : 0 if no complete snapshot could be copied
+    (no publication yet, or the game kept writing during TLM_MAX_RETRIES copies) **/
+Uint8 TLM_read (const TLM_Mapping*, TLM_Snapshot*);
+
+/** Measures the cost of a publication and of a read while readers run on other threads,
+    checks that no read is torn and prints the results in the stdout file **/
+void TLM_benchmark (int nbPublications, int nbReaders);
+
+#endif // TELEMETRY_H_INCLUDED
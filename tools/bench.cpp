@@ -0,0 +1,170 @@
+/**
+ *
+ *  bench.cpp measures the speed of the parts of the game that do not need a window.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  Usage : bench <name> [parameters]
+ *      features [nbBoards] [seed]      speed of the playfield feature extractor
+ *      pc [nbGames] [seed]             speed of the perfect clear solver
+ *      book <file> [nbGames] [seed]    speed of the opening book compared to the search of the AI
+ *      search [nbGames] [maxPieces] [seed]   strength and speed of the beam and expectimax searches
+ *      tbp [nbMessages]                speed of the encoding and the decoding of the bot protocol
+ *      versus [nbMatches] [maxPieces] [seed]   speed of the garbage and of the matches between two AI
+ *      spectate [nbGames] [seconds] [seed]     size of the spectator stream compared to full snapshots
+ *      telemetry [nbPublications] [nbReaders]  cost of the publications and of the reads of the telemetry
+ *      render [nbGames] [seconds] [seed]       pixels, time and checksum of the frames of the renderer in memory, whole window or changes only
+ *      assets [nbRepeats]              blits of the opening animation and of the menus, before and after conversion
+ *      cells [nbFrames]                cells filled with SDL_FillRect or in the pixels of the screen, blocks of 1, 2 and 4 sizes
+ *      pipeline [seconds] [presentMs] [seed]   latency of the inputs with the simulation on the thread of the rendering or not
+ *      pacing [seconds] [refreshRate] [seed]   intervals between the frames and moves of the falling tetrimino, interpolated or not
+ *      scales [nbGames] [seconds] [seed]       time to prescale the assets and time per frame at the scales 1 to 4
+ *      wall [nbBoards] [seconds] [nbThreads] [seed]   pacing and time to draw many boards at once, every cell or changes only
+ *      capture [nbFrames] [nbSlots]    time of the game and of the writer to capture a video, frames dropped and depth of the queue
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../boardfeatures.h"
+#include "../pcsolver.h"
+#include "../book.h"
+#include "../search.h"
+#include "../tbp.h"
+#include "../versus.h"
+#include "../spectate.h"
+#include "../telemetry.h"
+#include "../render.h"
+#include "../pipeline.h"
+#include "../wall.h"
+#include "../capture.h"
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : bench <name> [parameters]\n");
+    fprintf(stderr, "    features [nbBoards] [seed]\n");
+    fprintf(stderr, "    pc [nbGames] [seed]\n");
+    fprintf(stderr, "    book <file> [nbGames] [seed]\n");
+    fprintf(stderr, "    search [nbGames] [maxPieces] [seed]\n");
+    fprintf(stderr, "    tbp [nbMessages]\n");
+    fprintf(stderr, "    versus [nbMatches] [maxPieces] [seed]\n");
+    fprintf(stderr, "    spectate [nbGames] [seconds] [seed]\n");
+    fprintf(stderr, "    telemetry [nbPublications] [nbReaders]\n");
+    fprintf(stderr, "    render [nbGames] [seconds] [seed]\n");
+    fprintf(stderr, "    assets [nbRepeats]\n");
+    fprintf(stderr, "    cells [nbFrames]\n");
+    fprintf(stderr, "    pipeline [seconds] [presentMs] [seed]\n");
+    fprintf(stderr, "    pacing [seconds] [refreshRate] [seed]\n");
+    fprintf(stderr, "    scales [nbGames] [seconds] [seed]\n");
+    fprintf(stderr, "    wall [nbBoards] [seconds] [nbThreads] [seed]\n");
+    fprintf(stderr, "    capture [nbFrames] [nbSlots]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    if (argc < 2)
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    if (strcmp (argv[1], "features") == 0)
+    {
+        FTR_benchmark ( (argc > 2) ? atoi (argv[2]) : 10000,
+                        (argc > 3) ? (Uint32)strtoul (argv[3], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "pc") == 0)
+    {
+        PC_benchmark ( (argc > 2) ? atoi (argv[2]) : 200,
+                       (argc > 3) ? (Uint32)strtoul (argv[3], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "book") == 0 && argc > 2)
+    {
+        BOOK_benchmark ( argv[2],
+                         (argc > 3) ? atoi (argv[3]) : 1000,
+                         (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "search") == 0)
+    {
+        SRCH_benchmark ( (argc > 2) ? atoi (argv[2]) : 5,
+                         (argc > 3) ? atoi (argv[3]) : 200,
+                         (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "tbp") == 0)
+    {
+        TBP_benchmark ( (argc > 2) ? atoi (argv[2]) : 100000 );
+    }
+    else if (strcmp (argv[1], "versus") == 0)
+    {
+        VS_benchmark ( (argc > 2) ? atoi (argv[2]) : 200,
+                       (argc > 3) ? atoi (argv[3]) : 500,
+                       (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "spectate") == 0)
+    {
+        SPEC_benchmark ( (argc > 2) ? atoi (argv[2]) : 20,
+                         (argc > 3) ? atoi (argv[3]) : 300,
+                         (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "telemetry") == 0)
+    {
+        TLM_benchmark ( (argc > 2) ? atoi (argv[2]) : 1000000,
+                        (argc > 3) ? atoi (argv[3]) : 2 );
+    }
+    else if (strcmp (argv[1], "render") == 0)
+    {
+        RND_benchmark ( (argc > 2) ? atoi (argv[2]) : 10,
+                        (argc > 3) ? atoi (argv[3]) : 300,
+                        (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "assets") == 0)
+    {
+        RND_assetBenchmark ( (argc > 2) ? atoi (argv[2]) : 200 );
+    }
+    else if (strcmp (argv[1], "cells") == 0)
+    {
+        RND_fillBenchmark ( (argc > 2) ? atoi (argv[2]) : 2000 );
+    }
+    else if (strcmp (argv[1], "pipeline") == 0)
+    {
+        PIPE_benchmark ( (argc > 2) ? atoi (argv[2]) : 5,
+                         (argc > 3) ? atoi (argv[3]) : 20,
+                         (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "pacing") == 0)
+    {
+        PIPE_pacingBenchmark ( (argc > 2) ? atoi (argv[2]) : 5,
+                               (argc > 3) ? atoi (argv[3]) : 144,
+                               (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "scales") == 0)
+    {
+        RND_scaleBenchmark ( (argc > 2) ? atoi (argv[2]) : 5,
+                             (argc > 3) ? atoi (argv[3]) : 20,
+                             (argc > 4) ? (Uint32)strtoul (argv[4], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "wall") == 0)
+    {
+        WALL_benchmark ( (argc > 2) ? atoi (argv[2]) : 64,
+                         (argc > 3) ? atoi (argv[3]) : 5,
+                         (argc > 4) ? atoi (argv[4]) : 0,
+                         (argc > 5) ? (Uint32)strtoul (argv[5], NULL, 10) : 2463534242u );
+    }
+    else if (strcmp (argv[1], "capture") == 0)
+    {
+        CAP_benchmark ( (argc > 2) ? atoi (argv[2]) : 200,
+                        (argc > 3) ? atoi (argv[3]) : CAP_QUEUE_SIZE );
+    }
+    else
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
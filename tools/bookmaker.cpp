@@ -0,0 +1,257 @@
+/**
+ *
+ *  bookmaker.cpp builds the opening book read by book.cpp.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  Starting from the empty playfield, every order of the tetriminoes that the bag can give is explored
+ *  for the first pieces of the game. In each position, the placement chosen by the expectimax search
+ *  (see search.h) without time limit, deeper and wider than the game can afford, is stored in the book :
+ *  the game plays these stronger openings without searching, then AI_bestPlacementWithNext (see ai.h).
+ *  By default, the search looks at one unknown tetrimino (-d 1) and expands 8 placements per max node (-w 8),
+ *  about 5 ms per position. -d 2 is about 15 times slower.
+ *
+ *  Usage : bookmaker [-n nbPieces] [-d depth] [-w width] [-o file]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../sim.h"
+#include "../ai.h"
+#include "../search.h"
+#include "../book.h"
+#include "../platform.h"
+
+typedef struct BookEntry BookEntry;
+typedef struct BookMaker BookMaker;
+
+struct BookEntry
+{
+    Uint64 key;
+    Uint32 move;
+};
+
+struct BookMaker
+{
+    AI_Weights weights;
+    SearchParams params; /* Of the expectimax search that chooses the placements */
+    int nbPieces; /* Depth of the book */
+    BookEntry *entries;
+    Uint32 nbEntries;
+    Uint32 capacity;
+};
+
+static Uint8 addEntry (BookMaker *maker, Uint64 key, Uint32 move)
+{
+    BookEntry *entries = NULL;
+
+    if (maker->nbEntries == maker->capacity)
+    {
+        entries = (BookEntry*)realloc(maker->entries, 2*maker->capacity*sizeof(BookEntry));
+        if (entries == NULL)
+        {
+            fprintf(stderr, "An error occurred during memory allocation for the book entries\n");
+            return 0;
+        }
+        maker->entries = entries;
+        maker->capacity *= 2;
+    }
+
+    maker->entries[maker->nbEntries].key = key;
+    maker->entries[maker->nbEntries].move = move;
+    maker->nbEntries++;
+
+    return 1;
+}
+
+/* Stores the placement of the position, plays it, then explores every tetrimino that can come after */
+static Uint8 explore (BookMaker *maker, const SimGame *game, int depth)
+{
+    /* Variables */
+    SimGame after;
+    Placement placement;
+    Uint8 bag;
+    int tetrim;
+
+    if (depth >= maker->nbPieces || game->over)
+        return 1;
+    if (!SRCH_expectimax (game, &maker->weights, &maker->params, &placement, NULL))
+        return 1;
+    if (!addEntry (maker, BOOK_key (&game->board, game->actualTetrim, game->nextTetrim), BOOK_packMove (&placement)))
+        return 0;
+
+    bag = (game->bag != 0) ? game->bag : SIM_FULL_BAG;
+    for (tetrim = 0; tetrim < 7; tetrim++)
+    {
+        if (!(bag & (1 << tetrim)))
+            continue;
+
+        after = *game;
+        BB_putPiece (&after.board, after.actualTetrim, placement.rotation, placement.x, placement.y);
+        BB_clearLines (&after.board);
+        after.actualTetrim = after.nextTetrim;
+        after.nextTetrim = tetrim;
+        after.bag = bag & ~(1 << tetrim);
+        after.over = BB_collides (&after.board, after.actualTetrim, 0, BB_spawnColumn (after.actualTetrim), FIRST_LINE);
+
+        if (!explore (maker, &after, depth+1))
+            return 0;
+    }
+
+    return 1;
+}
+
+static int compareEntries (const void *a, const void *b)
+{
+    const BookEntry *entryA = (const BookEntry*)a, *entryB = (const BookEntry*)b;
+
+    if (entryA->key != entryB->key)
+        return (entryA->key < entryB->key) ? -1 : 1;
+    return 0;
+}
+
+static Uint8 writeBook (const BookMaker *maker, const char *fileName)
+{
+    /* Variables */
+    FILE *file = NULL;
+    Uint32 header[2] = {BOOK_VERSION, maker->nbEntries};
+    Uint32 n;
+    Uint8 ok = 1; /* Boolean */
+
+    file = fopen (fileName, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Impossible to create the file %s\n", fileName);
+        return 0;
+    }
+
+    ok = fwrite (BOOK_MAGIC, 1, 8, file) == 8 && fwrite (header, sizeof(Uint32), 2, file) == 2;
+    for (n = 0; n < maker->nbEntries && ok; n++)
+        ok = fwrite (&maker->entries[n].key, sizeof(Uint64), 1, file) == 1;
+    for (n = 0; n < maker->nbEntries && ok; n++)
+        ok = fwrite (&maker->entries[n].move, sizeof(Uint32), 1, file) == 1;
+
+    if (fclose (file) != 0 || !ok)
+    {
+        fprintf(stderr, "An error occurred while writing the file %s\n", fileName);
+        return 0;
+    }
+
+    return 1;
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : bookmaker [-n nbPieces] [-d depth] [-w width] [-o file]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    BookMaker maker;
+    SimGame game;
+    const char *fileName = "opening.book";
+    Uint64 startTime;
+    Uint32 n, k;
+    int actual, next;
+
+    maker.nbPieces = 7;
+    SRCH_defaultParams (&maker.params);
+    maker.params.maxDepth = 1;
+    maker.params.width = 8;
+    maker.params.timeBudget = 0; /* The same book whatever the machine */
+    for (n = 1; n < (Uint32)argc; n += 2)
+    {
+        if (n+1 >= (Uint32)argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'n':
+                maker.nbPieces = atoi (argv[n+1]);
+                break;
+            case 'd':
+                maker.params.maxDepth = atoi (argv[n+1]);
+                break;
+            case 'w':
+                maker.params.width = atoi (argv[n+1]);
+                break;
+            case 'o':
+                fileName = argv[n+1];
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (maker.params.maxDepth < 0 || maker.params.maxDepth > SRCH_MAX_DEPTH
+        || maker.params.width < 1 || maker.params.width > SRCH_MAX_WIDTH)
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    AI_defaultWeights (&maker.weights);
+    maker.nbEntries = 0;
+    maker.capacity = 1024;
+    maker.entries = (BookEntry*)malloc(maker.capacity*sizeof(BookEntry));
+    if (maker.entries == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the book entries\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Every first and second tetriminoes of the first bag */
+    startTime = PLT_getTimeUs ();
+    SIM_init (&game, 1);
+    for (actual = 0; actual < 7; actual++)
+    {
+        for (next = 0; next < 7; next++)
+        {
+            if (next == actual)
+                continue;
+            BB_clear (&game.board);
+            game.actualTetrim = actual;
+            game.nextTetrim = next;
+            game.bag = SIM_FULL_BAG & ~(1 << actual) & ~(1 << next);
+            game.over = 0;
+            if (!explore (&maker, &game, 0))
+            {
+                free (maker.entries);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    /* The same position can be reached by several orders : only one entry is kept */
+    qsort (maker.entries, maker.nbEntries, sizeof(BookEntry), compareEntries);
+    for (n = 0, k = 0; n < maker.nbEntries; n++)
+    {
+        if (k == 0 || maker.entries[n].key != maker.entries[k-1].key)
+            maker.entries[k++] = maker.entries[n];
+    }
+    fprintf(stdout, "%u positions explored, %u entries kept (%.1f s)\n",
+            maker.nbEntries, k, (PLT_getTimeUs () - startTime)/1e6);
+    maker.nbEntries = k;
+
+    if (!writeBook (&maker, fileName))
+    {
+        free (maker.entries);
+        return EXIT_FAILURE;
+    }
+    fprintf(stdout, "Book written in %s\n", fileName);
+
+    free (maker.entries);
+
+    return EXIT_SUCCESS;
+}
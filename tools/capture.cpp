@@ -0,0 +1,164 @@
+/**
+ *
+ *  capture.cpp makes a video of a game from its spectator stream (see spectate.h), without window.
+ *  It must be linked with the source files of the game, except main.cpp, and started from the folder
+ *  of the game, where its images and fonts are.
+ *
+ *  Each tick of the stream is a frame, drawn like the game does in a screen in memory (see render.h)
+ *  and captured in a Y4M video, or in raw yuv420p with -raw (see capture.h). The video goes to the
+ *  standard output by default, to be piped to an encoder :
+ *      capture replay | ffmpeg -i - replay.mp4
+ *  The replay is drawn as fast as the writer takes the frames, so none is dropped, unless -drop is given.
+ *
+ *  Usage : capture [-raw] [-drop] [-q nbSlots] [-scale n] replay [video]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_ttf.h>
+
+#include "../constants.h"
+#include "../game.h"
+#include "../animation.h"
+#include "../render.h"
+#include "../spectate.h"
+#include "../capture.h"
+
+#define READ_SIZE       4096
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : capture [-raw] [-drop] [-q nbSlots] [-scale n] replay [video]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    const char *replayName = NULL, *videoName = "-";
+    FILE *replay = NULL;
+    RND_Backend memory;
+    Sprites sprites;
+    CAP_Capture capture;
+    SPEC_Decoder decoder;
+    Uint8 buffer[2*READ_SIZE];
+    Uint32 lastTick = 0, tick;
+    Uint16 tickPeriod = 0;
+    int length = 0, read, used, n;
+    int nbSlots = CAP_QUEUE_SIZE, scale = 1;
+    Uint8 raw = 0, drop = 0, started = 0, overShown = 0, ok = 1; /* Booleans */
+
+    for (n = 1; n < argc; n++)
+    {
+        if (strcmp (argv[n], "-raw") == 0)
+            raw = 1;
+        else if (strcmp (argv[n], "-drop") == 0)
+            drop = 1;
+        else if (strcmp (argv[n], "-q") == 0 && n+1 < argc)
+            nbSlots = atoi (argv[++n]);
+        else if (strcmp (argv[n], "-scale") == 0 && n+1 < argc)
+            scale = atoi (argv[++n]);
+        else if (argv[n][0] != '-' && replayName == NULL)
+            replayName = argv[n];
+        else if ((argv[n][0] != '-' || strcmp (argv[n], "-") == 0) && replayName != NULL)
+            videoName = argv[n];
+        else
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+    }
+    if (replayName == NULL)
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    replay = fopen (replayName, "rb");
+    if (replay == NULL)
+    {
+        fprintf(stderr, "Impossible to open the replay %s\n", replayName);
+        return EXIT_FAILURE;
+    }
+    /* The period of the ticks, the one of the frames, is in the header */
+    length = fread (buffer, 1, SPEC_HEADER_SIZE, replay);
+    tickPeriod = SPEC_decodeHeader (buffer, length);
+    if (tickPeriod == 0)
+    {
+        fprintf(stderr, "This is not a spectator stream\n");
+        fclose (replay);
+        return EXIT_FAILURE;
+    }
+    length = 0;
+
+    /* The screen is in memory, the sprites are the ones of the game */
+    RND_chooseScale ((scale > 0) ? scale : 1);
+    if (TTF_Init () < 0)
+    {
+        fprintf(stderr, "An error occurred during SDL_ttf initialization\n");
+        fclose (replay);
+        return EXIT_FAILURE;
+    }
+    if (!RND_openMemory (&memory, WINDOW_WIDTH, WINDOW_HEIGHT) || !initSprites (&sprites, memory.screen))
+    {
+        fprintf(stderr, "An error occurred during sprites loading\n");
+        fclose (replay);
+        TTF_Quit ();
+        return EXIT_FAILURE;
+    }
+    if (!CAP_open (&capture, videoName, raw, memory.screen, tickPeriod, nbSlots))
+    {
+        freeSprites (&sprites);
+        RND_closeBackend (&memory);
+        fclose (replay);
+        TTF_Quit ();
+        return EXIT_FAILURE;
+    }
+
+    SPEC_initDecoder (&decoder);
+    while (ok && (read = fread (buffer + length, 1, READ_SIZE, replay)) > 0)
+    {
+        length += read;
+        used = 0;
+        while ((n = SPEC_decodeFrame (&decoder, buffer + used, length - used)) > 0)
+        {
+            used += n;
+            if (!decoder.synced)
+                continue;
+
+            /* The ticks without any change are the last frame again */
+            for (tick = lastTick + 1; started && tick < decoder.tick; tick++)
+                CAP_submit (&capture, memory.screen, !drop);
+            RND_drawFrame (&sprites.drawn, &memory, &sprites.tiles, &sprites.digits, &decoder.frame,
+                           decoder.tick*tickPeriod);
+            if (decoder.frame.over && !overShown)
+            {
+                RND_showOverlay (&sprites.drawn, &memory, sprites.txt_gameOver);
+                overShown = 1;
+            }
+            CAP_submit (&capture, memory.screen, !drop);
+            lastTick = decoder.tick;
+            started = 1;
+        }
+        if (n < 0)
+        {
+            fprintf(stderr, "The spectator stream is not correct : the video stops at the tick %u\n", lastTick);
+            ok = 0;
+        }
+
+        length -= used;
+        memmove (buffer, buffer + used, length);
+    }
+
+    CAP_close (&capture);
+    freeSprites (&sprites);
+    RND_closeBackend (&memory);
+    fclose (replay);
+    TTF_Quit ();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,334 @@
+/**
+ *
+ *  loadgen.cpp measures the server (see server.h) with many clients on the same machine.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  All the clients are opened at the start, then each one presses and releases random keys at a fixed rate,
+ *  the inputs of all the clients being spread over time. The latency is the time between an input and the state
+ *  that answers it, measured for every input : each client keeps the times of the inputs not answered yet, and
+ *  a state answers the nbEchoed oldest ones. The tick lateness is the one written by the server in the states.
+ *  A client whose game is over starts a new one.
+ *
+ *  Usage : loadgen [-p port | -u path] [-n connections] [-r inputsPerSecond] [-d duration]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../live.h"
+#include "../server.h"
+#include "../platform.h"
+
+#define MAX_EVENTS      1024
+#define MAX_PENDING     64 /* Inputs of a client waiting for their state, the next ones are skipped */
+
+typedef struct Client Client;
+
+struct Client
+{
+    int fd; /* -1 if the connection is closed */
+    Uint8 in[4*sizeof(SRV_State)];
+    Uint32 inLength;
+    Uint32 sentTimes[MAX_PENDING]; /* Times of the inputs not answered yet, from firstPending */
+    int firstPending, nbPending;
+    int keyHeld; /* Key to release with the next input, -1 if there is none */
+    Uint8 over; /* Boolean : 1 if the game is over, the next input starts a new one */
+};
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : loadgen [-p port | -u path] [-n connections] [-r inputsPerSecond] [-d duration]\n");
+}
+
+#ifdef __linux__
+
+/* Opens a connection to the server. Returns -1 if the server cannot be reached */
+static int connectClient (const char *unixPath, int port)
+{
+    struct sockaddr_in address;
+    struct sockaddr_un unixAddress;
+    int fd, one = 1, ok;
+
+    if (unixPath != NULL)
+    {
+        fd = socket (AF_UNIX, SOCK_STREAM, 0);
+        memset (&unixAddress, 0, sizeof(unixAddress));
+        unixAddress.sun_family = AF_UNIX;
+        strncpy (unixAddress.sun_path, unixPath, sizeof(unixAddress.sun_path)-1);
+        ok = (fd >= 0 && connect (fd, (struct sockaddr*)&unixAddress, sizeof(unixAddress)) == 0);
+    }
+    else
+    {
+        fd = socket (AF_INET, SOCK_STREAM, 0);
+        memset (&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons (port);
+        address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+        ok = (fd >= 0 && connect (fd, (struct sockaddr*)&address, sizeof(address)) == 0);
+        if (ok)
+            setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    /* The connection is made blocking, then the messages are sent and read without waiting */
+    if (!ok || fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK) != 0)
+    {
+        if (fd >= 0)
+            close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void closeClient (Client *client, Uint32 *nbClosed)
+{
+    if (client->fd < 0)
+        return;
+    close (client->fd);
+    client->fd = -1;
+    (*nbClosed)++;
+}
+
+/* Reads the states received by a client and measures them */
+static void readStates (Client *client, SRV_Histogram *latency, SRV_Histogram *lateness, Uint64 *nbStates, Uint32 *nbClosed)
+{
+    SRV_State state;
+    ssize_t length;
+    Uint32 now, offset;
+    int n;
+
+    while (client->fd >= 0)
+    {
+        length = read (client->fd, client->in + client->inLength, sizeof(client->in) - client->inLength);
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (length <= 0)
+        {
+            closeClient (client, nbClosed);
+            return;
+        }
+
+        client->inLength += length;
+        now = (Uint32)PLT_getTimeUs ();
+        for (offset = 0; offset + sizeof(SRV_State) <= client->inLength; offset += sizeof(SRV_State))
+        {
+            memcpy (&state, client->in + offset, sizeof(SRV_State));
+            for (n = 0; n < state.nbEchoed && client->nbPending > 0; n++)
+            {
+                SRV_addSample (latency, now - client->sentTimes[client->firstPending]);
+                client->firstPending = (client->firstPending + 1) % MAX_PENDING;
+                client->nbPending--;
+            }
+            SRV_addSample (lateness, state.tickLateness);
+            client->over = state.over;
+            (*nbStates)++;
+        }
+        client->inLength -= offset;
+        memmove (client->in, client->in + offset, client->inLength);
+    }
+}
+
+/* Sends the next input of a client : a key is pressed, then released by the next input.
+   Returns a boolean : 0 if the input could not be sent, or if too many inputs are waiting for their state */
+static Uint8 sendInput (Client *client, Uint32 *seed)
+{
+    SRV_Input input;
+    Uint32 time = (Uint32)PLT_getTimeUs ();
+
+    if (client->nbPending == MAX_PENDING)
+        return 0;
+
+    input.reserved = 0;
+    input.clientTime = (time != 0) ? time : 1;
+    if (client->over)
+    {
+        input.type = SRV_INPUT_RESTART;
+        input.key = 0;
+        client->over = 0;
+        client->keyHeld = -1;
+    }
+    else if (client->keyHeld >= 0)
+    {
+        input.type = SRV_INPUT_KEY_UP;
+        input.key = client->keyHeld;
+        client->keyHeld = -1;
+    }
+    else
+    {
+        input.type = SRV_INPUT_KEY_DOWN;
+        input.key = BB_random (seed) % LIVE_NB_KEYS;
+        client->keyHeld = input.key;
+    }
+
+    if (send (client->fd, &input, sizeof(input), MSG_NOSIGNAL) != sizeof(input))
+        return 0;
+    client->sentTimes[(client->firstPending + client->nbPending) % MAX_PENDING] = input.clientTime;
+    client->nbPending++;
+
+    return 1;
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    const char *unixPath = NULL;
+    struct epoll_event event, events[MAX_EVENTS];
+    struct rlimit limit;
+    Client *clients = NULL;
+    SRV_Histogram *latency = NULL, *lateness = NULL;
+    Uint64 startTime, connectTime, now, endTime, nbDue, nbSent = 0, nbStates = 0;
+    Uint32 nbFailed = 0, nbSkipped = 0, nbClosed = 0, seed = 2463534242u;
+    int port = 7777, nbClients = 10000, duration = 10, epollFd, nbEvents, cursor = 0, n;
+    double rate = 4.0;
+
+    for (n = 1; n < argc; n += 2)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'p':
+                port = atoi (argv[n+1]);
+                break;
+            case 'u':
+                unixPath = argv[n+1];
+                break;
+            case 'n':
+                nbClients = atoi (argv[n+1]);
+                break;
+            case 'r':
+                rate = atof (argv[n+1]);
+                break;
+            case 'd':
+                duration = atoi (argv[n+1]);
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+    if (nbClients < 1 || rate <= 0.0 || duration < 1)
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    /* One file per connection */
+    if (getrlimit (RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)nbClients + 64)
+    {
+        limit.rlim_cur = (limit.rlim_max < (rlim_t)nbClients + 64) ? limit.rlim_max : (rlim_t)nbClients + 64;
+        setrlimit (RLIMIT_NOFILE, &limit);
+    }
+
+    clients = (Client*)malloc(sizeof(Client)*nbClients);
+    latency = (SRV_Histogram*)malloc(sizeof(SRV_Histogram));
+    lateness = (SRV_Histogram*)malloc(sizeof(SRV_Histogram));
+    epollFd = epoll_create1 (0);
+    if (clients == NULL || latency == NULL || lateness == NULL || epollFd < 0)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the clients\n");
+        return EXIT_FAILURE;
+    }
+    SRV_clearHistogram (latency);
+    SRV_clearHistogram (lateness);
+
+    startTime = PLT_getTimeUs ();
+    for (n = 0; n < nbClients; n++)
+    {
+        clients[n].fd = connectClient (unixPath, port);
+        clients[n].inLength = 0;
+        clients[n].firstPending = clients[n].nbPending = 0;
+        clients[n].keyHeld = -1;
+        clients[n].over = 0;
+        if (clients[n].fd < 0)
+        {
+            if (nbFailed++ == 0)
+                fprintf(stderr, "Impossible to connect to the server : %s\n", strerror (errno));
+            continue;
+        }
+
+        event.events = EPOLLIN | EPOLLET;
+        event.data.u32 = n;
+        epoll_ctl (epollFd, EPOLL_CTL_ADD, clients[n].fd, &event);
+    }
+    connectTime = PLT_getTimeUs () - startTime;
+    fprintf(stdout, "%d connections opened in %.2f s, %u failed\n", nbClients - nbFailed, connectTime/1e6, nbFailed);
+    fflush (stdout);
+    if ((int)nbFailed == nbClients)
+        return EXIT_FAILURE;
+
+    /* The inputs are sent one client after the other, at the total rate of all the clients */
+    startTime = PLT_getTimeUs ();
+    endTime = startTime + (Uint64)duration*1000000;
+    while ((now = PLT_getTimeUs ()) < endTime)
+    {
+        nbDue = (Uint64)((now - startTime)*rate*nbClients/1e6);
+        while (nbSent + nbSkipped < nbDue)
+        {
+            if (clients[cursor].fd >= 0 && sendInput (&clients[cursor], &seed))
+                nbSent++;
+            else
+                nbSkipped++;
+            cursor = (cursor + 1) % nbClients;
+        }
+
+        nbEvents = epoll_wait (epollFd, events, MAX_EVENTS, 1);
+        for (n = 0; n < nbEvents; n++)
+            readStates (&clients[events[n].data.u32], latency, lateness, &nbStates, &nbClosed);
+    }
+
+    fprintf(stdout, "%d s : %llu inputs sent (%u skipped), %llu states received (%.0f per second), %u connections closed\n",
+            duration, (unsigned long long)nbSent, nbSkipped, (unsigned long long)nbStates,
+            nbStates/(double)duration, nbClosed);
+    SRV_printPercentiles ("Latency", latency);
+    SRV_printPercentiles ("Tick lateness", lateness);
+
+    for (n = 0; n < nbClients; n++)
+    {
+        if (clients[n].fd >= 0)
+            close (clients[n].fd);
+    }
+    close (epollFd);
+    free (clients);
+    free (latency);
+    free (lateness);
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main ( int, char** )
+{
+    printUsage ();
+    fprintf(stderr, "The load generator needs epoll, it only works on Linux\n");
+
+    return EXIT_FAILURE;
+}
+
+#endif
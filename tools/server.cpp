@@ -0,0 +1,77 @@
+/**
+ *
+ *  server.cpp hosts games played by remote clients (see server.h).
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  The server stops after the duration, or when it receives the signal SIGINT (Ctrl+C or kill -INT),
+ *  then prints the lateness of its ticks.
+ *
+ *  Usage : server [-p port | -u path] [-l loops] [-c maxConnections] [-k tick] [-d duration]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../server.h"
+
+static void onSignal (int)
+{
+    SRV_stop ();
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : server [-p port | -u path] [-l loops] [-c maxConnections] [-k tick] [-d duration]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    SRV_Params params;
+    int n;
+
+    SRV_defaultParams (&params);
+    for (n = 1; n < argc; n += 2)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'p':
+                params.port = atoi (argv[n+1]);
+                break;
+            case 'u':
+                params.unixPath = argv[n+1];
+                break;
+            case 'l':
+                params.nbLoops = atoi (argv[n+1]);
+                break;
+            case 'c':
+                params.maxConnections = atoi (argv[n+1]);
+                break;
+            case 'k':
+                params.tick = atoi (argv[n+1]);
+                break;
+            case 'd':
+                params.duration = atoi (argv[n+1]);
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+
+    signal (SIGINT, onSignal);
+    signal (SIGTERM, onSignal);
+
+    return SRV_run (&params) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
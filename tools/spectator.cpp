@@ -0,0 +1,188 @@
+/**
+ *
+ *  spectator.cpp follows a game from its spectator stream (see spectate.h) and draws it in the terminal.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  The stream is read from a file (- for the standard input), or from the game itself with -l port :
+ *  the viewer waits for the game started with "-spectate tcp:port" (not on Windows).
+ *  With -v, the playfield is drawn at each frame, at the speed of the game. Otherwise only the last
+ *  frame is drawn. In both cases the size of the stream is printed at the end.
+ *
+ *  Usage : spectator [-v] [-l port | file]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+
+#include "../constants.h"
+#include "../game.h"
+#include "../bitboard.h"
+#include "../spectate.h"
+
+#define READ_SIZE       4096
+
+/* Waits for the game on a TCP port. Returns NULL if the connection fails */
+static FILE* listenToGame (int port)
+{
+#ifndef _WIN32
+    struct sockaddr_in address;
+    int fd, client, one = 1;
+
+    fd = socket (AF_INET, SOCK_STREAM, 0);
+    memset (&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons (port);
+    address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    if (fd < 0 || setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+        || bind (fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen (fd, 1) != 0)
+    {
+        if (fd >= 0)
+            close (fd);
+        return NULL;
+    }
+
+    fprintf(stderr, "Waiting for the game on the port %d\n", port);
+    client = accept (fd, NULL, NULL);
+    close (fd);
+
+    return (client >= 0) ? fdopen (client, "rb") : NULL;
+#else
+    return NULL;
+#endif
+}
+
+/* Draws the playfield with the active tetrimino, the hidden lines excepted */
+static void drawFrame (const SPEC_Frame *frame, Uint32 tick, Uint16 tickPeriod)
+{
+    /* Variables */
+    static const char letters[] = "IOTLJZS";
+    const PieceShape *shape = NULL;
+    char line[NB_BLOCK_X+1];
+    int i, j, l;
+
+    if (frame->active)
+        shape = BB_getShape (frame->tetrim, frame->rotation);
+
+    fprintf(stdout, "\033[H\033[2J");
+    fprintf(stdout, "Time %.1f s   Score %u   Level %d   Lines %d   Next %c%s\n",
+            tick*tickPeriod/1000.0, frame->score, frame->level, frame->nbCompleteLines,
+            letters[frame->nextTetrim % 7], frame->over ? "   GAME OVER" : "");
+    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            line[i] = (frame->cells[j][i] != BLOCK_VOID) ? '#' : '.';
+            l = j - frame->y;
+            if (shape != NULL && l >= 0 && l < 4 && i - frame->x >= 0 && (shape->rows[l] & (1 << (i - frame->x))))
+                line[i] = '@';
+        }
+        line[NB_BLOCK_X] = '\0';
+        fprintf(stdout, "|%s|\n", line);
+    }
+    fflush (stdout);
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : spectator [-v] [-l port | file]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    FILE *file = NULL;
+    SPEC_Decoder decoder;
+    Uint8 buffer[2*READ_SIZE];
+    Uint64 nbBytes = 0;
+    Uint32 nbFrames = 0, lastTick = 0;
+    Uint16 tickPeriod = 0;
+    int length = 0, read, used, n;
+    Uint8 verbose = 0; /* Boolean */
+
+    for (n = 1; n < argc; n++)
+    {
+        if (strcmp (argv[n], "-v") == 0)
+            verbose = 1;
+        else if (strcmp (argv[n], "-l") == 0 && n+1 < argc)
+            file = listenToGame (atoi (argv[++n]));
+        else if (strcmp (argv[n], "-") == 0)
+            file = stdin;
+        else if (argv[n][0] != '-')
+            file = fopen (argv[n], "rb");
+        else
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+    }
+    if (file == NULL)
+    {
+        printUsage ();
+        fprintf(stderr, "No stream to read\n");
+        return EXIT_FAILURE;
+    }
+
+    SPEC_initDecoder (&decoder);
+    while ((read = fread (buffer + length, 1, READ_SIZE, file)) > 0)
+    {
+        length += read;
+        nbBytes += read;
+        used = 0;
+
+        if (tickPeriod == 0)
+        {
+            if (length < SPEC_HEADER_SIZE)
+                continue;
+            tickPeriod = SPEC_decodeHeader (buffer, length);
+            if (tickPeriod == 0)
+            {
+                fprintf(stderr, "This is not a spectator stream\n");
+                return EXIT_FAILURE;
+            }
+            used = SPEC_HEADER_SIZE;
+        }
+
+        while ((n = SPEC_decodeFrame (&decoder, buffer + used, length - used)) > 0)
+        {
+            used += n;
+            nbFrames++;
+            if (verbose && decoder.synced)
+            {
+                SDL_Delay ((decoder.tick - lastTick)*tickPeriod);
+                drawFrame (&decoder.frame, decoder.tick, tickPeriod);
+            }
+            lastTick = decoder.tick;
+        }
+        if (n < 0)
+        {
+            fprintf(stderr, "The spectator stream is not correct\n");
+            return EXIT_FAILURE;
+        }
+
+        length -= used;
+        memmove (buffer, buffer + used, length);
+    }
+
+    if (decoder.synced && !verbose)
+        drawFrame (&decoder.frame, decoder.tick, tickPeriod);
+    if (tickPeriod > 0 && decoder.tick > 0)
+        fprintf(stdout, "%u frames, %llu bytes for %.1f s of game : %.0f bytes per second\n", nbFrames,
+                (unsigned long long)nbBytes, decoder.tick*tickPeriod/1000.0, nbBytes*1000.0/(decoder.tick*tickPeriod));
+
+    if (file != stdin)
+        fclose (file);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+/**
+ *
+ *  tbpbot.cpp is a bot that speaks the Tetris Bot Protocol (see tbp.h) with the AI of the game (see ai.h).
+ *  It must be linked with the source files of the game, except main.cpp.
+ *  It reads the messages of the front-end in the stdin file and answers in the stdout file.
+ *  With -b, the openings are played from an opening book (see book.h) and the algorithm only searches
+ *  the positions which are not in it.
+ *
+ *  Usage : tbpbot [-a greedy|next|expectimax] [-b book] [-n name]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../sim.h"
+#include "../ai.h"
+#include "../search.h"
+#include "../book.h"
+#include "../tbp.h"
+
+enum { BOT_GREEDY, BOT_NEXT, BOT_EXPECTIMAX };
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : tbpbot [-a greedy|next|expectimax] [-b book] [-n name]\n");
+}
+
+static void sendMessage (const TBP_Buffer *buffer)
+{
+    fwrite (buffer->data, 1, buffer->length, stdout);
+    fflush (stdout);
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    static char line[TBP_MAX_MESSAGE];
+    static TBP_Buffer buffer;
+    const char *name = "Urban Tetrims AI", *bookName = NULL;
+    OpeningBook *book = NULL;
+    AI_Weights weights;
+    SearchParams params;
+    SimGame game;
+    Placement placement;
+    int queue[TBP_MAX_QUEUE], nbQueue = 0, algorithm = BOT_NEXT, tetrim, n;
+    Uint8 placed, continueBot = 1; /* Booleans */
+
+    for (n = 1; n < argc; n += 2)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        if (argv[n][1] == 'n')
+            name = argv[n+1];
+        else if (argv[n][1] == 'b')
+            bookName = argv[n+1];
+        else if (argv[n][1] == 'a' && strcmp (argv[n+1], "greedy") == 0)
+            algorithm = BOT_GREEDY;
+        else if (argv[n][1] == 'a' && strcmp (argv[n+1], "next") == 0)
+            algorithm = BOT_NEXT;
+        else if (argv[n][1] == 'a' && strcmp (argv[n+1], "expectimax") == 0)
+            algorithm = BOT_EXPECTIMAX;
+        else
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bookName != NULL)
+    {
+        book = BOOK_open (bookName);
+        if (book == NULL)
+            return EXIT_FAILURE;
+    }
+
+    AI_defaultWeights (&weights);
+    SRCH_defaultParams (&params);
+    SIM_init (&game, 1);
+
+    TBP_encodeInfo (&buffer, name);
+    sendMessage (&buffer);
+
+    while (continueBot && fgets (line, TBP_MAX_MESSAGE, stdin) != NULL)
+    {
+        switch (TBP_messageType (line))
+        {
+            case TBP_MSG_RULES:
+                TBP_encodeReady (&buffer);
+                sendMessage (&buffer);
+                break;
+            case TBP_MSG_START:
+                if (!TBP_decodeStart (line, &game.board, queue, &nbQueue))
+                    nbQueue = 0;
+                break;
+            case TBP_MSG_SUGGEST:
+                placed = 0;
+                if (nbQueue > 0)
+                {
+                    game.actualTetrim = queue[0];
+                    game.nextTetrim = (nbQueue > 1) ? queue[1] : queue[0];
+                    game.bag = 0;
+                    /* The book is keyed by the next tetrimino too */
+                    if (book != NULL && nbQueue > 1
+                        && BOOK_lookup (book, &game.board, game.actualTetrim, game.nextTetrim, &placement))
+                        placed = 1;
+                    else if (algorithm == BOT_GREEDY || nbQueue < 2)
+                        placed = AI_bestPlacement (&game, &weights, &placement);
+                    else if (algorithm == BOT_NEXT)
+                        placed = AI_bestPlacementWithNext (&game, &weights, &placement);
+                    else
+                        placed = SRCH_expectimax (&game, &weights, &params, &placement, NULL);
+                }
+                TBP_encodeSuggestion (&buffer, game.actualTetrim, &placement, placed ? 1 : 0);
+                sendMessage (&buffer);
+                break;
+            case TBP_MSG_PLAY:
+                if (nbQueue > 0 && TBP_decodeMove (line, 0, &tetrim, &placement))
+                {
+                    BB_putPiece (&game.board, tetrim, placement.rotation, placement.x, placement.y);
+                    BB_clearLines (&game.board);
+                    nbQueue--;
+                    memmove (queue, queue+1, sizeof(int)*nbQueue);
+                }
+                break;
+            case TBP_MSG_NEW_PIECE:
+                tetrim = TBP_decodeNewPiece (line);
+                if (tetrim >= 0 && nbQueue < TBP_MAX_QUEUE)
+                    queue[nbQueue++] = tetrim;
+                break;
+            case TBP_MSG_STOP:
+                nbQueue = 0;
+                break;
+            case TBP_MSG_QUIT:
+                continueBot = 0;
+                break;
+            default:
+                break;
+        }
+    }
+
+    BOOK_close (book);
+
+    return EXIT_SUCCESS;
+}
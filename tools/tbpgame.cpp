@@ -0,0 +1,88 @@
+/**
+ *
+ *  tbpgame.cpp plays games without window, driven by a bot that speaks the Tetris Bot Protocol (see tbp.h).
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  The messages are sent to the bot in the stdout file and the answers are read in the stdin file,
+ *  so the two programs are connected with pipes, for example :
+ *      mkfifo to_game
+ *      tbpgame -g 10 < to_game | tbpbot > to_game
+ *  The results and the measures of the protocol are printed in the stderr file.
+ *  On Windows, the game itself cannot speak on its standard files (see -tbp in main.cpp) : tbpgame is the front-end then.
+ *
+ *  Usage : tbpgame [-g games] [-m maxPieces] [-s seed]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../tbp.h"
+#include "../platform.h"
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : tbpgame [-g games] [-m maxPieces] [-s seed]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    static TBP_Session session; /* Too big for the stack of some systems */
+    int nbGames = 1, maxPieces = 0, nbPieces = 0, g, n;
+    Uint32 seed = 2463534242u;
+    Uint64 startTime, time, totalScore = 0, totalPieces = 0;
+
+    for (n = 1; n < argc; n++)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'g':
+                nbGames = atoi (argv[++n]);
+                break;
+            case 'm':
+                maxPieces = atoi (argv[++n]);
+                break;
+            case 's':
+                seed = strtoul (argv[++n], NULL, 10);
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!TBP_openSession (&session, stdin, stdout))
+        return EXIT_FAILURE;
+
+    startTime = PLT_getTimeUs ();
+    for (g = 0; g < nbGames; g++)
+    {
+        totalScore += TBP_playGame (&session, BB_random (&seed) | 1, maxPieces, &nbPieces);
+        totalPieces += nbPieces;
+    }
+    time = PLT_getTimeUs () - startTime;
+    TBP_closeSession (&session);
+
+    fprintf(stderr, "Bot %s : %d games, %.0f points and %.1f tetriminoes per game\n", session.botName, nbGames,
+            nbGames ? (double)totalScore/nbGames : 0.0, nbGames ? (double)totalPieces/nbGames : 0.0);
+    fprintf(stderr, "%.0f moves/s, %.1f us per move waiting for the bot, %.3f us per move to write and read the messages\n",
+            time ? totalPieces*1e6/time : 0.0, totalPieces ? (double)session.waitingTime/totalPieces : 0.0,
+            totalPieces ? (double)session.encodingTime/totalPieces : 0.0);
+    fprintf(stderr, "%u messages sent (%.0f bytes per move), %u received (%.0f bytes per move)\n",
+            session.nbSent, totalPieces ? (double)session.bytesSent/totalPieces : 0.0,
+            session.nbReceived, totalPieces ? (double)session.bytesReceived/totalPieces : 0.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/**
+ *
+ *  telemetry.cpp shows the telemetry of a running game (see telemetry.h) in the terminal.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  The game must have been started with "-telemetry [name]". The snapshot is read rate times per second,
+ *  count times (0 to read until the dashboard is interrupted). Each read is a copy of the mapped segment,
+ *  so the dashboard does not slow the game down, whatever the rate.
+ *
+ *  Usage : telemetry [-n name] [-r rate] [-c count]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../game.h"
+#include "../bitboard.h"
+#include "../telemetry.h"
+
+/* Draws the playfield, the hidden lines excepted, and the measures of the snapshot */
+static void drawSnapshot (const TLM_Snapshot *snapshot)
+{
+    /* Variables */
+    static const char letters[] = "IOTLJZS";
+    const PieceShape *shape = NULL;
+    char line[NB_BLOCK_X+1];
+    int i, j, l;
+
+    if (snapshot->active)
+        shape = BB_getShape (snapshot->tetrim, snapshot->rotation);
+
+    fprintf(stdout, "\033[H\033[2J");
+    fprintf(stdout, "Frame %u   Time %.1f s   Score %u   Level %u   Lines %u   Next %c%s\n",
+            snapshot->frame, snapshot->gameTime/1000.0, snapshot->score, snapshot->level,
+            snapshot->nbCompleteLines, letters[snapshot->nextTetrim % 7], snapshot->over ? "   GAME OVER" : "");
+    fprintf(stdout, "Frame interval %.1f ms (max %.1f)   Refresh %.2f ms (max %.2f)\n",
+            snapshot->frameInterval/1000.0, snapshot->maxFrameInterval/1000.0,
+            snapshot->renderTime/1000.0, snapshot->maxRenderTime/1000.0);
+    fprintf(stdout, "Inputs : left %u   right %u   rotate %u   down %u   pause %u   other %u\n",
+            snapshot->inputs[TLM_INPUT_LEFT], snapshot->inputs[TLM_INPUT_RIGHT], snapshot->inputs[TLM_INPUT_ROTATE],
+            snapshot->inputs[TLM_INPUT_DOWN], snapshot->inputs[TLM_INPUT_PAUSE], snapshot->inputs[TLM_INPUT_OTHER]);
+    for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+    {
+        for (i = 0; i < NB_BLOCK_X; i++)
+        {
+            line[i] = (snapshot->cells[j][i] != BLOCK_VOID) ? '#' : '.';
+            l = j - snapshot->y;
+            if (shape != NULL && l >= 0 && l < 4 && i - snapshot->x >= 0 && (shape->rows[l] & (1 << (i - snapshot->x))))
+                line[i] = '@';
+        }
+        line[NB_BLOCK_X] = '\0';
+        fprintf(stdout, "|%s|\n", line);
+    }
+    fflush (stdout);
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : telemetry [-n name] [-r rate] [-c count]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    const char *name = TLM_DEFAULT_NAME;
+    TLM_Mapping *mapping = NULL;
+    TLM_Snapshot snapshot;
+    int rate = 10, count = 0, n;
+    Uint32 nbFailed = 0;
+
+    for (n = 1; n < argc; n++)
+    {
+        if (strcmp (argv[n], "-n") == 0 && n+1 < argc)
+            name = argv[++n];
+        else if (strcmp (argv[n], "-r") == 0 && n+1 < argc)
+            rate = atoi (argv[++n]);
+        else if (strcmp (argv[n], "-c") == 0 && n+1 < argc)
+            count = atoi (argv[++n]);
+        else
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+    }
+    if (rate <= 0)
+        rate = 1;
+
+    mapping = TLM_openReader (name);
+    if (mapping == NULL)
+        return EXIT_FAILURE;
+
+    for (n = 0; count == 0 || n < count; n++)
+    {
+        if (TLM_read (mapping, &snapshot))
+            drawSnapshot (&snapshot);
+        else
+            nbFailed++;
+        SDL_Delay (1000/rate);
+    }
+
+    if (nbFailed > 0)
+        fprintf(stdout, "%u reads without a complete snapshot\n", nbFailed);
+    TLM_close (mapping);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,390 @@
+/**
+ *
+ *  tournament.cpp rates bots by making them play versus matches against each other (see versus.h).
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  Every pair of bots plays the same number of seeded matches (round-robin), each bot being the first
+ *  player in half of them. The matches are shared between threads.
+ *  The Elo ratings are the ones that best explain all the results together (Bradley-Terry model),
+ *  so they do not depend on the order in which the matches end. The average rating is 1500.
+ *  A match that nobody has lost after maxPieces tetriminoes is decided by the garbage lines made, then by the
+ *  height of the stacks (see versus.h). The draw rate is printed next to the ratings : a high one means that
+ *  the ratings rest on few decisive matches.
+ *
+ *  Bots : greedy (AI_bestPlacement), next (AI_bestPlacementWithNext), beam (SRCH_beam of width 8),
+ *         expectimax (SRCH_expectimax of depth 1 on one thread)
+ *
+ *  Usage : tournament [-b bot,bot,...] [-g matchesPerPair] [-m maxPieces] [-t threads] [-s seed]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../sim.h"
+#include "../ai.h"
+#include "../search.h"
+#include "../versus.h"
+#include "../platform.h"
+
+#define MAX_BOTS            16
+#define ELO_ITERATIONS      1000
+
+enum {BOT_GREEDY, BOT_NEXT, BOT_BEAM, BOT_EXPECTIMAX, NB_BOT_KINDS};
+
+typedef struct Bot Bot;
+typedef struct Tournament Tournament;
+
+struct Bot
+{
+    int kind;
+    AI_Weights weights;
+    SearchParams params;
+
+    /* Results */
+    Uint32 wins, draws, losses;
+    double elo;
+};
+
+struct Tournament
+{
+    Bot bots[MAX_BOTS];
+    int nbBots;
+    int matchesPerPair;
+    int maxPieces;
+    Uint32 seed;
+
+    /* Shared by the worker threads. A job is one match of one pair of bots */
+    SDL_mutex *lock;
+    int nextJob;
+    int nbJobs;
+    Uint8 *winners; /* VS_NB_PLAYERS+1 values : 0 and 1 are the players of the match, VS_DRAW a draw */
+    Uint64 nbPieces;
+    int nbCapped; /* Matches decided at the limit of tetriminoes */
+};
+
+static const char *botNames[NB_BOT_KINDS] = {"greedy", "next", "beam", "expectimax"};
+
+static Uint8 chooseWithBot (const SimGame *game, void *data, Placement *placement)
+{
+    const Bot *bot = (const Bot*)data;
+
+    switch (bot->kind)
+    {
+        case BOT_GREEDY:
+            return AI_bestPlacement (game, &bot->weights, placement);
+        case BOT_NEXT:
+            return AI_bestPlacementWithNext (game, &bot->weights, placement);
+        case BOT_BEAM:
+            return SRCH_beam (game, &bot->weights, 8, placement, NULL);
+        default:
+            return SRCH_expectimax (game, &bot->weights, &bot->params, placement, NULL);
+    }
+}
+
+/* Gives the bots of a job, the first player first */
+static void jobPlayers (const Tournament *tournament, int job, int *first, int *second)
+{
+    int pair = job / tournament->matchesPerPair, a, b;
+
+    /* Pairs in the order (0, 1), (0, 2)... (1, 2)... */
+    for (a = 0; pair >= tournament->nbBots - 1 - a; a++)
+        pair -= tournament->nbBots - 1 - a;
+    b = a + 1 + pair;
+
+    /* Each bot starts half of the matches of the pair */
+    if ((job % tournament->matchesPerPair) % 2 == 0)
+    {
+        *first = a;
+        *second = b;
+    }
+    else
+    {
+        *first = b;
+        *second = a;
+    }
+}
+
+static int worker (void *data)
+{
+    Tournament *tournament = (Tournament*)data;
+    VS_ChooseFunc choose[VS_NB_PLAYERS] = {chooseWithBot, chooseWithBot};
+    void *players[VS_NB_PLAYERS];
+    VS_Match match;
+    Uint32 seed;
+    int job, first, second;
+
+    while (1)
+    {
+        SDL_LockMutex (tournament->lock);
+        job = tournament->nextJob++;
+        SDL_UnlockMutex (tournament->lock);
+
+        if (job >= tournament->nbJobs)
+            break;
+
+        /* Both orders of a pair play the same tetriminoes */
+        jobPlayers (tournament, job, &first, &second);
+        players[0] = &tournament->bots[first];
+        players[1] = &tournament->bots[second];
+        seed = tournament->seed ^ (Uint32)((job % tournament->matchesPerPair) / 2 * 2654435761u);
+        BB_random (&seed);
+        tournament->winners[job] = VS_playMatch (&match, seed | 1, tournament->maxPieces, choose, players);
+
+        SDL_LockMutex (tournament->lock);
+        tournament->nbPieces += match.players[0].game.nbPieces + match.players[1].game.nbPieces;
+        tournament->nbCapped += match.capped;
+        SDL_UnlockMutex (tournament->lock);
+    }
+
+    return 0;
+}
+
+/* Plays all the matches on nbThreads threads */
+static Uint8 playMatches (Tournament *tournament, int nbThreads)
+{
+    SDL_Thread **threads = NULL;
+    int n;
+
+    tournament->nbJobs = tournament->nbBots*(tournament->nbBots - 1)/2*tournament->matchesPerPair;
+    tournament->nextJob = 0;
+    tournament->nbPieces = 0;
+    tournament->nbCapped = 0;
+    tournament->winners = (Uint8*)malloc(tournament->nbJobs);
+    threads = (SDL_Thread**)malloc(sizeof(SDL_Thread*)*nbThreads);
+    tournament->lock = SDL_CreateMutex ();
+    if (tournament->winners == NULL || threads == NULL || tournament->lock == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the matches\n");
+        if (tournament->lock != NULL)
+            SDL_DestroyMutex (tournament->lock);
+        free (tournament->winners);
+        tournament->winners = NULL;
+        free (threads);
+        return 0;
+    }
+
+    for (n = 0; n < nbThreads; n++)
+        threads[n] = SDL_CreateThread (worker, tournament);
+    for (n = 0; n < nbThreads; n++)
+    {
+        /* If a thread could not be created, the work is done by the remaining ones or by this one */
+        if (threads[n] != NULL)
+            SDL_WaitThread (threads[n], NULL);
+        else
+            worker (tournament);
+    }
+
+    SDL_DestroyMutex (tournament->lock);
+    free (threads);
+
+    return 1;
+}
+
+/* Counts the results of each bot and computes the Elo ratings */
+static void rateBots (Tournament *tournament)
+{
+    /* Variables */
+    double score[MAX_BOTS][MAX_BOTS]; /* Points of i against j, a draw being half a point */
+    double strength[MAX_BOTS], next[MAX_BOTS];
+    double points, games, mean;
+    int job, first, second, winner, i, j, k;
+
+    for (i = 0; i < tournament->nbBots; i++)
+    {
+        tournament->bots[i].wins = tournament->bots[i].draws = tournament->bots[i].losses = 0;
+        for (j = 0; j < tournament->nbBots; j++)
+            score[i][j] = (i != j) ? 0.5 : 0.0; /* One draw more per pair, so a bot that never wins keeps a rating */
+        strength[i] = 1.0;
+    }
+
+    for (job = 0; job < tournament->nbJobs; job++)
+    {
+        jobPlayers (tournament, job, &first, &second);
+        winner = tournament->winners[job];
+        if (winner == VS_DRAW)
+        {
+            tournament->bots[first].draws++;
+            tournament->bots[second].draws++;
+            score[first][second] += 0.5;
+            score[second][first] += 0.5;
+        }
+        else
+        {
+            i = (winner == 0) ? first : second;
+            j = (winner == 0) ? second : first;
+            tournament->bots[i].wins++;
+            tournament->bots[j].losses++;
+            score[i][j] += 1.0;
+        }
+    }
+
+    /* Bradley-Terry : the strength of a bot is its points divided by the points it was expected to make */
+    for (k = 0; k < ELO_ITERATIONS; k++)
+    {
+        for (i = 0; i < tournament->nbBots; i++)
+        {
+            points = 0.0;
+            games = 0.0;
+            for (j = 0; j < tournament->nbBots; j++)
+            {
+                if (j == i)
+                    continue;
+                points += score[i][j];
+                games += (score[i][j] + score[j][i])/(strength[i] + strength[j]);
+            }
+            next[i] = points/games;
+        }
+        for (i = 0; i < tournament->nbBots; i++)
+            strength[i] = next[i];
+    }
+
+    mean = 0.0;
+    for (i = 0; i < tournament->nbBots; i++)
+    {
+        tournament->bots[i].elo = 400.0*log10 (strength[i]);
+        mean += tournament->bots[i].elo/tournament->nbBots;
+    }
+    for (i = 0; i < tournament->nbBots; i++)
+        tournament->bots[i].elo += 1500.0 - mean;
+}
+
+/* Reads a list of bot names separated by commas. Returns a boolean : 0 if a name is unknown */
+static Uint8 readBots (Tournament *tournament, const char *list)
+{
+    const char *name = list;
+    int length, kind;
+
+    tournament->nbBots = 0;
+    while (*name != '\0')
+    {
+        length = strcspn (name, ",");
+        for (kind = 0; kind < NB_BOT_KINDS; kind++)
+        {
+            if ((int)strlen (botNames[kind]) == length && strncmp (name, botNames[kind], length) == 0)
+                break;
+        }
+        if (kind == NB_BOT_KINDS || tournament->nbBots == MAX_BOTS)
+        {
+            fprintf(stderr, "Unknown bot %.*s, or more than %d bots\n", length, name, MAX_BOTS);
+            return 0;
+        }
+
+        tournament->bots[tournament->nbBots].kind = kind;
+        AI_defaultWeights (&tournament->bots[tournament->nbBots].weights);
+        SRCH_defaultParams (&tournament->bots[tournament->nbBots].params);
+        tournament->bots[tournament->nbBots].params.maxDepth = 1;
+        tournament->bots[tournament->nbBots].params.timeBudget = 0;
+        tournament->bots[tournament->nbBots].params.nbThreads = 1; /* The matches already use all the threads */
+        tournament->nbBots++;
+
+        name += length;
+        if (*name == ',')
+            name++;
+    }
+
+    return tournament->nbBots >= 2;
+}
+
+static int compareElo (const void *a, const void *b)
+{
+    double ea = ((const Bot*)a)->elo, eb = ((const Bot*)b)->elo;
+
+    return (ea < eb) - (ea > eb); /* Best bots first */
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : tournament [-b bot,bot,...] [-g matchesPerPair] [-m maxPieces] [-t threads] [-s seed]\n");
+    fprintf(stderr, "    bots : greedy, next, beam, expectimax\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    Tournament tournament;
+    const char *botList = "greedy,next,beam";
+    Uint64 startTime, time;
+    int nbThreads = PLT_getNbCores ();
+    int nbDraws = 0, n;
+    Bot *bot = NULL;
+
+    tournament.matchesPerPair = 100;
+    tournament.maxPieces = 1000;
+    tournament.seed = 2463534242u;
+    for (n = 1; n < argc; n += 2)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'b':
+                botList = argv[n+1];
+                break;
+            case 'g':
+                tournament.matchesPerPair = atoi (argv[n+1]);
+                break;
+            case 'm':
+                tournament.maxPieces = atoi (argv[n+1]);
+                break;
+            case 't':
+                nbThreads = atoi (argv[n+1]);
+                break;
+            case 's':
+                tournament.seed = (Uint32)strtoul (argv[n+1], NULL, 10);
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+    if (!readBots (&tournament, botList) || tournament.matchesPerPair < 1 || nbThreads < 1)
+    {
+        printUsage ();
+        return EXIT_FAILURE;
+    }
+
+    /* The shapes are built before the threads use them */
+    BB_getShape (0, 0);
+
+    fprintf(stdout, "%d bots, %d matches per pair of at most %d tetriminoes per player, %d threads\n",
+            tournament.nbBots, tournament.matchesPerPair, tournament.maxPieces, nbThreads);
+    startTime = PLT_getTimeUs ();
+    if (!playMatches (&tournament, nbThreads))
+    {
+        free (tournament.winners);
+        return EXIT_FAILURE;
+    }
+    time = PLT_getTimeUs () - startTime;
+
+    rateBots (&tournament);
+    qsort (tournament.bots, tournament.nbBots, sizeof(Bot), compareElo);
+    fprintf(stdout, "%-12s %6s %6s %6s %6s %10s\n", "Bot", "Elo", "Wins", "Draws", "Losses", "Draw rate");
+    for (n = 0; n < tournament.nbBots; n++)
+    {
+        bot = &tournament.bots[n];
+        fprintf(stdout, "%-12s %6.0f %6u %6u %6u %8.1f %%\n", botNames[bot->kind], bot->elo,
+                bot->wins, bot->draws, bot->losses, 100.0*bot->draws/(bot->wins + bot->draws + bot->losses));
+    }
+    for (n = 0; n < tournament.nbJobs; n++)
+        nbDraws += (tournament.winners[n] == VS_DRAW);
+    fprintf(stdout, "Draws : %d of %d matches (%.1f %%), %d matches decided at the limit of %d tetriminoes\n",
+            nbDraws, tournament.nbJobs, 100.0*nbDraws/tournament.nbJobs, tournament.nbCapped, tournament.maxPieces);
+    fprintf(stdout, "%d matches in %.2f s : %.0f matches per minute, %.1f us per tetrimino\n",
+            tournament.nbJobs, time/1e6, tournament.nbJobs*60e6/(time ? time : 1),
+            (double)time*nbThreads/(tournament.nbPieces ? tournament.nbPieces : 1));
+
+    free (tournament.winners);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,489 @@
+/**
+ *
+ *  trainer.cpp evolves the weights of the AI (see ai.h) with a genetic algorithm.
+ *  It must be linked with the source files of the game, except main.cpp.
+ *
+ *  Each generation, every candidate plays the same seeded games without window, on all the processors.
+ *  Its fitness is its average score, counted with the rules of playGame.
+ *  The population is saved in a checkpoint file after each generation. If the checkpoint file exists
+ *  when the trainer starts, the training resumes from it, with the games and the pieces of the checkpoint :
+ *  -n and -m are refused if they are different, the fitnesses of the population would not be comparable.
+ *
+ *  Usage : trainer [-p population] [-g generations] [-n games] [-m maxPieces] [-t threads] [-s seed] [-c file]
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <SDL/SDL.h>
+
+#include "../constants.h"
+#include "../bitboard.h"
+#include "../sim.h"
+#include "../ai.h"
+#include "../platform.h"
+
+#define CHECKPOINT_MAGIC        "TETRIMS_GA"
+#define CHECKPOINT_VERSION      1
+#define ELITE_RATIO             0.1 /* Part of the population kept as is from a generation to the next */
+#define TOURNAMENT_SIZE         4
+#define MUTATION_RATE           0.15
+#define MUTATION_STRENGTH       0.2
+
+typedef struct Candidate Candidate;
+typedef struct Trainer Trainer;
+
+struct Candidate
+{
+    AI_Weights weights;
+    double fitness;
+};
+
+struct Trainer
+{
+    Candidate *population;
+    int populationSize;
+    int generation; /* Number of generations already evaluated */
+    Uint32 seed; /* State of the random generator of the genetic algorithm */
+    int gamesPerCandidate;
+    int maxPieces;
+
+    /* Shared by the worker threads during an evaluation */
+    SDL_mutex *lock;
+    int nextJob; /* A job is one game of one candidate */
+    int nbJobs;
+    Uint32 *gameSeeds;
+    Uint32 *scores;
+};
+
+/* Returns a random number between -1 and 1 */
+static double randomUnit (Uint32 *seed)
+{
+    return (BB_random (seed) / 4294967295.0)*2.0 - 1.0;
+}
+
+/* Gives a length of 1 to the weights so the candidates are compared on the direction of their weights only */
+static void normalize (AI_Weights *weights)
+{
+    double length = 0.0;
+    int k;
+
+    for (k = 0; k < AI_NB_WEIGHTS; k++)
+        length += weights->w[k]*weights->w[k];
+    length = sqrt (length);
+    if (length == 0.0)
+        return;
+    for (k = 0; k < AI_NB_WEIGHTS; k++)
+        weights->w[k] /= length;
+}
+
+static int compareCandidates (const void *a, const void *b)
+{
+    double fa = ((const Candidate*)a)->fitness, fb = ((const Candidate*)b)->fitness;
+
+    return (fa < fb) - (fa > fb); /* Best candidates first */
+}
+
+static void randomPopulation (Trainer *trainer)
+{
+    int n, k;
+
+    for (n = 0; n < trainer->populationSize; n++)
+    {
+        /* The first candidate starts from the default weights */
+        if (n == 0)
+            AI_defaultWeights (&trainer->population[n].weights);
+        else
+        {
+            for (k = 0; k < AI_NB_WEIGHTS; k++)
+                trainer->population[n].weights.w[k] = randomUnit (&trainer->seed);
+        }
+        normalize (&trainer->population[n].weights);
+        trainer->population[n].fitness = 0.0;
+    }
+}
+
+/* Writes the population in a temporary file, then replaces the checkpoint with it in one step,
+   so an interruption leaves either the previous checkpoint or the new one, never a half written one */
+static Uint8 saveCheckpoint (const Trainer *trainer, const char *fileName)
+{
+    char tmpName[1024];
+    FILE *file = NULL;
+    int n, k;
+
+    sprintf(tmpName, "%.1000s.tmp", fileName);
+    file = fopen (tmpName, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Impossible to write the checkpoint %s\n", tmpName);
+        return 0;
+    }
+
+    fprintf(file, "%s %d\n", CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+    fprintf(file, "generation %d\nseed %u\ngames %d\npieces %d\nweights %d\npopulation %d\n",
+            trainer->generation, trainer->seed, trainer->gamesPerCandidate, trainer->maxPieces,
+            AI_NB_WEIGHTS, trainer->populationSize);
+    for (n = 0; n < trainer->populationSize; n++)
+    {
+        fprintf(file, "%.17g", trainer->population[n].fitness);
+        for (k = 0; k < AI_NB_WEIGHTS; k++)
+            fprintf(file, " %.17g", trainer->population[n].weights.w[k]);
+        fprintf(file, "\n");
+    }
+
+    if (fclose (file) != 0)
+    {
+        fprintf(stderr, "Impossible to write the checkpoint %s\n", tmpName);
+        return 0;
+    }
+
+    if (!PLT_replaceFile (tmpName, fileName))
+    {
+        fprintf(stderr, "Impossible to replace the checkpoint %s\n", fileName);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* Returns 1 if the checkpoint has been loaded, 0 if there is no checkpoint, -1 if the checkpoint is invalid */
+static int loadCheckpoint (Trainer *trainer, const char *fileName)
+{
+    FILE *file = fopen (fileName, "r");
+    char magic[32] = "";
+    int version = 0, nbWeights = 0, populationSize = 0;
+    int n, k, ok;
+
+    if (file == NULL)
+        return 0;
+
+    ok = (fscanf (file, "%31s %d", magic, &version) == 2
+          && strcmp (magic, CHECKPOINT_MAGIC) == 0 && version == CHECKPOINT_VERSION
+          && fscanf (file, " generation %d seed %u games %d pieces %d weights %d population %d",
+                     &trainer->generation, &trainer->seed, &trainer->gamesPerCandidate, &trainer->maxPieces,
+                     &nbWeights, &populationSize) == 6
+          && nbWeights == AI_NB_WEIGHTS && populationSize > 0);
+
+    if (ok)
+    {
+        free (trainer->population);
+        trainer->population = (Candidate*)malloc(sizeof(Candidate)*populationSize);
+        trainer->populationSize = populationSize;
+        ok = (trainer->population != NULL);
+    }
+    for (n = 0; ok && n < populationSize; n++)
+    {
+        ok = (fscanf (file, "%lf", &trainer->population[n].fitness) == 1);
+        for (k = 0; ok && k < AI_NB_WEIGHTS; k++)
+            ok = (fscanf (file, "%lf", &trainer->population[n].weights.w[k]) == 1);
+    }
+
+    fclose (file);
+    if (!ok)
+    {
+        fprintf(stderr, "The checkpoint %s is invalid\n", fileName);
+        return -1;
+    }
+
+    return 1;
+}
+
+static int worker (void *data)
+{
+    Trainer *trainer = (Trainer*)data;
+    int job;
+
+    while (1)
+    {
+        SDL_LockMutex (trainer->lock);
+        job = trainer->nextJob++;
+        SDL_UnlockMutex (trainer->lock);
+
+        if (job >= trainer->nbJobs)
+            break;
+
+        trainer->scores[job] = AI_playGame (&trainer->population[job / trainer->gamesPerCandidate].weights,
+                                            trainer->gameSeeds[job % trainer->gamesPerCandidate],
+                                            trainer->maxPieces);
+    }
+
+    return 0;
+}
+
+/* Plays all the games of a generation on nbThreads threads and computes the fitness of each candidate */
+static Uint8 evaluatePopulation (Trainer *trainer, int nbThreads)
+{
+    SDL_Thread **threads = NULL;
+    Uint32 seed = 0x9E3779B9u ^ (Uint32)(trainer->generation + 1);
+    int n, g;
+
+    trainer->nbJobs = trainer->populationSize*trainer->gamesPerCandidate;
+    trainer->nextJob = 0;
+    trainer->scores = (Uint32*)malloc(sizeof(Uint32)*trainer->nbJobs);
+    trainer->gameSeeds = (Uint32*)malloc(sizeof(Uint32)*trainer->gamesPerCandidate);
+    threads = (SDL_Thread**)malloc(sizeof(SDL_Thread*)*nbThreads);
+    if (trainer->scores == NULL || trainer->gameSeeds == NULL || threads == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the evaluation\n");
+        free (trainer->scores);
+        free (trainer->gameSeeds);
+        free (threads);
+        return 0;
+    }
+
+    /* All the candidates of a generation play the same games */
+    for (g = 0; g < trainer->gamesPerCandidate; g++)
+        trainer->gameSeeds[g] = BB_random (&seed) | 1;
+
+    for (n = 0; n < nbThreads; n++)
+        threads[n] = SDL_CreateThread (worker, trainer);
+    for (n = 0; n < nbThreads; n++)
+    {
+        /* If a thread could not be created, the work is done by the remaining ones or by this one */
+        if (threads[n] != NULL)
+            SDL_WaitThread (threads[n], NULL);
+        else
+            worker (trainer);
+    }
+
+    for (n = 0; n < trainer->populationSize; n++)
+    {
+        trainer->population[n].fitness = 0.0;
+        for (g = 0; g < trainer->gamesPerCandidate; g++)
+            trainer->population[n].fitness += trainer->scores[n*trainer->gamesPerCandidate + g];
+        trainer->population[n].fitness /= trainer->gamesPerCandidate;
+    }
+
+    free (trainer->scores);
+    free (trainer->gameSeeds);
+    free (threads);
+
+    return 1;
+}
+
+/* Returns the best of TOURNAMENT_SIZE candidates picked at random */
+static const Candidate* tournament (Trainer *trainer)
+{
+    const Candidate *best = NULL, *candidate = NULL;
+    int k;
+
+    for (k = 0; k < TOURNAMENT_SIZE; k++)
+    {
+        candidate = &trainer->population[BB_random (&trainer->seed) % trainer->populationSize];
+        if (best == NULL || candidate->fitness > best->fitness)
+            best = candidate;
+    }
+
+    return best;
+}
+
+/* Replaces the population by its children. The population must be evaluated first */
+static Uint8 nextGeneration (Trainer *trainer)
+{
+    Candidate *children = (Candidate*)malloc(sizeof(Candidate)*trainer->populationSize);
+    const Candidate *mother = NULL, *father = NULL;
+    double total;
+    int nbElite, n, k;
+
+    if (children == NULL)
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the new generation\n");
+        return 0;
+    }
+
+    qsort (trainer->population, trainer->populationSize, sizeof(Candidate), compareCandidates);
+
+    nbElite = trainer->populationSize*ELITE_RATIO;
+    if (nbElite < 1)
+        nbElite = 1;
+
+    for (n = 0; n < trainer->populationSize; n++)
+    {
+        if (n < nbElite)
+        {
+            children[n] = trainer->population[n];
+            continue;
+        }
+
+        /* Crossover : average of both parents weighted by their fitness */
+        mother = tournament (trainer);
+        father = tournament (trainer);
+        total = mother->fitness + father->fitness;
+        for (k = 0; k < AI_NB_WEIGHTS; k++)
+        {
+            if (total > 0.0)
+                children[n].weights.w[k] = (mother->fitness*mother->weights.w[k] + father->fitness*father->weights.w[k])/total;
+            else
+                children[n].weights.w[k] = (mother->weights.w[k] + father->weights.w[k])/2;
+
+            /* Mutation */
+            if ((BB_random (&trainer->seed) % 1000) < MUTATION_RATE*1000)
+                children[n].weights.w[k] += randomUnit (&trainer->seed)*MUTATION_STRENGTH;
+        }
+        normalize (&children[n].weights);
+        children[n].fitness = 0.0;
+    }
+
+    free (trainer->population);
+    trainer->population = children;
+
+    return 1;
+}
+
+/* Destroys the mutex and frees the population, on every exit of the trainer */
+static void freeTrainer (Trainer *trainer)
+{
+    SDL_DestroyMutex (trainer->lock);
+    free (trainer->population);
+    trainer->population = NULL;
+}
+
+static void printUsage ()
+{
+    fprintf(stderr, "Usage : trainer [-p population] [-g generations] [-n games] [-m maxPieces] [-t threads] [-s seed] [-c file]\n");
+}
+
+int main ( int argc, char** argv )
+{
+    /* Variables */
+    Trainer trainer;
+    const char *checkpoint = "trainer.ckpt";
+    int nbThreads = PLT_getNbCores ();
+    int nbGenerations = 50, populationSize = 0;
+    int gamesPerCandidate = 0, maxPieces = 0; /* Given with -n and -m, 0 if not */
+    int n, k, loaded;
+    Uint64 startTime, elapsed;
+    double average;
+
+    trainer.population = NULL;
+    trainer.generation = 0;
+    trainer.seed = 20140704u;
+    trainer.gamesPerCandidate = 8;
+    trainer.maxPieces = 1000;
+
+    for (n = 1; n < argc; n++)
+    {
+        if (n+1 >= argc || argv[n][0] != '-')
+        {
+            printUsage ();
+            return EXIT_FAILURE;
+        }
+        switch (argv[n][1])
+        {
+            case 'p':
+                populationSize = atoi (argv[++n]);
+                break;
+            case 'g':
+                nbGenerations = atoi (argv[++n]);
+                break;
+            case 'n':
+                gamesPerCandidate = atoi (argv[++n]);
+                break;
+            case 'm':
+                maxPieces = atoi (argv[++n]);
+                break;
+            case 't':
+                nbThreads = atoi (argv[++n]);
+                break;
+            case 's':
+                trainer.seed = strtoul (argv[++n], NULL, 10);
+                break;
+            case 'c':
+                checkpoint = argv[++n];
+                break;
+            default:
+                printUsage ();
+                return EXIT_FAILURE;
+        }
+    }
+    if (nbThreads < 1)
+        nbThreads = 1;
+    if (trainer.seed == 0)
+        trainer.seed = 1;
+    if (gamesPerCandidate > 0)
+        trainer.gamesPerCandidate = gamesPerCandidate;
+    if (maxPieces > 0)
+        trainer.maxPieces = maxPieces;
+
+    /* The population grows with the number of processors, so does the number of games per generation */
+    if (populationSize <= 0)
+        populationSize = 16*nbThreads;
+
+    trainer.lock = SDL_CreateMutex ();
+    if (trainer.lock == NULL)
+    {
+        fprintf(stderr, "Impossible to create the mutex of the trainer\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Resumes the training or creates a new population */
+    loaded = loadCheckpoint (&trainer, checkpoint);
+    if (loaded < 0)
+    {
+        freeTrainer (&trainer);
+        return EXIT_FAILURE;
+    }
+    else if (loaded && ((gamesPerCandidate > 0 && gamesPerCandidate != trainer.gamesPerCandidate)
+                        || (maxPieces > 0 && maxPieces != trainer.maxPieces)))
+    {
+        fprintf(stderr, "The checkpoint %s was made with %d games of %d pieces : -n and -m cannot change them\n",
+                checkpoint, trainer.gamesPerCandidate, trainer.maxPieces);
+        freeTrainer (&trainer);
+        return EXIT_FAILURE;
+    }
+    else if (loaded)
+        fprintf(stdout, "Resuming from %s : generation %d, %d candidates\n", checkpoint, trainer.generation, trainer.populationSize);
+    else
+    {
+        trainer.populationSize = populationSize;
+        trainer.population = (Candidate*)malloc(sizeof(Candidate)*trainer.populationSize);
+        if (trainer.population == NULL)
+        {
+            fprintf(stderr, "An error occurred during memory allocation for the population\n");
+            freeTrainer (&trainer);
+            return EXIT_FAILURE;
+        }
+        randomPopulation (&trainer);
+    }
+
+    /* The shapes are built before the threads start */
+    BB_getShape (0, 0);
+
+    while (trainer.generation < nbGenerations)
+    {
+        startTime = PLT_getTimeUs ();
+        if (!evaluatePopulation (&trainer, nbThreads))
+            break;
+        elapsed = PLT_getTimeUs () - startTime;
+
+        average = 0.0;
+        for (n = 0; n < trainer.populationSize; n++)
+            average += trainer.population[n].fitness;
+        average /= trainer.populationSize;
+
+        if (!nextGeneration (&trainer))
+            break;
+        trainer.generation++;
+
+        fprintf(stdout, "Generation %d : best %.0f, average %.0f, %d games in %.1f s (%.0f games/s on %d threads)\n",
+                trainer.generation, trainer.population[0].fitness, average,
+                trainer.populationSize*trainer.gamesPerCandidate, elapsed/1000000.0,
+                trainer.populationSize*trainer.gamesPerCandidate*1000000.0/(elapsed+1), nbThreads);
+        fprintf(stdout, "    weights :");
+        for (k = 0; k < AI_NB_WEIGHTS; k++)
+            fprintf(stdout, " %.4f", trainer.population[0].weights.w[k]);
+        fprintf(stdout, "\n");
+        fflush (stdout);
+
+        if (!saveCheckpoint (&trainer, checkpoint))
+            break;
+    }
+
+    freeTrainer (&trainer);
+
+    return EXIT_SUCCESS;
+}
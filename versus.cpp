@@ -0,0 +1,222 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "bitboard.h"
+#include "sim.h"
+#include "ai.h"
+#include "platform.h"
+#include "versus.h"
+
+int VS_garbageLines (int nbLines)
+{
+    /* Single, double, triple, tetris */
+    static const int garbage[5] = {0, 0, 1, 2, 4};
+
+    if (nbLines < 0)
+        return 0;
+    return garbage[(nbLines < 4) ? nbLines : 4];
+}
+
+Uint8 VS_addGarbage (Bitboard *board, int nbLines, int hole)
+{
+    /* Variables */
+    Uint16 garbage = (Uint16)(BB_FULL_ROW & ~(1 << hole));
+    Uint16 pushedOut = 0;
+    int l;
+
+    if (nbLines <= 0)
+        return 0;
+    if (nbLines > NB_BLOCK_Y)
+        nbLines = NB_BLOCK_Y;
+
+    /* The lines that leave the playfield are the first ones */
+    for (l = 0; l < nbLines; l++)
+        pushedOut |= board->rows[l];
+
+    /* One move of the lines of the playfield, the floor stays where it is */
+    memmove (&board->rows[0], &board->rows[nbLines], (NB_BLOCK_Y - nbLines)*sizeof(Uint16));
+    for (l = NB_BLOCK_Y - nbLines; l < NB_BLOCK_Y; l++)
+        board->rows[l] = garbage;
+
+    return pushedOut != 0;
+}
+
+void VS_init (VS_Match *match, Uint32 seed)
+{
+    int p;
+
+    for (p = 0; p < VS_NB_PLAYERS; p++)
+    {
+        SIM_init (&match->players[p].game, seed);
+        match->players[p].pendingLines = 0;
+        match->players[p].linesSent = 0;
+        match->players[p].linesMade = 0;
+        match->players[p].linesReceived = 0;
+        match->players[p].garbageSeed = (seed ^ 0x9E3779B9u) | 1;
+    }
+    match->winner = VS_PLAYING;
+    match->capped = 0;
+}
+
+/* Marks the player as lost, the other one wins */
+static void lose (VS_Match *match, int player)
+{
+    match->players[player].game.over = 1;
+    if (match->winner == VS_PLAYING)
+        match->winner = (player + 1) % VS_NB_PLAYERS;
+}
+
+int VS_play (VS_Match *match, int player, const Placement *placement)
+{
+    /* Variables */
+    VS_Player *self = &match->players[player];
+    VS_Player *opponent = &match->players[(player + 1) % VS_NB_PLAYERS];
+    SimGame *game = &self->game;
+    int nbLines, sent, cancelled;
+
+    if (match->winner != VS_PLAYING || game->over)
+        return 0;
+
+    nbLines = SIM_play (game, placement);
+    if (game->over)
+    {
+        lose (match, player);
+        return 0;
+    }
+
+    sent = VS_garbageLines (nbLines);
+    if (sent > 0)
+    {
+        self->linesMade += sent;
+        cancelled = (sent < self->pendingLines) ? sent : self->pendingLines;
+        self->pendingLines -= cancelled;
+        sent -= cancelled;
+        opponent->pendingLines += sent;
+        self->linesSent += sent;
+    }
+    else if (nbLines == 0 && self->pendingLines > 0)
+    {
+        self->linesReceived += self->pendingLines;
+        if (VS_addGarbage (&game->board, self->pendingLines, BB_random (&self->garbageSeed) % NB_BLOCK_X)
+            || BB_collides (&game->board, game->actualTetrim, 0, BB_spawnColumn (game->actualTetrim), FIRST_LINE))
+            lose (match, player);
+        self->pendingLines = 0;
+    }
+
+    return sent;
+}
+
+/* Returns the height of the stack of a player once its waiting lines have risen */
+static int stackHeight (const VS_Player *player)
+{
+    int y = 0;
+
+    while (y < NB_BLOCK_Y && player->game.board.rows[y] == 0)
+        y++;
+
+    return NB_BLOCK_Y - y + player->pendingLines;
+}
+
+/* Decides a match that nobody has lost : the most garbage lines made, then the lowest stack */
+static int decideMatch (const VS_Match *match)
+{
+    const VS_Player *a = &match->players[0], *b = &match->players[1];
+    int heightA, heightB;
+
+    if (a->linesMade != b->linesMade)
+        return (a->linesMade > b->linesMade) ? 0 : 1;
+
+    heightA = stackHeight (a);
+    heightB = stackHeight (b);
+    if (heightA != heightB)
+        return (heightA < heightB) ? 0 : 1;
+
+    return VS_DRAW;
+}
+
+int VS_playMatch (VS_Match *match, Uint32 seed, int maxPieces, VS_ChooseFunc choose[VS_NB_PLAYERS], void *data[VS_NB_PLAYERS])
+{
+    Placement placement;
+    int p;
+
+    VS_init (match, seed);
+    while (match->winner == VS_PLAYING)
+    {
+        for (p = 0; p < VS_NB_PLAYERS && match->winner == VS_PLAYING; p++)
+        {
+            if (choose[p] (&match->players[p].game, data[p], &placement))
+                VS_play (match, p, &placement);
+            else
+                lose (match, p);
+        }
+
+        if (match->winner == VS_PLAYING && maxPieces > 0 && match->players[VS_NB_PLAYERS-1].game.nbPieces >= maxPieces)
+        {
+            match->winner = decideMatch (match);
+            match->capped = 1;
+        }
+    }
+
+    return match->winner;
+}
+
+static Uint8 chooseBestPlacement (const SimGame *game, void *data, Placement *placement)
+{
+    return AI_bestPlacement (game, (const AI_Weights*)data, placement);
+}
+
+void VS_benchmark (int nbMatches, int maxPieces, Uint32 seed)
+{
+    /* Variables */
+    VS_ChooseFunc choose[VS_NB_PLAYERS] = {chooseBestPlacement, chooseBestPlacement};
+    void *data[VS_NB_PLAYERS];
+    AI_Weights weights;
+    VS_Match match;
+    Bitboard board;
+    Uint64 startTime, time, pieces = 0, lines = 0;
+    Uint32 wins[VS_NB_PLAYERS+1] = {0, 0, 0}, nbCapped = 0;
+    Uint32 randomSeed = seed;
+    int nbInsertions = 1000000, n;
+
+    AI_defaultWeights (&weights);
+    data[0] = data[1] = &weights;
+    BB_getShape (0, 0);
+
+    /* Garbage : a few lines at a time, the playfield being emptied before it overflows */
+    BB_clear (&board);
+    startTime = PLT_getTimeUs ();
+    for (n = 0; n < nbInsertions; n++)
+    {
+        if (VS_addGarbage (&board, 1 + n % 4, BB_random (&randomSeed) % NB_BLOCK_X))
+            BB_clear (&board);
+    }
+    time = PLT_getTimeUs () - startTime;
+    fprintf(stdout, "Garbage : %d rises in %.1f ms, %.1f ns per rise (last line %04X)\n",
+            nbInsertions, time/1e3, time*1e3/nbInsertions, board.rows[NB_BLOCK_Y-1]);
+
+    /* Matches */
+    startTime = PLT_getTimeUs ();
+    for (n = 0; n < nbMatches; n++)
+    {
+        wins[VS_playMatch (&match, BB_random (&randomSeed) | 1, maxPieces, choose, data)]++;
+        pieces += match.players[0].game.nbPieces + match.players[1].game.nbPieces;
+        lines += match.players[0].linesSent + match.players[1].linesSent;
+        nbCapped += match.capped;
+    }
+    time = PLT_getTimeUs () - startTime;
+    if (nbMatches <= 0 || time == 0)
+        return;
+
+    fprintf(stdout, "Matches : %d matches of at most %d tetriminoes per player in %.2f s on 1 thread\n",
+            nbMatches, maxPieces, time/1e6);
+    fprintf(stdout, "    %.0f matches per minute, %.1f us per tetrimino\n",
+            nbMatches*60e6/time, (double)time/(pieces ? pieces : 1));
+    fprintf(stdout, "    %.1f tetriminoes and %.1f garbage lines per match, %u / %u / %u wins / wins / draws\n",
+            (double)pieces/nbMatches, (double)lines/nbMatches, wins[0], wins[1], wins[VS_DRAW]);
+    fprintf(stdout, "    %u matches decided at the limit of tetriminoes, draw rate %.1f %%\n",
+            nbCapped, 100.0*wins[VS_DRAW]/nbMatches);
+}
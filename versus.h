@@ -0,0 +1,77 @@
+/** versus.h and versus.cpp simulate a match between two players without any window.
+
+    Each player has its own playfield, but both get the same tetriminoes (same seed), so only their
+    placements make the difference. The players drop one tetrimino in turn.
+    Clearing lines sends garbage lines to the opponent (see VS_garbageLines). The garbage first cancels
+    the lines the player is about to receive, the rest is added to the lines waiting for the opponent.
+    The waiting lines rise from the bottom of the playfield when the player locks a tetrimino without
+    clearing any line. All the lines of a rise have their hole in the same column. Each player has its own
+    generator of holes, started from the same seed : the n-th rise of both players has the same hole.
+
+    A player loses when its tetrimino cannot enter the playfield or when the garbage pushes blocks out of
+    the top of the playfield. If nobody has lost after maxPieces tetriminoes each, the player whose lines
+    made the most garbage wins (the cancelled lines count, so playing first is no advantage), then the one
+    with the lowest stack, counting the lines waiting to rise.
+    The match is a draw only if both are equal.
+**/
+
+#ifndef VERSUS_H_INCLUDED
+#define VERSUS_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "bitboard.h"
+#include "sim.h"
+
+#define VS_NB_PLAYERS   2
+#define VS_DRAW         2 /* Winner of a match that nobody has lost */
+#define VS_PLAYING      -1 /* Winner of a match not finished */
+
+typedef struct VS_Player VS_Player;
+typedef struct VS_Match VS_Match;
+
+/* Chooses the placement of the active tetrimino of a game. data is given as is by VS_playMatch.
+   Returns a boolean : 0 if the tetrimino cannot be placed anywhere */
+typedef Uint8 (*VS_ChooseFunc) (const SimGame*, void *data, Placement*);
+
+struct VS_Player
+{
+    SimGame game;
+    int pendingLines; /* Garbage lines that will rise at the next tetrimino locked without clearing a line */
+    Uint32 linesSent;
+    Uint32 linesMade; /* Garbage lines made by the lines cleared, the ones that cancelled waiting lines included */
+    Uint32 linesReceived; /* Garbage lines that rose in the playfield */
+    Uint32 garbageSeed; /* State of the random generator of the holes of the lines rising in this playfield */
+};
+
+struct VS_Match
+{
+    VS_Player players[VS_NB_PLAYERS];
+    int winner; /* Index of the winner, VS_DRAW or VS_PLAYING */
+    Uint8 capped; /* Boolean : 1 if the winner has been decided after maxPieces tetriminoes, nobody having lost */
+};
+
+
+/** Returns the number of garbage lines sent for nbLines complete lines **/
+int VS_garbageLines (int nbLines);
+
+/** Makes the lines of the playfield rise by nbLines and fills the bottom with garbage lines whose hole
+    is in the column hole. Returns a boolean : 1 if blocks have been pushed out of the top of the playfield **/
+Uint8 VS_addGarbage (Bitboard*, int nbLines, int hole);
+
+/** Starts a new match. The seed must not be 0 **/
+void VS_init (VS_Match*, Uint32 seed);
+
+/** Plays the active tetrimino of a player, sends the garbage and makes the waiting lines rise.
+    Updates the winner if the player loses. Returns the number of garbage lines sent **/
+int VS_play (VS_Match*, int player, const Placement*);
+
+/** Plays a whole match, each player choosing its placements with its function, and decides it after maxPieces
+    tetriminoes each (no limit if 0). Returns the winner (0, 1 or VS_DRAW) **/
+int VS_playMatch (VS_Match*, Uint32 seed, int maxPieces, VS_ChooseFunc choose[VS_NB_PLAYERS], void *data[VS_NB_PLAYERS]);
+
+/** Measures the speed of the garbage and of matches between two AI_bestPlacement players
+    and prints it in the stdout file **/
+void VS_benchmark (int nbMatches, int maxPieces, Uint32 seed);
+
+#endif // VERSUS_H_INCLUDED
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "game.h"
+#include "bitboard.h"
+#include "live.h"
+#include "spectate.h"
+#include "platform.h"
+#include "render.h"
+#include "pipeline.h"
+#include "wall.h"
+
+/* Publishes the state of the game of a board */
+static void publishBoard (WALL_Board *board)
+{
+    PIPE_Snapshot *snapshot = PIPE_writeSlot (&board->snapshots);
+
+    SPEC_frameFromLive (&snapshot->frame, &board->live);
+    snapshot->gameTime = board->live.time;
+    snapshot->sequence = ++board->nbPublished;
+    snapshot->publishTime = PLT_getTimeUs ();
+    snapshot->piece = board->live.game.nbPieces;
+    PIPE_publish (&board->snapshots);
+}
+
+Uint8 WALL_init (WALL_Wall *wall, int nbBoards, SDL_Surface *screen, Uint32 seed)
+{
+    /* Variables */
+    WALL_Board *board = NULL;
+    int columns, rows, size, b;
+
+    memset (wall, 0, sizeof(WALL_Wall));
+    if (nbBoards <= 0 || seed == 0)
+        return 0;
+
+    /* The grid with the largest cells. Each board is surrounded by half a cell */
+    for (columns = 1; columns <= nbBoards; columns++)
+    {
+        rows = (nbBoards + columns - 1)/columns;
+        size = screen->w/(columns*(NB_BLOCK_X+1));
+        if (screen->h/(rows*(WALL_LINES+1)) < size)
+            size = screen->h/(rows*(WALL_LINES+1));
+        if (size > wall->blockSize)
+        {
+            wall->blockSize = size;
+            wall->columns = columns;
+            wall->rows = rows;
+        }
+    }
+    if (wall->blockSize == 0)
+    {
+        fprintf(stderr, "%d boards do not fit in a screen of %dx%d pixels\n", nbBoards, screen->w, screen->h);
+        return 0;
+    }
+    /* A line of the grid between the cells, if they are large enough to see it */
+    wall->cellSize = (wall->blockSize >= 4) ? wall->blockSize - GRID_WIDE : wall->blockSize;
+
+    wall->boards = (WALL_Board*)malloc(nbBoards*sizeof(WALL_Board));
+    wall->cells = (RND_Cell*)malloc(nbBoards*WALL_LINES*NB_BLOCK_X*sizeof(RND_Cell));
+    wall->rects = (SDL_Rect*)malloc(nbBoards*sizeof(SDL_Rect));
+    if (wall->boards == NULL || wall->cells == NULL || wall->rects == NULL || !RND_initTiles (&wall->tiles, screen->format))
+    {
+        fprintf(stderr, "An error occurred during memory allocation for the wall\n");
+        free (wall->boards);
+        free (wall->cells);
+        free (wall->rects);
+        return 0;
+    }
+    wall->nbBoards = nbBoards;
+    BB_getShape (0, 0);
+
+    for (b = 0; b < nbBoards; b++)
+    {
+        board = &wall->boards[b];
+        LIVE_initPilot (&board->pilot, BB_random (&seed) | 1);
+        LIVE_init (&board->live, BB_random (&board->pilot.seed) | 1);
+        board->nbTicks = 0;
+        board->nbPublished = 0;
+        PIPE_initBuffer (&board->snapshots);
+        publishBoard (board);
+
+        /* The grid is centered on the screen */
+        board->position.x = (screen->w - wall->columns*(NB_BLOCK_X+1)*wall->blockSize)/2
+                            + (b % wall->columns)*(NB_BLOCK_X+1)*wall->blockSize + wall->blockSize/2;
+        board->position.y = (screen->h - wall->rows*(WALL_LINES+1)*wall->blockSize)/2
+                            + (b / wall->columns)*(WALL_LINES+1)*wall->blockSize + wall->blockSize/2;
+        board->position.w = NB_BLOCK_X*wall->blockSize;
+        board->position.h = WALL_LINES*wall->blockSize;
+    }
+
+    return 1;
+}
+
+void WALL_free (WALL_Wall *wall)
+{
+    RND_freeTiles (&wall->tiles);
+    free (wall->boards);
+    free (wall->cells);
+    free (wall->rects);
+    wall->boards = NULL;
+    wall->cells = NULL;
+    wall->rects = NULL;
+    wall->nbBoards = 0;
+}
+
+/* Plays the boards of a worker until the time of the wall, tick by tick */
+static int simulateBoards (void *data)
+{
+    /* Variables */
+    WALL_Worker *worker = (WALL_Worker*)data;
+    WALL_Wall *wall = worker->wall;
+    WALL_Board *board = NULL;
+    Uint32 nbTicks;
+    int b, x, y, rotation, piece;
+    Uint8 changed; /* Boolean */
+
+    while (!wall->stop)
+    {
+        nbTicks = (Uint32)((PLT_getTimeUs () - wall->startTime)/(WALL_TICK_PERIOD*1000));
+        for (b = worker->first; b < wall->nbBoards; b += worker->step)
+        {
+            board = &wall->boards[b];
+            if (board->nbTicks >= nbTicks)
+                continue;
+
+            /* The keys of the pilot move the tetrimino without LIVE_advance knowing it */
+            x = board->live.x;
+            y = board->live.y;
+            rotation = board->live.rotation;
+            piece = board->live.game.nbPieces;
+            changed = board->live.game.over;
+            while (board->nbTicks < nbTicks)
+            {
+                LIVE_pilot (&board->pilot, &board->live);
+                changed |= LIVE_advance (&board->live, WALL_TICK_PERIOD);
+                board->nbTicks++;
+            }
+            if (changed || x != board->live.x || y != board->live.y || rotation != board->live.rotation
+                || piece != board->live.game.nbPieces)
+                publishBoard (board);
+        }
+        SDL_Delay (1);
+    }
+
+    return 0;
+}
+
+Uint8 WALL_start (WALL_Wall *wall, int nbThreads)
+{
+    int n;
+
+    if (nbThreads > WALL_MAX_THREADS)
+        nbThreads = WALL_MAX_THREADS;
+    if (nbThreads > wall->nbBoards)
+        nbThreads = wall->nbBoards;
+    if (nbThreads < 1)
+        nbThreads = 1;
+
+    wall->stop = 0;
+    wall->startTime = PLT_getTimeUs ();
+    for (n = 0; n < wall->nbBoards; n++)
+        wall->boards[n].nbTicks = 0;
+
+    for (wall->nbWorkers = 0; wall->nbWorkers < nbThreads; wall->nbWorkers++)
+    {
+        wall->workers[wall->nbWorkers].wall = wall;
+        wall->workers[wall->nbWorkers].first = wall->nbWorkers;
+        wall->workers[wall->nbWorkers].step = nbThreads;
+        wall->workers[wall->nbWorkers].thread = SDL_CreateThread (simulateBoards, &wall->workers[wall->nbWorkers]);
+        if (wall->workers[wall->nbWorkers].thread == NULL)
+        {
+            fprintf(stderr, "Impossible to create a thread of the wall : %s\n", SDL_GetError() );
+            WALL_stop (wall);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void WALL_stop (WALL_Wall *wall)
+{
+    int n;
+
+    wall->stop = 1;
+    for (n = 0; n < wall->nbWorkers; n++)
+        SDL_WaitThread (wall->workers[n].thread, NULL);
+    wall->nbWorkers = 0;
+}
+
+void WALL_invalidate (WALL_Wall *wall)
+{
+    wall->valid = 0;
+}
+
+void WALL_draw (WALL_Wall *wall, RND_Backend *backend)
+{
+    /* Variables */
+    SDL_Surface *screen = backend->screen;
+    const PIPE_Snapshot *snapshot = NULL;
+    const SPEC_Frame *frame = NULL;
+    const PieceShape *shape = NULL;
+    WALL_Board *board = NULL;
+    RND_Cell *cell = NULL;
+    Uint8 repaint = (!wall->valid || wall->fullRepaint), fresh, changed; /* Booleans */
+    int nbCells = 0, nbRects = 0;
+    int b, i, j, l, tile, active;
+
+    /* The background, and the black of the grid under the cells */
+    if (!wall->valid)
+    {
+        SDL_FillRect (screen, NULL, SDL_MapRGB (screen->format, 64, 64, 64));
+        for (b = 0; b < wall->nbBoards; b++)
+            SDL_FillRect (screen, &wall->boards[b].position, SDL_MapRGB (screen->format, 0, 0, 0));
+    }
+
+    for (b = 0; b < wall->nbBoards; b++)
+    {
+        board = &wall->boards[b];
+        snapshot = PIPE_latest (&board->snapshots, &fresh);
+        if (!fresh && !repaint)
+            continue;
+        if (repaint)
+            memset (board->tiles, WALL_NO_TILE, sizeof(board->tiles));
+
+        frame = &snapshot->frame;
+        shape = frame->active ? BB_getShape (frame->tetrim, frame->rotation) : NULL;
+        active = RND_tetrimTile (frame->tetrim);
+        changed = 0;
+        for (j = FIRST_LINE; j < NB_BLOCK_Y; j++)
+        {
+            l = j - frame->y;
+            for (i = 0; i < NB_BLOCK_X; i++)
+            {
+                tile = frame->cells[j][i];
+                if (shape != NULL && l >= 0 && l < 4 && i >= frame->x && (shape->rows[l] & (1 << (i - frame->x))))
+                    tile = active;
+                if (board->tiles[j-FIRST_LINE][i] == tile)
+                    continue;
+
+                board->tiles[j-FIRST_LINE][i] = tile;
+                cell = &wall->cells[nbCells++];
+                cell->x = board->position.x + i*wall->blockSize;
+                cell->y = board->position.y + (j-FIRST_LINE)*wall->blockSize;
+                cell->h = 0;
+                cell->tile = tile;
+                cell->color = wall->tiles.colors[tile];
+                changed = 1;
+            }
+        }
+        if (changed)
+            wall->rects[nbRects++] = board->position;
+    }
+
+    /* All the boards in one pass */
+    RND_fillCells (screen, wall->cells, nbCells, wall->cellSize);
+
+    if (!wall->valid)
+        RND_flip (backend);
+    else if (nbRects > 0)
+        RND_updateRects (backend, nbRects, wall->rects);
+
+    wall->valid = 1;
+    wall->nbFrames++;
+    wall->nbCellsDrawn += nbCells;
+    wall->nbBoardsChanged += nbRects;
+}
+
+void WALL_watch (RND_Backend *backend, int nbBoards, int refreshRate, Uint32 seed)
+{
+    /* Variables */
+    WALL_Wall wall;
+    PIPE_Pacing pacing;
+    SDL_Event event;
+    char caption[128];
+    Uint64 frameTime, lastCaption, lastDraw = 0;
+    Uint32 nbFrames = 0;
+    int continueWall = 1; /* Boolean */
+
+    if (!WALL_init (&wall, nbBoards, backend->screen, seed))
+        return;
+    if (!WALL_start (&wall, PLT_getNbCores ()))
+    {
+        WALL_free (&wall);
+        return;
+    }
+    PIPE_initPacing (&pacing, refreshRate);
+
+    lastCaption = PLT_getTimeUs ();
+    while (continueWall)
+    {
+        while (SDL_PollEvent (&event))
+        {
+            if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+                continueWall = 0;
+            else if (event.type == SDL_VIDEOEXPOSE)
+                WALL_invalidate (&wall);
+        }
+
+        frameTime = PIPE_waitFrame (&pacing);
+        WALL_draw (&wall, backend);
+        PIPE_endFrame (&pacing, frameTime);
+        nbFrames++;
+
+        /* The time to draw a frame during the last second */
+        if (frameTime - lastCaption >= 1000000)
+        {
+            sprintf(caption, "Urban Tetrims - %d boards - %.3f ms per frame", nbBoards,
+                    (pacing.totalDraw - lastDraw)/1e3/nbFrames);
+            SDL_WM_SetCaption (caption, NULL);
+            lastCaption = frameTime;
+            lastDraw = pacing.totalDraw;
+            nbFrames = 0;
+        }
+    }
+
+    WALL_stop (&wall);
+    PIPE_printPacing ("Wall", &pacing);
+    if (wall.nbFrames > 0)
+        fprintf(stdout, "%d boards : %.0f cells drawn and %.1f boards presented per frame\n", nbBoards,
+                (double)wall.nbCellsDrawn/wall.nbFrames, (double)wall.nbBoardsChanged/wall.nbFrames);
+    WALL_free (&wall);
+}
+
+void WALL_benchmark (int nbBoards, int seconds, int nbThreads, Uint32 seed)
+{
+    /* Variables */
+    const char *names[2] = {"    Every cell  ", "    Changes only"};
+    RND_Backend memory;
+    WALL_Wall wall;
+    PIPE_Pacing pacing;
+    Uint64 startTime, frameTime, nbTicks, nbPixels;
+    int mode, b;
+
+    if (nbThreads <= 0)
+        nbThreads = PLT_getNbCores ();
+    if (!RND_openMemory (&memory, WINDOW_WIDTH, WINDOW_HEIGHT))
+        return;
+
+    for (mode = 0; mode < 2; mode++)
+    {
+        /* The same games in both modes */
+        if (!WALL_init (&wall, nbBoards, memory.screen, seed))
+            break;
+        wall.fullRepaint = (mode == 0);
+        if (mode == 0)
+            fprintf(stdout, "Wall : %d boards in %d columns and %d rows, cells of %d pixels, %d simulation threads, %d s at 60 fps\n",
+                    nbBoards, wall.columns, wall.rows, wall.blockSize, nbThreads, seconds);
+        if (!WALL_start (&wall, nbThreads))
+        {
+            WALL_free (&wall);
+            break;
+        }
+        PIPE_initPacing (&pacing, 60);
+        nbPixels = memory.nbPixelsPresented;
+
+        startTime = PLT_getTimeUs ();
+        do
+        {
+            frameTime = PIPE_waitFrame (&pacing);
+            WALL_draw (&wall, &memory);
+            PIPE_endFrame (&pacing, frameTime);
+        } while (frameTime - startTime < (Uint64)seconds*1000000);
+
+        WALL_stop (&wall);
+
+        /* The simulation is late if it has played less ticks than the time allowed */
+        nbTicks = 0;
+        for (b = 0; b < nbBoards; b++)
+            nbTicks += wall.boards[b].nbTicks;
+
+        PIPE_printPacing (names[mode], &pacing);
+        fprintf(stdout, "        %.0f cells drawn, %.1f boards and %.0f pixels presented per frame, "
+                "simulation at %.0f%% of the time\n",
+                (double)wall.nbCellsDrawn/wall.nbFrames, (double)wall.nbBoardsChanged/wall.nbFrames,
+                (double)(memory.nbPixelsPresented - nbPixels)/wall.nbFrames,
+                100.0*nbTicks*WALL_TICK_PERIOD/((double)nbBoards*(PLT_getTimeUs () - startTime)/1000));
+        WALL_free (&wall);
+    }
+
+    RND_closeBackend (&memory);
+}
@@ -0,0 +1,111 @@
+/** wall.h and wall.cpp show many games at once, scaled down in a grid, to watch the bots of a tournament.
+
+    Each board is a game without window (see live.h) played by a LIVE_Pilot. The boards are shared between
+    simulation threads, that make them progress by ticks of WALL_TICK_PERIOD milliseconds and publish a
+    PIPE_Snapshot in the triple buffer of the board when it has changed (see pipeline.h).
+    The render thread never waits for them : at each frame, it takes the last snapshot of every board.
+
+    The tile drawn in each cell of each board is kept, like RND_Screen does for the game. The cells that have
+    changed on all the boards are gathered in one array, then written in the pixels of the screen in one pass
+    with RND_fillCells, the screen being locked once per frame. Only the boards that have changed are presented.
+    The active tetriminoes are drawn in the color of their locked blocks : they do not blink.
+**/
+
+#ifndef WALL_H_INCLUDED
+#define WALL_H_INCLUDED
+
+#include <SDL/SDL.h>
+
+#include "constants.h"
+#include "live.h"
+#include "render.h"
+#include "pipeline.h"
+
+#define WALL_TICK_PERIOD    30 /* Milliseconds between two ticks of a board, like playGame */
+#define WALL_MAX_THREADS    16
+#define WALL_LINES          (NB_BLOCK_Y - FIRST_LINE) /* Visible lines of a board */
+#define WALL_NO_TILE        0xFF /* Tile of a cell that must be drawn again */
+
+typedef struct WALL_Board WALL_Board;
+typedef struct WALL_Worker WALL_Worker;
+typedef struct WALL_Wall WALL_Wall;
+
+struct WALL_Board
+{
+    /* Simulation */
+    LiveGame live;
+    LIVE_Pilot pilot;
+    Uint32 nbTicks; /* Ticks played since the simulation started */
+    Uint32 nbPublished;
+    PIPE_TripleBuffer snapshots;
+
+    /* Rendering */
+    Uint8 tiles[WALL_LINES][NB_BLOCK_X]; /* Tile drawn in each visible cell, WALL_NO_TILE if none */
+    SDL_Rect position; /* Part of the screen of the playfield */
+};
+
+/* A simulation thread : it plays the boards first, first + step, first + 2*step... */
+struct WALL_Worker
+{
+    WALL_Wall *wall;
+    int first, step;
+    SDL_Thread *thread;
+};
+
+struct WALL_Wall
+{
+    WALL_Board *boards;
+    int nbBoards;
+    int columns, rows;
+    int blockSize; /* Pixels between two cells */
+    int cellSize; /* Pixels filled in a cell */
+
+    /* Simulation */
+    WALL_Worker workers[WALL_MAX_THREADS];
+    int nbWorkers;
+    Uint64 startTime; /* Microseconds of PLT_getTimeUs when the simulation started */
+    volatile int stop;
+
+    /* Rendering */
+    RND_Tiles tiles;
+    RND_Cell *cells; /* Cells changed during the frame */
+    SDL_Rect *rects; /* Boards changed during the frame */
+    Uint8 valid; /* Boolean : 0 if everything must be drawn and presented at the next frame */
+    Uint8 fullRepaint; /* Boolean : 1 to draw every cell at each frame */
+
+    /* Measures */
+    Uint32 nbFrames;
+    Uint64 nbCellsDrawn, nbBoardsChanged;
+};
+
+
+/** Places nbBoards boards in a grid that fits the screen, with the largest cells possible, and starts their games.
+    Returns a boolean : 0 if they cannot be allocated or do not fit **/
+Uint8 WALL_init (WALL_Wall*, int nbBoards, SDL_Surface *screen, Uint32 seed);
+
+/** Frees the boards. The simulation must have been stopped **/
+void WALL_free (WALL_Wall*);
+
+/** Plays the boards on nbThreads simulation threads until WALL_stop. Returns a boolean : 0 if a thread cannot be created **/
+Uint8 WALL_start (WALL_Wall*, int nbThreads);
+
+/** Stops the simulation threads **/
+void WALL_stop (WALL_Wall*);
+
+/** The whole screen is drawn and presented at the next frame **/
+void WALL_invalidate (WALL_Wall*);
+
+/** Draws the cells that have changed on all the boards since the last frame and presents the boards changed **/
+void WALL_draw (WALL_Wall*, RND_Backend*);
+
+/** Shows nbBoards games in the window at refreshRate frames per second until the window is closed or Escape
+    is pressed. The time to draw a frame is written in the caption every second, and the pacing of the frames
+    is printed in the stdout file at the end **/
+void WALL_watch (RND_Backend*, int nbBoards, int refreshRate, Uint32 seed);
+
+/** Draws nbBoards games played on nbThreads threads in a screen in memory for seconds seconds at 60 frames per second,
+    every cell at each frame then only the ones that have changed, and prints the pacing and the time to draw
+    the frames, and the cells drawn in the stdout file **/
+void WALL_benchmark (int nbBoards, int seconds, int nbThreads, Uint32 seed);
+
+#endif // WALL_H_INCLUDED